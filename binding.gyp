@@ -12,7 +12,46 @@
         'src/font.cc',
         'src/book_wrapper.cc',
         'src/string_copy.cc',
-        'src/buffer_copy.cc'
+        'src/buffer_copy.cc',
+        'src/format_translator.cc',
+        'src/range_copy.cc',
+        'src/sheet_import.cc',
+        'src/book_split.cc',
+        'src/functions.cc',
+        'src/typed_array.cc',
+        'src/column_auto_fit.cc',
+        'src/range_styler.cc',
+        'src/cell_reference.cc',
+        'src/formula_template.cc',
+        'src/formula_parser.cc',
+        'src/formula_evaluator.cc',
+        'src/formula_resolver.cc',
+        'src/dependency_graph.cc',
+        'src/byte_source.cc',
+        'src/zip_reader.cc',
+        'src/compound_file.cc',
+        'src/biff_reader.cc',
+        'src/xml_tag.cc',
+        'src/book_probe.cc',
+        'src/xlsx_package.cc',
+        'src/zip_writer.cc',
+        'src/xlsx_subset.cc',
+        'src/xlsx_row_reader.cc',
+        'src/xlsx_stream.cc',
+        'src/xlsx_writer.cc',
+        'src/xlsx_stream_writer.cc',
+        'src/xls_scanner.cc',
+        'src/sheet_rollover.cc',
+        'src/rollover_writer.cc',
+        'src/sheet_cache.cc',
+        'src/book_cache_index.cc',
+        'src/book_cache.cc',
+        'src/hash.cc',
+        'src/sheet_journal.cc',
+        'src/csv_export.cc',
+        'src/sheet_patch.cc',
+        'src/picture_extract.cc',
+        'src/sheet_name.cc'
       ],
       'include_dirs': [
         'deps/libxl/include_cpp',
@@ -159,6 +159,174 @@ describe('The book class', function() {
         });
     });
 
+    it('book.isDirty tracks changes and book.writeRaw reuses the output of unchanged books', function() {
+        var result;
+
+        runs(function() {
+            var book1 = new xl.Book(xl.BOOK_TYPE_XLS), sheet, font, buffer;
+
+            expect(book1.isDirty()).toBe(false);
+
+            sheet = book1.addSheet('foo');
+            expect(book1.isDirty()).toBe(true);
+
+            buffer = book1.writeRawSync();
+            expect(book1.isDirty()).toBe(false);
+            expect(testUtils.compareBuffers(book1.writeRawSync(), buffer)).toBe(true);
+
+            sheet.writeNum(1, 0, 10);
+            expect(book1.isDirty()).toBe(true);
+            expect(book1.writeRawSync().length).not.toBe(0);
+
+            font = book1.addFont();
+            book1.writeRawSync();
+            font.setSize(20);
+            expect(book1.isDirty()).toBe(true);
+
+            sheet.setZoom(120);
+            buffer = book1.writeRawSync();
+
+            var book2 = new xl.Book(xl.BOOK_TYPE_XLS);
+            book2.loadRawSync(buffer);
+            expect(book2.isDirty()).toBe(false);
+            book2.getSheet(0).setName('bar');
+            expect(book2.isDirty()).toBe(true);
+
+            book1.writeRaw(function(err, data) {
+                result = [err, data, buffer, book1.isDirty()];
+            });
+        });
+
+        waitsFor(function() {
+            return !!result;
+        }, 'book to save', 1000);
+
+        runs(function() {
+            expect(result[0]).toBeUndefined();
+            expect(testUtils.compareBuffers(result[1], result[2])).toBe(true);
+            expect(result[3]).toBe(false);
+        });
+    });
+
+    it('book.loadRawSync and book.loadSync can restrict loading to selected xlsx sheets', function() {
+        var book1 = new xl.Book(xl.BOOK_TYPE_XLSX),
+            file = testUtils.getWriteTestFile() + 'x';
+
+        book1.addSheet('Data').writeStr(1, 0, 'data');
+        book1.addSheet('Other').writeStr(1, 0, 'other').writeNum(5, 2, 1);
+        book1.writeSync(file);
+
+        var buffer = book1.writeRawSync(),
+            book2 = new xl.Book(xl.BOOK_TYPE_XLSX);
+
+        shouldThrow(book2.loadRawSync, book2, buffer, {sheets: 'Data'});
+        shouldThrow(book2.loadRawSync, book2, buffer, {sheets: [1]});
+        shouldThrow(book2.loadRawSync, book2, buffer, {sheets: ['Missing']});
+        shouldThrow(book2.loadRawSync, book2, new Buffer('no xlsx'), {sheets: ['Data']});
+
+        [
+            function(book) {return book.loadRawSync(buffer, {sheets: ['data']});},
+            function(book) {return book.loadSync(file, {sheets: ['Data']});}
+        ].forEach(function(load) {
+            var book = new xl.Book(xl.BOOK_TYPE_XLSX);
+
+            expect(load(book)).toBe(book);
+            expect(book.sheetCount()).toBe(2);
+            expect(book.getSheet(0).readStr(1, 0)).toBe('data');
+            expect(book.getSheet(1).name()).toBe('Other');
+            expect(book.getSheet(1).lastRow()).toBe(0);
+        });
+    });
+
+    it('book.loadPreviewSync and book.loadPreview load only the first rows of xlsx sheets', function() {
+        var book1 = new xl.Book(xl.BOOK_TYPE_XLSX),
+            file = testUtils.getWriteTestFile() + 'x',
+            data = book1.addSheet('Data'),
+            other = book1.addSheet('Other'),
+            result = null,
+            book3 = new xl.Book(xl.BOOK_TYPE_XLSX);
+
+        for (var row = 1; row <= 200; row++) {
+            data.writeNum(row, 0, row);
+            other.writeStr(row, 1, 'row ' + row);
+        }
+        data.setMerge(150, 151, 0, 1);
+        book1.writeSync(file);
+
+        // Trial versions of libxl add a banner in the first row
+        var buffer = book1.writeRawSync(),
+            book2 = new xl.Book(xl.BOOK_TYPE_XLSX),
+            firstRow = book2.loadRawSync(buffer).getSheet(0).firstRow();
+
+        shouldThrow(book2.loadPreviewSync, book2, 1);
+        shouldThrow(book2.loadPreviewSync, book2, buffer, {rows: -1});
+        shouldThrow(book2.loadPreviewSync, book2, buffer, {rows: 'a'});
+        shouldThrow(book2.loadPreviewSync, {}, buffer);
+
+        expect(book2.loadPreviewSync(buffer, {rows: 10, sheets: ['Other']})).toBe(book2);
+        expect(book2.getSheet(0).lastRow()).toBe(0);
+        expect(book2.getSheet(1).lastRow()).toBe(firstRow + 10);
+        expect(book2.getSheet(1).readStr(9, 1)).toBe('row 9');
+
+        expect(book2.loadPreviewSync(file)).toBe(book2);
+        expect(book2.getSheet(0).lastRow()).toBe(firstRow + 100);
+        expect(book2.getSheet(0).readNum(99, 0)).toBe(99);
+        expect(book2.getSheet(1).lastRow()).toBe(firstRow + 100);
+
+        runs(function() {
+            shouldThrow(book3.loadPreview, book3, buffer, {rows: 'a'}, function() {});
+            shouldThrow(book3.loadPreview, book3, buffer, {rows: 5});
+
+            book3.loadPreview(buffer, {rows: 5}, function(err) {
+                result = err;
+            });
+        });
+
+        waitsFor(function() {
+            return result !== null;
+        }, 'preview to load', 1000);
+
+        runs(function() {
+            expect(result).toBeUndefined();
+            expect(book3.getSheet(0).lastRow()).toBe(firstRow + 5);
+            expect(book3.getSheet(1).readStr(4, 1)).toBe('row 4');
+        });
+    });
+
+    it('book.loadRaw and book.load accept the sheets option in async mode', function() {
+        var book1 = new xl.Book(xl.BOOK_TYPE_XLSX),
+            file = testUtils.getWriteTestFile() + 'x',
+            books = [new xl.Book(xl.BOOK_TYPE_XLSX), new xl.Book(xl.BOOK_TYPE_XLSX)],
+            results = [];
+
+        book1.addSheet('Data').writeStr(1, 0, 'data');
+        book1.addSheet('Other').writeStr(1, 0, 'other');
+        book1.writeSync(file);
+
+        runs(function() {
+            var cb = function(err) {results.push(err);};
+
+            shouldThrow(books[0].loadRaw, books[0], book1.writeRawSync(), {sheets: 1}, cb);
+            shouldThrow(books[0].load, books[0], file, {sheets: ['Other']});
+
+            books[0].loadRaw(book1.writeRawSync(), {sheets: ['Other']}, cb);
+            books[1].load(file, {sheets: ['Other']}, cb);
+        });
+
+        waitsFor(function() {
+            return results.length === 2;
+        }, 'books to load', 1000);
+
+        runs(function() {
+            expect(results).toEqual([undefined, undefined]);
+
+            books.forEach(function(book) {
+                expect(book.getSheet(0).lastRow()).toBe(0);
+                expect(book.getSheet(1).readStr(1, 0)).toBe('other');
+            });
+        });
+    });
+
 
     it('book.addSheet adds a sheet to a book', function() {
         shouldThrow(book.addSheet, book, 10);
@@ -186,6 +354,76 @@ describe('The book class', function() {
         expect(sheet2.readStr(1, 0)).toBe('bbb');
     });
 
+    it('book.importSheet imports a sheet from another book', function() {
+        var sourceBook = new xl.Book(xl.BOOK_TYPE_XLSX),
+            source = sourceBook.addSheet('source'),
+            bold = sourceBook.addFormat()
+                .setFont(sourceBook.addFont().setBold(true)),
+            targetBold = book.addFormat()
+                .setFont(book.addFont().setBold(true)),
+            formatCount;
+
+        source
+            .writeNum(1, 0, 10)
+            .writeStr(1, 1, 'foo', bold)
+            .writeStr(2, 1, 'bar', bold)
+            .writeFormula(2, 0, 'A2*2')
+            .setMerge(3, 3, 0, 1)
+            .setCol(1, 1, 20);
+
+        shouldThrow(book.importSheet, book, 1);
+        shouldThrow(book.importSheet, book, source, {name: 1});
+        shouldThrow(book.importSheet, {}, source);
+
+        formatCount = book.formatSize();
+        var imported = book.importSheet(source);
+        var importedFormats = book.formatSize() - formatCount;
+
+        expect(book.sheetCount()).toBe(1);
+        expect(imported.name()).toBe('source');
+        expect(imported.readNum(1, 0)).toBe(10);
+        expect(imported.readStr(1, 1)).toBe('foo');
+        expect(imported.readFormula(2, 0)).toBe('A2*2');
+        expect(imported.getMerge(3, 0).colLast).toBe(1);
+        expect(imported.colWidth(1)).toBeCloseTo(20, 1);
+
+        var format = {};
+        imported.readStr(1, 1, format);
+        expect(format.format.font().bold()).toBe(true);
+
+        // Existing formats of the target book are not shared with the copy
+        targetBold.font().setItalic(true);
+        imported.readStr(1, 1, format);
+        expect(format.format.font().italic()).toBe(false);
+
+        // Cells sharing a source format share its translation
+        imported.readStr(2, 1, format);
+        expect(format.format.font().bold()).toBe(true);
+        formatCount = book.formatSize();
+        book.importSheet(source, {name: 'again'});
+        expect(book.formatSize() - formatCount).toBe(importedFormats);
+
+        var plain = book.importSheet(source, {name: 'plain',
+            includeFormats: false, includeMerges: false});
+        expect(plain.name()).toBe('plain');
+        expect(plain.readStr(1, 1, format)).toBe('foo');
+        expect(format.format.font().bold()).toBe(false);
+        shouldThrow(plain.getMerge, plain, 3, 0);
+
+        var local = book.addSheet('local')
+            .writeNum(1, 0, 10)
+            .writeStr(1, 1, 'foo', targetBold)
+            .setMerge(3, 3, 0, 1);
+
+        var copy = book.importSheet(local, {name: 'copy',
+            includeMerges: false});
+        expect(copy.readNum(1, 0)).toBe(10);
+        expect(copy.readStr(1, 1, format)).toBe('foo');
+        expect(format.format.font().italic()).toBe(true);
+        shouldThrow(copy.getMerge, copy, 3, 0);
+        expect(book.sheetCount()).toBe(5);
+    });
+
     it('book.getSheet retrieves a sheet at a given index', function() {
         var sheet = book.addSheet('foo');
         sheet.writeStr(1, 0, 'bar');
@@ -223,6 +461,40 @@ describe('The book class', function() {
         expect(book.sheetCount()).toBe(1);
     });
 
+    it('book.formulaDependencies extracts the formula dependency graph', function() {
+        var graphBook = new xl.Book(xl.BOOK_TYPE_XLSX),
+            data = graphBook.addSheet('Data'),
+            calc = graphBook.addSheet('Calc');
+
+        data.writeNum(1, 0, 1).writeNum(2, 0, 2);
+        data.setNamedRange('inputs', 1, 2, 0, 0);
+        calc
+            .writeFormula(1, 1, 'SUM(Data!A2:A3)')
+            .writeFormula(2, 1, 'B2*2+SUM(inputs)+B2')
+            .writeFormula(3, 1, 'missing+Nowhere!A1+B3');
+
+        shouldThrow(graphBook.formulaDependencies, {});
+
+        var graph = graphBook.formulaDependencies(),
+            toArray = function(a) {return Array.prototype.slice.call(a);};
+
+        expect(graph.sheet instanceof Int32Array).toBe(true);
+        expect(toArray(graph.sheet)).toEqual([0, 0, 1, 1, 1]);
+        expect(toArray(graph.row)).toEqual([1, 2, 1, 2, 3]);
+        expect(toArray(graph.col)).toEqual([0, 0, 1, 1, 1]);
+        expect(toArray(graph.isFormula)).toEqual([0, 0, 1, 1, 1]);
+
+        expect(toArray(graph.precedentOffsets)).toEqual([0, 0, 0, 2, 5, 6]);
+        expect(toArray(graph.precedents)).toEqual([0, 1, 0, 1, 2, 3]);
+        expect(toArray(graph.dependentOffsets)).toEqual([0, 2, 4, 5, 6, 6]);
+        expect(toArray(graph.dependents)).toEqual([2, 3, 2, 3, 3, 4]);
+
+        expect(graph.brokenReferences).toEqual([
+            {sheet: 1, row: 3, col: 1, reference: 'missing'},
+            {sheet: 1, row: 3, col: 1, reference: '\'Nowhere\'!A1'}
+        ]);
+    });
+
     it('book.addFormat adds a format', function() {
         shouldThrow(book.addFormat, book, 10);
         shouldThrow(book.addFormat, {});
@@ -369,6 +641,36 @@ describe('The book class', function() {
         expect(testUtils.compareBuffers(pic1.data, fileBuffer)).toBe(true);
     });
 
+    it('book.addPictureDedup adds pictures only once', function() {
+        var book = new xl.Book(xl.BOOK_TYPE_XLS),
+            file = testUtils.getTestPicturePath(),
+            fileBuffer = fs.readFileSync(file),
+            otherBuffer = Buffer.concat([fileBuffer, new Buffer([0])]);
+
+        shouldThrow(book.addPictureDedup, book, 1);
+        shouldThrow(book.addPictureDedup, {}, file);
+        shouldThrow(book.addPictureDedup, book, file + '.missing');
+
+        expect(book.addPicture(file)).toBe(0);
+        expect(book.addPictureDedup(fileBuffer)).toBe(0);
+        expect(book.addPictureDedup(file)).toBe(0);
+        expect(book.pictureSize()).toBe(1);
+
+        expect(book.addPictureDedup(otherBuffer)).toBe(1);
+        expect(book.addPictureDedup(otherBuffer)).toBe(1);
+        expect(book.pictureSize()).toBe(2);
+
+        book.addSheet('foo').setPicture(1, 0, 0).setPicture(5, 0, 1);
+
+        var loaded = new xl.Book(xl.BOOK_TYPE_XLS);
+        loaded.loadRawSync(book.writeRawSync());
+
+        var pictureCount = loaded.pictureSize();
+        expect(pictureCount).toBeGreaterThan(0);
+        expect(loaded.addPictureDedup(fileBuffer)).toBeLessThan(pictureCount);
+        expect(loaded.pictureSize()).toBe(pictureCount);
+    });
+
     it('book.addPictureAsync and boook.addPictureAsync provide async picture management',
         function()
     {
@@ -436,6 +738,101 @@ describe('The book class', function() {
         });
     });
 
+    it('book.extractPictures extracts pictures together with their placements',
+        function()
+    {
+        var book = new xl.Book(xl.BOOK_TYPE_XLS),
+            file = testUtils.getTestPicturePath(),
+            fileBuffer = fs.readFileSync(file),
+            outDir = testUtils.getOutputDir(),
+            buffers, files, failure, duplicate;
+
+        book.addPicture(file);
+        book.addPicture(fileBuffer);
+        book.addSheet('foo').setPicture(2, 1, 0).setPicture(4, 3, 0);
+        book.addSheet('bar').setPicture(1, 2, 1);
+
+        shouldThrow(book.extractPictures, book, {asBuffers: true}, 1);
+        shouldThrow(book.extractPictures, book, {}, function() {});
+        shouldThrow(book.extractPictures, book,
+            {outDir: outDir, asBuffers: true}, function() {});
+        shouldThrow(book.extractPictures, book, {outDir: ''}, function() {});
+        shouldThrow(book.extractPictures, book,
+            {asBuffers: true, indices: [0.5]}, function() {});
+        shouldThrow(book.extractPictures, {}, {asBuffers: true},
+            function() {});
+
+        runs(function() {
+            function extractBuffers() {
+                book.extractPictures({asBuffers: true},
+                    function(err, manifest) {
+                        expect(err).toBeUndefined();
+                        buffers = manifest;
+
+                        extractFiles();
+                    });
+            }
+
+            function extractFiles() {
+                book.extractPictures({outDir: outDir, indices: [1]},
+                    function(err, manifest) {
+                        expect(err).toBeUndefined();
+                        files = manifest;
+
+                        extractInvalid();
+                    });
+            }
+
+            function extractInvalid() {
+                book.extractPictures({asBuffers: true, indices: [2]},
+                    function(err) {
+                        failure = err;
+
+                        extractDuplicate();
+                    });
+            }
+
+            function extractDuplicate() {
+                book.extractPictures({outDir: outDir, indices: [0, 0]},
+                    function(err) {
+                        duplicate = err;
+                    });
+            }
+
+            extractBuffers();
+        });
+
+        waitsFor(function() {
+            return buffers && files && failure && duplicate;
+        }, 'pictures to be extracted', 2000);
+
+        runs(function() {
+            expect(buffers.length).toBe(2);
+            expect(buffers[0].index).toBe(0);
+            expect(buffers[0].type).toBe(xl.PICTURETYPE_PNG);
+            expect(testUtils.compareBuffers(buffers[0].data, fileBuffer))
+                .toBe(true);
+
+            expect(buffers[0].placements.length).toBe(2);
+            expect(buffers[0].placements[0].sheet).toBe(0);
+            expect(buffers[0].placements[0].rowTop).toBe(2);
+            expect(buffers[0].placements[0].colLeft).toBe(1);
+            expect(buffers[0].placements[1].rowTop).toBe(4);
+            expect(buffers[1].placements.length).toBe(1);
+            expect(buffers[1].placements[0].sheet).toBe(1);
+
+            expect(files.length).toBe(1);
+            expect(files[0].index).toBe(1);
+            expect(files[0].data).toBeUndefined();
+            expect(testUtils.compareBuffers(fs.readFileSync(files[0].path),
+                fileBuffer)).toBe(true);
+            expect(files[0].placements.length).toBe(1);
+
+            expect(failure instanceof Error).toBe(true);
+            expect(duplicate instanceof Error).toBe(true);
+        });
+    });
+
     it('book.defaultFont returns the default font', function() {
         book.setDefaultFont('times', 13);
         shouldThrow(book.defaultFont, {});
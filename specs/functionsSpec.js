@@ -0,0 +1,436 @@
+var xl = require('../lib/libxl'),
+    testUtils = require('./testUtils'),
+    path = require('path'),
+    fs = require('fs'),
+    shouldThrow = testUtils.shouldThrow;
+
+testUtils.initFilesystem();
+
+describe('The module level functions', function() {
+
+    it('xl.addrToRowColMany converts addresses in bulk', function() {
+        shouldThrow(xl.addrToRowColMany, xl, 'A1');
+        shouldThrow(xl.addrToRowColMany, xl, ['A1', 1]);
+
+        var result = xl.addrToRowColMany(['A1', '$C5', 'b$10', 'XFD1048576', 'A0', 'A1B',
+                'XFE1', 'A1048577']),
+            toArray = function(a) {return Array.prototype.slice.call(a);};
+
+        expect(result.row instanceof Int32Array).toBe(true);
+        expect(toArray(result.row)).toEqual([0, 4, 9, 1048575, -1, -1, -1, -1]);
+        expect(toArray(result.col)).toEqual([0, 2, 1, 16383, -1, -1, -1, -1]);
+        expect(toArray(result.rowRelative)).toEqual([1, 1, 0, 1, 1, 1, 1, 1]);
+        expect(toArray(result.colRelative)).toEqual([1, 0, 1, 1, 1, 1, 1, 1]);
+
+        var sheet = new xl.Book(xl.BOOK_TYPE_XLSX).addSheet('foo'),
+            single = sheet.addrToRowCol('$C5');
+        expect(single.row).toBe(result.row[1]);
+        expect(single.col).toBe(result.col[1]);
+    });
+
+    it('xl.rowColToAddrMany converts rows and columns to addresses in bulk', function() {
+        shouldThrow(xl.rowColToAddrMany, xl, [0], 0);
+        shouldThrow(xl.rowColToAddrMany, xl, [0, 1], [0]);
+        shouldThrow(xl.rowColToAddrMany, xl, [-1], [0]);
+        shouldThrow(xl.rowColToAddrMany, xl, [0], [0], {rowRelative: 1});
+
+        expect(xl.rowColToAddrMany([0, 4, 1048575], new Int32Array([0, 27, 16383])))
+            .toEqual(['A1', 'AB5', 'XFD1048576']);
+        expect(xl.rowColToAddrMany([9], [1], {rowRelative: false}))
+            .toEqual(['B$10']);
+        expect(xl.rowColToAddrMany([], [])).toEqual([]);
+    });
+
+    it('xl.probe lists sheets and dimensions without loading a book', function() {
+        shouldThrow(xl.probe, xl, 1);
+        shouldThrow(xl.probe, xl, new Buffer('no excel file'));
+        shouldThrow(xl.probe, xl, path.join(testUtils.getOutputDir(), 'missing.xlsx'));
+
+        [['xls', xl.BOOK_TYPE_XLS], ['xlsx', xl.BOOK_TYPE_XLSX]].forEach(function(format) {
+            var book = new xl.Book(format[1]),
+                file = path.join(testUtils.getOutputDir(), 'probe.' + format[0]);
+
+            book.addSheet('Data \u00fc').writeNum(2, 1, 1).writeStr(10, 4, 'x');
+            book.addSheet('Hidden').setHidden(xl.SHEETSTATE_HIDDEN);
+            book.writeSync(file);
+
+            [book.writeRawSync(), file].forEach(function(source) {
+                var result = xl.probe(source);
+
+                expect(result.format).toBe(format[0]);
+                expect(result.sheets.length).toBe(2);
+                expect(result.sheets[0]).toEqual({
+                    name: 'Data \u00fc', state: 'visible', type: 'worksheet',
+                    rowFirst: 2, rowLast: 10, colFirst: 1, colLast: 4
+                });
+                expect(result.sheets[1].name).toBe('Hidden');
+                expect(result.sheets[1].state).toBe('hidden');
+            });
+        });
+    });
+
+    it('xl.scanXls extracts the values of an xls sheet as columns', function() {
+        var book = new xl.Book(xl.BOOK_TYPE_XLS),
+            file = path.join(testUtils.getOutputDir(), 'scan.xls'),
+            long = new Array(3000).join('\u00e4b');
+
+        book.addSheet('First').writeStr(1, 0, 'first');
+        book.addSheet('Data')
+            .writeNum(1, 0, 1.5).writeNum(1, 1, -42).writeStr(1, 2, 'a & <b>')
+            .writeBool(2, 1, true)
+            .writeStr(3, 0, long).writeStr(3, 1, long + 'x');
+        book.writeSync(file);
+
+        shouldThrow(xl.scanXls, xl, 1);
+        shouldThrow(xl.scanXls, xl, new Buffer('no excel file'));
+        shouldThrow(xl.scanXls, xl, file, {sheet: 'Missing'});
+        shouldThrow(xl.scanXls, xl, book.writeRawSync(), {sheet: 1});
+        shouldThrow(xl.scanXls, xl, path.join(testUtils.getOutputDir(), 'missing.xls'));
+
+        [book.writeRawSync(), file].forEach(function(source) {
+            var result = xl.scanXls(source, {sheet: 'data'}),
+                cells = [];
+
+            expect(result.row instanceof Int32Array).toBe(true);
+            expect(result.type instanceof Uint8Array).toBe(true);
+            expect(result.number instanceof Float64Array).toBe(true);
+
+            // Trial versions of libxl add a banner in the first row
+            for (var i = 0; i < result.row.length; i++) {
+                if (result.row[i] === 0) continue;
+
+                var value = result.number[i];
+                if (result.type[i] === 2) value = result.strings[value];
+                if (result.type[i] === 3) value = !!value;
+
+                cells.push([result.row[i], result.col[i], value]);
+            }
+
+            expect(cells).toEqual([
+                [1, 0, 1.5], [1, 1, -42], [1, 2, 'a & <b>'],
+                [2, 1, true],
+                [3, 0, long], [3, 1, long + 'x']
+            ]);
+        });
+
+        var first = xl.scanXls(file);
+        expect(first.strings[first.number[first.row.length - 1]]).toBe('first');
+
+        // Corrupt string tables fail instead of exhausting memory
+        var buffer = book.writeRawSync(), sst = -1, next;
+
+        for (var i = 0; i + 4 < buffer.length && sst < 0; i++) {
+            next = i + 4 + buffer.readUInt16LE(i + 2);
+
+            if (buffer.readUInt16LE(i) === 0xFC && next + 2 <= buffer.length &&
+                [0x3C, 0xFF].indexOf(buffer.readUInt16LE(next)) >= 0)
+            {
+                sst = i;
+            }
+        }
+
+        expect(sst).toBeGreaterThan(0);
+
+        var hugeCount = new Buffer(buffer);
+        hugeCount.writeUInt32LE(0xFFFFFFF0, sst + 8);
+        shouldThrow(xl.scanXls, xl, hugeCount);
+
+        // A bad length in the record following the table truncates it
+        for (next = sst; buffer.readUInt16LE(next) === 0xFC ||
+                buffer.readUInt16LE(next) === 0x3C;)
+        {
+            next += 4 + buffer.readUInt16LE(next + 2);
+        }
+
+        var truncated = new Buffer(buffer);
+        truncated[next + 3] = 0xFD;
+        shouldThrow(xl.scanXls, xl, truncated);
+    });
+
+    it('xl.streamXlsx reads the values of an xlsx sheet in batches of rows', function() {
+        var book = new xl.Book(xl.BOOK_TYPE_XLSX),
+            file = path.join(testUtils.getOutputDir(), 'stream.xlsx'),
+            result = null;
+
+        book.addSheet('First').writeStr(1, 0, 'first');
+        book.addSheet('Data')
+            .writeNum(1, 0, 1.5).writeStr(1, 2, 'a & <b>')
+            .writeBool(2, 1, true)
+            .writeStr(3, 0, 'a & <b>');
+        book.writeSync(file);
+
+        shouldThrow(xl.streamXlsx, xl, 1);
+        shouldThrow(xl.streamXlsx, xl, file, {sheet: 'Missing'});
+        shouldThrow(xl.streamXlsx, xl, file, {batchSize: 0});
+        shouldThrow(xl.streamXlsx, xl, path.join(testUtils.getOutputDir(), 'missing.xlsx'));
+
+        // Trial versions of libxl add a banner in the first row
+        function dataRows(batch) {
+            return batch.filter(function(row) {return row.row > 0;});
+        }
+
+        var stream = xl.streamXlsx(file, {sheet: 'data', batchSize: 2}),
+            rows = dataRows(stream.nextSync().concat(stream.nextSync()));
+
+        expect(rows).toEqual([
+            {row: 1, values: [1.5, null, 'a & <b>']},
+            {row: 2, values: [null, true]},
+            {row: 3, values: ['a & <b>']}
+        ]);
+        expect(stream.nextSync()).toBe(null);
+        expect(stream.close()).toBe(stream);
+        shouldThrow(stream.nextSync, stream);
+
+        stream = xl.streamXlsx(file);
+
+        runs(function() {
+            shouldThrow(stream.next, stream);
+
+            stream.next(function(err, batch) {
+                result = err || batch;
+            });
+
+            shouldThrow(stream.nextSync, stream);
+        });
+
+        waitsFor(function() {
+            return result !== null;
+        }, 'rows to stream', 1000);
+
+        runs(function() {
+            expect(dataRows(result)).toEqual([{row: 1, values: ['first']}]);
+            stream.close();
+        });
+    });
+
+    it('xl.createXlsxStreamWriter writes xlsx files row by row', function() {
+        var formatBook = new xl.Book(xl.BOOK_TYPE_XLSX),
+            format = formatBook.addFormat(),
+            file = path.join(testUtils.getOutputDir(), 'streamWriter.xlsx'),
+            result = null;
+
+        format.setNumFormat(formatBook.addCustomNumFormat('0.000'));
+        format.font().setBold(true);
+
+        shouldThrow(xl.createXlsxStreamWriter, xl, 1);
+        shouldThrow(xl.createXlsxStreamWriter, xl, file, {sheets: ['a', 'A']});
+        shouldThrow(xl.createXlsxStreamWriter, xl, file, {sheets: ['a/b']});
+        shouldThrow(xl.createXlsxStreamWriter, xl, file, {columnFormats: [1]});
+        shouldThrow(xl.createXlsxStreamWriter, xl,
+            path.join(testUtils.getOutputDir(), 'missing', 'file.xlsx'));
+
+        var writer = xl.createXlsxStreamWriter(file, {
+            sheets: ['Data', 'More', 'Empty'],
+            columnFormats: [format]
+        });
+
+        shouldThrow(writer.writeRows, writer, [1]);
+        shouldThrow(writer.writeRows, writer, [[{}]]);
+
+        // Row 0 is left empty, as trial versions of libxl refuse to read it
+        expect(writer.writeRows([
+            [],
+            [1.5, 'a & <b>', true, null, new Date(Date.UTC(2000, 0, 1))],
+            [2, 'a & <b>']
+        ])).toBe(writer);
+        expect(writer.nextSheet().writeRows([[], ['more']])).toBe(writer);
+        expect(writer.closeSync()).toBe(writer);
+        shouldThrow(writer.writeRows, writer, [[1]]);
+        shouldThrow(writer.closeSync, writer);
+
+        var rows = xl.streamXlsx(file).nextSync();
+
+        expect(rows).toEqual([
+            {row: 0, values: []},
+            {row: 1, values: [1.5, 'a & <b>', true, null, 36526]},
+            {row: 2, values: [2, 'a & <b>']}
+        ]);
+
+        var book = new xl.Book(xl.BOOK_TYPE_XLSX),
+            cellFormat = {};
+
+        book.loadSync(file);
+        expect(book.sheetCount()).toBe(3);
+        expect(book.getSheet(0).readNum(1, 0, cellFormat)).toBe(1.5);
+        expect(book.customNumFormat(cellFormat.format.numFormat())).toBe('0.000');
+        expect(cellFormat.format.font().bold()).toBe(true);
+        expect(book.getSheet(1).readStr(1, 0)).toBe('more');
+
+        runs(function() {
+            writer = xl.createXlsxStreamWriter(file);
+            writer.writeRows([[], ['async']]);
+
+            shouldThrow(writer.close, writer);
+
+            writer.close(function(err) {
+                result = err || 'closed';
+            });
+
+            shouldThrow(writer.writeRows, writer, [[1]]);
+        });
+
+        waitsFor(function() {
+            return result !== null;
+        }, 'writer to close', 1000);
+
+        runs(function() {
+            expect(result).toBe('closed');
+            expect(xl.streamXlsx(file).nextSync()[1].values).toEqual(['async']);
+        });
+    });
+
+    it('xl.BookCache shares loaded books between callers', function() {
+        var file = path.join(testUtils.getOutputDir(), 'cache.xls'),
+            book = new xl.Book(xl.BOOK_TYPE_XLS),
+            cache = new xl.BookCache({maxBooks: 1}),
+            first, second, results = [];
+
+        book.addSheet('foo').writeNum(1, 0, 10);
+        book.writeSync(file);
+
+        first = cache.loadSync(file);
+        expect(cache.loadSync(file)).toBe(first);
+        expect(first.getSheet(0).readNum(1, 0)).toBe(10);
+
+        second = cache.loadSync(book.writeRawSync());
+        expect(second).not.toBe(first);
+        expect(cache.loadSync(new Buffer(book.writeRawSync()))).toBe(second);
+        expect(cache.loadSync(file)).not.toBe(first);
+
+        var stats = cache.stats();
+        expect(stats.books).toBe(1);
+        expect(stats.hits).toBe(2);
+        expect(stats.misses).toBe(3);
+        expect(stats.bytes).toBeGreaterThan(0);
+
+        shouldThrow(cache.loadSync, cache, path.join(testUtils.getOutputDir(), 'missing.xls'));
+        shouldThrow(cache.loadSync, cache, new Buffer('nope'));
+        expect(function() {new xl.BookCache({maxBooks: -1});}).toThrow();
+
+        runs(function() {
+            cache.clear();
+            expect(cache.stats().books).toBe(0);
+
+            var collect = function(err, book) {
+                results.push([err, book]);
+            };
+
+            cache.load(file, collect);
+            cache.load(file, collect);
+            expect(cache.stats().loading).toBe(1);
+        });
+
+        waitsFor(function() {
+            return results.length === 2;
+        }, 'the cache to load', 1000);
+
+        runs(function() {
+            expect(results[0][0]).toBeUndefined();
+            expect(results[0][1]).toBe(results[1][1]);
+            expect(results[0][1].getSheet(0).readNum(1, 0)).toBe(10);
+            expect(cache.loadSync(file)).toBe(results[0][1]);
+            expect(cache.stats().loading).toBe(0);
+
+            var cached = results[0][1];
+            expect(cached.isReadOnly()).toBe(true);
+            expect(book.isReadOnly()).toBe(false);
+
+            shouldThrow(cached.getSheet(0).setName, cached.getSheet(0), 'bar');
+            shouldThrow(cached.getSheet(0).writeNum, cached.getSheet(0), 1, 0, 20);
+            shouldThrow(cached.format(0).setWrap, cached.format(0), true);
+            shouldThrow(cached.addSheet, cached, 'bar');
+            shouldThrow(cached.loadSync, cached, file);
+            expect(cached.getSheet(0).name()).toBe('foo');
+            expect(cached.getSheet(0).readNum(1, 0)).toBe(10);
+            expect(cached.isDirty()).toBe(false);
+
+            // Cached books can still be copied from
+            var range = {rowFirst: 1, rowLast: 1, colFirst: 0, colLast: 0};
+            cached.getSheet(0).copyRange(range, 2, 0, {targetSheet: book.getSheet(0)});
+            expect(book.getSheet(0).readNum(2, 0)).toBe(10);
+            shouldThrow(book.getSheet(0).copyRange, book.getSheet(0), range, 2, 0,
+                {targetSheet: cached.getSheet(0)});
+
+            expect(cache.loadSync(file)).toBe(cached);
+        });
+    });
+
+    it('xl.splitBook writes every sheet into a separate file', function() {
+        var book = new xl.Book(xl.BOOK_TYPE_XLS),
+            outDir = testUtils.getOutputDir(),
+            result = null,
+            files = null;
+
+        book.addSheet('foo').writeNum(1, 0, 1);
+        book.addSheet('bar').writeStr(1, 0, 'bar');
+        book.addSheet('a/b').writeFormula(1, 0, '1+1');
+        book.addSheet('a:b').writeNum(1, 0, 2);
+
+        var buffer = book.writeRawSync();
+
+        runs(function() {
+            var cb = function() {};
+
+            shouldThrow(xl.splitBook, xl, 1, {outDir: outDir}, cb);
+            shouldThrow(xl.splitBook, xl, buffer, {}, cb);
+            shouldThrow(xl.splitBook, xl, buffer, {outDir: outDir, format: 'csv'}, cb);
+            shouldThrow(xl.splitBook, xl, buffer, {outDir: outDir, concurrency: 'a'}, cb);
+            shouldThrow(xl.splitBook, xl, buffer, {outDir: outDir});
+
+            xl.splitBook(buffer, {outDir: outDir, format: 'xls', concurrency: 2},
+                function(err, res) {
+                    result = err;
+                    files = res;
+                }
+            );
+        });
+
+        waitsFor(function() {
+            return files !== null || result !== null;
+        }, 'book to split', 5000);
+
+        runs(function() {
+            expect(result).toBeUndefined();
+            expect(files).toEqual([
+                path.join(outDir, 'foo.xls'),
+                path.join(outDir, 'bar.xls'),
+                path.join(outDir, 'a_b.xls'),
+                path.join(outDir, 'a_b_3.xls')
+            ]);
+
+            var part = new xl.Book(xl.BOOK_TYPE_XLS);
+
+            part.loadSync(files[0]);
+            expect(part.sheetCount()).toBe(1);
+            expect(part.getSheet(0).name()).toBe('foo');
+            expect(part.getSheet(0).readNum(1, 0)).toBe(1);
+
+            part.loadSync(files[1]);
+            expect(part.getSheet(0).readStr(1, 0)).toBe('bar');
+
+            part.loadSync(files[2]);
+            expect(part.getSheet(0).readFormula(1, 0)).toBe('1+1');
+
+            part.loadSync(files[3]);
+            expect(part.getSheet(0).readNum(1, 0)).toBe(2);
+        });
+
+        runs(function() {
+            result = files = null;
+            xl.splitBook(path.join(outDir, 'missing.xls'), {outDir: outDir},
+                function(err) {
+                    result = err;
+                }
+            );
+        });
+
+        waitsFor(function() {
+            return result !== null;
+        }, 'split to fail', 1000);
+
+        runs(function() {
+            expect(result instanceof Error).toBe(true);
+        });
+    });
+
+});
@@ -64,6 +64,117 @@ describe('The sheet class', function() {
         expect(sheet.setCellFormat(row, 0, format)).toBe(sheet);
     });
 
+    it('sheet.setRangeFormat sets the format of a range', function() {
+        var sheet = newSheet(),
+            range = {rowFirst: 1, rowLast: 3, colFirst: 1, colLast: 2},
+            bold = book.addFormat().setFont(book.addFont().setBold(true));
+
+        sheet.writeNum(2, 2, 10);
+
+        expect(function() {sheet.setRangeFormat(range);}).toThrow();
+        expect(function() {sheet.setRangeFormat(range, wrongFormat);}).toThrow();
+        expect(function() {sheet.setRangeFormat.call({}, range, bold);}).toThrow();
+
+        expect(sheet.setRangeFormat(range, bold)).toBe(sheet);
+
+        expect(sheet.cellFormat(1, 1).font().bold()).toBe(true);
+        expect(sheet.cellFormat(3, 2).font().bold()).toBe(true);
+        expect(sheet.readNum(2, 2)).toBe(10);
+    });
+
+    it('sheet.applyStyles applies formats, bands and borders', function() {
+        var sheet = newSheet(),
+            range = {rowFirst: 1, rowLast: 4, colFirst: 1, colLast: 3},
+            even = book.addFormat().setFillPattern(xl.FILLPATTERN_SOLID),
+            odd = book.addFormat().setPatternForegroundColor(xl.COLOR_RED),
+            formatCount;
+
+        expect(function() {sheet.applyStyles();}).toThrow();
+        expect(function() {sheet.applyStyles([{format: even}]);}).toThrow();
+        expect(function() {sheet.applyStyles([{range: range}]);}).toThrow();
+        expect(function() {sheet.applyStyles([{range: range, format: wrongFormat}]);}).toThrow();
+        expect(function() {sheet.applyStyles([{range: range, formats: []}]);}).toThrow();
+        expect(function() {
+            sheet.applyStyles([{range: range, formats: [even], bandBy: 'foo'}]);
+        }).toThrow();
+        expect(function() {sheet.applyStyles.call({}, []);}).toThrow();
+
+        formatCount = book.formatSize();
+
+        expect(sheet.applyStyles([
+            {range: range, formats: [even, odd]},
+            {range: range, border: xl.BORDERSTYLE_THIN, borderColor: xl.COLOR_BLUE}
+        ])).toBe(sheet);
+
+        expect(sheet.cellFormat(2, 2).patternForegroundColor()).toBe(xl.COLOR_RED);
+        expect(sheet.cellFormat(3, 2).fillPattern()).toBe(xl.FILLPATTERN_SOLID);
+        expect(sheet.cellFormat(2, 2).borderLeft()).toBe(xl.BORDERSTYLE_NONE);
+
+        var corner = sheet.cellFormat(1, 1);
+        expect(corner.borderLeft()).toBe(xl.BORDERSTYLE_THIN);
+        expect(corner.borderTop()).toBe(xl.BORDERSTYLE_THIN);
+        expect(corner.borderRight()).toBe(xl.BORDERSTYLE_NONE);
+        expect(corner.borderLeftColor()).toBe(xl.COLOR_BLUE);
+        expect(corner.fillPattern()).toBe(xl.FILLPATTERN_SOLID);
+
+        expect(sheet.cellFormat(4, 3).borderBottom()).toBe(xl.BORDERSTYLE_THIN);
+        expect(sheet.cellFormat(4, 3).borderRight()).toBe(xl.BORDERSTYLE_THIN);
+
+        // Border variants are shared: top row (3) + left / right edges of
+        // both bands (4) + bottom row (3)
+        expect(book.formatSize() - formatCount).toBe(10);
+
+        sheet.applyStyles([{range: range, formats: [even, odd], bandBy: 'columns'}]);
+        expect(sheet.cellFormat(2, 2).patternForegroundColor()).toBe(xl.COLOR_RED);
+        expect(sheet.cellFormat(2, 3).fillPattern()).toBe(xl.FILLPATTERN_SOLID);
+    });
+
+    it('sheet.styleByRules formats cells depending on their values', function() {
+        var sheet = newSheet(),
+            range = {rowFirst: 1, rowLast: 5, colFirst: 0, colLast: 0},
+            negative = book.addFormat().setPatternForegroundColor(xl.COLOR_RED),
+            date = book.addFormat().setNumFormat(xl.NUMFORMAT_DATE),
+            overdue = book.addFormat(date).setPatternForegroundColor(xl.COLOR_YELLOW),
+            marked = book.addFormat().setPatternForegroundColor(xl.COLOR_BLUE),
+            today = book.datePack(2015, 6, 1);
+
+        sheet
+            .writeNum(1, 0, -5)
+            .writeNum(2, 0, 5)
+            .writeNum(3, 0, book.datePack(2015, 1, 1), date)
+            .writeNum(4, 0, book.datePack(2016, 1, 1), date)
+            .writeStr(5, 0, 'x');
+
+        expect(function() {sheet.styleByRules(range);}).toThrow();
+        expect(function() {sheet.styleByRules(range, [{format: negative}]);}).toThrow();
+        expect(function() {sheet.styleByRules(range, [{when: {}}]);}).toThrow();
+        expect(function() {
+            sheet.styleByRules(range, [{when: {op: '<>', value: 0}, format: negative}]);
+        }).toThrow();
+        expect(function() {
+            sheet.styleByRules(range, [{when: {op: '<'}, format: negative}]);
+        }).toThrow();
+        expect(function() {
+            sheet.styleByRules(range, [{when: {isDate: 1}, format: negative}]);
+        }).toThrow();
+        expect(function() {
+            sheet.styleByRules(range, [{when: {}, format: wrongFormat}]);
+        }).toThrow();
+        expect(function() {sheet.styleByRules.call({}, range, []);}).toThrow();
+
+        expect(sheet.styleByRules(range, [
+            {when: {isDate: true, op: '<', value: today}, format: overdue},
+            {when: {isDate: false, op: '<', value: 0}, format: negative},
+            {when: {op: '==', value: 'x'}, format: marked}
+        ])).toBe(sheet);
+
+        expect(sheet.cellFormat(1, 0).patternForegroundColor()).toBe(xl.COLOR_RED);
+        expect(sheet.cellFormat(2, 0).patternForegroundColor()).not.toBe(xl.COLOR_RED);
+        expect(sheet.cellFormat(3, 0).patternForegroundColor()).toBe(xl.COLOR_YELLOW);
+        expect(sheet.cellFormat(4, 0).patternForegroundColor()).not.toBe(xl.COLOR_YELLOW);
+        expect(sheet.cellFormat(5, 0).patternForegroundColor()).toBe(xl.COLOR_BLUE);
+    });
+
     it('sheet.readStr reads a string', function() {
         sheet.writeStr(row, 0, 'foo');
         sheet.writeNum(row, 1, 10);
@@ -184,6 +295,103 @@ describe('The sheet class', function() {
         row++;
     });
 
+    it('sheet.fillFormula fills a column with a shifted formula', function() {
+        var sheet = newSheet(),
+            percent = book.addFormat().setNumFormat(xl.NUMFORMAT_PERCENT);
+        book.addSheet('Q1 data');
+
+        expect(function() {sheet.fillFormula('B2*C2', 1, 3);}).toThrow();
+        expect(function() {sheet.fillFormula('B2*C2', 3, 1, 0);}).toThrow();
+        expect(function() {sheet.fillFormula('B2*C2', 1, 3, 0, {format: wrongFormat});}).toThrow();
+        expect(function() {sheet.fillFormula.call({}, 'B2*C2', 1, 3, 0);}).toThrow();
+
+        expect(sheet.fillFormula(
+            'B2*$C$2+SUM(B$2:B2)+LOG10(A1)+\'Q1 data\'!D2+"B2"', 1, 3, 0,
+            {format: percent})).toBe(sheet);
+
+        expect(sheet.readFormula(1, 0)).toBe(
+            'B2*$C$2+SUM(B$2:B2)+LOG10(A1)+\'Q1 data\'!D2+"B2"');
+        expect(sheet.readFormula(3, 0)).toBe(
+            'B4*$C$2+SUM(B$2:B4)+LOG10(A3)+\'Q1 data\'!D4+"B2"');
+        expect(sheet.cellType(4, 0)).toBe(xl.CELLTYPE_EMPTY);
+
+        var formatRef = {};
+        sheet.readFormula(2, 0, formatRef);
+        expect(formatRef.format.numFormat()).toBe(xl.NUMFORMAT_PERCENT);
+
+        // References moved past the last row become #REF!
+        sheet.fillFormula('B65535+B$2+C65536', 65533, 65535, 0);
+        expect(sheet.readFormula(65534, 0)).toBe('B65536+B$2+#REF!');
+        expect(sheet.readFormula(65535, 0)).toBe('#REF!+B$2+#REF!');
+
+        // Rejected calls leave the book unmodified
+        var cleanBook = new xl.Book(xl.BOOK_TYPE_XLS),
+            cleanSheet = cleanBook.addSheet('clean'),
+            range = {rowFirst: 1, rowLast: 2, colFirst: 0, colLast: 0};
+
+        cleanBook.writeRawSync();
+        expect(function() {cleanSheet.fillFormula('B2', 3, 1, 0);}).toThrow();
+        expect(function() {cleanSheet.applyStyles([{range: range, formats: []}]);}).toThrow();
+        expect(function() {cleanSheet.styleByRules(range, [{when: {op: '?'}}]);}).toThrow();
+        expect(cleanBook.isDirty()).toBe(false);
+    });
+
+    it('sheet.evaluateFormulas computes formulas natively', function() {
+        var formulaBook = new xl.Book(xl.BOOK_TYPE_XLS),
+            sheet = formulaBook.addSheet('Formulas'),
+            other = formulaBook.addSheet('Other data'),
+            percent = formulaBook.addFormat()
+                .setNumFormat(xl.NUMFORMAT_PERCENT);
+
+        sheet
+            .writeNum(1, 0, 1)
+            .writeNum(2, 0, 2)
+            .writeStr(3, 0, 'text')
+            .writeNum(4, 0, 2.675);
+        other.writeNum(1, 1, 10);
+
+        // Dependencies are written before their precedents
+        sheet
+            .writeFormula(1, 2, 'B2*2+SUM(A2:A4)', percent)
+            .writeFormula(1, 1, 'AVERAGE(A2:A4)+\'Other data\'!B2')
+            .writeFormula(2, 1, 'IF(MAX(A2:A3)>=2,"big "&COUNT(A2:A5),"small")')
+            .writeFormula(3, 1, 'ROUND(A5,2)*2^-1')
+            .writeFormula(4, 1, 'MIN(A2:A5)/0')
+            .writeFormula(5, 1, 'B7+1')
+            .writeFormula(6, 1, 'B6+1')
+            .writeFormula(7, 1, 'LOG10(A2)');
+
+        expect(function() {sheet.evaluateFormulas();}).toThrow();
+        expect(function() {sheet.evaluateFormulas({rowFirst: 1, rowLast: 7, colFirst: 1, colLast: 2}, {write: 1});}).toThrow();
+        expect(function() {sheet.evaluateFormulas.call({}, {rowFirst: 1, rowLast: 7, colFirst: 1, colLast: 2});}).toThrow();
+
+        formulaBook.writeRawSync();
+
+        var range = {rowFirst: 1, rowLast: 7, colFirst: 0, colLast: 1};
+        expect(sheet.evaluateFormulas(range)).toEqual([
+            [null, 11.5],
+            [null, 'big 3'],
+            [null, 1.34],
+            [null, '#DIV/0!'],
+            [null, '#CYCLE!'],
+            [null, '#CYCLE!'],
+            [null, '#NAME?']
+        ]);
+        expect(sheet.isFormula(1, 1)).toBe(true);
+        expect(formulaBook.isDirty()).toBe(false);
+
+        range = {rowFirst: 1, rowLast: 2, colFirst: 1, colLast: 2};
+        expect(sheet.evaluateFormulas(range, {write: true})).toEqual([
+            [11.5, 26], ['big 3', null]
+        ]);
+        expect(formulaBook.isDirty()).toBe(true);
+        expect(sheet.isFormula(1, 2)).toBe(false);
+        expect(sheet.readNum(1, 2)).toBe(26);
+        expect(sheet.cellFormat(1, 2).numFormat()).toBe(xl.NUMFORMAT_PERCENT);
+        expect(sheet.readStr(2, 1)).toBe('big 3');
+        expect(sheet.isFormula(4, 1)).toBe(true);
+    });
+
     it('sheet.writeComment writes a comment', function() {
         expect(function() {sheet.writeComment();}).toThrow();
         expect(function() {sheet.writeComment.call({}, row, 0, 'comment');}).toThrow();
@@ -302,6 +510,104 @@ describe('The sheet class', function() {
         expect(sheet.colHidden(0)).toBe(false);
     });
 
+    it('sheet.getLayout and sheet.setLayout read and write layout in bulk', function() {
+        var sheet = newSheet(),
+            range = {rowFirst: 1, rowLast: 3, colFirst: 2, colLast: 3};
+
+        sheet
+            .setRow(2, 30, format, true)
+            .setCol(3, 3, 25);
+
+        expect(function() {sheet.getLayout();}).toThrow();
+        expect(function() {sheet.getLayout.call({}, range);}).toThrow();
+
+        var layout = sheet.getLayout(range);
+        expect(layout.rowHeight instanceof Float64Array).toBe(true);
+        expect(layout.rowHeight.length).toBe(3);
+        expect(layout.rowHeight[1]).toBe(30);
+        expect(Array.prototype.slice.call(layout.rowHidden)).toEqual([0, 1, 0]);
+        expect(layout.colWidth.length).toBe(2);
+        expect(layout.colWidth[1]).toBeCloseTo(25, 1);
+        expect(Array.prototype.slice.call(layout.colHidden)).toEqual([0, 0]);
+
+        shouldThrow(sheet.setLayout, sheet, range, {rowHeight: [1, 2]});
+        shouldThrow(sheet.setLayout, sheet, range, {colWidth: ['a', 'b']});
+        shouldThrow(sheet.setLayout, sheet, range, {colFormat: [wrongFormat, null]});
+        shouldThrow(sheet.setLayout, {}, range, {});
+
+        expect(sheet.setLayout(range, {
+            rowHeight: new Float64Array([20, 21, 22]),
+            colHidden: [true, false],
+            colFormat: [format, null]
+        })).toBe(sheet);
+
+        expect(sheet.rowHeight(1)).toBe(20);
+        expect(sheet.rowHeight(3)).toBe(22);
+        expect(sheet.rowHidden(2)).toBe(true);
+        expect(sheet.colHidden(2)).toBe(true);
+        expect(sheet.colHidden(3)).toBe(false);
+        expect(sheet.colWidth(3)).toBeCloseTo(25, 1);
+
+        // Hiding rows keeps their automatic height
+        var xlsxBook = new xl.Book(xl.BOOK_TYPE_XLSX),
+            xlsxSheet = xlsxBook.addSheet('foo').writeStr(2, 0, 'foo').writeStr(3, 0, 'bar');
+
+        xlsxSheet.setLayout({rowFirst: 2, rowLast: 3, colFirst: 0, colLast: 0}, {
+            rowHidden: [1, 0]
+        });
+        expect(xlsxSheet.rowHidden(2)).toBe(true);
+        expect(xlsxSheet.rowHidden(3)).toBe(false);
+
+        var xml = testUtils.readZipEntry(xlsxBook.writeRawSync(), 'xl/worksheets/sheet1.xml');
+        expect(xml).toMatch(/<row r="3" hidden="(true|1)">/);
+        expect(xml).not.toMatch(/<row r="[34]"[^>]*customHeight/);
+    });
+
+    it('sheet.autoFitColumns sizes columns to their content', function() {
+        var sheet = newSheet(),
+            range = {rowFirst: 1, rowLast: 2, colFirst: 0, colLast: 4},
+            bold = book.addFormat().setFont(book.addFont().setBold(true)),
+            percent = book.addFormat().setNumFormat(xl.NUMFORMAT_PERCENT_D2);
+
+        sheet
+            .writeStr(1, 0, 'a rather long piece of text')
+            .writeStr(2, 0, 'short')
+            .writeStr(1, 1, 'abc')
+            .writeStr(1, 2, 'abc', bold)
+            .writeNum(1, 3, 0.5, percent)
+            .setCol(4, 4, 17);
+
+        expect(function() {sheet.autoFitColumns();}).toThrow();
+        expect(function() {sheet.autoFitColumns(range, {min: 'a'});}).toThrow();
+        expect(function() {sheet.autoFitColumns.call({}, range);}).toThrow();
+
+        expect(sheet.autoFitColumns(range)).toBe(sheet);
+
+        expect(sheet.colWidth(0)).toBeGreaterThan(20);
+        expect(sheet.colWidth(0)).toBeLessThan(30);
+        expect(sheet.colWidth(1)).toBeLessThan(5);
+        expect(sheet.colWidth(2)).toBeGreaterThan(sheet.colWidth(1));
+        // "50.00%"
+        expect(sheet.colWidth(3)).toBeGreaterThan(6);
+        expect(sheet.colWidth(3)).toBeLessThan(8);
+        expect(sheet.colWidth(4)).toBeCloseTo(17, 1);
+
+        sheet.autoFitColumns(range, {min: 5, max: 10, padding: 0});
+        expect(sheet.colWidth(0)).toBeCloseTo(10, 1);
+        expect(sheet.colWidth(1)).toBeCloseTo(5, 1);
+
+        // Cells merged across columns are skipped, those below them are not
+        sheet
+            .writeStr(1, 5, 'a rather long piece of text')
+            .setMerge(1, 2, 5, 6)
+            .writeStr(3, 5, 'abc')
+            .writeStr(3, 6, 'a bit longer');
+        sheet.autoFitColumns({rowFirst: 1, rowLast: 3, colFirst: 5, colLast: 6});
+        expect(sheet.colWidth(5)).toBeLessThan(5);
+        expect(sheet.colWidth(6)).toBeGreaterThan(sheet.colWidth(5));
+        expect(sheet.colWidth(6)).toBeLessThan(20);
+    });
+
     it('sheet.setMerge, sheet.getMerge and sheet.delMerge manage merged cells', function() {
         shouldThrow(sheet.getMerge, sheet, row, 0);
         shouldThrow(sheet.delMerge, sheet, row, 0);
@@ -614,6 +920,260 @@ describe('The sheet class', function() {
         row++;
     });
 
+    it('sheet.copyRange copies a block of cells', function() {
+        var sheet = newSheet(),
+            range = {rowFirst: 1, rowLast: 2, colFirst: 0, colLast: 1},
+            targetBook = new xl.Book(xl.BOOK_TYPE_XLSX),
+            targetSheet = targetBook.addSheet('foo'),
+            boldFormat = book.addFormat();
+
+        boldFormat.setFont(book.addFont().setBold(true));
+
+        sheet
+            .writeStr(1, 0, 'foo', boldFormat)
+            .writeNum(1, 1, 10)
+            .writeBool(2, 0, true)
+            .writeFormula(2, 1, '=B2*2');
+
+        shouldThrow(sheet.copyRange, sheet, {rowFirst: 1}, 3, 0);
+        shouldThrow(sheet.copyRange, sheet, range, 3, 'a');
+        shouldThrow(sheet.copyRange, sheet, range, 3, 0, {targetSheet: 1});
+        shouldThrow(sheet.copyRange, sheet, range, 3, 0, {values: 1});
+        shouldThrow(sheet.copyRange, {}, range, 3, 0);
+
+        expect(sheet.copyRange(range, 3, 0)).toBe(sheet);
+        expect(sheet.readStr(3, 0)).toBe('foo');
+        expect(sheet.readNum(3, 1)).toBe(10);
+        expect(sheet.readBool(4, 0)).toBe(true);
+        expect(sheet.readFormula(4, 1)).toBe('B2*2');
+
+        expect(sheet.copyRange(range, 5, 0, {formulas: false})).toBe(sheet);
+        expect(sheet.isFormula(6, 1)).toBe(false);
+
+        expect(sheet.copyRange(range, 1, 0, {targetSheet: targetSheet}))
+            .toBe(sheet);
+        expect(targetSheet.readStr(1, 0)).toBe('foo');
+        expect(targetSheet.cellFormat(1, 0).font().bold()).toBe(true);
+        expect(targetSheet.readFormula(2, 1)).toBe('B2*2');
+
+        expect(sheet.copyRange(range, 4, 0,
+            {targetSheet: targetSheet, formats: false})).toBe(sheet);
+        expect(targetSheet.cellFormat(4, 0).font().bold()).toBe(false);
+
+        expect(sheet.copyRange(range, 2, 1)).toBe(sheet);
+        expect(sheet.readStr(2, 1)).toBe('foo');
+        expect(sheet.readNum(2, 2)).toBe(10);
+        expect(sheet.readBool(3, 1)).toBe(true);
+    });
+
+    it('sheet.createRolloverWriter appends rows to a series of sheets', function() {
+        var book = new xl.Book(xl.BOOK_TYPE_XLS),
+            sheet = book.addSheet('Data'),
+            last = book.addSheet('Last'),
+            numFormat = book.addFormat();
+
+        numFormat.setNumFormat(xl.NUMFORMAT_NUMBER_D2);
+        sheet.writeStr(1, 0, 'id').writeStr(1, 1, 'name').setCol(1, 1, 30);
+
+        shouldThrow(sheet.createRolloverWriter, sheet, {maxRows: 70000});
+        shouldThrow(sheet.createRolloverWriter, sheet, {headerRows: 3, maxRows: 3});
+        shouldThrow(sheet.createRolloverWriter, sheet, {columnFormats: [wrongFormat]});
+        shouldThrow(sheet.createRolloverWriter, sheet, {columnFormats: [1]});
+        shouldThrow(sheet.createRolloverWriter, {});
+
+        var writer = sheet.createRolloverWriter({
+            headerRows: 2, maxRows: 4, columnFormats: [numFormat]
+        });
+
+        shouldThrow(writer.writeRows, writer, [1]);
+        shouldThrow(writer.writeRows, writer, [[{}]]);
+
+        expect(writer.writeRows([[1, 'a'], [2, 'b']])).toBe(writer);
+        expect(writer.sheetCount()).toBe(1);
+        expect(writer.rowCount()).toBe(4);
+        expect(sheet.readStr(3, 1)).toBe('b');
+        expect(sheet.cellFormat(2, 0).numFormat()).toBe(xl.NUMFORMAT_NUMBER_D2);
+
+        writer.writeRows([[3, 'c'], [4, null, true], [5, 'e']]);
+
+        expect(writer.sheetCount()).toBe(3);
+        expect(writer.rowCount()).toBe(3);
+        expect(writer.sheet().name()).toBe('Data (3)');
+        expect(book.sheetCount()).toBe(4);
+        expect(book.getSheet(3).name()).toBe('Last');
+
+        var second = book.getSheet(1);
+        expect(second.name()).toBe('Data (2)');
+        expect(second.readStr(1, 1)).toBe('name');
+        expect(second.readNum(2, 0)).toBe(3);
+        expect(second.readBool(3, 2)).toBe(true);
+        expect(second.cellType(3, 1)).toBe(xl.CELLTYPE_EMPTY);
+        expect(second.cellFormat(2, 0).numFormat()).toBe(xl.NUMFORMAT_NUMBER_D2);
+        expect(Math.round(second.colWidth(1))).toBe(30);
+        expect(book.getSheet(2).readStr(2, 1)).toBe('e');
+
+        // Sheets added for empty rows count as changes
+        book.writeRawSync();
+        writer.writeRows([[], []]);
+        expect(writer.sheetCount()).toBe(4);
+        expect(book.isDirty()).toBe(true);
+
+        // The default limit is the row limit of the format
+        sheet = book.addSheet('Full').writeNum(65535, 0, 1);
+        writer = sheet.createRolloverWriter({headerRows: 1})
+            .writeRows([['next']]);
+        expect(writer.sheet().name()).toBe('Full (2)');
+        expect(writer.sheet().readStr(1, 0)).toBe('next');
+    });
+
+    it('sheet.enableCache serves reads from a snapshot that follows writes', function() {
+        var sheet = newSheet(),
+            formatRef = {};
+
+        sheet
+            .writeNum(1, 0, 1.5, format)
+            .writeStr(1, 1, 'foo')
+            .writeBool(2, 0, true)
+            .writeNum(5, 3, 7);
+
+        shouldThrow(sheet.enableCache, sheet, {range: {rowFirst: 2, rowLast: 1, colFirst: 0, colLast: 0}});
+        shouldThrow(sheet.enableCache, {});
+        shouldThrow(sheet.disableCache, {});
+
+        expect(sheet.enableCache({range: {rowFirst: 1, rowLast: 3, colFirst: 0, colLast: 2}}))
+            .toBe(sheet);
+
+        expect(sheet.readNum(1, 0, formatRef)).toBe(1.5);
+        expect(formatRef.format.numFormat()).toBe(format.numFormat());
+        expect(sheet.readStr(1, 1)).toBe('foo');
+        expect(sheet.readBool(2, 0)).toBe(true);
+        expect(sheet.cellType(3, 2)).toBe(xl.CELLTYPE_EMPTY);
+        expect(sheet.cellType(1, 1)).toBe(xl.CELLTYPE_STRING);
+        expect(sheet.readNum(5, 3)).toBe(7);
+        shouldThrow(sheet.readStr, sheet, 1, 0);
+
+        sheet.writeStr(1, 0, 'bar').writeNum(3, 2, 2);
+        expect(sheet.readStr(1, 0)).toBe('bar');
+        expect(sheet.readNum(3, 2)).toBe(2);
+
+        sheet.insertRow(1, 1);
+        expect(sheet.readStr(2, 1)).toBe('foo');
+        expect(sheet.cellType(1, 1)).toBe(xl.CELLTYPE_EMPTY);
+
+        sheet.copyRange({rowFirst: 2, rowLast: 2, colFirst: 1, colLast: 1}, 1, 1);
+        expect(sheet.readStr(1, 1)).toBe('foo');
+
+        expect(sheet.enableCache()).toBe(sheet);
+        expect(sheet.readNum(6, 3)).toBe(7);
+        expect(sheet.disableCache()).toBe(sheet);
+        expect(sheet.readStr(2, 1)).toBe('foo');
+    });
+
+    it('sheet.exportCsvIncremental re-renders only the rows that changed', function() {
+        var sheet = new xl.Book(xl.BOOK_TYPE_XLS).addSheet('csv'), csv, lines;
+
+        sheet
+            .writeStr(1, 0, 'a,b')
+            .writeNum(1, 1, 1.5)
+            .writeBool(2, 0, true)
+            .writeStr(2, 1, 'x')
+            .writeStr(3, 0, 'q"q');
+
+        shouldThrow(sheet.exportCsvIncremental, sheet, 10);
+        shouldThrow(sheet.exportCsvIncremental, {});
+
+        csv = sheet.exportCsvIncremental();
+        lines = csv.split('\n');
+        expect(lines.slice(1)).toEqual(['"a,b",1.5', 'TRUE,x', '"q""q",', '']);
+
+        sheet.writeNum(2, 1, 7);
+        csv = sheet.exportCsvIncremental(csv);
+        expect(csv.split('\n').slice(1)).toEqual(['"a,b",1.5', 'TRUE,7', '"q""q",', '']);
+
+        sheet.insertRow(2, 2);
+        csv = sheet.exportCsvIncremental(csv);
+        expect(csv.split('\n').slice(1)).toEqual(['"a,b",1.5', ',', 'TRUE,7', '"q""q",', '']);
+
+        sheet.removeRow(1, 1);
+        sheet.writeStr(1, 1, 'new');
+        csv = sheet.exportCsvIncremental(csv);
+        expect(csv.split('\n').slice(1)).toEqual([',new', 'TRUE,7', '"q""q",', '']);
+
+        expect(sheet.exportCsvIncremental('unrelated')).toBe(csv);
+        expect(sheet.exportCsvIncremental(null)).toBe(csv);
+    });
+
+    it('sheet.applyPatch writes a batch of cells atomically', function() {
+        var book = new xl.Book(xl.BOOK_TYPE_XLS),
+            sheet = book.addSheet('patch'),
+            format = book.addFormat(),
+            formatIndex = book.formatSize() - 1,
+            result;
+
+        function patch(cells, strings) {
+            return {
+                row: new Int32Array(cells.map(function(c) {return c[0];})),
+                col: new Int32Array(cells.map(function(c) {return c[1];})),
+                type: new Uint8Array(cells.map(function(c) {return c[2];})),
+                number: new Float64Array(cells.map(function(c) {return c[3];})),
+                format: new Int32Array(cells.map(function(c) {return c[4];})),
+                strings: strings
+            };
+        }
+
+        sheet.writeNum(1, 0, 1);
+        format.setNumFormat(xl.NUMFORMAT_PERCENT);
+
+        expect(sheet.applyPatch(patch([
+            [1, 0, 1, 2.5, formatIndex],
+            [1, 1, 2, 1, -1],
+            [2, 0, 3, 1, -1],
+            [2, 1, 5, 0, -1],
+            [3, 0, 0, 0, formatIndex]
+        ], ['A1*2', 'foo']))).toBe(sheet);
+
+        expect(sheet.readNum(1, 0)).toBe(2.5);
+        expect(sheet.cellFormat(1, 0).numFormat()).toBe(xl.NUMFORMAT_PERCENT);
+        expect(sheet.readStr(1, 1)).toBe('foo');
+        expect(sheet.readBool(2, 0)).toBe(true);
+        expect(sheet.readFormula(2, 1)).toBe('A1*2');
+        expect(sheet.cellType(3, 0)).toBe(xl.CELLTYPE_BLANK);
+
+        shouldThrow(sheet.applyPatch, sheet, 1);
+        shouldThrow(sheet.applyPatch, sheet, {row: [1], col: [1], type: [1], number: [1]});
+        shouldThrow(sheet.applyPatch, sheet, patch([[1, 0, 1, 7, -1], [1, 1, 2, 5, -1]], ['x']));
+        shouldThrow(sheet.applyPatch, sheet, patch([[1, 0, 1, 7, -1], [-1, 0, 1, 1, -1]]));
+        shouldThrow(sheet.applyPatch, sheet, patch([[1, 0, 1, 7, -1], [1, 1, 4, 1, -1]]));
+        shouldThrow(sheet.applyPatch, sheet, patch([[1, 0, 1, 7, 1000]]));
+        shouldThrow(sheet.applyPatch, sheet, patch([[1, 0, 1, 7, -1]]), 1);
+        expect(sheet.readNum(1, 0)).toBe(2.5);
+
+        // The trial version refuses to write row 0, which exercises the
+        // rollback of cells that were already written
+        try {
+            sheet.applyPatch(patch([[1, 0, 1, 8, -1], [0, 5, 1, 9, -1]]));
+            expect(sheet.readNum(1, 0)).toBe(8);
+        } catch (e) {
+            expect(sheet.readNum(1, 0)).toBe(2.5);
+        }
+
+        runs(function() {
+            sheet.applyPatch(patch([[4, 0, 1, 42, -1]]), function(err) {
+                result = [err, sheet.readNum(4, 0)];
+            });
+
+            shouldThrow(sheet.readNum, sheet, 4, 0);
+        });
+
+        waitsFor(function() {
+            return !!result;
+        }, 'the patch to apply', 1000);
+
+        runs(function() {
+            expect(result).toEqual([undefined, 42]);
+        });
+    });
+
     it('sheet.firstRow, sheet.firstCol, sheet.lastRow, sheet.lastCol return ' +
         'the spreadsheet limits', function()
     {
@@ -1,5 +1,6 @@
 var path = require('path'),
-    fs = require('fs');
+    fs = require('fs'),
+    zlib = require('zlib');
 
 var outputDir = path.join(__dirname, 'output'),
     writeTestFile = path.join(outputDir, 'writetest.xls'),
@@ -21,6 +22,10 @@ module.exports = {
         return writeTestFile;
     },
 
+    getOutputDir: function() {
+        return outputDir;
+    },
+
     shouldThrow: function(fun, scope) {
         var args = Array.prototype.slice.call(arguments, 2);
 
@@ -41,6 +46,29 @@ module.exports = {
         return true;
     },
 
+    // Extracts a file from a zip archive like an XLSX book. Only handles
+    // archives that store the sizes in the local headers, like libxl does.
+    readZipEntry: function(buffer, name) {
+        var pos = 0;
+
+        while (pos + 30 <= buffer.length && buffer.readUInt32LE(pos) === 0x04034b50) {
+            var method = buffer.readUInt16LE(pos + 8),
+                size = buffer.readUInt32LE(pos + 18),
+                nameLength = buffer.readUInt16LE(pos + 26),
+                extraLength = buffer.readUInt16LE(pos + 28),
+                start = pos + 30 + nameLength + extraLength,
+                data = buffer.slice(start, start + size);
+
+            if (buffer.toString('utf8', pos + 30, pos + 30 + nameLength) === name) {
+                return (method === 8 ? zlib.inflateRawSync(data) : data).toString();
+            }
+
+            pos = start + size;
+        }
+
+        return null;
+    },
+
     testPictureWidth: 640,
     testPictureHeight: 480
 };
@@ -126,6 +126,261 @@ v8::Handle<v8::Value> ArgumentHelper::GetBuffer(uint8_t pos) {
 }
 
 
+v8::Handle<v8::Array> ArgumentHelper::GetArray(uint8_t pos) {
+    NanEscapableScope();
+
+    if (!arguments[pos]->IsArray()) {
+        RaiseException("array required at position", pos);
+        return NanEscapeScope(NanNew<v8::Array>());
+    }
+
+    return NanEscapeScope(arguments[pos].As<v8::Array>());
+}
+
+
+void ArgumentHelper::GetNumberArray(uint8_t pos,
+    std::vector<double>& values)
+{
+    NanScope();
+
+    v8::Handle<v8::Value> lengthValue = arguments[pos]->IsObject() ?
+        arguments[pos].As<v8::Object>()->Get(NanNew<v8::String>("length")) :
+        NanUndefined().As<v8::Value>();
+
+    if (!lengthValue->IsUint32()) {
+        RaiseException("array required at position", pos);
+        return;
+    }
+
+    values.resize(lengthValue->Uint32Value());
+
+    for (uint32_t i = 0; i < values.size(); i++) {
+        v8::Handle<v8::Value> value = arguments[pos].As<v8::Object>()->Get(i);
+
+        if (!value->IsNumber()) {
+            RaiseException("array of numbers required at position", pos);
+            return;
+        }
+
+        values[i] = value->NumberValue();
+    }
+}
+
+
+Range ArgumentHelper::GetRange(uint8_t pos) {
+    NanScope();
+
+    if (!arguments[pos]->IsObject()) {
+        RaiseException("range required at position", pos);
+        return Range();
+    }
+
+    Range range;
+    if (!ToRange(arguments[pos], range)) {
+        RaiseException("invalid range at position", pos);
+    }
+
+    return range;
+}
+
+
+// Converts an object with rowFirst, rowLast, colFirst and colLast properties
+bool ArgumentHelper::ToRange(v8::Handle<v8::Value> value, Range& range) {
+    NanScope();
+
+    if (!value->IsObject()) return false;
+
+    v8::Handle<v8::Object> object = value.As<v8::Object>();
+    const char* keys[] = {"rowFirst", "rowLast", "colFirst", "colLast"};
+    int values[4];
+
+    for (int i = 0; i < 4; i++) {
+        v8::Handle<v8::Value> property = object->Get(NanNew<v8::String>(keys[i]));
+        if (!property->IsInt32()) return false;
+
+        values[i] = property->Int32Value();
+    }
+
+    range = Range(values[0], values[1], values[2], values[3]);
+
+    return range.IsValid();
+}
+
+
+int ArgumentHelper::GetInt(uint8_t pos, const char* key, int def) {
+    NanScope();
+
+    v8::Handle<v8::Value> value = GetProperty(pos, key);
+    if (value->IsUndefined()) return def;
+
+    if (!value->IsInt32()) {
+        RaiseException(std::string("integer required for property ") + key +
+            " of argument", pos);
+        return def;
+    }
+
+    return value->Int32Value();
+}
+
+
+double ArgumentHelper::GetDouble(uint8_t pos, const char* key, double def) {
+    NanScope();
+
+    v8::Handle<v8::Value> value = GetProperty(pos, key);
+    if (value->IsUndefined()) return def;
+
+    if (!value->IsNumber()) {
+        RaiseException(std::string("number required for property ") + key +
+            " of argument", pos);
+        return def;
+    }
+
+    return value->NumberValue();
+}
+
+
+bool ArgumentHelper::GetBoolean(uint8_t pos, const char* key, bool def) {
+    NanScope();
+
+    v8::Handle<v8::Value> value = GetProperty(pos, key);
+    if (value->IsUndefined()) return def;
+
+    if (!value->IsBoolean()) {
+        RaiseException(std::string("bool required for property ") + key +
+            " of argument", pos);
+        return def;
+    }
+
+    return value->BooleanValue();
+}
+
+
+// A NULL default yields undefined for missing properties
+v8::Handle<v8::Value> ArgumentHelper::GetString(uint8_t pos, const char* key,
+    const char* def)
+{
+    NanEscapableScope();
+
+    v8::Handle<v8::Value> value = GetProperty(pos, key);
+
+    if (value->IsUndefined()) {
+        return def ?
+            NanEscapeScope(NanNew<v8::String>(def).As<v8::Value>()) :
+            NanEscapeScope(NanUndefined().As<v8::Value>());
+    }
+
+    if (!value->IsString()) {
+        RaiseException(std::string("string required for property ") + key +
+            " of argument", pos);
+    }
+
+    return NanEscapeScope(value);
+}
+
+
+bool ArgumentHelper::GetNumberArray(uint8_t pos, const char* key,
+    uint32_t length, std::vector<double>& values)
+{
+    NanScope();
+
+    v8::Handle<v8::Value> array = GetArrayProperty(pos, key, length);
+    if (array->IsUndefined()) return false;
+
+    values.resize(length);
+
+    for (uint32_t i = 0; i < length; i++) {
+        v8::Handle<v8::Value> value = array.As<v8::Object>()->Get(i);
+
+        if (!value->IsNumber() && !value->IsBoolean()) {
+            RaiseException(std::string("numbers required in property ") +
+                key + " of argument", pos);
+            return false;
+        }
+
+        values[i] = value->NumberValue();
+    }
+
+    return true;
+}
+
+
+bool ArgumentHelper::GetStringArray(uint8_t pos, const char* key,
+    std::vector<std::string>& values)
+{
+    NanScope();
+
+    v8::Handle<v8::Value> array = GetProperty(pos, key);
+    if (array->IsUndefined()) return false;
+
+    if (!array->IsArray()) {
+        RaiseException(std::string("array required for property ") + key +
+            " of argument", pos);
+        return false;
+    }
+
+    uint32_t length = array.As<v8::Array>()->Length();
+    values.resize(length);
+
+    for (uint32_t i = 0; i < length; i++) {
+        v8::Handle<v8::Value> value = array.As<v8::Object>()->Get(i);
+
+        if (!value->IsString()) {
+            RaiseException(std::string("strings required in property ") +
+                key + " of argument", pos);
+            return false;
+        }
+
+        values[i] = *v8::String::Utf8Value(value);
+    }
+
+    return true;
+}
+
+
+v8::Handle<v8::Value> ArgumentHelper::GetArrayProperty(uint8_t pos,
+    const char* key, uint32_t length)
+{
+    NanEscapableScope();
+
+    v8::Handle<v8::Value> value = GetProperty(pos, key);
+    if (value->IsUndefined()) return NanEscapeScope(value);
+
+    v8::Handle<v8::Value> lengthValue = value->IsObject() ?
+        value.As<v8::Object>()->Get(NanNew<v8::String>("length")) :
+        NanUndefined().As<v8::Value>();
+
+    if (!lengthValue->IsUint32() || lengthValue->Uint32Value() != length) {
+        std::stringstream ss;
+        ss << "array of length " << length << " required for property " <<
+            key << " of argument";
+
+        RaiseException(ss.str(), pos);
+        return NanEscapeScope(NanUndefined().As<v8::Value>());
+    }
+
+    return NanEscapeScope(value);
+}
+
+
+v8::Handle<v8::Value> ArgumentHelper::GetProperty(uint8_t pos,
+    const char* key)
+{
+    NanEscapableScope();
+
+    if (arguments[pos]->IsUndefined()) {
+        return NanEscapeScope(NanUndefined());
+    }
+
+    if (!arguments[pos]->IsObject()) {
+        RaiseException("object required at position", pos);
+        return NanEscapeScope(NanUndefined());
+    }
+
+    return NanEscapeScope(
+        arguments[pos].As<v8::Object>()->Get(NanNew<v8::String>(key)));
+}
+
+
 void ArgumentHelper::RaiseException(const std::string& message, int32_t pos) {
     NanEscapableScope();
 
@@ -26,8 +26,10 @@
 #define BINDINGS_ARGUMENT_HELPER_H
 
 #include <string>
+#include <vector>
 
 #include "common.h"
+#include "range.h"
 
 namespace node_libxl {
 
@@ -56,6 +58,35 @@ class ArgumentHelper {
         template<typename T> T* GetWrapped(uint8_t pos);
         template<typename T> T* GetWrapped(uint8_t pos, T* def);
 
+        v8::Handle<v8::Array> GetArray(uint8_t pos);
+
+        // Array or typed array of numbers
+        void GetNumberArray(uint8_t pos, std::vector<double>& values);
+
+        Range GetRange(uint8_t pos);
+        static bool ToRange(v8::Handle<v8::Value> value, Range& range);
+
+        // Accessors for the properties of an optional options object
+        int GetInt(uint8_t pos, const char* key, int def);
+        double GetDouble(uint8_t pos, const char* key, double def);
+        bool GetBoolean(uint8_t pos, const char* key, bool def);
+        v8::Handle<v8::Value> GetString(uint8_t pos, const char* key,
+            const char* def);
+        template<typename T> T* GetWrapped(uint8_t pos, const char* key,
+            T* def);
+
+        // Array (or typed array) properties of an exact length. Return
+        // false if the property is missing or invalid.
+        bool GetNumberArray(uint8_t pos, const char* key, uint32_t length,
+            std::vector<double>& values);
+        template<typename T> bool GetWrappedArray(uint8_t pos,
+            const char* key, uint32_t length, std::vector<T*>& values);
+
+        // Array of strings of any length. Returns false if the property is
+        // missing or invalid.
+        bool GetStringArray(uint8_t pos, const char* key,
+            std::vector<std::string>& values);
+
         bool HasException() const;
         _NAN_METHOD_RETURN_TYPE ThrowException() const;
 
@@ -67,6 +98,10 @@ class ArgumentHelper {
 
         void RaiseException(const std::string& message, int32_t pos = -1);
 
+        v8::Handle<v8::Value> GetProperty(uint8_t pos, const char* key);
+        v8::Handle<v8::Value> GetArrayProperty(uint8_t pos, const char* key,
+            uint32_t length);
+
         ArgumentHelper(const ArgumentHelper&);
         const ArgumentHelper& operator=(ArgumentHelper&);
 };
@@ -86,6 +121,49 @@ template<typename T> T* ArgumentHelper::GetWrapped(uint8_t pos, T* def) {
 }
 
 
+template<typename T> T* ArgumentHelper::GetWrapped(uint8_t pos,
+    const char* key, T* def)
+{
+    NanScope();
+
+    v8::Handle<v8::Value> value = GetProperty(pos, key);
+    if (value->IsUndefined()) return def;
+
+    T* unwrapped = T::Unwrap(value);
+    if (!unwrapped)
+        RaiseException(std::string("Invalid type for property ") + key +
+            " of argument", pos);
+    return unwrapped;
+}
+
+
+template<typename T> bool ArgumentHelper::GetWrappedArray(uint8_t pos,
+    const char* key, uint32_t length, std::vector<T*>& values)
+{
+    NanScope();
+
+    v8::Handle<v8::Value> array = GetArrayProperty(pos, key, length);
+    if (array->IsUndefined()) return false;
+
+    values.resize(length);
+
+    for (uint32_t i = 0; i < length; i++) {
+        v8::Handle<v8::Value> value = array.As<v8::Object>()->Get(i);
+
+        values[i] = (value->IsUndefined() || value->IsNull()) ?
+            NULL : T::Unwrap(value);
+
+        if (!values[i] && !value->IsUndefined() && !value->IsNull()) {
+            RaiseException(std::string("Invalid type in property ") + key +
+                " of argument", pos);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 }
 
 #endif // BINDINGS_ARGUMENT_HELPER_H
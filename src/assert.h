@@ -33,6 +33,9 @@
 #define ASSERT_THIS(THIS) if (!THIS) return(NanThrowTypeError("invalid scope")); \
     if (::node_libxl::util::GetBook(THIS)->AsyncPending()) return(NanThrowError("async operation pending"))
 
+#define ASSERT_WRITABLE(THIS) if (::node_libxl::util::GetBook(THIS)->ReadOnly()) \
+    return(NanThrowError("book is read-only"))
+
 #define ASSERT_SAME_BOOK(BOOK1, BOOK2) if ( \
     !::node_libxl::util::IsSameBook(BOOK1, BOOK2)) \
     return NanThrowTypeError("parent books differ")
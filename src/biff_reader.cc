@@ -0,0 +1,153 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "biff_reader.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const size_t BLOCK_SIZE = 256 * 1024;
+const size_t RECORD_HEADER_SIZE = 4;
+
+
+}
+
+
+BiffReader::BiffReader(CompoundFile::Stream& stream) :
+    stream(stream),
+    bufferOffset(0),
+    position(0),
+    recordOffset(0),
+    id(0)
+{}
+
+
+void BiffReader::Seek(uint64_t offset) {
+    position = offset;
+}
+
+
+bool BiffReader::Next() {
+    if (!Fill(position, RECORD_HEADER_SIZE)) return false;
+
+    const char* header = buffer.data() + (position - bufferOffset);
+    size_t length = ByteSource::Uint16(header + 2);
+
+    id = ByteSource::Uint16(header);
+
+    if (!Fill(position + RECORD_HEADER_SIZE, length)) return false;
+
+    data.assign(buffer, position + RECORD_HEADER_SIZE - bufferOffset, length);
+    recordOffset = position;
+    position += RECORD_HEADER_SIZE + length;
+
+    return true;
+}
+
+
+uint16_t BiffReader::Id() const {
+    return id;
+}
+
+
+const std::string& BiffReader::Data() const {
+    return data;
+}
+
+
+uint64_t BiffReader::Offset() const {
+    return recordOffset;
+}
+
+
+std::string BiffReader::DecodeCharacters(const char* data, size_t count,
+    bool wide)
+{
+    std::string out;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!wide) {
+            AppendUtf8(out, static_cast<unsigned char>(data[i]));
+            continue;
+        }
+
+        unsigned long code = ByteSource::Uint16(data + 2 * i);
+
+        // Surrogate pairs
+        if (code >= 0xD800 && code < 0xDC00 && i + 1 < count) {
+            unsigned long low = ByteSource::Uint16(data + 2 * (i + 1));
+
+            if (low >= 0xDC00 && low < 0xE000) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            }
+        }
+
+        AppendUtf8(out, code);
+    }
+
+    return out;
+}
+
+
+void BiffReader::AppendUtf8(std::string& out, unsigned long code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+
+// Makes sure that the buffer holds the given range of the stream
+bool BiffReader::Fill(uint64_t offset, size_t length) {
+    if (offset >= bufferOffset &&
+        offset + length <= bufferOffset + buffer.size())
+    {
+        return true;
+    }
+
+    if (offset + length > stream.Size()) return false;
+
+    bufferOffset = offset;
+
+    return stream.Read(offset, length > BLOCK_SIZE ? length : BLOCK_SIZE,
+        buffer) && buffer.size() >= length;
+}
+
+
+}
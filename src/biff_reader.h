@@ -0,0 +1,97 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_BIFF_READER_H
+#define BINDINGS_BIFF_READER_H
+
+#include <stdint.h>
+
+#include <string>
+
+#include "compound_file.h"
+
+namespace node_libxl {
+
+
+// Iterates over the records of a BIFF stream (the Workbook stream of XLS
+// files). The stream is read in large blocks.
+class BiffReader {
+    public:
+
+        enum {
+            RECORD_FORMULA = 0x0006,
+            RECORD_EOF = 0x000A,
+            RECORD_FILEPASS = 0x002F,
+            RECORD_CONTINUE = 0x003C,
+            RECORD_BOUNDSHEET = 0x0085,
+            RECORD_MULRK = 0x00BD,
+            RECORD_SST = 0x00FC,
+            RECORD_LABELSST = 0x00FD,
+            RECORD_DIMENSIONS = 0x0200,
+            RECORD_NUMBER = 0x0203,
+            RECORD_LABEL = 0x0204,
+            RECORD_BOOLERR = 0x0205,
+            RECORD_STRING = 0x0207,
+            RECORD_RK = 0x027E,
+            RECORD_BOF = 0x0809
+        };
+
+        explicit BiffReader(CompoundFile::Stream& stream);
+
+        void Seek(uint64_t offset);
+
+        // Reads the next record; returns false at the end of the stream
+        bool Next();
+
+        uint16_t Id() const;
+        const std::string& Data() const;
+
+        // Offset of the current record in the stream
+        uint64_t Offset() const;
+
+        // Decodes the characters of a BIFF8 string (compressed 8 bit or
+        // UTF-16LE, depending on the option flags) to UTF-8
+        static std::string DecodeCharacters(const char* data, size_t count,
+            bool wide);
+
+        static void AppendUtf8(std::string& out, unsigned long code);
+
+    private:
+
+        bool Fill(uint64_t offset, size_t length);
+
+        CompoundFile::Stream& stream;
+        std::string buffer;
+        uint64_t bufferOffset, position, recordOffset;
+        uint16_t id;
+        std::string data;
+
+        BiffReader(const BiffReader&);
+        const BiffReader& operator=(const BiffReader&);
+};
+
+
+}
+
+#endif // BINDINGS_BIFF_READER_H
@@ -27,6 +27,11 @@
 #include "sheet.h"
 #include "format.h"
 #include "font.h"
+#include "functions.h"
+#include "xlsx_stream.h"
+#include "xlsx_stream_writer.h"
+#include "rollover_writer.h"
+#include "book_cache.h"
 
 using namespace v8;
 using namespace node_libxl;
@@ -36,6 +41,11 @@ void Initialize(Handle<Object> exports) {
     Sheet::Initialize(exports);
     Format::Initialize(exports);
     Font::Initialize(exports);
+    Functions::Initialize(exports);
+    XlsxStream::Initialize(exports);
+    XlsxStreamWriter::Initialize(exports);
+    RolloverWriter::Initialize(exports);
+    BookCache::Initialize(exports);
 }
 
 NODE_MODULE(libxl, Initialize)
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cstring>
 
 #include "book.h"
@@ -35,6 +36,15 @@
 #include "async_worker.h"
 #include "string_copy.h"
 #include "buffer_copy.h"
+#include "sheet_import.h"
+#include "typed_array.h"
+#include "dependency_graph.h"
+#include "byte_source.h"
+#include "xlsx_subset.h"
+#include "sheet_cache.h"
+#include "sheet_journal.h"
+#include "hash.h"
+#include "picture_extract.h"
 
 using namespace v8;
 
@@ -46,11 +56,17 @@ namespace node_libxl {
 
 Book::Book(libxl::Book* libxlBook) :
     Wrapper<libxl::Book>(libxlBook),
-    asyncPending(false)
+    asyncPending(false),
+    readOnly(false),
+    generation(0),
+    cleanGeneration(0),
+    savedRawGeneration(0),
+    hashedPictures(0)
 {}
 
 
 Book::~Book() {
+    SheetsReplaced();
     wrapped->release();
 }
 
@@ -68,6 +84,33 @@ NAN_METHOD(Book::New) {
     int type = arguments.GetInt(0);
     ASSERT_ARGUMENTS(arguments);
 
+    if (type != BOOK_TYPE_XLS && type != BOOK_TYPE_XLSX) {
+        return NanThrowTypeError("invalid book type");
+    }
+
+    libxl::Book* libxlBook = CreateLibxlBook(type);
+
+    if (!libxlBook) {
+        return NanThrowError("unknown error");
+    }
+
+    Book* book = new Book(libxlBook);
+    book->Wrap(args.This());
+
+    NanReturnValue(args.This());
+}
+
+
+Handle<Object> Book::NewInstance(int type) {
+    NanEscapableScope();
+
+    Handle<Value> argv[1] = {NanNew<Integer>(type)};
+
+    return NanEscapeScope(NanNew(constructor)->NewInstance(1, argv));
+}
+
+
+libxl::Book* Book::CreateLibxlBook(int type) {
     libxl::Book* libxlBook;
 
     switch (type) {
@@ -78,22 +121,17 @@ NAN_METHOD(Book::New) {
             libxlBook = xlCreateXMLBook();
             break;
         default:
-            return NanThrowTypeError("invalid book type");
+            return NULL;
     }
 
-    if (!libxlBook) {
-        return NanThrowError("unknown error");
-    }
+    if (!libxlBook) return NULL;
 
     libxlBook->setLocale("UTF-8");
     #ifdef INCLUDE_API_KEY
         libxlBook->setKey(API_KEY_NAME, API_KEY_KEY);
     #endif
 
-    Book* book = new Book(libxlBook);
-    book->Wrap(args.This());
-
-    NanReturnValue(args.This());
+    return libxlBook;
 }
 
 
@@ -115,24 +153,275 @@ bool Book::AsyncPending() {
 }
 
 
+// Change tracking
+
+
+SheetCache* Book::GetSheetCache(libxl::Sheet* sheet) {
+    std::map<libxl::Sheet*, SheetCache*>::iterator it =
+        sheetCaches.find(sheet);
+
+    return it == sheetCaches.end() ? NULL : it->second;
+}
+
+
+void Book::SetSheetCache(libxl::Sheet* sheet, SheetCache* cache) {
+    delete GetSheetCache(sheet);
+
+    if (cache) {
+        sheetCaches[sheet] = cache;
+    } else {
+        sheetCaches.erase(sheet);
+    }
+}
+
+
+SheetJournal* Book::GetSheetJournal(libxl::Sheet* sheet) {
+    std::map<libxl::Sheet*, SheetJournal*>::iterator it =
+        sheetJournals.find(sheet);
+
+    return it == sheetJournals.end() ? NULL : it->second;
+}
+
+
+void Book::SetSheetJournal(libxl::Sheet* sheet, SheetJournal* journal) {
+    delete GetSheetJournal(sheet);
+
+    if (journal) {
+        sheetJournals[sheet] = journal;
+    } else {
+        sheetJournals.erase(sheet);
+    }
+}
+
+
+void Book::CellChanged(libxl::Sheet* sheet, int row, int col) {
+    Modified();
+
+    SheetCache* cache = GetSheetCache(sheet);
+    if (cache) cache->InvalidateCell(row, col);
+
+    SheetJournal* journal = GetSheetJournal(sheet);
+    if (journal) journal->RowsChanged(row, row);
+}
+
+
+void Book::RowsChanged(libxl::Sheet* sheet, int first, int last) {
+    Modified();
+
+    SheetCache* cache = GetSheetCache(sheet);
+    if (cache) cache->Invalidate();
+
+    SheetJournal* journal = GetSheetJournal(sheet);
+    if (journal) journal->RowsChanged(first, last);
+}
+
+
+void Book::RowsInserted(libxl::Sheet* sheet, int first, int last) {
+    Modified();
+
+    SheetCache* cache = GetSheetCache(sheet);
+    if (cache) cache->Invalidate();
+
+    SheetJournal* journal = GetSheetJournal(sheet);
+    if (journal) journal->RowsInserted(first, last);
+}
+
+
+void Book::RowsRemoved(libxl::Sheet* sheet, int first, int last) {
+    Modified();
+
+    SheetCache* cache = GetSheetCache(sheet);
+    if (cache) cache->Invalidate();
+
+    SheetJournal* journal = GetSheetJournal(sheet);
+    if (journal) journal->RowsRemoved(first, last);
+}
+
+
+void Book::FormatsChanged(libxl::Sheet* sheet) {
+    Modified();
+
+    SheetCache* cache = GetSheetCache(sheet);
+    if (cache) cache->Invalidate();
+}
+
+
+void Book::SheetChanged(libxl::Sheet* sheet) {
+    Modified();
+
+    SheetCache* cache = GetSheetCache(sheet);
+    if (cache) cache->Invalidate();
+
+    SheetJournal* journal = GetSheetJournal(sheet);
+    if (journal) journal->Invalidate();
+}
+
+
+void Book::SheetRemoved(libxl::Sheet* sheet) {
+    Modified();
+
+    SetSheetCache(sheet, NULL);
+    SetSheetJournal(sheet, NULL);
+}
+
+
+// Sheet pointers may be reused by libxl once sheets are gone
+void Book::SheetsReplaced() {
+    Modified();
+
+    std::map<libxl::Sheet*, SheetCache*>::iterator it;
+
+    for (it = sheetCaches.begin(); it != sheetCaches.end(); ++it) {
+        delete it->second;
+    }
+
+    std::map<libxl::Sheet*, SheetJournal*>::iterator jt;
+
+    for (jt = sheetJournals.begin(); jt != sheetJournals.end(); ++jt) {
+        delete jt->second;
+    }
+
+    sheetCaches.clear();
+    sheetJournals.clear();
+
+    pictureHashes.clear();
+    hashedPictures = 0;
+}
+
+
+void Book::Modified() {
+    generation++;
+}
+
+
+void Book::MarkClean() {
+    cleanGeneration = generation;
+}
+
+
+bool Book::Dirty() {
+    return generation != cleanGeneration;
+}
+
+
+void Book::SetReadOnly() {
+    readOnly = true;
+}
+
+
+bool Book::ReadOnly() {
+    return readOnly;
+}
+
+
+bool Book::HasSavedRaw() {
+    return savedRawGeneration == generation && !savedRaw.empty();
+}
+
+
+void Book::SetSavedRaw(const char* data, unsigned size) {
+    savedRaw.assign(data, size);
+    savedRawGeneration = generation;
+
+    MarkClean();
+}
+
+
+// Returns the index of a picture with the given contents or -1
+int Book::FindPicture(const char* data, unsigned size) {
+    int pictureCount = wrapped->pictureSize();
+    const char* pictureData;
+    unsigned pictureSize;
+
+    for (; hashedPictures < pictureCount; hashedPictures++) {
+        if (wrapped->getPicture(hashedPictures, &pictureData, &pictureSize) ==
+            libxl::PICTURETYPE_ERROR) continue;
+
+        pictureHashes.insert(std::make_pair(
+            HashBytes(pictureData, pictureSize), hashedPictures));
+    }
+
+    typedef std::multimap<uint64_t, int>::iterator Iterator;
+    std::pair<Iterator, Iterator> candidates =
+        pictureHashes.equal_range(HashBytes(data, size));
+
+    // Hash collisions are ruled out by comparing the contents
+    for (Iterator it = candidates.first; it != candidates.second; ++it) {
+        if (wrapped->getPicture(it->second, &pictureData, &pictureSize) !=
+                libxl::PICTURETYPE_ERROR &&
+            pictureSize == size && memcmp(pictureData, data, size) == 0)
+        {
+            return it->second;
+        }
+    }
+
+    return -1;
+}
+
+
 // Implementation
 
 
+namespace {
+
+
+const int DEFAULT_PREVIEW_ROWS = 100;
+
+
+// Loads an XLSX package with all worksheets but the selected ones replaced
+// by empty stubs, and optionally with the rows of the selected worksheets
+// cut off. Returns an error message, or an empty string on success.
+std::string LoadSheets(libxl::Book* libxlBook, ByteSource& source,
+    const std::vector<std::string>& sheets, int rowLimit = -1)
+{
+    XlsxSubset subset(source);
+    std::string data;
+
+    subset.SelectSheets(sheets);
+    subset.LimitRows(rowLimit);
+
+    if (!subset.Run(data)) return subset.ErrorMessage();
+
+    if (!libxlBook->loadRaw(data.data(), data.size())) {
+        return libxlBook->errorMessage();
+    }
+
+    return "";
+}
+
+
+}
+
+
 NAN_METHOD(Book::LoadSync){
     NanScope();
 
     ArgumentHelper arguments(args);
 
     String::Utf8Value filename(arguments.GetString(0));
+    std::vector<std::string> sheets;
+    arguments.GetStringArray(1, "sheets", sheets);
     ASSERT_ARGUMENTS(arguments);
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetsReplaced();
 
-    if (!that->GetWrapped()->load(*filename)) {
+    if (!sheets.empty()) {
+        FileSource file(*filename);
+        std::string error = file.IsOpen() ?
+            LoadSheets(that->GetWrapped(), file, sheets) :
+            std::string("unable to read ") + *filename;
+
+        if (!error.empty()) return NanThrowError(error.c_str());
+    } else if (!that->GetWrapped()->load(*filename)) {
         return util::ThrowLibxlError(that);
     }
 
+    that->MarkClean();
+
     NanReturnValue(args.This());
 }
 
@@ -140,33 +429,62 @@ NAN_METHOD(Book::LoadSync){
 NAN_METHOD(Book::Load) {
     class Worker : public AsyncWorker<Book> {
         public:
-            Worker(NanCallback* callback, Local<Object> that, Handle<Value> filename) :
+            Worker(NanCallback* callback, Local<Object> that, Handle<Value> filename,
+                    const std::vector<std::string>& sheets) :
                 AsyncWorker<Book>(callback, that),
-                filename(filename)
+                filename(filename),
+                sheets(sheets)
             {}
 
             virtual void Execute() {
-                if (!that->GetWrapped()->load(*filename)) {
-                    RaiseLibxlError();
+                if (sheets.empty()) {
+                    if (!that->GetWrapped()->load(*filename)) {
+                        RaiseLibxlError();
+                    }
+
+                    return;
                 }
+
+                FileSource file(*filename);
+                std::string error = file.IsOpen() ?
+                    LoadSheets(that->GetWrapped(), file, sheets) :
+                    std::string("unable to read ") + *filename;
+
+                if (!error.empty()) SetErrorMessage(error.c_str());
+            }
+
+            virtual void HandleOKCallback() {
+                that->MarkClean();
+
+                AsyncWorker<Book>::HandleOKCallback();
             }
 
         private:
             StringCopy filename;
+            std::vector<std::string> sheets;
     };
 
     NanScope();
 
     ArgumentHelper arguments(args);
 
+    // The options object is optional
+    bool hasOptions = !args[1]->IsFunction();
+
     Handle<Value> filename = arguments.GetString(0);
-    Handle<Function> callback = arguments.GetFunction(1);
+    std::vector<std::string> sheets;
+    if (hasOptions) arguments.GetStringArray(1, "sheets", sheets);
+    Handle<Function> callback = arguments.GetFunction(hasOptions ? 2 : 1);
     ASSERT_ARGUMENTS(arguments);
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
-    NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(), filename));
+    that->SheetsReplaced();
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(), filename,
+        sheets));
 
     NanReturnValue(args.This());
 }
@@ -188,6 +506,8 @@ NAN_METHOD(Book::WriteSync) {
         return util::ThrowLibxlError(libxlBook);
     }
 
+    that->MarkClean();
+
     NanReturnValue(args.This());
 }
 
@@ -205,6 +525,12 @@ NAN_METHOD(Book::Write) {
                     RaiseLibxlError();
                 }
             }
+
+            virtual void HandleOKCallback() {
+                that->MarkClean();
+
+                AsyncWorker<Book>::HandleOKCallback();
+            }
         
         private:
             StringCopy filename;
@@ -236,7 +562,13 @@ NAN_METHOD(Book::WriteRawSync) {
     const char* data;
     unsigned size;
 
-    if (!that->GetWrapped()->saveRaw(&data, &size)) {
+    // Unchanged books are not serialized again
+    if (that->HasSavedRaw()) {
+        data = that->savedRaw.data();
+        size = static_cast<unsigned>(that->savedRaw.size());
+    } else if (that->GetWrapped()->saveRaw(&data, &size)) {
+        that->SetSavedRaw(data, size);
+    } else {
         return util::ThrowLibxlError(that);
     }
 
@@ -251,23 +583,30 @@ NAN_METHOD(Book::WriteRaw) {
     class Worker : public AsyncWorker<Book> {
         public:
             Worker(NanCallback *callback, Local<Object> that) :
-                AsyncWorker<Book>(callback, that)
+                AsyncWorker<Book>(callback, that),
+                cached(this->that->HasSavedRaw())
             {}
 
             virtual void Execute() {
                 const char* data;
 
-                if (!that->GetWrapped()->saveRaw(&data, &size)) {
+                if (cached) {
+                    data = that->savedRaw.data();
+                    size = static_cast<unsigned>(that->savedRaw.size());
+                } else if (!that->GetWrapped()->saveRaw(&data, &size)) {
                     RaiseLibxlError();
-                } else {
-                    buffer = new char[size];
-                    memcpy(buffer, data, size);
+                    return;
                 }
+
+                buffer = new char[size];
+                memcpy(buffer, data, size);
             }
 
             virtual void HandleOKCallback() {
                 NanScope();
 
+                if (!cached) that->SetSavedRaw(buffer, size);
+
                 Handle<Value> argv[] = {
                     NanUndefined(),
                     NanBufferUse(buffer, size)
@@ -276,6 +615,7 @@ NAN_METHOD(Book::WriteRaw) {
             }
 
         private:
+            bool cached;
             char* buffer;
             unsigned size;
     };
@@ -296,23 +636,56 @@ NAN_METHOD(Book::WriteRaw) {
 }
 
 
+NAN_METHOD(Book::IsDirty) {
+    NanScope();
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    NanReturnValue(NanNew<Boolean>(that->Dirty()));
+}
+
+
+NAN_METHOD(Book::IsReadOnly) {
+    NanScope();
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    NanReturnValue(NanNew<Boolean>(that->ReadOnly()));
+}
+
+
 NAN_METHOD(Book::LoadRawSync) {
     NanScope();
 
     ArgumentHelper arguments(args);
 
     Handle<Value> buffer = arguments.GetBuffer(0);
+    std::vector<std::string> sheets;
+    arguments.GetStringArray(1, "sheets", sheets);
     ASSERT_ARGUMENTS(arguments);
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetsReplaced();
 
-    if (!that->GetWrapped()->loadRaw(
+    if (!sheets.empty()) {
+        BufferSource source(node::Buffer::Data(buffer),
+            node::Buffer::Length(buffer));
+        std::string error = LoadSheets(that->GetWrapped(), source, sheets);
+
+        if (!error.empty()) return NanThrowError(error.c_str());
+    } else if (!that->GetWrapped()->loadRaw(
         node::Buffer::Data(buffer), node::Buffer::Length(buffer)))
     {
         return util::ThrowLibxlError(that);
     }
 
+    that->MarkClean();
+
     NanReturnValue(args.This());
 }
 
@@ -321,34 +694,194 @@ NAN_METHOD(Book::LoadRaw) {
     class Worker : public AsyncWorker<Book> {
         public:
             Worker(NanCallback *callback, Local<Object> that,
-                    Handle<Value> buffer) :
+                    Handle<Value> buffer,
+                    const std::vector<std::string>& sheets) :
                 AsyncWorker<Book>(callback, that),
-                buffer(buffer)
+                buffer(buffer),
+                sheets(sheets)
             {}
 
             virtual void Execute() {
-                if (!that->GetWrapped()->loadRaw(*buffer, buffer.GetSize())) {
-                    RaiseLibxlError();
+                if (sheets.empty()) {
+                    if (!that->GetWrapped()->loadRaw(*buffer,
+                        buffer.GetSize()))
+                    {
+                        RaiseLibxlError();
+                    }
+
+                    return;
                 }
+
+                BufferSource source(*buffer, buffer.GetSize());
+                std::string error = LoadSheets(that->GetWrapped(), source,
+                    sheets);
+
+                if (!error.empty()) SetErrorMessage(error.c_str());
+            }
+
+            virtual void HandleOKCallback() {
+                that->MarkClean();
+
+                AsyncWorker<Book>::HandleOKCallback();
             }
 
         private:
             BufferCopy buffer;
+            std::vector<std::string> sheets;
     };
 
     NanScope();
 
     ArgumentHelper arguments(args);
 
+    // The options object is optional
+    bool hasOptions = !args[1]->IsFunction();
+
     Handle<Value> buffer = arguments.GetBuffer(0);
-    Handle<Function> callback = arguments.GetFunction(1);
+    std::vector<std::string> sheets;
+    if (hasOptions) arguments.GetStringArray(1, "sheets", sheets);
+    Handle<Function> callback = arguments.GetFunction(hasOptions ? 2 : 1);
     ASSERT_ARGUMENTS(arguments);
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetsReplaced();
 
     NanAsyncQueueWorker(new Worker(
-        new NanCallback(callback), args.This(), buffer));
+        new NanCallback(callback), args.This(), buffer, sheets));
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Book::LoadPreviewSync) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    bool isBuffer = node::Buffer::HasInstance(args[0]);
+    Handle<Value> source = isBuffer ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    int rows = arguments.GetInt(1, "rows", DEFAULT_PREVIEW_ROWS);
+    std::vector<std::string> sheets;
+    arguments.GetStringArray(1, "sheets", sheets);
+    ASSERT_ARGUMENTS(arguments);
+
+    if (rows < 0) {
+        return NanThrowTypeError("rows must not be negative");
+    }
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetsReplaced();
+
+    std::string error;
+
+    if (isBuffer) {
+        BufferSource buffer(node::Buffer::Data(source),
+            node::Buffer::Length(source));
+        error = LoadSheets(that->GetWrapped(), buffer, sheets, rows);
+    } else {
+        String::Utf8Value path(source);
+        FileSource file(*path);
+
+        error = file.IsOpen() ?
+            LoadSheets(that->GetWrapped(), file, sheets, rows) :
+            std::string("unable to read ") + *path;
+    }
+
+    if (!error.empty()) return NanThrowError(error.c_str());
+
+    that->MarkClean();
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Book::LoadPreview) {
+    class Worker : public AsyncWorker<Book> {
+        public:
+            Worker(NanCallback* callback, Local<Object> that,
+                    Handle<Value> source, int rows,
+                    const std::vector<std::string>& sheets) :
+                AsyncWorker<Book>(callback, that),
+                rows(rows),
+                sheets(sheets)
+            {
+                if (node::Buffer::HasInstance(source)) {
+                    data.assign(node::Buffer::Data(source),
+                        node::Buffer::Length(source));
+                } else {
+                    path = *String::Utf8Value(source);
+                }
+            }
+
+            virtual void Execute() {
+                std::string error;
+
+                if (path.empty()) {
+                    BufferSource buffer(data.data(), data.size());
+                    error = LoadSheets(that->GetWrapped(), buffer, sheets,
+                        rows);
+                } else {
+                    FileSource file(path);
+
+                    error = file.IsOpen() ?
+                        LoadSheets(that->GetWrapped(), file, sheets, rows) :
+                        "unable to read " + path;
+                }
+
+                if (!error.empty()) SetErrorMessage(error.c_str());
+            }
+
+            virtual void HandleOKCallback() {
+                that->MarkClean();
+
+                AsyncWorker<Book>::HandleOKCallback();
+            }
+
+        private:
+            std::string path, data;
+            int rows;
+            std::vector<std::string> sheets;
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    // The options object is optional
+    bool hasOptions = !args[1]->IsFunction();
+
+    Handle<Value> source = node::Buffer::HasInstance(args[0]) ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    int rows = DEFAULT_PREVIEW_ROWS;
+    std::vector<std::string> sheets;
+
+    if (hasOptions) {
+        rows = arguments.GetInt(1, "rows", DEFAULT_PREVIEW_ROWS);
+        arguments.GetStringArray(1, "sheets", sheets);
+    }
+
+    Handle<Function> callback = arguments.GetFunction(hasOptions ? 2 : 1);
+    ASSERT_ARGUMENTS(arguments);
+
+    if (rows < 0) {
+        return NanThrowTypeError("rows must not be negative");
+    }
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetsReplaced();
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(),
+        source, rows, sheets));
 
     NanReturnValue(args.This());
 }
@@ -366,10 +899,13 @@ NAN_METHOD(Book::AddSheet) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (parentSheet) {
         ASSERT_SAME_BOOK(parentSheet, that);
     }
 
+    that->Modified();
+
     libxl::Book* libxlBook = that->GetWrapped();
     libxl::Sheet* libxlSheet = libxlBook->addSheet(*name,
         parentSheet ? parentSheet->GetWrapped() : NULL);
@@ -396,10 +932,13 @@ NAN_METHOD(Book::InsertSheet) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (parentSheet) {
         ASSERT_SAME_BOOK(parentSheet, that);
     }
 
+    that->Modified();
+
     libxl::Sheet* libxlSheet = that->GetWrapped()->insertSheet(index, *name,
         parentSheet ? parentSheet->GetWrapped() : NULL);
 
@@ -411,6 +950,46 @@ NAN_METHOD(Book::InsertSheet) {
 }
 
 
+NAN_METHOD(Book::ImportSheet) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Sheet* sourceSheet = arguments.GetWrapped<Sheet>(0);
+    Handle<Value> nameHandle = arguments.GetString(1, "name", NULL);
+    bool includeFormats     = arguments.GetBoolean(1, "includeFormats", true),
+         includeMerges      = arguments.GetBoolean(1, "includeMerges", true),
+         includePictures    = arguments.GetBoolean(1, "includePictures", true);
+    ASSERT_ARGUMENTS(arguments);
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+    ASSERT_THIS(sourceSheet);
+
+    that->Modified();
+
+    libxl::Book* libxlBook = that->GetWrapped();
+    libxl::Sheet* libxlSourceSheet = sourceSheet->GetWrapped();
+
+    String::Utf8Value name(nameHandle->IsUndefined() ?
+        NanNew<String>(libxlSourceSheet->name()).As<Value>() : nameHandle);
+
+    SheetImport sheetImport(util::UnwrapBook(sourceSheet), libxlBook,
+        (includeFormats ? SheetImport::IMPORT_FORMATS : 0) |
+        (includeMerges ? SheetImport::IMPORT_MERGES : 0) |
+        (includePictures ? SheetImport::IMPORT_PICTURES : 0));
+
+    libxl::Sheet* libxlSheet = sheetImport.Import(libxlSourceSheet, *name);
+
+    if (!libxlSheet) {
+        return NanThrowError(sheetImport.ErrorMessage());
+    }
+
+    NanReturnValue(Sheet::NewInstance(libxlSheet, args.This()));
+}
+
+
 NAN_METHOD(Book::GetSheet) {
     NanScope();
 
@@ -456,6 +1035,9 @@ NAN_METHOD(Book::DelSheet) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetRemoved(that->GetWrapped()->getSheet(index));
 
     if (!that->GetWrapped()->delSheet(index)) {
         return util::ThrowLibxlError(that);
@@ -475,6 +1057,85 @@ NAN_METHOD(Book::SheetCount) {
 }
 
 
+namespace {
+
+
+Local<Object> NewInt32Array(const std::vector<int>& values) {
+    int32_t* data;
+    Local<Object> array = util::NewTypedArray("Int32Array", values.size(),
+        reinterpret_cast<void**>(&data));
+
+    std::copy(values.begin(), values.end(), data);
+
+    return array;
+}
+
+
+}
+
+
+NAN_METHOD(Book::FormulaDependencies) {
+    NanScope();
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    DependencyGraph graph(that->GetWrapped());
+
+    if (!graph.Build()) {
+        return util::ThrowLibxlError(that);
+    }
+
+    const std::vector<DependencyGraph::Node>& nodes = graph.Nodes();
+    std::vector<int> sheet(nodes.size()), row(nodes.size()),
+        col(nodes.size());
+    uint8_t* isFormula;
+
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("isFormula"), util::NewTypedArray(
+        "Uint8Array", nodes.size(), reinterpret_cast<void**>(&isFormula)));
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        sheet[i] = nodes[i].sheet;
+        row[i] = nodes[i].row;
+        col[i] = nodes[i].col;
+        isFormula[i] = nodes[i].isFormula;
+    }
+
+    result->Set(NanNew<String>("sheet"), NewInt32Array(sheet));
+    result->Set(NanNew<String>("row"), NewInt32Array(row));
+    result->Set(NanNew<String>("col"), NewInt32Array(col));
+    result->Set(NanNew<String>("precedentOffsets"),
+        NewInt32Array(graph.PrecedentOffsets()));
+    result->Set(NanNew<String>("precedents"),
+        NewInt32Array(graph.Precedents()));
+    result->Set(NanNew<String>("dependentOffsets"),
+        NewInt32Array(graph.DependentOffsets()));
+    result->Set(NanNew<String>("dependents"),
+        NewInt32Array(graph.Dependents()));
+
+    const std::vector<DependencyGraph::BrokenReference>& broken =
+        graph.BrokenReferences();
+    Local<Array> brokenReferences = NanNew<Array>(static_cast<int>(broken.size()));
+
+    for (size_t i = 0; i < broken.size(); i++) {
+        Local<Object> reference = NanNew<Object>();
+        reference->Set(NanNew<String>("sheet"),
+            NanNew<Integer>(broken[i].sheet));
+        reference->Set(NanNew<String>("row"), NanNew<Integer>(broken[i].row));
+        reference->Set(NanNew<String>("col"), NanNew<Integer>(broken[i].col));
+        reference->Set(NanNew<String>("reference"),
+            NanNew<String>(broken[i].reference.c_str()));
+
+        brokenReferences->Set(i, reference);
+    }
+
+    result->Set(NanNew<String>("brokenReferences"), brokenReferences);
+
+    NanReturnValue(result);
+}
+
+
 NAN_METHOD(Book::AddFormat) {
     NanScope();
 
@@ -486,6 +1147,9 @@ NAN_METHOD(Book::AddFormat) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (parentFormat) {
         ASSERT_SAME_BOOK(parentFormat, that);
@@ -515,6 +1179,9 @@ NAN_METHOD(Book::AddFont) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (parentFont) {
         ASSERT_SAME_BOOK(parentFont, that);
@@ -543,6 +1210,9 @@ NAN_METHOD(Book::AddCustomNumFormat) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
     
     libxl::Book* libxlBook = that->GetWrapped();
     int format = libxlBook->addCustomNumFormat(*description);
@@ -749,6 +1419,9 @@ NAN_METHOD(Book::SetActiveSheet) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setActiveSheet(index);
 
@@ -859,6 +1532,9 @@ NAN_METHOD(Book::AddPicture) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     int index;
 
@@ -959,6 +1635,9 @@ NAN_METHOD(Book::AddPictureAsync) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (args[0]->IsString()) {
 
@@ -984,6 +1663,226 @@ NAN_METHOD(Book::AddPictureAsync) {
 }
 
 
+// Pictures with the same contents as an existing picture are not added
+// again; the index of the existing picture is returned instead
+NAN_METHOD(Book::AddPictureDedup) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    bool isBuffer = node::Buffer::HasInstance(args[0]);
+    Handle<Value> source = isBuffer ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    std::string data;
+
+    if (!isBuffer) {
+        String::Utf8Value path(source);
+        FileSource file(*path);
+
+        if (!file.IsOpen() || !file.Read(0, file.Size(), data)) {
+            return NanThrowError(
+                (std::string("unable to read ") + *path).c_str());
+        }
+    }
+
+    const char* pictureData = isBuffer ? node::Buffer::Data(source) :
+        data.data();
+    unsigned size = isBuffer ?
+        static_cast<unsigned>(node::Buffer::Length(source)) :
+        static_cast<unsigned>(data.size());
+
+    int index = that->FindPicture(pictureData, size);
+
+    if (index < 0) {
+        that->Modified();
+        index = that->GetWrapped()->addPicture2(pictureData, size);
+
+        if (index == -1) {
+            return util::ThrowLibxlError(that);
+        }
+    }
+
+    NanReturnValue(NanNew<Integer>(index));
+}
+
+
+// Extracts pictures in a single worker instead of one round trip per picture
+// like getPictureAsync
+NAN_METHOD(Book::ExtractPictures) {
+    class Worker : public AsyncWorker<Book> {
+        public:
+            Worker(NanCallback* callback, Local<Object> that,
+                    const std::string& outDir, bool asBuffers,
+                    const std::vector<int>& indices, bool allPictures) :
+                AsyncWorker<Book>(callback, that),
+                outDir(outDir),
+                asBuffers(asBuffers),
+                indices(indices),
+                allPictures(allPictures),
+                extract(NULL)
+            {}
+
+            virtual ~Worker() {
+                delete extract;
+            }
+
+            virtual void Execute() {
+                libxl::Book* libxlBook = that->GetWrapped();
+
+                if (allPictures) {
+                    int pictureCount = libxlBook->pictureSize();
+                    for (int i = 0; i < pictureCount; i++) indices.push_back(i);
+                }
+
+                extract = asBuffers ? new PictureExtract(libxlBook) :
+                    new PictureExtract(libxlBook, outDir);
+
+                if (!extract->Run(indices)) {
+                    SetErrorMessage(extract->ErrorMessage().c_str());
+                }
+            }
+
+            virtual void HandleOKCallback() {
+                NanScope();
+
+                std::vector<PictureExtract::Picture>& pictures =
+                    extract->GetPictures();
+                Local<Array> manifest = NanNew<Array>(
+                    static_cast<int>(pictures.size()));
+
+                for (size_t i = 0; i < pictures.size(); i++) {
+                    const PictureExtract::Picture& picture = pictures[i];
+                    Local<Object> entry = NanNew<Object>();
+
+                    entry->Set(NanNew<String>("index"),
+                        NanNew<Integer>(picture.index));
+                    entry->Set(NanNew<String>("type"),
+                        NanNew<Integer>(picture.type));
+                    entry->Set(NanNew<String>("size"),
+                        NanNew<Integer>(picture.size));
+
+                    if (asBuffers) {
+                        entry->Set(NanNew<String>("data"), NanBufferUse(
+                            extract->ReleaseData(i), picture.size));
+                    } else {
+                        entry->Set(NanNew<String>("path"),
+                            NanNew<String>(picture.path.c_str()));
+                    }
+
+                    entry->Set(NanNew<String>("placements"),
+                        NewPlacements(picture.placements));
+
+                    manifest->Set(i, entry);
+                }
+
+                Handle<Value> argv[] = {NanUndefined(), manifest};
+                callback->Call(2, argv);
+            }
+
+        private:
+            static Local<Array> NewPlacements(
+                const std::vector<PictureExtract::Placement>& placements)
+            {
+                Local<Array> result = NanNew<Array>(
+                    static_cast<int>(placements.size()));
+
+                // Same keys as sheet.getPicture
+                for (size_t i = 0; i < placements.size(); i++) {
+                    const PictureExtract::Placement& p = placements[i];
+                    Local<Object> placement = NanNew<Object>();
+
+                    placement->Set(NanNew<String>("sheet"),
+                        NanNew<Integer>(p.sheet));
+                    placement->Set(NanNew<String>("rowTop"),
+                        NanNew<Integer>(p.rowTop));
+                    placement->Set(NanNew<String>("colLeft"),
+                        NanNew<Integer>(p.colLeft));
+                    placement->Set(NanNew<String>("rowBottom"),
+                        NanNew<Integer>(p.rowBottom));
+                    placement->Set(NanNew<String>("colRight"),
+                        NanNew<Integer>(p.colRight));
+                    placement->Set(NanNew<String>("width"),
+                        NanNew<Integer>(p.width));
+                    placement->Set(NanNew<String>("height"),
+                        NanNew<Integer>(p.height));
+                    placement->Set(NanNew<String>("offset_x"),
+                        NanNew<Integer>(p.offsetX));
+                    placement->Set(NanNew<String>("offset_y"),
+                        NanNew<Integer>(p.offsetY));
+
+                    result->Set(i, placement);
+                }
+
+                return result;
+            }
+
+            std::string outDir;
+            bool asBuffers;
+            std::vector<int> indices;
+            bool allPictures;
+            PictureExtract* extract;
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Value> outDir = arguments.GetString(0, "outDir", NULL);
+    bool asBuffers = arguments.GetBoolean(0, "asBuffers", false);
+    Handle<Function> callback = arguments.GetFunction(1);
+    ASSERT_ARGUMENTS(arguments);
+
+    Book* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    if (outDir->IsString() == asBuffers) {
+        return NanThrowTypeError(
+            "either outDir or asBuffers required in argument 0");
+    }
+
+    if (outDir->IsString() && outDir.As<String>()->Length() == 0) {
+        return NanThrowTypeError(
+            "non-empty string required for property outDir of argument 0");
+    }
+
+    Handle<Value> indicesValue =
+        args[0].As<Object>()->Get(NanNew<String>("indices"));
+    std::vector<int> indices;
+
+    if (!indicesValue->IsUndefined()) {
+        if (!indicesValue->IsArray()) {
+            return NanThrowTypeError(
+                "array required for property indices of argument 0");
+        }
+
+        Handle<Array> indexArray = indicesValue.As<Array>();
+
+        for (uint32_t i = 0; i < indexArray->Length(); i++) {
+            Handle<Value> index = indexArray->Get(i);
+
+            if (!index->IsInt32()) {
+                return NanThrowTypeError(
+                    "integers required in property indices of argument 0");
+            }
+
+            indices.push_back(index->Int32Value());
+        }
+    }
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(),
+        asBuffers ? "" : *String::Utf8Value(outDir), asBuffers,
+        indices, indicesValue->IsUndefined()));
+
+    NanReturnValue(args.This());
+}
+
+
 NAN_METHOD(Book::DefaultFont) {
     NanScope();
 
@@ -1016,6 +1915,9 @@ NAN_METHOD(Book::SetDefaultFont) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setDefaultFont(*name, size);
 
@@ -1042,6 +1944,9 @@ NAN_METHOD(Book::SetRefR1C1) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setRefR1C1(refR1C1);
 
@@ -1069,6 +1974,9 @@ NAN_METHOD(Book::SetRgbMode) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setRgbMode(rgbMode);
 
@@ -1106,6 +2014,9 @@ NAN_METHOD(Book::SetDate1904) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setDate1904(date1904);
 
@@ -1133,6 +2044,9 @@ NAN_METHOD(Book::SetTemplate) {
 
     Book* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setTemplate(isTemplate);
 
@@ -1178,16 +2092,22 @@ void Book::Initialize(Handle<Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(t, "save", Write);
     NODE_SET_PROTOTYPE_METHOD(t, "loadRawSync", LoadRawSync);
     NODE_SET_PROTOTYPE_METHOD(t, "loadRaw", LoadRaw);
+    NODE_SET_PROTOTYPE_METHOD(t, "loadPreviewSync", LoadPreviewSync);
+    NODE_SET_PROTOTYPE_METHOD(t, "loadPreview", LoadPreview);
     NODE_SET_PROTOTYPE_METHOD(t, "writeRawSync", WriteRawSync);
     NODE_SET_PROTOTYPE_METHOD(t, "saveRawSync", WriteRawSync);
     NODE_SET_PROTOTYPE_METHOD(t, "writeRaw", WriteRaw);
     NODE_SET_PROTOTYPE_METHOD(t, "saveRaw", WriteRaw);
+    NODE_SET_PROTOTYPE_METHOD(t, "isDirty", IsDirty);
+    NODE_SET_PROTOTYPE_METHOD(t, "isReadOnly", IsReadOnly);
     NODE_SET_PROTOTYPE_METHOD(t, "addSheet", AddSheet);
     NODE_SET_PROTOTYPE_METHOD(t, "insertSheet", InsertSheet);
+    NODE_SET_PROTOTYPE_METHOD(t, "importSheet", ImportSheet);
     NODE_SET_PROTOTYPE_METHOD(t, "getSheet", GetSheet);
     NODE_SET_PROTOTYPE_METHOD(t, "sheetType", SheetType);
     NODE_SET_PROTOTYPE_METHOD(t, "delSheet", DelSheet);
     NODE_SET_PROTOTYPE_METHOD(t, "sheetCount", SheetCount);
+    NODE_SET_PROTOTYPE_METHOD(t, "formulaDependencies", FormulaDependencies);
     NODE_SET_PROTOTYPE_METHOD(t, "addFormat", AddFormat);
     NODE_SET_PROTOTYPE_METHOD(t, "addFont", AddFont);
     NODE_SET_PROTOTYPE_METHOD(t, "addCustomNumFormat", AddCustomNumFormat);
@@ -1207,6 +2127,8 @@ void Book::Initialize(Handle<Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(t, "getPictureAsync", GetPictureAsync);
     NODE_SET_PROTOTYPE_METHOD(t, "addPicture", AddPicture);
     NODE_SET_PROTOTYPE_METHOD(t, "addPictureAsync", AddPictureAsync);
+    NODE_SET_PROTOTYPE_METHOD(t, "addPictureDedup", AddPictureDedup);
+    NODE_SET_PROTOTYPE_METHOD(t, "extractPictures", ExtractPictures);
     NODE_SET_PROTOTYPE_METHOD(t, "defaultFont", DefaultFont);
     NODE_SET_PROTOTYPE_METHOD(t, "setDefaultFont", SetDefaultFont);
     NODE_SET_PROTOTYPE_METHOD(t, "refR1C1", RefR1C1);
@@ -1222,10 +2144,10 @@ void Book::Initialize(Handle<Object> exports) {
 
     #ifdef INCLUDE_API_KEY
         CSNanObjectSetWithAttributes(exports, NanNew<String>("apiKeyCompiledIn"), NanTrue(),
-            static_cast<PropertyAttribute>(ReadOnly|DontDelete));
+            static_cast<PropertyAttribute>(v8::ReadOnly|DontDelete));
     #else
         CSNanObjectSetWithAttributes(exports, NanNew<String>("apiKeyCompiledIn"), NanFalse(),
-            static_cast<PropertyAttribute>(ReadOnly|DontDelete));
+            static_cast<PropertyAttribute>(v8::ReadOnly|DontDelete));
     #endif
 
     t->ReadOnlyPrototype();
@@ -25,12 +25,19 @@
 #ifndef BINDINGS_BOOK
 #define BINDINGS_BOOK
 
+#include <map>
+#include <string>
+
 #include "common.h"
 #include "wrapper.h"
 
 namespace node_libxl {
 
 
+class SheetCache;
+class SheetJournal;
+
+
 enum {
     BOOK_TYPE_XLS,
     BOOK_TYPE_XLSX
@@ -47,8 +54,48 @@ class Book : public Wrapper<libxl::Book> {
         void StopAsync();
         bool AsyncPending();
 
+        // Read caches of sheets, see sheet.enableCache. The book takes
+        // ownership; passing NULL removes the cache.
+        SheetCache* GetSheetCache(libxl::Sheet* sheet);
+        void SetSheetCache(libxl::Sheet* sheet, SheetCache* cache);
+
+        // Change journals of sheets, see sheet.exportCsvIncremental. Owned by
+        // the book like the caches.
+        SheetJournal* GetSheetJournal(libxl::Sheet* sheet);
+        void SetSheetJournal(libxl::Sheet* sheet, SheetJournal* journal);
+
+        // Called by all methods that change cells, either a single cell, whole
+        // rows or a sheet as a whole, and before sheets are replaced or
+        // deleted. Row hooks for insertions and removals are called once the
+        // rows have moved. FormatsChanged is for changes that leave the
+        // values alone.
+        void CellChanged(libxl::Sheet* sheet, int row, int col);
+        void RowsChanged(libxl::Sheet* sheet, int first, int last);
+        void RowsInserted(libxl::Sheet* sheet, int first, int last);
+        void RowsRemoved(libxl::Sheet* sheet, int first, int last);
+        void FormatsChanged(libxl::Sheet* sheet);
+        void SheetChanged(libxl::Sheet* sheet);
+        void SheetRemoved(libxl::Sheet* sheet);
+        void SheetsReplaced();
+
+        // Counts mutations; every mutating method calls Modified. The book is
+        // dirty if it changed since it was last loaded or saved.
+        void Modified();
+        void MarkClean();
+        bool Dirty();
+
+        // Books shared by a BookCache are read-only. All methods that call
+        // one of the hooks above check the flag first, see ASSERT_WRITABLE.
+        void SetReadOnly();
+        bool ReadOnly();
+
         static void Initialize(v8::Handle<v8::Object> exports);
 
+        static libxl::Book* CreateLibxlBook(int type);
+
+        // Creates an empty book for native callers
+        static v8::Handle<v8::Object> NewInstance(int type);
+
         static Book* Unwrap(v8::Handle<v8::Value> object) {
             return Wrapper<libxl::Book>::Unwrap<Book>(object);
         }
@@ -63,14 +110,20 @@ class Book : public Wrapper<libxl::Book> {
         static NAN_METHOD(Write);
         static NAN_METHOD(WriteRawSync);
         static NAN_METHOD(WriteRaw);
+        static NAN_METHOD(IsDirty);
+        static NAN_METHOD(IsReadOnly);
         static NAN_METHOD(LoadRawSync);
         static NAN_METHOD(LoadRaw);
+        static NAN_METHOD(LoadPreviewSync);
+        static NAN_METHOD(LoadPreview);
         static NAN_METHOD(AddSheet);
         static NAN_METHOD(InsertSheet);
+        static NAN_METHOD(ImportSheet);
         static NAN_METHOD(GetSheet);
         static NAN_METHOD(SheetType);
         static NAN_METHOD(DelSheet);
         static NAN_METHOD(SheetCount);
+        static NAN_METHOD(FormulaDependencies);
         static NAN_METHOD(AddFormat);
         static NAN_METHOD(AddFont);
         static NAN_METHOD(AddCustomNumFormat);
@@ -90,6 +143,8 @@ class Book : public Wrapper<libxl::Book> {
         static NAN_METHOD(GetPictureAsync);
         static NAN_METHOD(AddPicture);
         static NAN_METHOD(AddPictureAsync);
+        static NAN_METHOD(AddPictureDedup);
+        static NAN_METHOD(ExtractPictures);
         static NAN_METHOD(DefaultFont);
         static NAN_METHOD(SetDefaultFont);
         static NAN_METHOD(RefR1C1);
@@ -108,7 +163,26 @@ class Book : public Wrapper<libxl::Book> {
         Book(const Book&);
         const Book& operator=(const Book&);
 
-        bool asyncPending;
+        bool asyncPending, readOnly;
+        std::map<libxl::Sheet*, SheetCache*> sheetCaches;
+        std::map<libxl::Sheet*, SheetJournal*> sheetJournals;
+
+        uint64_t generation, cleanGeneration;
+
+        // Output of the last saveRaw and the generation it belongs to
+        std::string savedRaw;
+        uint64_t savedRawGeneration;
+
+        bool HasSavedRaw();
+        void SetSavedRaw(const char* data, unsigned size);
+
+        // Content hashes of the pictures of the book, see
+        // book.addPictureDedup. Pictures are hashed on demand, so the table
+        // also covers pictures that were loaded or added otherwise.
+        std::multimap<uint64_t, int> pictureHashes;
+        int hashedPictures;
+
+        int FindPicture(const char* data, unsigned size);
 };
 
 
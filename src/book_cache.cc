@@ -0,0 +1,476 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sys/stat.h>
+#include <sstream>
+
+#include "book_cache.h"
+#include "argument_helper.h"
+#include "assert.h"
+#include "book.h"
+#include "book_split.h"
+#include "byte_source.h"
+#include "async_worker.h"
+#include "hash.h"
+
+using namespace v8;
+
+namespace node_libxl {
+
+
+// Lifecycle
+
+
+BookCache::BookCache(BookCacheIndex* index) :
+    Wrapper<BookCacheIndex>(index),
+    hits(0),
+    misses(0)
+{}
+
+
+BookCache::~BookCache() {
+    std::map<std::string, Entry>::iterator it;
+
+    for (it = entries.begin(); it != entries.end(); ++it) {
+        NanDisposePersistent(*it->second.book);
+        delete it->second.book;
+    }
+
+    delete wrapped;
+}
+
+
+NAN_METHOD(BookCache::New) {
+    NanScope();
+
+    if (!args.IsConstructCall()) {
+        NanReturnValue(NanNew(
+            util::ProxyConstructor(NanNew(constructor), args)));
+    }
+
+    ArgumentHelper arguments(args);
+
+    int maxBooks = arguments.GetInt(0, "maxBooks", 0);
+    double maxBytes = arguments.GetDouble(0, "maxBytes", 0);
+    ASSERT_ARGUMENTS(arguments);
+
+    if (maxBooks < 0 || maxBytes < 0) {
+        return NanThrowTypeError("invalid cache limit");
+    }
+
+    BookCache* cache = new BookCache(new BookCacheIndex(
+        maxBooks, static_cast<uint64_t>(maxBytes)));
+    cache->Wrap(args.This());
+
+    NanReturnValue(args.This());
+}
+
+
+// Implementation
+
+
+namespace {
+
+
+// Rough per-cell footprint of a loaded book on top of the file itself
+const uint64_t BYTES_PER_CELL = 32;
+
+
+struct Source {
+    std::string key, version;
+    int type;
+    bool isBuffer;
+};
+
+
+template<typename T> std::string ToString(T value) {
+    std::ostringstream ss;
+    ss << value;
+
+    return ss.str();
+}
+
+
+// The hash only picks the slot of a buffer; its contents are kept as the
+// version so that a colliding buffer never returns the wrong book
+std::string ResolveSource(Handle<Value> value, Source& source) {
+    source.isBuffer = node::Buffer::HasInstance(value);
+
+    if (source.isBuffer) {
+        const char* data = node::Buffer::Data(value);
+        size_t size = node::Buffer::Length(value);
+
+        source.key = "buffer:" + ToString(HashBytes(data, size)) + ":" +
+            ToString(size);
+        source.version.assign(data, size);
+        source.type = BookSplit::DetectType(data, size);
+    } else {
+        std::string path = *String::Utf8Value(value);
+        struct stat info;
+        FileSource file(path);
+        std::string magic;
+
+        if (stat(path.c_str(), &info) != 0 || !file.IsOpen()) {
+            return "unable to read " + path;
+        }
+
+        source.key = "file:" + path;
+        source.version = ToString(info.st_size) + ":" +
+            ToString(info.st_mtime);
+        source.type = file.Read(0, 4, magic) ?
+            BookSplit::DetectType(magic.data(), magic.size()) : -1;
+    }
+
+    return source.type < 0 ? "unknown file format" : "";
+}
+
+
+uint64_t EstimateSize(libxl::Book* book, uint64_t sourceSize) {
+    uint64_t cells = 0;
+
+    for (int i = 0; i < book->sheetCount(); i++) {
+        libxl::Sheet* sheet = book->getSheet(i);
+        if (!sheet) continue;
+
+        int rows = sheet->lastRow() - sheet->firstRow(),
+            cols = sheet->lastCol() - sheet->firstCol();
+
+        if (rows > 0 && cols > 0) {
+            cells += static_cast<uint64_t>(rows) * cols;
+        }
+    }
+
+    return sourceSize + cells * BYTES_PER_CELL;
+}
+
+
+}
+
+
+Handle<Value> BookCache::Lookup(const std::string& key,
+    const std::string& version)
+{
+    NanEscapableScope();
+
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+
+    if (it == entries.end() || it->second.version != version) {
+        return NanEscapeScope(NanUndefined());
+    }
+
+    wrapped->Touch(key);
+    hits++;
+
+    return NanEscapeScope(NanNew(*it->second.book));
+}
+
+
+void BookCache::Store(const std::string& key, const std::string& version,
+    Handle<Object> book, uint64_t size)
+{
+    Drop(key);
+
+    Book::Unwrap(book)->SetReadOnly();
+
+    Entry entry;
+    entry.version = version;
+    entry.book = new Persistent<Object>();
+    NanAssignPersistent(*entry.book, book);
+
+    entries[key] = entry;
+
+    std::vector<std::string> evicted = wrapped->Insert(key, size);
+
+    for (size_t i = 0; i < evicted.size(); i++) {
+        Drop(evicted[i]);
+    }
+}
+
+
+void BookCache::Drop(const std::string& key) {
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if (it == entries.end()) return;
+
+    // The key may refer to the entry itself
+    wrapped->Remove(key);
+
+    NanDisposePersistent(*it->second.book);
+    delete it->second.book;
+
+    entries.erase(it);
+}
+
+
+NAN_METHOD(BookCache::LoadSync) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Value> value = node::Buffer::HasInstance(args[0]) ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    BookCache* that = Unwrap(args.This());
+    if (!that) return NanThrowTypeError("invalid scope");
+
+    Source source;
+    std::string error = ResolveSource(value, source);
+    if (!error.empty()) return NanThrowError(error.c_str());
+
+    Handle<Value> cached = that->Lookup(source.key, source.version);
+    if (!cached->IsUndefined()) NanReturnValue(cached);
+
+    that->misses++;
+
+    Local<Object> bookHandle = NanNew(Book::NewInstance(source.type));
+    libxl::Book* libxlBook = Book::Unwrap(bookHandle)->GetWrapped();
+    uint64_t sourceSize;
+
+    if (source.isBuffer) {
+        sourceSize = node::Buffer::Length(value);
+
+        if (!libxlBook->loadRaw(node::Buffer::Data(value),
+            static_cast<unsigned>(sourceSize)))
+        {
+            return util::ThrowLibxlError(libxlBook);
+        }
+    } else {
+        String::Utf8Value path(value);
+        sourceSize = FileSource(*path).Size();
+
+        if (!libxlBook->load(*path)) {
+            return util::ThrowLibxlError(libxlBook);
+        }
+    }
+
+    that->Store(source.key, source.version, bookHandle,
+        EstimateSize(libxlBook, sourceSize));
+
+    NanReturnValue(bookHandle);
+}
+
+
+// Concurrent loads of the same source share a single worker
+NAN_METHOD(BookCache::Load) {
+    class HitWorker : public NanAsyncWorker {
+        public:
+            HitWorker(NanCallback* callback, Handle<Value> book) :
+                NanAsyncWorker(callback)
+            {
+                SaveToPersistent("book", book.As<Object>());
+            }
+
+            virtual void Execute() {}
+
+            virtual void HandleOKCallback() {
+                NanScope();
+
+                Handle<Value> argv[] = {
+                    NanUndefined(),
+                    GetFromPersistent("book")
+                };
+                callback->Call(2, argv);
+            }
+    };
+
+    class Worker : public AsyncWorker<Book> {
+        public:
+            Worker(NanCallback* callback, Local<Object> book,
+                    Local<Object> cache, const Source& source,
+                    Handle<Value> value) :
+                AsyncWorker<Book>(callback, book),
+                source(source)
+            {
+                SaveToPersistent("cache", cache);
+
+                if (!source.isBuffer) path = *String::Utf8Value(value);
+            }
+
+            virtual void Execute() {
+                libxl::Book* libxlBook = that->GetWrapped();
+                const std::string& data = source.version;
+                bool ok = source.isBuffer ?
+                    libxlBook->loadRaw(data.data(),
+                        static_cast<unsigned>(data.size())) :
+                    libxlBook->load(path.c_str());
+
+                if (!ok) {
+                    RaiseLibxlError();
+                    return;
+                }
+
+                size = EstimateSize(libxlBook, source.isBuffer ?
+                    data.size() : FileSource(path).Size());
+            }
+
+            virtual void HandleOKCallback() {
+                NanScope();
+
+                Local<Object> book = GetFromPersistent("that");
+                Handle<Value> argv[] = {NanUndefined(), book};
+
+                BookCache* cache = BookCache::Unwrap(
+                    GetFromPersistent("cache"));
+                cache->Store(source.key, source.version, book, size);
+
+                Complete(2, argv);
+            }
+
+            virtual void HandleErrorCallback() {
+                NanScope();
+
+                Handle<Value> argv[] = {
+                    Exception::Error(NanNew<String>(ErrorMessage()))
+                };
+
+                Complete(1, argv);
+            }
+
+        private:
+            Source source;
+            std::string path;
+            uint64_t size;
+
+            void Complete(int argc, Handle<Value>* argv) {
+                BookCache* cache = BookCache::Unwrap(
+                    GetFromPersistent("cache"));
+                std::string id = source.key + "\n" + source.version;
+
+                std::vector<NanCallback*> waiting = cache->pending[id];
+                cache->pending.erase(id);
+
+                callback->Call(argc, argv);
+
+                for (size_t i = 0; i < waiting.size(); i++) {
+                    waiting[i]->Call(argc, argv);
+                    delete waiting[i];
+                }
+            }
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Value> value = node::Buffer::HasInstance(args[0]) ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    Handle<Function> callback = arguments.GetFunction(1);
+    ASSERT_ARGUMENTS(arguments);
+
+    BookCache* that = Unwrap(args.This());
+    if (!that) return NanThrowTypeError("invalid scope");
+
+    Source source;
+    std::string error = ResolveSource(value, source);
+    if (!error.empty()) return NanThrowError(error.c_str());
+
+    Handle<Value> cached = that->Lookup(source.key, source.version);
+
+    if (!cached->IsUndefined()) {
+        NanAsyncQueueWorker(new HitWorker(new NanCallback(callback), cached));
+        NanReturnValue(args.This());
+    }
+
+    std::string id = source.key + "\n" + source.version;
+    std::map<std::string, std::vector<NanCallback*> >::iterator it =
+        that->pending.find(id);
+
+    if (it != that->pending.end()) {
+        that->hits++;
+        it->second.push_back(new NanCallback(callback));
+
+        NanReturnValue(args.This());
+    }
+
+    that->misses++;
+    that->pending[id];
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback),
+        NanNew(Book::NewInstance(source.type)), args.This(), source, value));
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(BookCache::Stats) {
+    NanScope();
+
+    BookCache* that = Unwrap(args.This());
+    if (!that) return NanThrowTypeError("invalid scope");
+
+    Local<Object> stats = NanNew<Object>();
+
+    stats->Set(NanNew<String>("books"),
+        NanNew<Number>(static_cast<double>(that->wrapped->Count())));
+    stats->Set(NanNew<String>("bytes"),
+        NanNew<Number>(static_cast<double>(that->wrapped->Bytes())));
+    stats->Set(NanNew<String>("hits"),
+        NanNew<Number>(static_cast<double>(that->hits)));
+    stats->Set(NanNew<String>("misses"),
+        NanNew<Number>(static_cast<double>(that->misses)));
+    stats->Set(NanNew<String>("loading"),
+        NanNew<Number>(static_cast<double>(that->pending.size())));
+
+    NanReturnValue(stats);
+}
+
+
+// Loads in flight still complete, but their books are cached afresh
+NAN_METHOD(BookCache::Clear) {
+    NanScope();
+
+    BookCache* that = Unwrap(args.This());
+    if (!that) return NanThrowTypeError("invalid scope");
+
+    while (!that->entries.empty()) {
+        that->Drop(that->entries.begin()->first);
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+// Init
+
+
+void BookCache::Initialize(Handle<Object> exports) {
+    NanScope();
+
+    Local<FunctionTemplate> t = NanNew<FunctionTemplate>(New);
+    t->SetClassName(NanNew<String>("BookCache"));
+    t->InstanceTemplate()->SetInternalFieldCount(1);
+
+    NODE_SET_PROTOTYPE_METHOD(t, "loadSync", LoadSync);
+    NODE_SET_PROTOTYPE_METHOD(t, "load", Load);
+    NODE_SET_PROTOTYPE_METHOD(t, "stats", Stats);
+    NODE_SET_PROTOTYPE_METHOD(t, "clear", Clear);
+
+    t->ReadOnlyPrototype();
+    NanAssignPersistent(constructor, t->GetFunction());
+
+    exports->Set(NanNew<String>("BookCache"), NanNew(constructor));
+}
+
+
+}
@@ -0,0 +1,91 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_BOOK_CACHE_H
+#define BINDINGS_BOOK_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "wrapper.h"
+#include "book_cache_index.h"
+
+namespace node_libxl {
+
+
+// Shares loaded books between callers that load the same file or buffer.
+// Files are identified by path, size and modification time, buffers by their
+// contents. Cached books are shared, not copied, and are marked read-only.
+class BookCache : public Wrapper<BookCacheIndex> {
+    public:
+
+        BookCache(BookCacheIndex* index);
+        ~BookCache();
+
+        static void Initialize(v8::Handle<v8::Object> exports);
+
+        static BookCache* Unwrap(v8::Handle<v8::Value> object) {
+            return Wrapper<BookCacheIndex>::Unwrap<BookCache>(object);
+        }
+
+    protected:
+
+        static NAN_METHOD(New);
+        static NAN_METHOD(LoadSync);
+        static NAN_METHOD(Load);
+        static NAN_METHOD(Stats);
+        static NAN_METHOD(Clear);
+
+    private:
+
+        struct Entry {
+            std::string version;
+            v8::Persistent<v8::Object>* book;
+        };
+
+        // Slots are keyed by path or content hash; the version tells apart
+        // different states of the same file or holds the buffer contents
+        std::map<std::string, Entry> entries;
+
+        // Callbacks waiting for an in-flight load, by slot and version
+        std::map<std::string, std::vector<NanCallback*> > pending;
+
+        uint64_t hits, misses;
+
+        v8::Handle<v8::Value> Lookup(const std::string& key,
+            const std::string& version);
+        void Store(const std::string& key, const std::string& version,
+            v8::Handle<v8::Object> book, uint64_t size);
+        void Drop(const std::string& key);
+
+        BookCache(const BookCache&);
+        const BookCache& operator=(const BookCache&);
+};
+
+
+}
+
+#endif // BINDINGS_BOOK_CACHE_H
@@ -0,0 +1,105 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "book_cache_index.h"
+
+namespace node_libxl {
+
+
+BookCacheIndex::BookCacheIndex(size_t maxEntries, uint64_t maxBytes) :
+    maxEntries(maxEntries),
+    maxBytes(maxBytes),
+    bytes(0)
+{}
+
+
+bool BookCacheIndex::Contains(const std::string& key) const {
+    return entries.find(key) != entries.end();
+}
+
+
+void BookCacheIndex::Touch(const std::string& key) {
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if (it == entries.end()) return;
+
+    order.splice(order.begin(), order, it->second.position);
+}
+
+
+std::vector<std::string> BookCacheIndex::Insert(const std::string& key,
+    uint64_t size)
+{
+    Remove(key);
+
+    order.push_front(key);
+
+    Entry entry;
+    entry.size = size;
+    entry.position = order.begin();
+
+    entries[key] = entry;
+    bytes += size;
+
+    std::vector<std::string> evicted;
+
+    while (order.size() > 1 &&
+        ((maxEntries > 0 && order.size() > maxEntries) ||
+            (maxBytes > 0 && bytes > maxBytes)))
+    {
+        evicted.push_back(order.back());
+        Remove(order.back());
+    }
+
+    return evicted;
+}
+
+
+void BookCacheIndex::Remove(const std::string& key) {
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if (it == entries.end()) return;
+
+    bytes -= it->second.size;
+    order.erase(it->second.position);
+    entries.erase(it);
+}
+
+
+void BookCacheIndex::Clear() {
+    order.clear();
+    entries.clear();
+    bytes = 0;
+}
+
+
+size_t BookCacheIndex::Count() const {
+    return entries.size();
+}
+
+
+uint64_t BookCacheIndex::Bytes() const {
+    return bytes;
+}
+
+
+}
@@ -0,0 +1,82 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_BOOK_CACHE_INDEX_H
+#define BINDINGS_BOOK_CACHE_INDEX_H
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace node_libxl {
+
+
+// Keeps track of cached entries in least recently used order and decides
+// which entries to evict when a limit on their number or their total size
+// is exceeded. A limit of 0 disables the respective check.
+class BookCacheIndex {
+    public:
+
+        BookCacheIndex(size_t maxEntries, uint64_t maxBytes);
+
+        bool Contains(const std::string& key) const;
+
+        // Marks an entry as used
+        void Touch(const std::string& key);
+
+        // Adds or replaces an entry and returns the keys of the entries that
+        // have to be evicted. The new entry itself is always kept.
+        std::vector<std::string> Insert(const std::string& key, uint64_t size);
+
+        void Remove(const std::string& key);
+        void Clear();
+
+        size_t Count() const;
+        uint64_t Bytes() const;
+
+    private:
+
+        struct Entry {
+            uint64_t size;
+            std::list<std::string>::iterator position;
+        };
+
+        size_t maxEntries;
+        uint64_t maxBytes, bytes;
+
+        // Most recently used first
+        std::list<std::string> order;
+        std::map<std::string, Entry> entries;
+
+        BookCacheIndex(const BookCacheIndex&);
+        const BookCacheIndex& operator=(const BookCacheIndex&);
+};
+
+
+}
+
+#endif // BINDINGS_BOOK_CACHE_INDEX_H
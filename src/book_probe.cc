@@ -0,0 +1,263 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "book_probe.h"
+
+#include "book.h"
+#include "biff_reader.h"
+#include "cell_reference.h"
+#include "compound_file.h"
+#include "xlsx_package.h"
+#include "xml_tag.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+// The <dimension> element precedes the cell data and is expected within
+// the first few kilobytes of a sheet part
+const size_t DIMENSION_SEARCH_LIMIT = 64 * 1024;
+
+const uint16_t BIFF8_VERSION = 0x0600;
+
+
+// Parses dimension references like "A1:D10" or "B2"
+bool ParseDimension(const std::string& ref, Range& range) {
+    CellReference first, last;
+    size_t length = first.Parse(ref.c_str(), ref.size());
+
+    if (length == 0) return false;
+
+    if (length == ref.size()) {
+        last = first;
+    } else if (ref[length] != ':' ||
+        last.Parse(ref.c_str() + length + 1, ref.size() - length - 1) !=
+            ref.size() - length - 1)
+    {
+        return false;
+    }
+
+    range = Range(first.row, last.row, first.col, last.col);
+    return true;
+}
+
+
+}
+
+
+BookProbe::BookProbe(ByteSource& source) :
+    source(source),
+    type(-1)
+{}
+
+
+bool BookProbe::Run() {
+    std::string magic;
+
+    if (!source.Read(0, 4, magic) || magic.size() < 4) {
+        return Fail("unknown file format");
+    }
+
+    if (magic == "PK\x03\x04") return ProbeXlsx();
+    if (magic == "\xD0\xCF\x11\xE0") return ProbeXls();
+
+    return Fail("unknown file format");
+}
+
+
+int BookProbe::Type() const {
+    return type;
+}
+
+
+const std::vector<BookProbe::SheetInfo>& BookProbe::Sheets() const {
+    return sheets;
+}
+
+
+const std::string& BookProbe::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool BookProbe::ProbeXlsx() {
+    type = BOOK_TYPE_XLSX;
+
+    XlsxPackage package(source);
+    if (!package.Open()) return Fail(package.ErrorMessage());
+
+    const std::vector<XlsxPackage::Sheet>& packageSheets = package.Sheets();
+    ZipReader& zip = package.Zip();
+    XmlTag tag;
+
+    for (size_t i = 0; i < packageSheets.size(); i++) {
+        SheetInfo sheet;
+        sheet.name = packageSheets[i].name;
+        sheet.state = packageSheets[i].state;
+        sheet.type = packageSheets[i].type;
+
+        const ZipReader::Entry* entry = zip.Find(packageSheets[i].path);
+        std::string part;
+        size_t pos = 0;
+
+        if (entry && sheet.type == "worksheet") {
+            if (!zip.Extract(*entry, part, DIMENSION_SEARCH_LIMIT)) {
+                return Fail(zip.ErrorMessage());
+            }
+
+            if (tag.Find(part, pos, "dimension")) {
+                sheet.hasDimension = ParseDimension(tag.Attribute("ref"),
+                    sheet.dimension);
+            }
+        }
+
+        sheets.push_back(sheet);
+    }
+
+    return true;
+}
+
+
+bool BookProbe::ProbeXls() {
+    type = BOOK_TYPE_XLS;
+
+    CompoundFile file(source);
+    CompoundFile::Stream stream;
+
+    if (!file.Open()) return Fail(file.ErrorMessage());
+
+    if (!file.OpenStream("Workbook", stream) &&
+        !file.OpenStream("Book", stream))
+    {
+        return Fail("missing workbook stream");
+    }
+
+    BiffReader reader(stream);
+    std::vector<uint32_t> offsets;
+    uint16_t version = 0;
+
+    while (reader.Next() && reader.Id() != BiffReader::RECORD_EOF) {
+        const std::string& data = reader.Data();
+
+        switch (reader.Id()) {
+            case BiffReader::RECORD_BOF:
+                if (data.size() >= 2) version = ByteSource::Uint16(data.data());
+                break;
+
+            case BiffReader::RECORD_FILEPASS:
+                return Fail("encrypted workbooks are not supported");
+
+            case BiffReader::RECORD_BOUNDSHEET: {
+                static const char* states[] = {
+                    "visible", "hidden", "veryHidden", "veryHidden"
+                };
+
+                if (data.size() < 7) return Fail("corrupt BOUNDSHEET record");
+
+                SheetInfo sheet;
+                sheet.state = states[data[4] & 0x03];
+
+                switch (static_cast<unsigned char>(data[5])) {
+                    case 0x01:  sheet.type = "macrosheet"; break;
+                    case 0x02:  sheet.type = "chartsheet"; break;
+                    case 0x06:  sheet.type = "module"; break;
+                    default:    sheet.type = "worksheet";
+                }
+
+                size_t count = static_cast<unsigned char>(data[6]);
+
+                // BIFF8 names carry an option byte for the encoding, older
+                // versions use 8 bit characters only
+                if (version >= BIFF8_VERSION && data.size() >= 8) {
+                    bool wide = data[7] & 0x01;
+
+                    if (data.size() < 8 + count * (wide ? 2 : 1)) {
+                        return Fail("corrupt BOUNDSHEET record");
+                    }
+
+                    sheet.name = BiffReader::DecodeCharacters(
+                        data.data() + 8, count, wide);
+                } else {
+                    if (data.size() < 7 + count) {
+                        return Fail("corrupt BOUNDSHEET record");
+                    }
+
+                    sheet.name = BiffReader::DecodeCharacters(
+                        data.data() + 7, count, false);
+                }
+
+                sheets.push_back(sheet);
+                offsets.push_back(ByteSource::Uint32(data.data()));
+                break;
+            }
+        }
+    }
+
+    // The DIMENSIONS record follows a few records after the sheet's BOF
+    for (size_t i = 0; i < sheets.size(); i++) {
+        reader.Seek(offsets[i]);
+
+        while (reader.Next() && reader.Id() != BiffReader::RECORD_EOF) {
+            const std::string& data = reader.Data();
+            if (reader.Id() != BiffReader::RECORD_DIMENSIONS) continue;
+
+            uint32_t rowFirst, rowLast;
+            uint16_t colFirst, colLast;
+
+            if (version >= BIFF8_VERSION && data.size() >= 12) {
+                rowFirst = ByteSource::Uint32(data.data());
+                rowLast = ByteSource::Uint32(data.data() + 4);
+                colFirst = ByteSource::Uint16(data.data() + 8);
+                colLast = ByteSource::Uint16(data.data() + 10);
+            } else if (data.size() >= 8) {
+                rowFirst = ByteSource::Uint16(data.data());
+                rowLast = ByteSource::Uint16(data.data() + 2);
+                colFirst = ByteSource::Uint16(data.data() + 4);
+                colLast = ByteSource::Uint16(data.data() + 6);
+            } else {
+                break;
+            }
+
+            // The last row and column are stored exclusively
+            sheets[i].hasDimension = true;
+            sheets[i].dimension = Range(rowFirst, rowLast - 1,
+                colFirst, colLast - 1);
+            break;
+        }
+    }
+
+    return true;
+}
+
+
+bool BookProbe::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return false;
+}
+
+
+}
@@ -0,0 +1,92 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_BOOK_PROBE_H
+#define BINDINGS_BOOK_PROBE_H
+
+#include <string>
+#include <vector>
+
+#include "byte_source.h"
+#include "range.h"
+
+namespace node_libxl {
+
+
+// Determines the sheets of a book and their used ranges without loading it
+// through libxl. For XLSX packages only the zip directory, the workbook
+// part, its relationships and the beginning of each sheet part (up to the
+// <dimension> element) are read; for XLS files the BOUNDSHEET records of the
+// workbook globals and the DIMENSIONS record of each sheet.
+class BookProbe {
+    public:
+
+        struct SheetInfo {
+            SheetInfo() : hasDimension(false) {}
+
+            std::string name;
+
+            // "visible", "hidden" or "veryHidden"
+            std::string state;
+
+            // "worksheet", "chartsheet", "dialogsheet", "macrosheet" or
+            // "module"
+            std::string type;
+
+            // Used range as recorded in the file; an approximation, as
+            // writers are not required to maintain it accurately
+            bool hasDimension;
+            Range dimension;
+        };
+
+        explicit BookProbe(ByteSource& source);
+
+        bool Run();
+
+        // BOOK_TYPE_XLS or BOOK_TYPE_XLSX
+        int Type() const;
+
+        const std::vector<SheetInfo>& Sheets() const;
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        bool ProbeXlsx();
+        bool ProbeXls();
+
+        bool Fail(const std::string& message);
+
+        ByteSource& source;
+        int type;
+        std::vector<SheetInfo> sheets;
+        std::string errorMessage;
+
+        BookProbe(const BookProbe&);
+        const BookProbe& operator=(const BookProbe&);
+};
+
+
+}
+
+#endif // BINDINGS_BOOK_PROBE_H
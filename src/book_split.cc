@@ -0,0 +1,269 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "book_split.h"
+
+#include <cstring>
+#include <set>
+#include <sstream>
+
+#include "book.h"
+#include "sheet_name.h"
+#include "sheet_import.h"
+
+namespace node_libxl {
+
+
+#ifdef _WIN32
+    static const char PATH_SEPARATOR = '\\';
+#else
+    static const char PATH_SEPARATOR = '/';
+#endif
+
+
+BookSplit::BookSplit(const char* data, size_t size, const std::string& outDir,
+        int targetType, int concurrency) :
+    data(data),
+    size(size),
+    outDir(outDir),
+    sourceType(DetectType(data, size)),
+    targetType(targetType < 0 ? sourceType : targetType),
+    concurrency(concurrency > 0 ? concurrency : 1),
+    nextSheet(0),
+    sheetCount(0),
+    failed(false)
+{
+    uv_mutex_init(&mutex);
+}
+
+
+BookSplit::~BookSplit() {
+    uv_mutex_destroy(&mutex);
+}
+
+
+int BookSplit::DetectType(const char* data, size_t size) {
+    static const char xlsMagic[] = {'\xD0', '\xCF', '\x11', '\xE0'};
+    static const char xlsxMagic[] = {'P', 'K', '\x03', '\x04'};
+
+    if (size < 4) return -1;
+    if (memcmp(data, xlsMagic, 4) == 0) return BOOK_TYPE_XLS;
+    if (memcmp(data, xlsxMagic, 4) == 0) return BOOK_TYPE_XLSX;
+
+    return -1;
+}
+
+
+bool BookSplit::Run() {
+    if (sourceType < 0) return Fail("unknown file format");
+
+    // The first replica is loaded up front in order to learn the number of
+    // sheets; there is no point in starting more threads than that
+    libxl::Book* replica = LoadReplica();
+    if (!replica) return false;
+
+    sheetCount = replica->sheetCount();
+    files.resize(sheetCount);
+
+    if (!AssignPaths(replica)) {
+        replica->release();
+        return false;
+    }
+
+    int threadCount = concurrency < sheetCount ? concurrency : sheetCount;
+    std::vector<uv_thread_t> threads(threadCount > 1 ? threadCount - 1 : 0);
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        uv_thread_create(&threads[i], ThreadMain, this);
+    }
+
+    Work(replica);
+
+    for (size_t i = 0; i < threads.size(); i++) {
+        uv_thread_join(&threads[i]);
+    }
+
+    return !failed;
+}
+
+
+const std::vector<std::string>& BookSplit::GetFiles() const {
+    return files;
+}
+
+
+const std::string& BookSplit::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+void BookSplit::ThreadMain(void* split) {
+    BookSplit* that = static_cast<BookSplit*>(split);
+    libxl::Book* replica = that->LoadReplica();
+
+    if (replica) that->Work(replica);
+}
+
+
+void BookSplit::Work(libxl::Book* replica) {
+    int index;
+
+    while ((index = NextSheet()) >= 0) {
+        if (!SplitSheet(replica, index)) break;
+    }
+
+    replica->release();
+}
+
+
+bool BookSplit::SplitSheet(libxl::Book* replica, int index) {
+    // Chart sheets cannot be imported and are skipped
+    if (replica->sheetType(index) != libxl::SHEETTYPE_SHEET) return true;
+
+    libxl::Sheet* sheet = replica->getSheet(index);
+    if (!sheet) return Fail(replica->errorMessage());
+
+    libxl::Book* target = Book::CreateLibxlBook(targetType);
+    if (!target) return Fail("unknown error");
+
+    const std::string& path = paths[index];
+    SheetImport sheetImport(replica, target);
+
+    bool success;
+
+    if (!sheetImport.Import(sheet, sheet->name())) {
+        success = Fail(sheetImport.ErrorMessage());
+    } else if (!target->save(path.c_str())) {
+        success = Fail(target->errorMessage());
+    } else {
+        success = true;
+    }
+
+    target->release();
+
+    if (success) files[index] = path;
+
+    return success;
+}
+
+
+libxl::Book* BookSplit::LoadReplica() {
+    libxl::Book* replica = Book::CreateLibxlBook(sourceType);
+
+    if (!replica) {
+        Fail("unknown error");
+        return NULL;
+    }
+
+    if (!replica->loadRaw(data, size)) {
+        Fail(replica->errorMessage());
+        replica->release();
+        return NULL;
+    }
+
+    return replica;
+}
+
+
+int BookSplit::NextSheet() {
+    uv_mutex_lock(&mutex);
+    int index = (failed || nextSheet >= sheetCount) ? -1 : nextSheet++;
+    uv_mutex_unlock(&mutex);
+
+    return index;
+}
+
+
+// Paths are assigned before any thread starts, so they don't depend on the
+// order in which sheets are processed
+bool BookSplit::AssignPaths(libxl::Book* replica) {
+    std::set<std::string> used;
+    paths.resize(sheetCount);
+
+    for (int i = 0; i < sheetCount; i++) {
+        if (replica->sheetType(i) != libxl::SHEETTYPE_SHEET) continue;
+
+        libxl::Sheet* sheet = replica->getSheet(i);
+        if (!sheet) return Fail(replica->errorMessage());
+
+        std::string name = FileName(sheet->name(), i);
+
+        // Names can repeat once invalid characters are replaced (and on
+        // case insensitive file systems), so repeats get the sheet index
+        while (!used.insert(LowercaseSheetName(name)).second) {
+            std::ostringstream ss;
+            ss << name << "_" << i;
+            name = ss.str();
+        }
+
+        paths[i] = FilePath(name);
+    }
+
+    return true;
+}
+
+
+std::string BookSplit::FileName(const char* sheetName, int index) {
+    std::string name(sheetName ? sheetName : "");
+
+    // Sheet names may contain characters that are not allowed in file names
+    for (size_t i = 0; i < name.size(); i++) {
+        if (strchr("/\\:*?\"<>|", name[i])) name[i] = '_';
+    }
+
+    if (name.empty() || name[0] == '.') {
+        std::ostringstream ss;
+        ss << "sheet" << index;
+        name = ss.str();
+    }
+
+    return name;
+}
+
+
+std::string BookSplit::FilePath(const std::string& name) const {
+    std::string path(outDir);
+    if (!path.empty() && path[path.size() - 1] != PATH_SEPARATOR) {
+        path += PATH_SEPARATOR;
+    }
+
+    return path + name + (targetType == BOOK_TYPE_XLS ? ".xls" : ".xlsx");
+}
+
+
+bool BookSplit::Fail(const std::string& message) {
+    uv_mutex_lock(&mutex);
+
+    if (!failed) {
+        failed = true;
+        errorMessage = message;
+    }
+
+    uv_mutex_unlock(&mutex);
+
+    return false;
+}
+
+
+}
@@ -0,0 +1,90 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_BOOK_SPLIT_H
+#define BINDINGS_BOOK_SPLIT_H
+
+#include <string>
+#include <vector>
+
+#include <uv.h>
+#include <libxl.h>
+
+namespace node_libxl {
+
+
+// Writes every sheet of a book to a separate file. Each worker thread loads
+// its own replica of the source book and imports the sheets it picks into
+// fresh books, so neither libxl book is ever shared between threads.
+class BookSplit {
+    public:
+
+        // A target type of -1 keeps the type of the source book
+        BookSplit(const char* data, size_t size, const std::string& outDir,
+            int targetType, int concurrency);
+        ~BookSplit();
+
+        // Returns BOOK_TYPE_XLS, BOOK_TYPE_XLSX or -1 if unknown
+        static int DetectType(const char* data, size_t size);
+
+        bool Run();
+
+        const std::vector<std::string>& GetFiles() const;
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        static void ThreadMain(void* split);
+
+        void Work(libxl::Book* replica);
+        bool SplitSheet(libxl::Book* replica, int index);
+
+        libxl::Book* LoadReplica();
+        int NextSheet();
+        bool AssignPaths(libxl::Book* replica);
+        static std::string FileName(const char* sheetName, int index);
+        std::string FilePath(const std::string& name) const;
+
+        bool Fail(const std::string& message);
+
+        const char* data;
+        size_t size;
+        std::string outDir;
+        int sourceType, targetType, concurrency;
+
+        uv_mutex_t mutex;
+        int nextSheet, sheetCount;
+        bool failed;
+
+        std::vector<std::string> paths, files;
+        std::string errorMessage;
+
+        BookSplit(const BookSplit&);
+        const BookSplit& operator=(const BookSplit&);
+};
+
+
+}
+
+#endif // BINDINGS_BOOK_SPLIT_H
@@ -0,0 +1,85 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "byte_source.h"
+
+namespace node_libxl {
+
+
+BufferSource::BufferSource(const char* data, size_t size) :
+    data(data),
+    size(size)
+{}
+
+
+uint64_t BufferSource::Size() const {
+    return size;
+}
+
+
+bool BufferSource::Read(uint64_t offset, size_t length, std::string& out) {
+    if (offset > size) return false;
+    if (length > size - offset) length = size - offset;
+
+    out.assign(data + offset, length);
+    return true;
+}
+
+
+FileSource::FileSource(const std::string& path) :
+    file(path.c_str(), std::ios::in | std::ios::binary),
+    size(0)
+{
+    if (file && file.seekg(0, std::ios::end)) {
+        size = file.tellg();
+    }
+}
+
+
+bool FileSource::IsOpen() const {
+    return file.is_open() && !file.fail();
+}
+
+
+uint64_t FileSource::Size() const {
+    return size;
+}
+
+
+bool FileSource::Read(uint64_t offset, size_t length, std::string& out) {
+    if (offset > size) return false;
+    if (length > size - offset) length = size - offset;
+
+    out.resize(length);
+    if (length == 0) return true;
+
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(&out[0], length);
+
+    return static_cast<size_t>(file.gcount()) == length;
+}
+
+
+}
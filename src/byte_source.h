@@ -0,0 +1,110 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_BYTE_SOURCE_H
+#define BINDINGS_BYTE_SOURCE_H
+
+#include <stdint.h>
+
+#include <fstream>
+#include <string>
+
+namespace node_libxl {
+
+
+// Random access to the bytes of a document in memory or on disk, so that
+// container formats can be inspected without reading files completely.
+class ByteSource {
+    public:
+
+        virtual ~ByteSource() {}
+
+        virtual uint64_t Size() const = 0;
+
+        // Reads up to length bytes at offset into out; returns false on I/O
+        // errors or if offset is beyond the end of the source
+        virtual bool Read(uint64_t offset, size_t length, std::string& out) = 0;
+
+        // Little endian integers as used by zip and OLE2 files
+        static uint16_t Uint16(const char* data) {
+            const unsigned char* bytes =
+                reinterpret_cast<const unsigned char*>(data);
+
+            return bytes[0] | (bytes[1] << 8);
+        }
+
+        static uint32_t Uint32(const char* data) {
+            return Uint16(data) |
+                (static_cast<uint32_t>(Uint16(data + 2)) << 16);
+        }
+
+        static uint64_t Uint64(const char* data) {
+            return Uint32(data) |
+                (static_cast<uint64_t>(Uint32(data + 4)) << 32);
+        }
+};
+
+
+// The memory must outlive the source
+class BufferSource : public ByteSource {
+    public:
+
+        BufferSource(const char* data, size_t size);
+
+        virtual uint64_t Size() const;
+        virtual bool Read(uint64_t offset, size_t length, std::string& out);
+
+    private:
+
+        const char* data;
+        size_t size;
+
+        BufferSource(const BufferSource&);
+        const BufferSource& operator=(const BufferSource&);
+};
+
+
+class FileSource : public ByteSource {
+    public:
+
+        explicit FileSource(const std::string& path);
+
+        bool IsOpen() const;
+
+        virtual uint64_t Size() const;
+        virtual bool Read(uint64_t offset, size_t length, std::string& out);
+
+    private:
+
+        std::ifstream file;
+        uint64_t size;
+
+        FileSource(const FileSource&);
+        const FileSource& operator=(const FileSource&);
+};
+
+
+}
+
+#endif // BINDINGS_BYTE_SOURCE_H
@@ -0,0 +1,133 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "cell_reference.h"
+
+namespace node_libxl {
+
+
+// XLSX limits, XFD1048576
+static const int MAX_COLUMN_LETTERS = 3;
+static const int MAX_ROW_DIGITS = 7;
+
+
+CellReference::CellReference() :
+    row(0),
+    col(0),
+    rowRelative(true),
+    colRelative(true)
+{}
+
+
+CellReference::CellReference(int row, int col, bool rowRelative,
+        bool colRelative) :
+    row(row),
+    col(col),
+    rowRelative(rowRelative),
+    colRelative(colRelative)
+{}
+
+
+size_t CellReference::Parse(const char* str, size_t length) {
+    size_t pos = 0;
+    bool parsedColRelative = true, parsedRowRelative = true;
+    int parsedCol = 0, parsedRow = 0, letters = 0, digits = 0;
+
+    if (pos < length && str[pos] == '$') {
+        parsedColRelative = false;
+        pos++;
+    }
+
+    for (; pos < length && letters <= MAX_COLUMN_LETTERS; pos++, letters++) {
+        char c = str[pos];
+
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        if (c < 'A' || c > 'Z') break;
+
+        parsedCol = parsedCol * 26 + (c - 'A' + 1);
+    }
+
+    if (letters == 0 || letters > MAX_COLUMN_LETTERS) return 0;
+
+    if (pos < length && str[pos] == '$') {
+        parsedRowRelative = false;
+        pos++;
+    }
+
+    for (; pos < length && digits <= MAX_ROW_DIGITS; pos++, digits++) {
+        char c = str[pos];
+        if (c < '0' || c > '9') break;
+
+        parsedRow = parsedRow * 10 + (c - '0');
+    }
+
+    if (digits == 0 || digits > MAX_ROW_DIGITS || parsedRow == 0) return 0;
+
+    row = parsedRow - 1;
+    col = parsedCol - 1;
+    rowRelative = parsedRowRelative;
+    colRelative = parsedColRelative;
+
+    return pos;
+}
+
+
+void CellReference::AppendTo(std::string& out) const {
+    if (!colRelative) out += '$';
+    AppendColumn(out, col);
+
+    if (!rowRelative) out += '$';
+
+    char digits[16];
+    int count = 0;
+
+    for (int value = row + 1; value > 0 || count == 0; value /= 10) {
+        digits[count++] = '0' + value % 10;
+    }
+
+    while (count > 0) out += digits[--count];
+}
+
+
+std::string CellReference::ToString() const {
+    std::string out;
+    AppendTo(out);
+
+    return out;
+}
+
+
+void CellReference::AppendColumn(std::string& out, int col) {
+    char letters[8];
+    int count = 0;
+
+    for (int value = col + 1; value > 0 && count < 8; value = (value - 1) / 26) {
+        letters[count++] = 'A' + (value - 1) % 26;
+    }
+
+    while (count > 0) out += letters[--count];
+}
+
+
+}
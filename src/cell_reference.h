@@ -0,0 +1,59 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_CELL_REFERENCE_H
+#define BINDINGS_CELL_REFERENCE_H
+
+#include <cstddef>
+#include <string>
+
+namespace node_libxl {
+
+
+// An A1 style cell reference like "B3" or "$B$3", with zero based row and
+// column (same semantics as Sheet::addrToRowCol).
+class CellReference {
+    public:
+
+        CellReference();
+        CellReference(int row, int col, bool rowRelative = true,
+            bool colRelative = true);
+
+        // Parses a reference at the start of str and returns the number of
+        // characters consumed, or 0 if str does not start with a reference
+        size_t Parse(const char* str, size_t length);
+
+        void AppendTo(std::string& out) const;
+        std::string ToString() const;
+
+        static void AppendColumn(std::string& out, int col);
+
+        int row, col;
+        bool rowRelative, colRelative;
+};
+
+
+}
+
+#endif // BINDINGS_CELL_REFERENCE_H
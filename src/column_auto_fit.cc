@@ -0,0 +1,513 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "column_auto_fit.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+// Advance widths of the printable ASCII characters (32 - 126) in 1/1000 em,
+// taken from the Helvetica and Times metrics. Arial and Times New Roman
+// share these metrics, and they are close enough for Calibri, Verdana,
+// Cambria and friends.
+const unsigned short SANS_WIDTHS[] = {
+    278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333,
+    278, 278, 556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278,
+    584, 584, 584, 556, 1015, 667, 667, 722, 722, 667, 611, 778, 722, 278,
+    500, 667, 556, 833, 722, 778, 667, 778, 722, 667, 611, 722, 667, 944,
+    667, 667, 611, 278, 278, 278, 469, 556, 333, 556, 556, 500, 556, 556,
+    278, 556, 556, 222, 222, 500, 222, 833, 556, 556, 556, 556, 333, 500,
+    278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584
+};
+
+const unsigned short SERIF_WIDTHS[] = {
+    250, 333, 408, 500, 500, 833, 778, 180, 333, 333, 500, 564, 250, 333,
+    250, 278, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 278, 278,
+    564, 564, 564, 444, 921, 722, 667, 667, 722, 611, 556, 722, 722, 333,
+    389, 722, 611, 889, 722, 722, 556, 722, 667, 556, 611, 722, 722, 944,
+    722, 722, 611, 333, 278, 333, 469, 500, 333, 444, 500, 444, 500, 444,
+    333, 500, 500, 278, 278, 500, 278, 778, 500, 500, 500, 500, 333, 389,
+    278, 500, 500, 722, 500, 500, 444, 480, 200, 480, 541
+};
+
+// Column widths are measured in digit widths
+const double SANS_DIGIT_WIDTH = 556;
+const double SERIF_DIGIT_WIDTH = 500;
+
+const double BOLD_FACTOR = 1.08;
+const double WIDE_GLYPH_WIDTH = 1.8;
+
+// Excel refuses wider columns
+const double MAX_COLUMN_WIDTH = 255;
+
+
+enum FontFamily {
+    FAMILY_SANS,
+    FAMILY_SERIF,
+    FAMILY_MONO
+};
+
+
+FontFamily GetFontFamily(const char* name) {
+    std::string lower(name ? name : "");
+    for (size_t i = 0; i < lower.size(); i++) {
+        lower[i] = tolower(static_cast<unsigned char>(lower[i]));
+    }
+
+    const char* mono[] = {"courier", "consolas", "mono", "console", NULL};
+    const char* serif[] = {"times", "georgia", "cambria", "garamond",
+        "antiqua", "serif", NULL};
+
+    for (int i = 0; mono[i]; i++) {
+        if (lower.find(mono[i]) != std::string::npos) return FAMILY_MONO;
+    }
+
+    if (lower.find("sans") != std::string::npos) return FAMILY_SANS;
+
+    for (int i = 0; serif[i]; i++) {
+        if (lower.find(serif[i]) != std::string::npos) return FAMILY_SERIF;
+    }
+
+    return FAMILY_SANS;
+}
+
+
+// East asian characters occupy roughly two digit widths
+bool IsWideCodePoint(unsigned long cp) {
+    return (cp >= 0x1100 && cp <= 0x115F) || (cp >= 0x2E80 && cp <= 0xA4CF) ||
+        (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+        (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60) ||
+        (cp >= 0xFFE0 && cp <= 0xFFE6) || cp >= 0x20000;
+}
+
+
+// Decodes the UTF-8 sequence at text[pos] and advances pos
+unsigned long NextCodePoint(const std::string& text, size_t& pos) {
+    unsigned char c = text[pos++];
+    int trailing = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    unsigned long cp = trailing ? c & (0x3F >> trailing) : c;
+
+    for (; trailing > 0 && pos < text.size(); trailing--) {
+        cp = (cp << 6) | (text[pos++] & 0x3F);
+    }
+
+    return cp;
+}
+
+
+std::string FormatDouble(double value, int precision,
+    std::ios_base::fmtflags flags = std::ios_base::fmtflags())
+{
+    std::ostringstream ss;
+
+    ss.flags(flags);
+    ss.precision(precision);
+    ss << value;
+
+    return ss.str();
+}
+
+
+void InsertThousandsSeparators(std::string& digits) {
+    for (int i = static_cast<int>(digits.size()) - 3; i > 0; i -= 3) {
+        digits.insert(i, ",");
+    }
+}
+
+
+// Representative text for a run of date / time format characters
+std::string DateToken(char token, size_t length) {
+    switch (tolower(token)) {
+        case 'y':
+            return length <= 2 ? "00" : "0000";
+        case 'm':
+            return length <= 2 ? "00" : length == 3 ? "Sep" :
+                length == 4 ? "September" : "S";
+        case 'd':
+            return length <= 2 ? "00" : length == 3 ? "Wed" : "Wednesday";
+        default:
+            return "00";
+    }
+}
+
+
+}
+
+
+ColumnAutoFit::ColumnAutoFit(libxl::Book* book, libxl::Sheet* sheet) :
+    book(book),
+    sheet(sheet),
+    defaultFontSize(0)
+{
+    book->defaultFont(&defaultFontSize);
+    if (defaultFontSize <= 0) defaultFontSize = 10;
+}
+
+
+bool ColumnAutoFit::Apply(const Range& range, double minWidth,
+    double maxWidth, double padding)
+{
+    // Merged cells spanning several columns do not contribute. Their row
+    // spans are collected per column of the range and sorted, so that each
+    // column skips them in a single pass.
+    std::vector<std::vector<std::pair<int, int> > > merged(range.Cols());
+    int mergeSize = sheet->mergeSize();
+
+    for (int i = 0; i < mergeSize; i++) {
+        Range merge;
+
+        if (!sheet->merge(i, &merge.rowFirst, &merge.rowLast,
+                &merge.colFirst, &merge.colLast) || merge.Cols() <= 1)
+        {
+            continue;
+        }
+
+        int first = std::max(merge.colFirst, range.colFirst),
+            last = std::min(merge.colLast, range.colLast);
+
+        for (int col = first; col <= last; col++) {
+            merged[col - range.colFirst].push_back(
+                std::make_pair(merge.rowFirst, merge.rowLast));
+        }
+    }
+
+    for (int col = range.colFirst; col <= range.colLast; col++) {
+        std::vector<std::pair<int, int> >& spans =
+            merged[col - range.colFirst];
+        std::sort(spans.begin(), spans.end());
+
+        double width = -1;
+        size_t next = 0;
+
+        for (int row = range.rowFirst; row <= range.rowLast; row++) {
+            while (next < spans.size() && spans[next].second < row) next++;
+
+            if (next < spans.size() && spans[next].first <= row) {
+                row = spans[next].second;
+                continue;
+            }
+
+            double cellWidth = CellWidth(row, col);
+            if (cellWidth > width) width = cellWidth;
+        }
+
+        if (width < 0) continue;
+
+        width += padding;
+        if (width > maxWidth) width = maxWidth;
+        if (width < minWidth) width = minWidth;
+        if (width > MAX_COLUMN_WIDTH) width = MAX_COLUMN_WIDTH;
+
+        if (!sheet->setCol(col, col, width, NULL, sheet->colHidden(col))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Returns -1 for empty cells
+double ColumnAutoFit::CellWidth(int row, int col) {
+    libxl::CellType type = sheet->cellType(row, col);
+
+    if (type == libxl::CELLTYPE_EMPTY || type == libxl::CELLTYPE_BLANK) {
+        return -1;
+    }
+
+    libxl::Format* format = sheet->cellFormat(row, col);
+
+    return TextWidth(DisplayText(row, col, type, format),
+        format ? format->font() : NULL);
+}
+
+
+const char* ColumnAutoFit::ErrorMessage() const {
+    return book->errorMessage();
+}
+
+
+std::string ColumnAutoFit::DisplayText(int row, int col,
+    libxl::CellType type, libxl::Format* format)
+{
+    switch (type) {
+        case libxl::CELLTYPE_STRING: {
+            const char* str = sheet->readStr(row, col);
+            return str ? str : "";
+        }
+
+        case libxl::CELLTYPE_NUMBER:
+            return FormatNumber(sheet->readNum(row, col), format);
+
+        case libxl::CELLTYPE_BOOLEAN:
+            return sheet->readBool(row, col) ? "TRUE" : "FALSE";
+
+        case libxl::CELLTYPE_ERROR:
+            return "#VALUE!";
+
+        default:
+            return "";
+    }
+}
+
+
+// Approximates the text Excel displays for a number. Only the features that
+// affect the length of the output are evaluated: placeholders, decimals,
+// thousands separators, percent, exponents, literals and date tokens.
+std::string ColumnAutoFit::FormatNumber(double value, libxl::Format* format) {
+    int numFormat = format ? format->numFormat() : libxl::NUMFORMAT_GENERAL;
+    const char* formatString = NumFormatString(numFormat);
+
+    if (!formatString && numFormat >= 164) {
+        formatString = book->customNumFormat(numFormat);
+    }
+
+    if (!formatString || !*formatString ||
+        strncmp(formatString, "General", 7) == 0)
+    {
+        return FormatDouble(value, 10);
+    }
+
+    // Select the section for positive numbers, negative numbers or zero
+    std::vector<std::string> sections(1);
+    bool quoted = false;
+
+    for (const char* c = formatString; *c; c++) {
+        if (*c == '"') quoted = !quoted;
+
+        if (*c == ';' && !quoted) {
+            sections.push_back("");
+        } else {
+            sections.back() += *c;
+        }
+    }
+
+    size_t section = 0;
+    if (value < 0 && sections.size() > 1) section = 1;
+    if (value == 0 && sections.size() > 2) section = 2;
+
+    const std::string& spec = sections[section];
+    bool negative = value < 0 && section == 0;
+
+    std::string prefix, suffix, text;
+    int integerDigits = 0, decimals = 0, percent = 0;
+    bool seenPlaceholder = false, inDecimals = false, thousands = false,
+         exponent = false, date = false;
+
+    for (size_t i = 0; i < spec.size(); i++) {
+        char c = spec[i];
+        std::string literal;
+
+        if (c == '"') {
+            size_t end = spec.find('"', i + 1);
+            if (end == std::string::npos) end = spec.size();
+            literal = spec.substr(i + 1, end - i - 1);
+            i = end;
+        } else if (c == '\\' && i + 1 < spec.size()) {
+            literal = spec.substr(++i, 1);
+        } else if (c == '_' && i + 1 < spec.size()) {
+            i++;
+            literal = " ";
+        } else if (c == '*' && i + 1 < spec.size()) {
+            i++;
+        } else if (c == '[') {
+            size_t end = spec.find(']', i);
+            if (end == std::string::npos) end = spec.size();
+
+            // Elapsed time like [h]
+            if (end > i + 1 && strchr("hHmMsS", spec[i + 1])) {
+                date = true;
+                literal = "00";
+            }
+
+            i = end;
+        } else if (c == '0' || c == '#' || c == '?') {
+            seenPlaceholder = true;
+
+            if (exponent) {
+                // Exponent digits are rendered by the stream
+            } else if (inDecimals) {
+                decimals++;
+            } else if (c == '0') {
+                integerDigits++;
+            }
+        } else if (c == '.' && !date) {
+            inDecimals = true;
+        } else if (c == ',' && seenPlaceholder && !inDecimals) {
+            thousands = true;
+        } else if (c == '%') {
+            percent++;
+            literal = "%";
+        } else if ((c == 'E' || c == 'e') && i + 1 < spec.size() &&
+            (spec[i + 1] == '+' || spec[i + 1] == '-'))
+        {
+            exponent = true;
+            i++;
+        } else if (strchr("yYmMdDhHsS", c)) {
+            size_t end = i;
+            while (end < spec.size() && tolower(spec[end]) == tolower(c)) end++;
+
+            date = true;
+            literal = DateToken(c, end - i);
+            i = end - 1;
+        } else if (c == 'A' && spec.compare(i, 5, "AM/PM") == 0) {
+            literal = "AM";
+            i += 4;
+        } else if (c == '@') {
+            literal = FormatDouble(value, 10);
+        } else {
+            literal = std::string(1, c);
+        }
+
+        if (date) {
+            text += literal;
+        } else if (seenPlaceholder) {
+            suffix += literal;
+        } else {
+            prefix += literal;
+        }
+    }
+
+    if (date) return text;
+    if (!seenPlaceholder) return prefix + suffix;
+
+    double absolute = fabs(value);
+    for (int i = 0; i < percent; i++) absolute *= 100;
+
+    if (exponent) {
+        text = FormatDouble(absolute, decimals,
+            std::ios_base::scientific | std::ios_base::uppercase);
+    } else {
+        text = FormatDouble(absolute, decimals, std::ios_base::fixed);
+
+        size_t point = text.find('.');
+        std::string integer = text.substr(0, point),
+            fraction = point == std::string::npos ? "" : text.substr(point);
+
+        if (integer == "0" && integerDigits == 0) integer = "";
+        while (static_cast<int>(integer.size()) < integerDigits) {
+            integer = "0" + integer;
+        }
+
+        if (thousands) InsertThousandsSeparators(integer);
+
+        text = integer + fraction;
+    }
+
+    return (negative ? "-" : "") + prefix + text + suffix;
+}
+
+
+const char* ColumnAutoFit::NumFormatString(int numFormat) {
+    switch (numFormat) {
+        case libxl::NUMFORMAT_GENERAL:                  return "General";
+        case libxl::NUMFORMAT_NUMBER:                   return "0";
+        case libxl::NUMFORMAT_NUMBER_D2:                return "0.00";
+        case libxl::NUMFORMAT_NUMBER_SEP:               return "#,##0";
+        case libxl::NUMFORMAT_NUMBER_SEP_D2:            return "#,##0.00";
+        case libxl::NUMFORMAT_CURRENCY_NEGBRA:          return "$#,##0_);($#,##0)";
+        case libxl::NUMFORMAT_CURRENCY_NEGBRARED:       return "$#,##0_);[Red]($#,##0)";
+        case libxl::NUMFORMAT_CURRENCY_D2_NEGBRA:       return "$#,##0.00_);($#,##0.00)";
+        case libxl::NUMFORMAT_CURRENCY_D2_NEGBRARED:    return "$#,##0.00_);[Red]($#,##0.00)";
+        case libxl::NUMFORMAT_PERCENT:                  return "0%";
+        case libxl::NUMFORMAT_PERCENT_D2:               return "0.00%";
+        case libxl::NUMFORMAT_SCIENTIFIC_D2:            return "0.00E+00";
+        case libxl::NUMFORMAT_FRACTION_ONEDIG:          return "# ?/?";
+        case libxl::NUMFORMAT_FRACTION_TWODIG:          return "# ?\?/?\?";
+        case libxl::NUMFORMAT_DATE:                     return "m/d/yyyy";
+        case libxl::NUMFORMAT_CUSTOM_D_MON_YY:          return "d-mmm-yy";
+        case libxl::NUMFORMAT_CUSTOM_D_MON:             return "d-mmm";
+        case libxl::NUMFORMAT_CUSTOM_MON_YY:            return "mmm-yy";
+        case libxl::NUMFORMAT_CUSTOM_HMM_AM:            return "h:mm AM/PM";
+        case libxl::NUMFORMAT_CUSTOM_HMMSS_AM:          return "h:mm:ss AM/PM";
+        case libxl::NUMFORMAT_CUSTOM_HMM:               return "h:mm";
+        case libxl::NUMFORMAT_CUSTOM_HMMSS:             return "h:mm:ss";
+        case libxl::NUMFORMAT_CUSTOM_MDYYYY_HMM:        return "m/d/yyyy h:mm";
+        case libxl::NUMFORMAT_NUMBER_SEP_NEGBRA:        return "#,##0_);(#,##0)";
+        case libxl::NUMFORMAT_NUMBER_SEP_NEGBRARED:     return "#,##0_);[Red](#,##0)";
+        case libxl::NUMFORMAT_NUMBER_D2_SEP_NEGBRA:     return "#,##0.00_);(#,##0.00)";
+        case libxl::NUMFORMAT_NUMBER_D2_SEP_NEGBRARED:  return "#,##0.00_);[Red](#,##0.00)";
+        case libxl::NUMFORMAT_ACCOUNT:                  return "_(* #,##0_);_(* (#,##0);_(* \"-\"_);_(@_)";
+        case libxl::NUMFORMAT_ACCOUNTCUR:               return "_($* #,##0_);_($* (#,##0);_($* \"-\"_);_(@_)";
+        case libxl::NUMFORMAT_ACCOUNT_D2:               return "_(* #,##0.00_);_(* (#,##0.00);_(* \"-\"??_);_(@_)";
+        case libxl::NUMFORMAT_ACCOUNT_D2_CUR:           return "_($* #,##0.00_);_($* (#,##0.00);_($* \"-\"??_);_(@_)";
+        case libxl::NUMFORMAT_CUSTOM_MMSS:              return "mm:ss";
+        case libxl::NUMFORMAT_CUSTOM_H0MMSS:            return "[h]:mm:ss";
+        case libxl::NUMFORMAT_CUSTOM_MMSS0:             return "mm:ss.0";
+        case libxl::NUMFORMAT_CUSTOM_000P0E_PLUS0:      return "##0.0E+0";
+        case libxl::NUMFORMAT_TEXT:                     return "@";
+        default:                                        return NULL;
+    }
+}
+
+
+// Width of a text in digit widths of the default font; multi line texts
+// are measured by their longest line
+double ColumnAutoFit::TextWidth(const std::string& text, libxl::Font* font) {
+    int defaultSize;
+    const char* name = font ? font->name() : book->defaultFont(&defaultSize);
+    double scale = font ?
+        static_cast<double>(font->size()) / defaultFontSize : 1;
+
+    if (font && font->bold()) scale *= BOLD_FACTOR;
+
+    FontFamily family = GetFontFamily(name);
+    double lineWidth = 0, width = 0;
+
+    for (size_t pos = 0; pos < text.size();) {
+        unsigned long cp = NextCodePoint(text, pos);
+
+        if (cp == '\n') {
+            lineWidth = 0;
+        } else if (cp < 32) {
+            continue;
+        } else if (family == FAMILY_MONO) {
+            lineWidth += IsWideCodePoint(cp) ? 2 : 1;
+        } else if (cp < 127) {
+            lineWidth += family == FAMILY_SERIF ?
+                SERIF_WIDTHS[cp - 32] / SERIF_DIGIT_WIDTH :
+                SANS_WIDTHS[cp - 32] / SANS_DIGIT_WIDTH;
+        } else {
+            lineWidth += IsWideCodePoint(cp) ? WIDE_GLYPH_WIDTH : 1;
+        }
+
+        if (lineWidth > width) width = lineWidth;
+    }
+
+    return width * scale;
+}
+
+
+}
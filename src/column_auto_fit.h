@@ -0,0 +1,75 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_COLUMN_AUTO_FIT_H
+#define BINDINGS_COLUMN_AUTO_FIT_H
+
+#include <string>
+
+#include <libxl.h>
+
+#include "range.h"
+
+namespace node_libxl {
+
+
+// Estimates the column widths required to display the cells of a range.
+// Widths are measured in the unit used by Sheet::setCol (the width of a
+// digit in the default font) from an approximation of the displayed text
+// and builtin glyph width tables for sans serif, serif and monospaced
+// fonts.
+class ColumnAutoFit {
+    public:
+
+        ColumnAutoFit(libxl::Book* book, libxl::Sheet* sheet);
+
+        // Columns without any content in the range are left untouched
+        bool Apply(const Range& range, double minWidth, double maxWidth,
+            double padding);
+
+        double CellWidth(int row, int col);
+
+        const char* ErrorMessage() const;
+
+    private:
+
+        std::string DisplayText(int row, int col, libxl::CellType type,
+            libxl::Format* format);
+        std::string FormatNumber(double value, libxl::Format* format);
+        const char* NumFormatString(int numFormat);
+
+        double TextWidth(const std::string& text, libxl::Font* font);
+
+        libxl::Book* book;
+        libxl::Sheet* sheet;
+        int defaultFontSize;
+
+        ColumnAutoFit(const ColumnAutoFit&);
+        const ColumnAutoFit& operator=(const ColumnAutoFit&);
+};
+
+
+}
+
+#endif // BINDINGS_COLUMN_AUTO_FIT_H
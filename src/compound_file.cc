@@ -0,0 +1,356 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "compound_file.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const char SIGNATURE[] = {
+    '\xD0', '\xCF', '\x11', '\xE0', '\xA1', '\xB1', '\x1A', '\xE1'
+};
+
+const size_t HEADER_SIZE = 512;
+const size_t DIRECTORY_ENTRY_SIZE = 128;
+const size_t HEADER_DIFAT_ENTRIES = 109;
+
+const uint32_t MAX_SECTOR = 0xFFFFFFFA;
+const uint32_t END_OF_CHAIN = 0xFFFFFFFE;
+
+const int TYPE_STREAM = 2;
+const int TYPE_ROOT = 5;
+
+
+std::string ToLower(const std::string& str) {
+    std::string lower(str);
+
+    for (size_t i = 0; i < lower.size(); i++) {
+        lower[i] = tolower(static_cast<unsigned char>(lower[i]));
+    }
+
+    return lower;
+}
+
+
+}
+
+
+CompoundFile::Stream::Stream() :
+    file(NULL),
+    mini(false),
+    size(0)
+{}
+
+
+uint64_t CompoundFile::Stream::Size() const {
+    return size;
+}
+
+
+bool CompoundFile::Stream::Read(uint64_t offset, size_t length,
+    std::string& out)
+{
+    return file && file->ReadStream(*this, offset, length, out);
+}
+
+
+CompoundFile::CompoundFile(ByteSource& source) :
+    source(source),
+    sectorSize(512),
+    miniSectorSize(64),
+    miniStreamCutoff(4096)
+{}
+
+
+bool CompoundFile::Open() {
+    std::string header;
+
+    if (!source.Read(0, HEADER_SIZE, header) || header.size() < HEADER_SIZE ||
+        memcmp(header.data(), SIGNATURE, sizeof(SIGNATURE)) != 0)
+    {
+        return Fail("not an OLE2 compound file");
+    }
+
+    const char* h = header.data();
+    int majorVersion = ByteSource::Uint16(h + 26),
+        sectorShift = ByteSource::Uint16(h + 30),
+        miniSectorShift = ByteSource::Uint16(h + 32);
+
+    if ((sectorShift != 9 && sectorShift != 12) || miniSectorShift != 6) {
+        return Fail("unsupported sector size");
+    }
+
+    sectorSize = 1 << sectorShift;
+    miniSectorSize = 1 << miniSectorShift;
+    miniStreamCutoff = ByteSource::Uint32(h + 56);
+
+    uint32_t fatSectorCount = ByteSource::Uint32(h + 44),
+        firstDirectorySector = ByteSource::Uint32(h + 48),
+        firstMiniFatSector = ByteSource::Uint32(h + 60),
+        difatSector = ByteSource::Uint32(h + 68),
+        difatSectorCount = ByteSource::Uint32(h + 72);
+
+    // The locations of the FAT sectors are stored in the header and in a
+    // chain of DIFAT sectors
+    std::vector<uint32_t> fatSectors;
+
+    for (size_t i = 0; i < HEADER_DIFAT_ENTRIES; i++) {
+        fatSectors.push_back(ByteSource::Uint32(h + 76 + 4 * i));
+    }
+
+    uint32_t entriesPerSector = sectorSize / 4;
+    std::string sector;
+
+    for (uint32_t i = 0; i < difatSectorCount && difatSector <= MAX_SECTOR;
+        i++)
+    {
+        if (!ReadSector(difatSector, sector)) return false;
+
+        for (uint32_t j = 0; j < entriesPerSector - 1; j++) {
+            fatSectors.push_back(ByteSource::Uint32(sector.data() + 4 * j));
+        }
+
+        difatSector = ByteSource::Uint32(
+            sector.data() + 4 * (entriesPerSector - 1));
+    }
+
+    if (fatSectorCount > fatSectors.size()) {
+        return Fail("corrupt sector allocation table");
+    }
+
+    fat.clear();
+
+    for (uint32_t i = 0; i < fatSectorCount; i++) {
+        if (!ReadSector(fatSectors[i], sector)) return false;
+
+        for (uint32_t j = 0; j < entriesPerSector; j++) {
+            fat.push_back(ByteSource::Uint32(sector.data() + 4 * j));
+        }
+    }
+
+    std::vector<uint32_t> chain;
+
+    miniFat.clear();
+    if (firstMiniFatSector <= MAX_SECTOR) {
+        if (!ReadChain(fat, firstMiniFatSector, chain)) return false;
+
+        for (size_t i = 0; i < chain.size(); i++) {
+            if (!ReadSector(chain[i], sector)) return false;
+
+            for (uint32_t j = 0; j < entriesPerSector; j++) {
+                miniFat.push_back(ByteSource::Uint32(sector.data() + 4 * j));
+            }
+        }
+    }
+
+    if (!ReadChain(fat, firstDirectorySector, chain)) return false;
+
+    directory.clear();
+
+    for (size_t i = 0; i < chain.size(); i++) {
+        if (!ReadSector(chain[i], sector)) return false;
+
+        for (size_t pos = 0; pos + DIRECTORY_ENTRY_SIZE <= sector.size();
+            pos += DIRECTORY_ENTRY_SIZE)
+        {
+            const char* e = sector.data() + pos;
+            DirectoryEntry entry;
+
+            // Names are UTF-16; only ASCII names are ever looked up
+            size_t nameLength = ByteSource::Uint16(e + 64);
+            for (size_t j = 0; j + 2 < nameLength && j < 64; j += 2) {
+                uint16_t c = ByteSource::Uint16(e + j);
+                entry.name += c < 0x80 ? static_cast<char>(c) : '?';
+            }
+
+            entry.type = static_cast<unsigned char>(e[66]);
+            entry.start = ByteSource::Uint32(e + 116);
+            entry.size = majorVersion >= 4 ? ByteSource::Uint64(e + 120) :
+                ByteSource::Uint32(e + 120);
+
+            directory.push_back(entry);
+        }
+    }
+
+    if (directory.empty() || directory[0].type != TYPE_ROOT) {
+        return Fail("missing root storage");
+    }
+
+    miniStreamSectors.clear();
+    if (directory[0].start <= MAX_SECTOR &&
+        !ReadChain(fat, directory[0].start, miniStreamSectors))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+bool CompoundFile::OpenStream(const std::string& name, Stream& stream) {
+    std::string lowerName = ToLower(name);
+
+    for (size_t i = 0; i < directory.size(); i++) {
+        const DirectoryEntry& entry = directory[i];
+
+        if (entry.type != TYPE_STREAM || ToLower(entry.name) != lowerName) {
+            continue;
+        }
+
+        stream.file = this;
+        stream.size = entry.size;
+        stream.mini = entry.size < miniStreamCutoff;
+        stream.sectors.clear();
+
+        if (entry.size == 0) return true;
+
+        return ReadChain(stream.mini ? miniFat : fat, entry.start,
+            stream.sectors);
+    }
+
+    return Fail("missing stream " + name);
+}
+
+
+const std::string& CompoundFile::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool CompoundFile::ReadSector(uint32_t sector, std::string& out) {
+    if (sector > MAX_SECTOR ||
+        !source.Read((static_cast<uint64_t>(sector) + 1) * sectorSize,
+            sectorSize, out) ||
+        out.size() != sectorSize)
+    {
+        return Fail("truncated compound file");
+    }
+
+    return true;
+}
+
+
+bool CompoundFile::ReadChain(const std::vector<uint32_t>& table,
+    uint32_t start, std::vector<uint32_t>& chain)
+{
+    chain.clear();
+
+    for (uint32_t sector = start; sector != END_OF_CHAIN;
+        sector = table[sector])
+    {
+        // A chain can not be longer than the table without a loop
+        if (sector >= table.size() || chain.size() >= table.size()) {
+            return Fail("corrupt sector chain");
+        }
+
+        chain.push_back(sector);
+    }
+
+    return true;
+}
+
+
+bool CompoundFile::ReadStream(const Stream& stream, uint64_t offset,
+    size_t length, std::string& out)
+{
+    out.clear();
+
+    if (offset > stream.size) return false;
+    if (length > stream.size - offset) length = stream.size - offset;
+
+    uint32_t unit = stream.mini ? miniSectorSize : sectorSize;
+    std::string piece;
+
+    while (out.size() < length) {
+        uint64_t position = offset + out.size();
+        size_t index = position / unit, within = position % unit,
+            pieceLength = unit - within;
+
+        if (pieceLength > length - out.size()) {
+            pieceLength = length - out.size();
+        }
+
+        if (index >= stream.sectors.size()) {
+            return Fail("truncated stream");
+        }
+
+        uint64_t fileOffset;
+
+        if (stream.mini) {
+            // Mini sectors are stored in the sectors of the mini stream
+            uint64_t miniOffset =
+                static_cast<uint64_t>(stream.sectors[index]) * unit + within;
+            size_t container = miniOffset / sectorSize;
+
+            if (container >= miniStreamSectors.size()) {
+                return Fail("truncated mini stream");
+            }
+
+            fileOffset =
+                (static_cast<uint64_t>(miniStreamSectors[container]) + 1) *
+                sectorSize + miniOffset % sectorSize;
+        } else {
+            fileOffset = (static_cast<uint64_t>(stream.sectors[index]) + 1) *
+                sectorSize + within;
+
+            // Consecutive sectors are read in one go
+            for (size_t next = index + 1; pieceLength < length - out.size() &&
+                next < stream.sectors.size() &&
+                stream.sectors[next] == stream.sectors[next - 1] + 1; next++)
+            {
+                pieceLength += unit;
+            }
+
+            if (pieceLength > length - out.size()) {
+                pieceLength = length - out.size();
+            }
+        }
+
+        if (!source.Read(fileOffset, pieceLength, piece) ||
+            piece.size() != pieceLength)
+        {
+            return Fail("truncated compound file");
+        }
+
+        out += piece;
+    }
+
+    return true;
+}
+
+
+bool CompoundFile::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return false;
+}
+
+
+}
@@ -0,0 +1,105 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_COMPOUND_FILE_H
+#define BINDINGS_COMPOUND_FILE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "byte_source.h"
+
+namespace node_libxl {
+
+
+// Reads the streams of an OLE2 compound file, the container of XLS files.
+// Streams are read on demand through their sector chains.
+class CompoundFile {
+    public:
+
+        class Stream {
+            public:
+
+                Stream();
+
+                uint64_t Size() const;
+
+                // Reads up to length bytes at offset into out
+                bool Read(uint64_t offset, size_t length, std::string& out);
+
+            private:
+
+                friend class CompoundFile;
+
+                CompoundFile* file;
+                std::vector<uint32_t> sectors;
+                bool mini;
+                uint64_t size;
+        };
+
+        explicit CompoundFile(ByteSource& source);
+
+        // Reads header, sector allocation tables and directory
+        bool Open();
+
+        // Looks up a stream in the root storage by name (case insensitive)
+        bool OpenStream(const std::string& name, Stream& stream);
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        friend class Stream;
+
+        struct DirectoryEntry {
+            std::string name;
+            int type;
+            uint32_t start;
+            uint64_t size;
+        };
+
+        bool ReadSector(uint32_t sector, std::string& out);
+        bool ReadChain(const std::vector<uint32_t>& table, uint32_t start,
+            std::vector<uint32_t>& chain);
+        bool ReadStream(const Stream& stream, uint64_t offset, size_t length,
+            std::string& out);
+
+        bool Fail(const std::string& message);
+
+        ByteSource& source;
+        uint32_t sectorSize, miniSectorSize, miniStreamCutoff;
+        std::vector<uint32_t> fat, miniFat, miniStreamSectors;
+        std::vector<DirectoryEntry> directory;
+        std::string errorMessage;
+
+        CompoundFile(const CompoundFile&);
+        const CompoundFile& operator=(const CompoundFile&);
+};
+
+
+}
+
+#endif // BINDINGS_COMPOUND_FILE_H
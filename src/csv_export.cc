@@ -0,0 +1,167 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "csv_export.h"
+#include "hash.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const char* ErrorCode(libxl::ErrorType error) {
+    switch (error) {
+        case libxl::ERRORTYPE_NULL:     return "#NULL!";
+        case libxl::ERRORTYPE_DIV_0:    return "#DIV/0!";
+        case libxl::ERRORTYPE_REF:      return "#REF!";
+        case libxl::ERRORTYPE_NAME:     return "#NAME?";
+        case libxl::ERRORTYPE_NUM:      return "#NUM!";
+        case libxl::ERRORTYPE_NA:       return "#N/A";
+        default:                        return "#VALUE!";
+    }
+}
+
+
+// Uses the shortest representation that reads back to the same value
+void AppendNumber(std::string& out, double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.15g", value);
+
+    if (strtod(buffer, NULL) != value) {
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+
+    out += buffer;
+}
+
+
+void AppendQuoted(std::string& out, const char* value) {
+    if (!strpbrk(value, ",\"\r\n")) {
+        out += value;
+        return;
+    }
+
+    out += '"';
+
+    for (const char* c = value; *c; c++) {
+        if (*c == '"') out += '"';
+        out += *c;
+    }
+
+    out += '"';
+}
+
+
+}
+
+
+CsvExport::CsvExport(libxl::Sheet* sheet, SheetJournal& journal) :
+    sheet(sheet),
+    journal(journal)
+{}
+
+
+void CsvExport::Run(const std::string* previous, std::string& out) {
+    int rows = sheet->lastRow(), cols = sheet->lastCol();
+    if (rows < 0) rows = 0;
+    if (cols < 0) cols = 0;
+
+    SheetJournal::Snapshot& snapshot = journal.GetSnapshot();
+    const std::vector<size_t>& offsets = snapshot.offsets;
+
+    // A different column count changes every line
+    bool reuse = previous && snapshot.cols == cols && !offsets.empty() &&
+        previous->size() == offsets.back() &&
+        HashBytes(previous->data(), previous->size()) == snapshot.checksum;
+
+    std::vector<size_t> newOffsets;
+    newOffsets.reserve(rows + 1);
+
+    out.clear();
+    if (reuse) out.reserve(previous->size());
+
+    for (int row = 0; row < rows; row++) {
+        int source = reuse ? journal.SourceRow(row) : -1;
+        newOffsets.push_back(out.size());
+
+        if (source >= 0 && source + 1 < static_cast<int>(offsets.size())) {
+            out.append(*previous, offsets[source],
+                offsets[source + 1] - offsets[source]);
+        } else {
+            RenderRow(row, cols, out);
+        }
+    }
+
+    newOffsets.push_back(out.size());
+
+    snapshot.offsets.swap(newOffsets);
+    snapshot.checksum = HashBytes(out.data(), out.size());
+    snapshot.cols = cols;
+
+    journal.Reset(rows);
+}
+
+
+void CsvExport::RenderRow(int row, int cols, std::string& out) {
+    for (int col = 0; col < cols; col++) {
+        if (col > 0) out += ',';
+        AppendCell(row, col, out);
+    }
+
+    out += '\n';
+}
+
+
+void CsvExport::AppendCell(int row, int col, std::string& out) {
+    switch (sheet->cellType(row, col)) {
+        case libxl::CELLTYPE_NUMBER:
+            AppendNumber(out, sheet->readNum(row, col));
+            break;
+
+        case libxl::CELLTYPE_STRING: {
+            const char* value = sheet->readStr(row, col);
+            if (value) AppendQuoted(out, value);
+            break;
+        }
+
+        case libxl::CELLTYPE_BOOLEAN:
+            out += sheet->readBool(row, col) ? "TRUE" : "FALSE";
+            break;
+
+        case libxl::CELLTYPE_ERROR:
+            out += ErrorCode(sheet->readError(row, col));
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+}
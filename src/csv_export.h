@@ -0,0 +1,64 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_CSV_EXPORT_H
+#define BINDINGS_CSV_EXPORT_H
+
+#include <string>
+
+#include <libxl.h>
+
+#include "sheet_journal.h"
+
+namespace node_libxl {
+
+
+// Renders the values of a sheet as CSV, one line per row from the first row
+// up to the last used one. If the previous output is passed in and matches
+// the snapshot of the journal, rows that did not change since are copied
+// from it instead of being read from the sheet again.
+class CsvExport {
+    public:
+
+        CsvExport(libxl::Sheet* sheet, SheetJournal& journal);
+
+        // previous may be NULL
+        void Run(const std::string* previous, std::string& out);
+
+    private:
+
+        void RenderRow(int row, int cols, std::string& out);
+        void AppendCell(int row, int col, std::string& out);
+
+        libxl::Sheet* sheet;
+        SheetJournal& journal;
+
+        CsvExport(const CsvExport&);
+        const CsvExport& operator=(const CsvExport&);
+};
+
+
+}
+
+#endif // BINDINGS_CSV_EXPORT_H
@@ -0,0 +1,277 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "dependency_graph.h"
+
+#include <algorithm>
+#include <map>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+typedef DependencyGraph::Node Node;
+
+
+std::string ReferenceText(const FormulaNode* node) {
+    if (node->type == FormulaNode::NAME) return node->text;
+
+    std::string text;
+
+    if (!node->sheet.empty()) {
+        text = "'" + node->sheet + "'!";
+    }
+
+    node->first.AppendTo(text);
+
+    if (node->isRange) {
+        text += ':';
+        node->last.AppendTo(text);
+    }
+
+    return text;
+}
+
+
+// Fills the offsets and targets of a CSR adjacency from edges sorted by
+// source index
+void BuildAdjacency(const std::vector<std::pair<int, int> >& edges,
+    size_t nodeCount, std::vector<int>& offsets, std::vector<int>& targets)
+{
+    offsets.assign(nodeCount + 1, 0);
+    targets.resize(edges.size());
+
+    for (size_t i = 0; i < edges.size(); i++) {
+        offsets[edges[i].first + 1]++;
+        targets[i] = edges[i].second;
+    }
+
+    for (size_t i = 0; i < nodeCount; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+}
+
+
+}
+
+
+bool DependencyGraph::Node::operator<(const Node& other) const {
+    if (sheet != other.sheet) return sheet < other.sheet;
+    if (row != other.row) return row < other.row;
+
+    return col < other.col;
+}
+
+
+DependencyGraph::DependencyGraph(libxl::Book* book) :
+    book(book),
+    resolver(book),
+    errorMessage(NULL)
+{}
+
+
+bool DependencyGraph::Build() {
+    std::vector<Edge> edges;
+    std::vector<Node> formulaCells;
+
+    sheets.clear();
+    for (int i = 0; i < book->sheetCount(); i++) {
+        sheets.push_back(book->getSheet(i));
+    }
+
+    for (size_t i = 0; i < sheets.size(); i++) {
+        libxl::Sheet* sheet = sheets[i];
+        if (!sheet) continue;
+
+        Range used = FormulaResolver::UsedRange(sheet);
+
+        for (int row = used.rowFirst; row <= used.rowLast; row++) {
+            for (int col = used.colFirst; col <= used.colLast; col++) {
+                if (!sheet->isFormula(row, col)) continue;
+
+                const char* formula = sheet->readFormula(row, col);
+
+                if (!formula) {
+                    errorMessage = book->errorMessage();
+                    return false;
+                }
+
+                Node cell(i, row, col);
+                formulaCells.push_back(cell);
+
+                FormulaNode* root = FormulaParser(formula).Parse();
+
+                if (root) {
+                    CollectEdges(root, sheet, cell, edges);
+                    delete root;
+                } else {
+                    AddBrokenReference(cell, formula);
+                }
+            }
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    // Number the nodes in sorted order
+    std::map<Node, int> index;
+
+    for (size_t i = 0; i < formulaCells.size(); i++) {
+        index[formulaCells[i]] = 0;
+    }
+
+    for (size_t i = 0; i < edges.size(); i++) {
+        index[edges[i].second] = 0;
+    }
+
+    nodes.clear();
+    for (std::map<Node, int>::iterator i = index.begin(); i != index.end();
+        ++i)
+    {
+        i->second = nodes.size();
+        nodes.push_back(i->first);
+    }
+
+    for (size_t i = 0; i < formulaCells.size(); i++) {
+        nodes[index[formulaCells[i]]].isFormula = true;
+    }
+
+    // Sorted edges map to sorted index pairs; a formula may reference the
+    // same cell more than once
+    std::vector<std::pair<int, int> > forward, backward;
+
+    for (size_t i = 0; i < edges.size(); i++) {
+        forward.push_back(std::make_pair(
+            index[edges[i].first], index[edges[i].second]));
+    }
+
+    forward.erase(std::unique(forward.begin(), forward.end()), forward.end());
+
+    for (size_t i = 0; i < forward.size(); i++) {
+        backward.push_back(std::make_pair(forward[i].second, forward[i].first));
+    }
+
+    std::sort(backward.begin(), backward.end());
+
+    BuildAdjacency(forward, nodes.size(), precedentOffsets, precedents);
+    BuildAdjacency(backward, nodes.size(), dependentOffsets, dependents);
+
+    return true;
+}
+
+
+const std::vector<DependencyGraph::Node>& DependencyGraph::Nodes() const {
+    return nodes;
+}
+
+
+const std::vector<int>& DependencyGraph::PrecedentOffsets() const {
+    return precedentOffsets;
+}
+
+
+const std::vector<int>& DependencyGraph::Precedents() const {
+    return precedents;
+}
+
+
+const std::vector<int>& DependencyGraph::DependentOffsets() const {
+    return dependentOffsets;
+}
+
+
+const std::vector<int>& DependencyGraph::Dependents() const {
+    return dependents;
+}
+
+
+const std::vector<DependencyGraph::BrokenReference>&
+    DependencyGraph::BrokenReferences() const
+{
+    return brokenReferences;
+}
+
+
+const char* DependencyGraph::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+void DependencyGraph::CollectEdges(const FormulaNode* node,
+    libxl::Sheet* sheet, const Node& cell, std::vector<Edge>& edges)
+{
+    if (node->type == FormulaNode::REFERENCE ||
+        node->type == FormulaNode::NAME)
+    {
+        libxl::Sheet* target;
+        Range range;
+
+        if (resolver.Resolve(node, sheet, target, range)) {
+            int targetIndex = SheetIndex(target);
+            range = range.Intersect(FormulaResolver::UsedRange(target));
+
+            for (int row = range.rowFirst; row <= range.rowLast; row++) {
+                for (int col = range.colFirst; col <= range.colLast; col++) {
+                    if (target->cellType(row, col) != libxl::CELLTYPE_EMPTY) {
+                        edges.push_back(
+                            Edge(cell, Node(targetIndex, row, col)));
+                    }
+                }
+            }
+        } else {
+            AddBrokenReference(cell, ReferenceText(node));
+        }
+    }
+
+    for (size_t i = 0; i < node->children.size(); i++) {
+        CollectEdges(node->children[i], sheet, cell, edges);
+    }
+}
+
+
+void DependencyGraph::AddBrokenReference(const Node& cell,
+    const std::string& reference)
+{
+    BrokenReference broken;
+    broken.sheet = cell.sheet;
+    broken.row = cell.row;
+    broken.col = cell.col;
+    broken.reference = reference;
+
+    brokenReferences.push_back(broken);
+}
+
+
+int DependencyGraph::SheetIndex(libxl::Sheet* sheet) const {
+    for (size_t i = 0; i < sheets.size(); i++) {
+        if (sheets[i] == sheet) return i;
+    }
+
+    return -1;
+}
+
+
+}
@@ -0,0 +1,110 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_DEPENDENCY_GRAPH_H
+#define BINDINGS_DEPENDENCY_GRAPH_H
+
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+#include "formula_parser.h"
+#include "formula_resolver.h"
+
+namespace node_libxl {
+
+
+// Dependency graph of all formula cells of a book. Nodes are the formula
+// cells and the non empty cells they reference (references are clamped to
+// the used area of their sheet), sorted by sheet index, row and column.
+// Edges are stored in compressed sparse row form: the precedents of node i
+// are precedents[precedentOffsets[i]] ... precedents[precedentOffsets[i + 1]
+// - 1], and likewise for dependents.
+class DependencyGraph {
+    public:
+
+        struct Node {
+            Node(int sheet, int row, int col) :
+                sheet(sheet), row(row), col(col), isFormula(false)
+            {}
+
+            bool operator<(const Node& other) const;
+
+            int sheet, row, col;
+            bool isFormula;
+        };
+
+        struct BrokenReference {
+            int sheet, row, col;
+
+            // The unresolvable reference or name, or the whole formula if
+            // it cannot be parsed
+            std::string reference;
+        };
+
+        explicit DependencyGraph(libxl::Book* book);
+
+        // Returns false if libxl fails to read a formula
+        bool Build();
+
+        const std::vector<Node>& Nodes() const;
+        const std::vector<int>& PrecedentOffsets() const;
+        const std::vector<int>& Precedents() const;
+        const std::vector<int>& DependentOffsets() const;
+        const std::vector<int>& Dependents() const;
+        const std::vector<BrokenReference>& BrokenReferences() const;
+
+        const char* ErrorMessage() const;
+
+    private:
+
+        typedef std::pair<Node, Node> Edge;
+
+        void CollectEdges(const FormulaNode* node, libxl::Sheet* sheet,
+            const Node& cell, std::vector<Edge>& edges);
+        void AddBrokenReference(const Node& cell,
+            const std::string& reference);
+
+        int SheetIndex(libxl::Sheet* sheet) const;
+
+        libxl::Book* book;
+        FormulaResolver resolver;
+        std::vector<libxl::Sheet*> sheets;
+
+        std::vector<Node> nodes;
+        std::vector<int> precedentOffsets, precedents;
+        std::vector<int> dependentOffsets, dependents;
+        std::vector<BrokenReference> brokenReferences;
+
+        const char* errorMessage;
+
+        DependencyGraph(const DependencyGraph&);
+        const DependencyGraph& operator=(const DependencyGraph&);
+};
+
+
+}
+
+#endif // BINDINGS_DEPENDENCY_GRAPH_H
@@ -72,6 +72,9 @@ NAN_METHOD(Font::SetSize) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setSize(size);
 
@@ -109,6 +112,9 @@ NAN_METHOD(Font::SetItalic){
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setItalic(italic);
 
@@ -136,6 +142,9 @@ NAN_METHOD(Font::SetStrikeOut) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setStrikeOut(strikeOut);
 
@@ -163,6 +172,9 @@ NAN_METHOD(Font::SetColor) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setColor(static_cast<libxl::Color>(color));
 
@@ -190,6 +202,9 @@ NAN_METHOD(Font::SetBold) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBold(bold);
 
@@ -217,6 +232,9 @@ NAN_METHOD(Font::SetScript) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setScript(static_cast<libxl::Script>(script));
 
@@ -244,6 +262,9 @@ NAN_METHOD(Font::SetUnderline) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setUnderline(static_cast<libxl::Underline>(underline));
 
@@ -276,6 +297,9 @@ NAN_METHOD(Font::SetName) {
 
     Font* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     if (!that->GetWrapped()->setName(*name)) {
         return util::ThrowLibxlError(that);
@@ -87,6 +87,9 @@ NAN_METHOD(Format::SetFont) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     if (!that->GetWrapped()->setFont(font->GetWrapped())) {
         return util::ThrowLibxlError(that);
@@ -106,6 +109,9 @@ NAN_METHOD(Format::SetNumFormat) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setNumFormat(format);
 
@@ -143,6 +149,9 @@ NAN_METHOD(Format::SetAlignH) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setAlignH(static_cast<libxl::AlignH>(align));
 
@@ -170,6 +179,9 @@ NAN_METHOD(Format::SetAlignV) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setAlignV(static_cast<libxl::AlignV>(align));
     
@@ -196,6 +208,9 @@ NAN_METHOD(Format::SetWrap) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setWrap(wrap);
 
@@ -223,6 +238,9 @@ NAN_METHOD(Format::SetRotation) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     if (!that->GetWrapped()->setRotation(rotation)) {
         return util::ThrowLibxlError(that);
@@ -252,6 +270,9 @@ NAN_METHOD(Format::SetIndent) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setIndent(indent);
 
@@ -278,6 +299,9 @@ NAN_METHOD(Format::SetShrinkToFit) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setShrinkToFit(shrink);
 
@@ -295,6 +319,9 @@ NAN_METHOD(Format::SetBorder) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorder(static_cast<libxl::BorderStyle>(border));
 
@@ -312,6 +339,9 @@ NAN_METHOD(Format::SetBorderColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderColor(static_cast<libxl::Color>(color));
 
@@ -339,6 +369,9 @@ NAN_METHOD(Format::SetBorderLeft) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderLeft(static_cast<libxl::BorderStyle>(border));
 
@@ -366,6 +399,9 @@ NAN_METHOD(Format::SetBorderRight) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderRight(static_cast<libxl::BorderStyle>(border));
 
@@ -393,6 +429,9 @@ NAN_METHOD(Format::SetBorderTop) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderTop(static_cast<libxl::BorderStyle>(border));
 
@@ -420,6 +459,9 @@ NAN_METHOD(Format::SetBorderBottom) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderBottom(static_cast<libxl::BorderStyle>(border));
 
@@ -447,6 +489,9 @@ NAN_METHOD(Format::SetBorderLeftColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderLeftColor(static_cast<libxl::Color>(color));
     NanReturnValue(args.This());
@@ -473,6 +518,9 @@ NAN_METHOD(Format::SetBorderRightColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderRightColor(static_cast<libxl::Color>(color));
     NanReturnValue(args.This());
@@ -499,6 +547,9 @@ NAN_METHOD(Format::SetBorderTopColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderTopColor(static_cast<libxl::Color>(color));
     NanReturnValue(args.This());
@@ -525,6 +576,9 @@ NAN_METHOD(Format::SetBorderBottomColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderBottomColor(static_cast<libxl::Color>(color));
     NanReturnValue(args.This());
@@ -551,6 +605,9 @@ NAN_METHOD(Format::SetBorderDiagonal) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderDiagonal(static_cast<libxl::BorderDiagonal>(border));
 
@@ -578,6 +635,9 @@ NAN_METHOD(Format::SetBorderDiagonalColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setBorderDiagonalColor(static_cast<libxl::Color>(color));
     NanReturnValue(args.This());
@@ -604,6 +664,9 @@ NAN_METHOD(Format::SetFillPattern) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setFillPattern(static_cast<libxl::FillPattern>(pattern));
 
@@ -631,6 +694,9 @@ NAN_METHOD(Format::SetPatternBackgroundColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setPatternBackgroundColor(static_cast<libxl::Color>(color));
 
@@ -658,6 +724,9 @@ NAN_METHOD(Format::SetPatternForegroundColor) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setPatternForegroundColor(static_cast<libxl::Color>(color));
 
@@ -685,6 +754,9 @@ NAN_METHOD(Format::SetLocked) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setLocked(locked);
 
@@ -712,6 +784,9 @@ NAN_METHOD(Format::SetHidden) {
 
     Format* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->GetBook()->Modified();
 
     that->GetWrapped()->setHidden(hidden);
 
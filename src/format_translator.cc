@@ -0,0 +1,241 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "format_translator.h"
+
+#include <sstream>
+
+namespace node_libxl {
+
+
+// Number formats below this index are builtin and identical in all books
+static const int FIRST_CUSTOM_NUMFORMAT = 164;
+
+
+// XLSX books report unset colors as -1, XLS books as 0x7F
+static const int COLOR_NONE = 0x7F;
+
+
+static int NormalizeColor(int color) {
+    return color < 0 ? COLOR_NONE : color;
+}
+
+
+FormatTranslator::FormatTranslator(libxl::Book* sourceBook,
+        libxl::Book* targetBook) :
+    sourceBook(sourceBook),
+    targetBook(targetBook)
+{}
+
+
+bool FormatTranslator::IsIdentity() const {
+    return sourceBook == targetBook;
+}
+
+
+libxl::Book* FormatTranslator::GetSourceBook() const {
+    return sourceBook;
+}
+
+
+libxl::Book* FormatTranslator::GetTargetBook() const {
+    return targetBook;
+}
+
+
+libxl::Format* FormatTranslator::Translate(libxl::Format* format) {
+    if (!format || IsIdentity()) return format;
+
+    std::map<libxl::Format*, libxl::Format*>::iterator cached =
+        formatCache.find(format);
+    if (cached != formatCache.end()) return cached->second;
+
+
+    std::string signature = Signature(format, sourceBook);
+    std::map<std::string, libxl::Format*>::iterator equivalent =
+        formatsBySignature.find(signature);
+
+    if (equivalent != formatsBySignature.end()) {
+        formatCache[format] = equivalent->second;
+        return equivalent->second;
+    }
+
+    libxl::Format* translated = targetBook->addFormat();
+    if (!translated) return NULL;
+
+    if (format->font()) {
+        libxl::Font* font = Translate(format->font());
+        if (!font || !translated->setFont(font)) return NULL;
+    }
+
+    int numFormat = TranslateNumFormat(format->numFormat());
+    if (numFormat < 0) return NULL;
+
+    translated->setNumFormat(numFormat);
+    translated->setAlignH(format->alignH());
+    translated->setAlignV(format->alignV());
+    translated->setWrap(format->wrap());
+    translated->setRotation(format->rotation());
+    translated->setIndent(format->indent());
+    translated->setShrinkToFit(format->shrinkToFit());
+    translated->setBorderLeft(format->borderLeft());
+    translated->setBorderRight(format->borderRight());
+    translated->setBorderTop(format->borderTop());
+    translated->setBorderBottom(format->borderBottom());
+    translated->setBorderLeftColor(format->borderLeftColor());
+    translated->setBorderRightColor(format->borderRightColor());
+    translated->setBorderTopColor(format->borderTopColor());
+    translated->setBorderBottomColor(format->borderBottomColor());
+    translated->setBorderDiagonal(format->borderDiagonal());
+    // XLSX books report an unset diagonal style as -1
+    if (format->borderDiagonalStyle() >= 0) {
+        translated->setBorderDiagonalStyle(format->borderDiagonalStyle());
+    }
+    translated->setBorderDiagonalColor(format->borderDiagonalColor());
+    translated->setFillPattern(format->fillPattern());
+    translated->setPatternForegroundColor(format->patternForegroundColor());
+    translated->setPatternBackgroundColor(format->patternBackgroundColor());
+    translated->setLocked(format->locked());
+    translated->setHidden(format->hidden());
+
+    formatCache[format] = translated;
+    formatsBySignature[signature] = translated;
+
+    return translated;
+}
+
+
+libxl::Font* FormatTranslator::Translate(libxl::Font* font) {
+    if (!font || IsIdentity()) return font;
+
+    std::map<libxl::Font*, libxl::Font*>::iterator cached =
+        fontCache.find(font);
+    if (cached != fontCache.end()) return cached->second;
+
+
+    std::string signature = Signature(font);
+    std::map<std::string, libxl::Font*>::iterator equivalent =
+        fontsBySignature.find(signature);
+
+    if (equivalent != fontsBySignature.end()) {
+        fontCache[font] = equivalent->second;
+        return equivalent->second;
+    }
+
+    libxl::Font* translated = targetBook->addFont();
+    if (!translated) return NULL;
+
+    if (font->name() && !translated->setName(font->name())) return NULL;
+
+    translated->setSize(font->size());
+    translated->setItalic(font->italic());
+    translated->setStrikeOut(font->strikeOut());
+    translated->setColor(font->color());
+    translated->setBold(font->bold());
+    translated->setScript(font->script());
+    translated->setUnderline(font->underline());
+
+    fontCache[font] = translated;
+    fontsBySignature[signature] = translated;
+
+    return translated;
+}
+
+
+std::string FormatTranslator::Signature(libxl::Format* format,
+        libxl::Book* book)
+{
+    std::ostringstream ss;
+
+    ss << (format->font() ? Signature(format->font()) : "") << '|';
+
+    // Custom number formats are compared by their description
+    int numFormat = format->numFormat();
+    const char* description = numFormat >= FIRST_CUSTOM_NUMFORMAT ?
+        book->customNumFormat(numFormat) : NULL;
+
+    if (description) {
+        ss << description;
+    } else {
+        ss << numFormat;
+    }
+
+    ss  << '|' << format->alignH() << ',' << format->alignV()
+        << ',' << format->wrap() << ',' << format->rotation()
+        << ',' << format->indent() << ',' << format->shrinkToFit()
+        << ',' << format->borderLeft() << ',' << format->borderRight()
+        << ',' << format->borderTop() << ',' << format->borderBottom()
+        << ',' << NormalizeColor(format->borderLeftColor())
+        << ',' << NormalizeColor(format->borderRightColor())
+        << ',' << NormalizeColor(format->borderTopColor())
+        << ',' << NormalizeColor(format->borderBottomColor())
+        << ',' << format->borderDiagonal();
+
+    // Diagonal style and color are meaningless (and not reported
+    // consistently) unless a diagonal border is set
+    if (format->borderDiagonal() != libxl::BORDERDIAGONAL_NONE) {
+        ss  << ',' << format->borderDiagonalStyle()
+            << ',' << NormalizeColor(format->borderDiagonalColor());
+    }
+
+    ss  << '|' << format->fillPattern()
+        << ',' << NormalizeColor(format->patternForegroundColor())
+        << ',' << NormalizeColor(format->patternBackgroundColor())
+        << ',' << format->locked() << ',' << format->hidden();
+
+    return ss.str();
+}
+
+
+std::string FormatTranslator::Signature(libxl::Font* font) {
+    std::ostringstream ss;
+
+    ss  << (font->name() ? font->name() : "") << '|' << font->size()
+        << ',' << font->italic() << ',' << font->strikeOut()
+        << ',' << font->color() << ',' << font->bold()
+        << ',' << font->script() << ',' << font->underline();
+
+    return ss.str();
+}
+
+
+int FormatTranslator::TranslateNumFormat(int numFormat) {
+    if (numFormat < FIRST_CUSTOM_NUMFORMAT) return numFormat;
+
+    std::map<int, int>::iterator cached = numFormatCache.find(numFormat);
+    if (cached != numFormatCache.end()) return cached->second;
+
+    const char* description = sourceBook->customNumFormat(numFormat);
+    if (!description) return -1;
+
+    int translated = targetBook->addCustomNumFormat(description);
+    if (!translated) return -1;
+
+    numFormatCache[numFormat] = translated;
+
+    return translated;
+}
+
+
+}
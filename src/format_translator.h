@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_FORMAT_TRANSLATOR_H
+#define BINDINGS_FORMAT_TRANSLATOR_H
+
+#include <map>
+#include <string>
+
+#include <libxl.h>
+
+namespace node_libxl {
+
+
+// Maps formats and fonts of one book to equivalent objects in another book.
+// Translations are cached, so every source format is recreated at most once
+// in the target book. In addition, source formats and fonts with identical
+// properties share one translation. Objects that already exist in the target
+// book are never reused, as later changes to them would restyle the copies.
+// If both books are identical, formats pass through unchanged.
+class FormatTranslator {
+    public:
+
+        FormatTranslator(libxl::Book* sourceBook, libxl::Book* targetBook);
+
+        libxl::Format* Translate(libxl::Format* format);
+        libxl::Font* Translate(libxl::Font* font);
+
+        bool IsIdentity() const;
+
+        libxl::Book* GetSourceBook() const;
+        libxl::Book* GetTargetBook() const;
+
+    private:
+
+        int TranslateNumFormat(int numFormat);
+
+        std::string Signature(libxl::Format* format, libxl::Book* book);
+        std::string Signature(libxl::Font* font);
+
+        libxl::Book *sourceBook, *targetBook;
+
+        std::map<libxl::Format*, libxl::Format*> formatCache;
+        std::map<libxl::Font*, libxl::Font*> fontCache;
+        std::map<int, int> numFormatCache;
+
+        std::map<std::string, libxl::Format*> formatsBySignature;
+        std::map<std::string, libxl::Font*> fontsBySignature;
+
+        FormatTranslator(const FormatTranslator&);
+        const FormatTranslator& operator=(const FormatTranslator&);
+};
+
+
+}
+
+#endif // BINDINGS_FORMAT_TRANSLATOR_H
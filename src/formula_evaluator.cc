@@ -0,0 +1,658 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "formula_evaluator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+typedef FormulaEvaluator::Value Value;
+
+
+const char* CYCLE_ERROR = "#CYCLE!";
+
+
+const char* ErrorCode(libxl::ErrorType error) {
+    switch (error) {
+        case libxl::ERRORTYPE_NULL:     return "#NULL!";
+        case libxl::ERRORTYPE_DIV_0:    return "#DIV/0!";
+        case libxl::ERRORTYPE_REF:      return "#REF!";
+        case libxl::ERRORTYPE_NAME:     return "#NAME?";
+        case libxl::ERRORTYPE_NUM:      return "#NUM!";
+        case libxl::ERRORTYPE_NA:       return "#N/A";
+        default:                        return "#VALUE!";
+    }
+}
+
+
+std::string ToLower(const std::string& str) {
+    std::string lower(str);
+
+    for (size_t i = 0; i < lower.size(); i++) {
+        lower[i] = tolower(static_cast<unsigned char>(lower[i]));
+    }
+
+    return lower;
+}
+
+
+bool IsFinite(double number) {
+    return number - number == 0;
+}
+
+
+bool IsWhitespace(char c) {
+    return isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+
+// Converts a value to a number like Excel does for arithmetic operands;
+// returns an error value if that is not possible
+bool ToNumber(const Value& value, double& number, Value& error) {
+    switch (value.type) {
+        case Value::EMPTY:
+            number = 0;
+            return true;
+
+        case Value::NUMBER:
+        case Value::BOOLEAN:
+            number = value.number;
+            return true;
+
+        case Value::STRING: {
+            const char* start = value.text.c_str();
+            char* end;
+
+            while (IsWhitespace(*start)) start++;
+            number = strtod(start, &end);
+
+            while (IsWhitespace(*end)) end++;
+            if (end != start && *end == '\0' && IsFinite(number)) {
+                return true;
+            }
+
+            error = Value::Error("#VALUE!");
+            return false;
+        }
+
+        default:
+            error = value;
+            return false;
+    }
+}
+
+
+std::string ToText(const Value& value) {
+    switch (value.type) {
+        case Value::NUMBER: {
+            std::ostringstream text;
+            text.precision(15);
+            text << value.number;
+
+            return text.str();
+        }
+
+        case Value::BOOLEAN:
+            return value.number ? "TRUE" : "FALSE";
+
+        case Value::EMPTY:
+            return "";
+
+        default:
+            return value.text;
+    }
+}
+
+
+// Orders values like Excel: numbers before strings before booleans,
+// strings are compared case insensitively. Empty cells take the type of
+// the other operand.
+int Compare(const Value& left, const Value& right) {
+    Value a = left, b = right;
+
+    if (a.type == Value::EMPTY) {
+        a = b.type == Value::STRING ? Value::String("") :
+            b.type == Value::BOOLEAN ? Value::Boolean(false) :
+            Value::Number(0);
+    }
+
+    if (b.type == Value::EMPTY) {
+        b = a.type == Value::STRING ? Value::String("") :
+            a.type == Value::BOOLEAN ? Value::Boolean(false) :
+            Value::Number(0);
+    }
+
+    if (a.type != b.type) {
+        return a.type == Value::NUMBER ||
+            (a.type == Value::STRING && b.type == Value::BOOLEAN) ? -1 : 1;
+    }
+
+    if (a.type == Value::STRING) {
+        int result = ToLower(a.text).compare(ToLower(b.text));
+        return result < 0 ? -1 : result > 0 ? 1 : 0;
+    }
+
+    return a.number < b.number ? -1 : a.number > b.number ? 1 : 0;
+}
+
+
+// Rounds half away from zero. The scaled value is rounded to 15 significant
+// digits first so that e.g. ROUND(2.675, 2) yields 2.68 like in Excel.
+double Round(double value, int digits) {
+    double factor = pow(10.0, std::abs(digits));
+    double scaled = digits >= 0 ? fabs(value) * factor : fabs(value) / factor;
+
+    std::ostringstream text;
+    text.precision(15);
+    text << scaled;
+    scaled = floor(strtod(text.str().c_str(), NULL) + 0.5);
+
+    scaled = digits >= 0 ? scaled / factor : scaled * factor;
+    return value < 0 ? -scaled : scaled;
+}
+
+
+Value CheckNumber(double number) {
+    return IsFinite(number) ? Value::Number(number) :
+        Value::Error("#NUM!");
+}
+
+
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::Value::Number(double number) {
+    Value value;
+    value.type = NUMBER;
+    value.number = number;
+
+    return value;
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::Value::String(
+    const std::string& text)
+{
+    Value value;
+    value.type = STRING;
+    value.text = text;
+
+    return value;
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::Value::Boolean(bool flag) {
+    Value value;
+    value.type = BOOLEAN;
+    value.number = flag ? 1 : 0;
+
+    return value;
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::Value::Error(
+    const std::string& code)
+{
+    Value value;
+    value.type = ERROR;
+    value.text = code;
+
+    return value;
+}
+
+
+bool FormulaEvaluator::CellKey::operator<(const CellKey& other) const {
+    if (sheet != other.sheet) {
+        return std::less<libxl::Sheet*>()(sheet, other.sheet);
+    }
+
+    return row < other.row || (row == other.row && col < other.col);
+}
+
+
+FormulaEvaluator::FormulaEvaluator(libxl::Book* book, libxl::Sheet* sheet) :
+    book(book),
+    sheet(sheet),
+    resolver(book),
+    errorMessage(NULL)
+{}
+
+
+FormulaEvaluator::~FormulaEvaluator() {
+    for (CellMap::iterator i = cells.begin(); i != cells.end(); ++i) {
+        delete i->second->formula;
+        delete i->second;
+    }
+}
+
+
+bool FormulaEvaluator::Evaluate(const Range& range) {
+    std::vector<CellKey> queue;
+    Range scan = range.Intersect(FormulaResolver::UsedRange(sheet));
+    bool ok = true;
+
+    for (int row = scan.rowFirst; row <= scan.rowLast && ok; row++) {
+        for (int col = scan.colFirst; col <= scan.colLast && ok; col++) {
+            if (sheet->isFormula(row, col)) {
+                AddCell(CellKey(sheet, row, col), queue, ok);
+            }
+        }
+    }
+
+    // The queue grows while precedents are discovered
+    for (size_t i = 0; i < queue.size() && ok; i++) {
+        Cell* cell = cells[queue[i]];
+        if (!cell->formula) continue;
+
+        std::vector<CellKey> precedents;
+        CollectPrecedents(cell->formula, queue[i].sheet, precedents);
+
+        std::set<CellKey> unique(precedents.begin(), precedents.end());
+
+        for (std::set<CellKey>::iterator j = unique.begin();
+            j != unique.end() && ok; ++j)
+        {
+            Cell* precedent = AddCell(*j, queue, ok);
+            if (!precedent) break;
+
+            precedent->dependents.push_back(queue[i]);
+            cell->pending++;
+        }
+    }
+
+    if (!ok) return false;
+
+    std::vector<CellKey> ready;
+    for (CellMap::iterator i = cells.begin(); i != cells.end(); ++i) {
+        if (i->second->pending == 0) ready.push_back(i->first);
+    }
+
+    while (!ready.empty()) {
+        CellKey key = ready.back();
+        ready.pop_back();
+
+        Cell* cell = cells[key];
+
+        if (cell->formula) {
+            cell->value = Eval(cell->formula, key.sheet);
+            if (cell->value.type == Value::EMPTY) {
+                cell->value = Value::Number(0);
+            }
+        } else {
+            cell->value = Value::Error("#NAME?");
+        }
+
+        cell->evaluated = true;
+
+        for (size_t i = 0; i < cell->dependents.size(); i++) {
+            if (--cells[cell->dependents[i]]->pending == 0) {
+                ready.push_back(cell->dependents[i]);
+            }
+        }
+    }
+
+    for (CellMap::iterator i = cells.begin(); i != cells.end(); ++i) {
+        if (!i->second->evaluated) {
+            i->second->value = Value::Error(CYCLE_ERROR);
+        }
+    }
+
+    return true;
+}
+
+
+const FormulaEvaluator::Value* FormulaEvaluator::Result(int row, int col)
+    const
+{
+    CellMap::const_iterator i = cells.find(CellKey(sheet, row, col));
+
+    return i == cells.end() ? NULL : &i->second->value;
+}
+
+
+const char* FormulaEvaluator::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+FormulaEvaluator::Cell* FormulaEvaluator::AddCell(const CellKey& key,
+    std::vector<CellKey>& queue, bool& ok)
+{
+    CellMap::iterator i = cells.find(key);
+    if (i != cells.end()) return i->second;
+
+    const char* formula = key.sheet->readFormula(key.row, key.col);
+
+    if (!formula) {
+        errorMessage = book->errorMessage();
+        ok = false;
+
+        return NULL;
+    }
+
+    Cell* cell = new Cell();
+    cell->formula = FormulaParser(formula).Parse();
+
+    cells[key] = cell;
+    queue.push_back(key);
+
+    return cell;
+}
+
+
+void FormulaEvaluator::CollectPrecedents(const FormulaNode* node,
+    libxl::Sheet* sheet, std::vector<CellKey>& precedents)
+{
+    libxl::Sheet* target;
+    Range range;
+
+    if ((node->type == FormulaNode::REFERENCE ||
+        node->type == FormulaNode::NAME) &&
+        resolver.Resolve(node, sheet, target, range))
+    {
+        range = range.Intersect(FormulaResolver::UsedRange(target));
+
+        for (int row = range.rowFirst; row <= range.rowLast; row++) {
+            for (int col = range.colFirst; col <= range.colLast; col++) {
+                if (target->isFormula(row, col)) {
+                    precedents.push_back(CellKey(target, row, col));
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < node->children.size(); i++) {
+        CollectPrecedents(node->children[i], sheet, precedents);
+    }
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::Eval(const FormulaNode* node,
+    libxl::Sheet* sheet)
+{
+    switch (node->type) {
+        case FormulaNode::NUMBER:
+            return Value::Number(node->number);
+
+        case FormulaNode::STRING:
+            return Value::String(node->text);
+
+        case FormulaNode::BOOLEAN:
+            return Value::Boolean(node->number != 0);
+
+        case FormulaNode::ERROR:
+            return Value::Error(node->text);
+
+        case FormulaNode::REFERENCE:
+        case FormulaNode::NAME: {
+            libxl::Sheet* target;
+            Range range;
+
+            if (!resolver.Resolve(node, sheet, target, range)) {
+                return Value::Error(
+                    node->type == FormulaNode::NAME ? "#NAME?" : "#REF!");
+            }
+
+            // Ranges are only supported as function arguments
+            if (range.Rows() != 1 || range.Cols() != 1) {
+                return Value::Error("#VALUE!");
+            }
+
+            return CellValue(target, range.rowFirst, range.colFirst);
+        }
+
+        case FormulaNode::UNARY:
+            return EvalUnary(node, sheet);
+
+        case FormulaNode::BINARY:
+            return EvalBinary(node, sheet);
+
+        default:
+            return EvalFunction(node, sheet);
+    }
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::EvalUnary(const FormulaNode* node,
+    libxl::Sheet* sheet)
+{
+    Value error;
+    double operand;
+
+    if (!ToNumber(Eval(node->children[0], sheet), operand, error)) {
+        return error;
+    }
+
+    if (node->text == "-") return Value::Number(-operand);
+    if (node->text == "%") return Value::Number(operand / 100);
+
+    return Value::Number(operand);
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::EvalBinary(const FormulaNode* node,
+    libxl::Sheet* sheet)
+{
+    Value left = Eval(node->children[0], sheet),
+        right = Eval(node->children[1], sheet);
+    const std::string& op = node->text;
+
+    if (left.type == Value::ERROR) return left;
+    if (right.type == Value::ERROR) return right;
+
+    if (op == "&") return Value::String(ToText(left) + ToText(right));
+
+    if (op == "=") return Value::Boolean(Compare(left, right) == 0);
+    if (op == "<>") return Value::Boolean(Compare(left, right) != 0);
+    if (op == "<") return Value::Boolean(Compare(left, right) < 0);
+    if (op == "<=") return Value::Boolean(Compare(left, right) <= 0);
+    if (op == ">") return Value::Boolean(Compare(left, right) > 0);
+    if (op == ">=") return Value::Boolean(Compare(left, right) >= 0);
+
+    Value error;
+    double a, b;
+
+    if (!ToNumber(left, a, error) || !ToNumber(right, b, error)) return error;
+
+    if (op == "+") return CheckNumber(a + b);
+    if (op == "-") return CheckNumber(a - b);
+    if (op == "*") return CheckNumber(a * b);
+
+    if (op == "/") {
+        return b == 0 ? Value::Error("#DIV/0!") : CheckNumber(a / b);
+    }
+
+    if (a == 0 && b < 0) return Value::Error("#DIV/0!");
+    return CheckNumber(pow(a, b));
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::EvalFunction(
+    const FormulaNode* node, libxl::Sheet* sheet)
+{
+    const std::string& name = node->text;
+    size_t argc = node->children.size();
+
+    if (name == "SUM" || name == "AVERAGE" || name == "MIN" ||
+        name == "MAX" || name == "COUNT")
+    {
+        return argc > 0 ? EvalAggregate(node, sheet) : Value::Error("#VALUE!");
+    }
+
+    if (name == "IF") {
+        if (argc < 2 || argc > 3) return Value::Error("#VALUE!");
+
+        Value condition = Eval(node->children[0], sheet);
+        bool result;
+
+        if (condition.type == Value::ERROR) return condition;
+
+        if (condition.type == Value::STRING) {
+            std::string text = ToLower(condition.text);
+            if (text != "true" && text != "false") {
+                return Value::Error("#VALUE!");
+            }
+
+            result = text == "true";
+        } else {
+            result = condition.number != 0;
+        }
+
+        if (result) return Eval(node->children[1], sheet);
+
+        return argc == 3 ? Eval(node->children[2], sheet) :
+            Value::Boolean(false);
+    }
+
+    if (name == "ROUND") {
+        if (argc != 2) return Value::Error("#VALUE!");
+
+        Value error;
+        double value, digits;
+
+        if (!ToNumber(Eval(node->children[0], sheet), value, error) ||
+            !ToNumber(Eval(node->children[1], sheet), digits, error))
+        {
+            return error;
+        }
+
+        return CheckNumber(Round(value, static_cast<int>(digits)));
+    }
+
+    return Value::Error("#NAME?");
+}
+
+
+// Inside of references only numbers are aggregated, while direct arguments
+// are converted to numbers (and ignored by COUNT if that is impossible)
+FormulaEvaluator::Value FormulaEvaluator::EvalAggregate(
+    const FormulaNode* node, libxl::Sheet* sheet)
+{
+    const std::string& name = node->text;
+    double sum = 0, min = 0, max = 0;
+    int count = 0;
+
+    for (size_t i = 0; i < node->children.size(); i++) {
+        const FormulaNode* argument = node->children[i];
+        std::vector<double> numbers;
+
+        if (argument->type == FormulaNode::REFERENCE ||
+            argument->type == FormulaNode::NAME)
+        {
+            libxl::Sheet* target;
+            Range range;
+
+            if (!resolver.Resolve(argument, sheet, target, range)) {
+                return Value::Error(
+                    argument->type == FormulaNode::NAME ? "#NAME?" : "#REF!");
+            }
+
+            range = range.Intersect(FormulaResolver::UsedRange(target));
+
+            for (int row = range.rowFirst; row <= range.rowLast; row++) {
+                for (int col = range.colFirst; col <= range.colLast; col++) {
+                    Value value = CellValue(target, row, col);
+
+                    if (value.type == Value::ERROR && name != "COUNT") {
+                        return value;
+                    }
+
+                    if (value.type == Value::NUMBER) {
+                        numbers.push_back(value.number);
+                    }
+                }
+            }
+        } else {
+            Value value = Eval(argument, sheet), error;
+            double number;
+
+            if (ToNumber(value, number, error)) {
+                numbers.push_back(number);
+            } else if (name != "COUNT") {
+                return error;
+            }
+        }
+
+        for (size_t j = 0; j < numbers.size(); j++, count++) {
+            sum += numbers[j];
+            min = count == 0 ? numbers[j] : std::min(min, numbers[j]);
+            max = count == 0 ? numbers[j] : std::max(max, numbers[j]);
+        }
+    }
+
+    if (name == "COUNT") return Value::Number(count);
+    if (name == "MIN") return Value::Number(min);
+    if (name == "MAX") return Value::Number(max);
+
+    if (name == "AVERAGE") {
+        return count == 0 ? Value::Error("#DIV/0!") :
+            Value::Number(sum / count);
+    }
+
+    return CheckNumber(sum);
+}
+
+
+FormulaEvaluator::Value FormulaEvaluator::CellValue(libxl::Sheet* sheet,
+    int row, int col)
+{
+    CellMap::iterator i = cells.find(CellKey(sheet, row, col));
+
+    if (i != cells.end()) {
+        return i->second->evaluated ? i->second->value :
+            Value::Error(CYCLE_ERROR);
+    }
+
+    switch (sheet->cellType(row, col)) {
+        case libxl::CELLTYPE_NUMBER:
+            return Value::Number(sheet->readNum(row, col));
+
+        case libxl::CELLTYPE_STRING: {
+            const char* text = sheet->readStr(row, col);
+            return text ? Value::String(text) : Value::Error("#VALUE!");
+        }
+
+        case libxl::CELLTYPE_BOOLEAN:
+            return Value::Boolean(sheet->readBool(row, col));
+
+        case libxl::CELLTYPE_ERROR:
+            return Value::Error(ErrorCode(sheet->readError(row, col)));
+
+        default:
+            return Value();
+    }
+}
+
+
+}
@@ -0,0 +1,139 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_FORMULA_EVALUATOR_H
+#define BINDINGS_FORMULA_EVALUATOR_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+#include "formula_parser.h"
+#include "formula_resolver.h"
+#include "range.h"
+
+namespace node_libxl {
+
+
+// Evaluates a subset of the Excel formula language natively: literals,
+// arithmetic, comparison and concatenation operators, references and ranges
+// (also on other sheets and through named ranges) and the functions SUM,
+// AVERAGE, MIN, MAX, COUNT, IF and ROUND. Formulas outside of this subset
+// evaluate to #NAME?.
+//
+// All formula cells the requested range depends on are collected into a
+// dependency graph and evaluated once, in topological order. Cells on a
+// reference cycle evaluate to the pseudo error #CYCLE!.
+class FormulaEvaluator {
+    public:
+
+        class Value {
+            public:
+
+                enum Type {
+                    EMPTY,
+                    NUMBER,
+                    STRING,
+                    BOOLEAN,
+                    ERROR
+                };
+
+                Value() : type(EMPTY), number(0) {}
+
+                static Value Number(double number);
+                static Value String(const std::string& text);
+                static Value Boolean(bool value);
+                static Value Error(const std::string& code);
+
+                Type type;
+                double number;
+                std::string text;
+        };
+
+        FormulaEvaluator(libxl::Book* book, libxl::Sheet* sheet);
+        ~FormulaEvaluator();
+
+        // Returns false if libxl fails to read a formula
+        bool Evaluate(const Range& range);
+
+        // Returns NULL for cells that hold no formula
+        const Value* Result(int row, int col) const;
+
+        const char* ErrorMessage() const;
+
+    private:
+
+        struct CellKey {
+            CellKey(libxl::Sheet* sheet, int row, int col) :
+                sheet(sheet), row(row), col(col)
+            {}
+
+            bool operator<(const CellKey& other) const;
+
+            libxl::Sheet* sheet;
+            int row, col;
+        };
+
+        struct Cell {
+            Cell() : formula(NULL), pending(0), evaluated(false) {}
+
+            FormulaNode* formula;
+            std::vector<CellKey> dependents;
+            int pending;
+            bool evaluated;
+            Value value;
+        };
+
+        typedef std::map<CellKey, Cell*> CellMap;
+
+        Cell* AddCell(const CellKey& key, std::vector<CellKey>& queue,
+            bool& ok);
+        void CollectPrecedents(const FormulaNode* node, libxl::Sheet* sheet,
+            std::vector<CellKey>& precedents);
+
+        Value Eval(const FormulaNode* node, libxl::Sheet* sheet);
+        Value EvalUnary(const FormulaNode* node, libxl::Sheet* sheet);
+        Value EvalBinary(const FormulaNode* node, libxl::Sheet* sheet);
+        Value EvalFunction(const FormulaNode* node, libxl::Sheet* sheet);
+        Value EvalAggregate(const FormulaNode* node, libxl::Sheet* sheet);
+
+        Value CellValue(libxl::Sheet* sheet, int row, int col);
+
+        libxl::Book* book;
+        libxl::Sheet* sheet;
+        FormulaResolver resolver;
+        CellMap cells;
+        const char* errorMessage;
+
+        FormulaEvaluator(const FormulaEvaluator&);
+        const FormulaEvaluator& operator=(const FormulaEvaluator&);
+};
+
+
+}
+
+#endif // BINDINGS_FORMULA_EVALUATOR_H
@@ -0,0 +1,467 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "formula_parser.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const char* ERROR_CODES[] = {
+    "#NULL!", "#DIV/0!", "#VALUE!", "#REF!", "#NAME?", "#NUM!", "#N/A", NULL
+};
+
+
+bool IsIdentifierChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' ||
+        c == '$' || c == '\\' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+
+std::string ToUpper(const std::string& str) {
+    std::string upper(str);
+
+    for (size_t i = 0; i < upper.size(); i++) {
+        upper[i] = toupper(static_cast<unsigned char>(upper[i]));
+    }
+
+    return upper;
+}
+
+
+}
+
+
+FormulaNode::FormulaNode(Type type) :
+    type(type),
+    number(0),
+    isRange(false)
+{}
+
+
+FormulaNode::~FormulaNode() {
+    for (size_t i = 0; i < children.size(); i++) {
+        delete children[i];
+    }
+}
+
+
+FormulaParser::FormulaParser(const std::string& formula) :
+    formula(formula),
+    pos(0)
+{}
+
+
+FormulaNode* FormulaParser::Parse() {
+    pos = 0;
+    errorMessage.clear();
+
+    SkipWhitespace();
+    Accept("=");
+
+    FormulaNode* node = ParseComparison();
+    if (!node) return NULL;
+
+    SkipWhitespace();
+
+    if (pos < formula.size()) {
+        delete node;
+        return Fail("unexpected character");
+    }
+
+    return node;
+}
+
+
+const std::string& FormulaParser::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+FormulaNode* FormulaParser::ParseComparison() {
+    FormulaNode* node = ParseConcatenation();
+    const char* operators[] = {"<>", "<=", ">=", "=", "<", ">", NULL};
+
+    while (node) {
+        const char* op = NULL;
+
+        for (int i = 0; operators[i] && !op; i++) {
+            if (Accept(operators[i])) op = operators[i];
+        }
+
+        if (!op) break;
+
+        node = Binary(op, node, ParseConcatenation());
+    }
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParseConcatenation() {
+    FormulaNode* node = ParseAdditive();
+
+    while (node && Accept("&")) {
+        node = Binary("&", node, ParseAdditive());
+    }
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParseAdditive() {
+    FormulaNode* node = ParseMultiplicative();
+
+    while (node) {
+        if (Accept("+")) {
+            node = Binary("+", node, ParseMultiplicative());
+        } else if (Accept("-")) {
+            node = Binary("-", node, ParseMultiplicative());
+        } else {
+            break;
+        }
+    }
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParseMultiplicative() {
+    FormulaNode* node = ParsePower();
+
+    while (node) {
+        if (Accept("*")) {
+            node = Binary("*", node, ParsePower());
+        } else if (Accept("/")) {
+            node = Binary("/", node, ParsePower());
+        } else {
+            break;
+        }
+    }
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParsePower() {
+    FormulaNode* node = ParsePercent();
+
+    while (node && Accept("^")) {
+        node = Binary("^", node, ParsePercent());
+    }
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParsePercent() {
+    FormulaNode* node = ParseUnary();
+
+    while (node && Accept("%")) {
+        FormulaNode* percent = new FormulaNode(FormulaNode::UNARY);
+        percent->text = "%";
+        percent->children.push_back(node);
+
+        node = percent;
+    }
+
+    return node;
+}
+
+
+// Negation binds stronger than all binary operators, so -2^2 is 4
+FormulaNode* FormulaParser::ParseUnary() {
+    const char* op = Accept("-") ? "-" : Accept("+") ? "+" : NULL;
+    if (!op) return ParsePrimary();
+
+    FormulaNode* operand = ParseUnary();
+    if (!operand) return NULL;
+
+    FormulaNode* node = new FormulaNode(FormulaNode::UNARY);
+    node->text = op;
+    node->children.push_back(operand);
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParsePrimary() {
+    SkipWhitespace();
+    if (pos >= formula.size()) return Fail("unexpected end of formula");
+
+    char c = formula[pos];
+
+    if (c == '(') {
+        pos++;
+
+        FormulaNode* node = ParseComparison();
+        if (node && !Accept(")")) {
+            delete node;
+            return Fail("missing )");
+        }
+
+        return node;
+    }
+
+    if (c == '"') {
+        FormulaNode* node = new FormulaNode(FormulaNode::STRING);
+
+        for (pos++; pos < formula.size(); pos++) {
+            if (formula[pos] == '"') {
+                if (pos + 1 < formula.size() && formula[pos + 1] == '"') {
+                    pos++;
+                } else {
+                    break;
+                }
+            }
+
+            node->text += formula[pos];
+        }
+
+        if (pos++ >= formula.size()) {
+            delete node;
+            return Fail("unterminated string");
+        }
+
+        return node;
+    }
+
+    if (c == '#') {
+        for (int i = 0; ERROR_CODES[i]; i++) {
+            size_t length = strlen(ERROR_CODES[i]);
+
+            if (formula.compare(pos, length, ERROR_CODES[i]) == 0) {
+                FormulaNode* node = new FormulaNode(FormulaNode::ERROR);
+                node->text = ERROR_CODES[i];
+                pos += length;
+
+                return node;
+            }
+        }
+
+        return Fail("unknown error code");
+    }
+
+    if (isdigit(static_cast<unsigned char>(c)) || c == '.') {
+        const char* start = formula.c_str() + pos;
+        char* end;
+
+        FormulaNode* node = new FormulaNode(FormulaNode::NUMBER);
+        node->number = strtod(start, &end);
+        pos += end - start;
+
+        // Row ranges like 1:3 are not supported
+        if (end == start || (pos < formula.size() && formula[pos] == ':')) {
+            delete node;
+            return Fail("invalid number");
+        }
+
+        return node;
+    }
+
+    if (c == '\'') {
+        std::string sheet;
+
+        for (pos++; pos < formula.size(); pos++) {
+            if (formula[pos] == '\'') {
+                if (pos + 1 < formula.size() && formula[pos + 1] == '\'') {
+                    pos++;
+                } else {
+                    break;
+                }
+            }
+
+            sheet += formula[pos];
+        }
+
+        if (pos + 1 >= formula.size() || formula[pos + 1] != '!') {
+            return Fail("invalid sheet reference");
+        }
+
+        pos += 2;
+        return ParseReference(sheet);
+    }
+
+    if (IsIdentifierChar(c)) return ParseIdentifier();
+
+    return Fail("unexpected character");
+}
+
+
+FormulaNode* FormulaParser::ParseIdentifier() {
+    size_t end = IdentifierEnd(pos);
+    std::string identifier = formula.substr(pos, end - pos);
+
+    if (end < formula.size() && formula[end] == '(') {
+        pos = end + 1;
+        return ParseFunction(ToUpper(identifier));
+    }
+
+    if (end < formula.size() && formula[end] == '!') {
+        pos = end + 1;
+        return ParseReference(identifier);
+    }
+
+    CellReference reference;
+    if (reference.Parse(identifier.c_str(), identifier.size()) ==
+        identifier.size())
+    {
+        return ParseReference("");
+    }
+
+    pos = end;
+
+    std::string upper = ToUpper(identifier);
+    if (upper == "TRUE" || upper == "FALSE") {
+        FormulaNode* node = new FormulaNode(FormulaNode::BOOLEAN);
+        node->number = upper == "TRUE";
+
+        return node;
+    }
+
+    FormulaNode* node = new FormulaNode(FormulaNode::NAME);
+    node->text = identifier;
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::ParseReference(const std::string& sheet) {
+    FormulaNode* node = new FormulaNode(FormulaNode::REFERENCE);
+    node->sheet = sheet;
+
+    size_t end = IdentifierEnd(pos);
+    if (node->first.Parse(formula.c_str() + pos, end - pos) != end - pos ||
+        end == pos)
+    {
+        delete node;
+        return Fail("invalid cell reference");
+    }
+
+    pos = end;
+    node->last = node->first;
+
+    if (pos < formula.size() && formula[pos] == ':') {
+        end = IdentifierEnd(++pos);
+
+        if (node->last.Parse(formula.c_str() + pos, end - pos) != end - pos ||
+            end == pos)
+        {
+            delete node;
+            return Fail("invalid range");
+        }
+
+        pos = end;
+        node->isRange = true;
+    }
+
+    return node;
+}
+
+
+// libxl returns the arguments of XLS formulas separated by semicolons
+FormulaNode* FormulaParser::ParseFunction(const std::string& name) {
+    FormulaNode* node = new FormulaNode(FormulaNode::FUNCTION);
+    node->text = name;
+
+    if (Accept(")")) return node;
+
+    do {
+        FormulaNode* argument = ParseComparison();
+
+        if (!argument) {
+            delete node;
+            return NULL;
+        }
+
+        node->children.push_back(argument);
+    } while (Accept(",") || Accept(";"));
+
+    if (!Accept(")")) {
+        delete node;
+        return Fail("missing ) after function arguments");
+    }
+
+    return node;
+}
+
+
+FormulaNode* FormulaParser::Binary(const std::string& op, FormulaNode* left,
+    FormulaNode* right)
+{
+    if (!right) {
+        delete left;
+        return NULL;
+    }
+
+    FormulaNode* node = new FormulaNode(FormulaNode::BINARY);
+    node->text = op;
+    node->children.push_back(left);
+    node->children.push_back(right);
+
+    return node;
+}
+
+
+void FormulaParser::SkipWhitespace() {
+    while (pos < formula.size() &&
+        isspace(static_cast<unsigned char>(formula[pos])))
+    {
+        pos++;
+    }
+}
+
+
+bool FormulaParser::Accept(const char* token) {
+    SkipWhitespace();
+
+    size_t length = strlen(token);
+    if (formula.compare(pos, length, token) != 0) return false;
+
+    pos += length;
+    return true;
+}
+
+
+size_t FormulaParser::IdentifierEnd(size_t start) const {
+    while (start < formula.size() && IsIdentifierChar(formula[start])) start++;
+
+    return start;
+}
+
+
+FormulaNode* FormulaParser::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return NULL;
+}
+
+
+}
@@ -0,0 +1,124 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_FORMULA_PARSER_H
+#define BINDINGS_FORMULA_PARSER_H
+
+#include <string>
+#include <vector>
+
+#include "cell_reference.h"
+
+namespace node_libxl {
+
+
+// Syntax tree of a parsed formula. Nodes own their children.
+class FormulaNode {
+    public:
+
+        enum Type {
+            NUMBER,
+            STRING,
+            BOOLEAN,
+            ERROR,
+            REFERENCE,
+            NAME,
+            UNARY,
+            BINARY,
+            FUNCTION
+        };
+
+        explicit FormulaNode(Type type);
+        ~FormulaNode();
+
+        Type type;
+
+        // Numbers and booleans
+        double number;
+
+        // String literal, error code, operator, function name (upper case)
+        // or defined name
+        std::string text;
+
+        // References; sheet is empty for references to the own sheet
+        std::string sheet;
+        CellReference first, last;
+        bool isRange;
+
+        std::vector<FormulaNode*> children;
+
+    private:
+
+        FormulaNode(const FormulaNode&);
+        const FormulaNode& operator=(const FormulaNode&);
+};
+
+
+// Recursive descent parser for A1 style formulas as returned by
+// Sheet::readFormula. Operators follow the Excel precedence rules.
+class FormulaParser {
+    public:
+
+        explicit FormulaParser(const std::string& formula);
+
+        // Returns NULL on syntax errors; the caller owns the result
+        FormulaNode* Parse();
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        FormulaNode* ParseComparison();
+        FormulaNode* ParseConcatenation();
+        FormulaNode* ParseAdditive();
+        FormulaNode* ParseMultiplicative();
+        FormulaNode* ParsePower();
+        FormulaNode* ParsePercent();
+        FormulaNode* ParseUnary();
+        FormulaNode* ParsePrimary();
+        FormulaNode* ParseIdentifier();
+        FormulaNode* ParseReference(const std::string& sheet);
+        FormulaNode* ParseFunction(const std::string& name);
+
+        FormulaNode* Binary(const std::string& op, FormulaNode* left,
+            FormulaNode* right);
+
+        void SkipWhitespace();
+        bool Accept(const char* token);
+        size_t IdentifierEnd(size_t pos) const;
+
+        FormulaNode* Fail(const std::string& message);
+
+        std::string formula;
+        size_t pos;
+        std::string errorMessage;
+
+        FormulaParser(const FormulaParser&);
+        const FormulaParser& operator=(const FormulaParser&);
+};
+
+
+}
+
+#endif // BINDINGS_FORMULA_PARSER_H
@@ -0,0 +1,110 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "formula_resolver.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+std::string ToLower(const std::string& str) {
+    std::string lower(str);
+
+    for (size_t i = 0; i < lower.size(); i++) {
+        lower[i] = tolower(static_cast<unsigned char>(lower[i]));
+    }
+
+    return lower;
+}
+
+
+}
+
+
+FormulaResolver::FormulaResolver(libxl::Book* book) :
+    book(book)
+{}
+
+
+bool FormulaResolver::Resolve(const FormulaNode* node, libxl::Sheet* sheet,
+    libxl::Sheet*& target, Range& range) const
+{
+    if (node->type == FormulaNode::REFERENCE) {
+        target = node->sheet.empty() ? sheet : FindSheet(node->sheet);
+
+        range = Range(
+            std::min(node->first.row, node->last.row),
+            std::max(node->first.row, node->last.row),
+            std::min(node->first.col, node->last.col),
+            std::max(node->first.col, node->last.col));
+
+        return target != NULL;
+    }
+
+    if (node->type != FormulaNode::NAME) return false;
+
+    // Named ranges are looked up on the formula's own sheet first
+    int count = book->sheetCount();
+
+    for (int i = -1; i < count; i++) {
+        target = i < 0 ? sheet : book->getSheet(i);
+        if (!target || (i >= 0 && target == sheet)) continue;
+
+        if (target->getNamedRange(node->text.c_str(), &range.rowFirst,
+            &range.rowLast, &range.colFirst, &range.colLast))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+libxl::Sheet* FormulaResolver::FindSheet(const std::string& name) const {
+    std::string lower = ToLower(name);
+    int count = book->sheetCount();
+
+    for (int i = 0; i < count; i++) {
+        libxl::Sheet* candidate = book->getSheet(i);
+
+        if (candidate && ToLower(candidate->name()) == lower) return candidate;
+    }
+
+    return NULL;
+}
+
+
+Range FormulaResolver::UsedRange(libxl::Sheet* sheet) {
+    return Range(sheet->firstRow(), sheet->lastRow() - 1,
+        sheet->firstCol(), sheet->lastCol() - 1);
+}
+
+
+}
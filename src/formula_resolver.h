@@ -0,0 +1,68 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_FORMULA_RESOLVER_H
+#define BINDINGS_FORMULA_RESOLVER_H
+
+#include <string>
+
+#include <libxl.h>
+
+#include "formula_parser.h"
+#include "range.h"
+
+namespace node_libxl {
+
+
+// Resolves the references and defined names of parsed formulas to cell
+// ranges of the sheets of a book.
+class FormulaResolver {
+    public:
+
+        explicit FormulaResolver(libxl::Book* book);
+
+        // Resolves a REFERENCE or NAME node of a formula on sheet. Returns
+        // false for references to unknown sheets and for unknown names.
+        bool Resolve(const FormulaNode* node, libxl::Sheet* sheet,
+            libxl::Sheet*& target, Range& range) const;
+
+        // Sheet names are matched case insensitively; returns NULL for
+        // unknown sheets
+        libxl::Sheet* FindSheet(const std::string& name) const;
+
+        // The range of cells that may contain data
+        static Range UsedRange(libxl::Sheet* sheet);
+
+    private:
+
+        libxl::Book* book;
+
+        FormulaResolver(const FormulaResolver&);
+        const FormulaResolver& operator=(const FormulaResolver&);
+};
+
+
+}
+
+#endif // BINDINGS_FORMULA_RESOLVER_H
@@ -0,0 +1,155 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "formula_template.h"
+
+namespace node_libxl {
+
+
+static bool IsIdentifierChar(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+        (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '$' ||
+        static_cast<unsigned char>(c) >= 0x80;
+}
+
+
+FormulaTemplate::FormulaTemplate(const std::string& formula, int maxRows,
+        int maxCols) :
+    maxRows(maxRows),
+    maxCols(maxCols)
+{
+    const char* str = formula.c_str();
+    size_t length = formula.size(), pos = 0, textStart = 0;
+
+    while (pos < length) {
+        char c = str[pos];
+
+        // String literals and quoted sheet names are copied verbatim
+        if (c == '"' || c == '\'') {
+            for (pos++; pos < length; pos++) {
+                if (str[pos] != c) continue;
+                if (pos + 1 < length && str[pos + 1] == c) {
+                    pos++;
+                } else {
+                    break;
+                }
+            }
+
+            pos++;
+            continue;
+        }
+
+        // Structured references and external book indices
+        if (c == '[') {
+            while (pos < length && str[pos] != ']') pos++;
+            pos++;
+            continue;
+        }
+
+        if (!IsIdentifierChar(c)) {
+            pos++;
+            continue;
+        }
+
+        size_t end = pos;
+        while (end < length && IsIdentifierChar(str[end])) end++;
+
+        // A reference must span the whole identifier and must be neither a
+        // function name like LOG10( nor a sheet name like Q1!
+        CellReference reference;
+        size_t consumed = reference.Parse(str + pos, end - pos);
+
+        if (consumed == end - pos &&
+            (end >= length || (str[end] != '(' && str[end] != '!')))
+        {
+            AddText(str + textStart, pos - textStart);
+            AddReference(reference);
+            textStart = end;
+        }
+
+        pos = end;
+    }
+
+    AddText(str + textStart, length - textStart);
+}
+
+
+const std::string& FormulaTemplate::Shift(int rowOffset, int colOffset) {
+    buffer.clear();
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        const Part& part = parts[i];
+
+        if (!part.isReference) {
+            buffer += part.text;
+            continue;
+        }
+
+        CellReference shifted(part.reference);
+        if (shifted.rowRelative) shifted.row += rowOffset;
+        if (shifted.colRelative) shifted.col += colOffset;
+
+        // Identifiers that are out of range to begin with are names rather
+        // than references, so only moved parts are checked against the limits
+        bool outside = shifted.row < 0 || shifted.col < 0 ||
+            (shifted.row >= maxRows && shifted.row != part.reference.row) ||
+            (shifted.col >= maxCols && shifted.col != part.reference.col);
+
+        if (outside) {
+            buffer += "#REF!";
+        } else {
+            shifted.AppendTo(buffer);
+        }
+    }
+
+    return buffer;
+}
+
+
+void FormulaTemplate::AddText(const char* text, size_t length) {
+    if (length == 0) return;
+
+    if (!parts.empty() && !parts.back().isReference) {
+        parts.back().text.append(text, length);
+        return;
+    }
+
+    Part part;
+    part.text.assign(text, length);
+    part.isReference = false;
+
+    parts.push_back(part);
+}
+
+
+void FormulaTemplate::AddReference(const CellReference& reference) {
+    Part part;
+    part.isReference = true;
+    part.reference = reference;
+
+    parts.push_back(part);
+}
+
+
+}
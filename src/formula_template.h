@@ -0,0 +1,67 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_FORMULA_TEMPLATE_H
+#define BINDINGS_FORMULA_TEMPLATE_H
+
+#include <string>
+#include <vector>
+
+#include "cell_reference.h"
+
+namespace node_libxl {
+
+
+// A formula whose A1 references are located once, so that copies moved by
+// an arbitrary offset can be produced without parsing the formula again.
+// Relative references are shifted, absolute ones are kept; references
+// that end up outside the sheet are replaced by #REF!.
+class FormulaTemplate {
+    public:
+
+        // The limits are the number of rows and columns of the file format
+        FormulaTemplate(const std::string& formula, int maxRows, int maxCols);
+
+        const std::string& Shift(int rowOffset, int colOffset);
+
+    private:
+
+        struct Part {
+            std::string text;
+            bool isReference;
+            CellReference reference;
+        };
+
+        void AddText(const char* text, size_t length);
+        void AddReference(const CellReference& reference);
+
+        std::vector<Part> parts;
+        std::string buffer;
+        int maxRows, maxCols;
+};
+
+
+}
+
+#endif // BINDINGS_FORMULA_TEMPLATE_H
@@ -0,0 +1,499 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "functions.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "argument_helper.h"
+#include "assert.h"
+#include "book.h"
+#include "book_split.h"
+#include "book_probe.h"
+#include "byte_source.h"
+#include "cell_reference.h"
+#include "typed_array.h"
+#include "format.h"
+#include "xls_scanner.h"
+#include "xlsx_stream.h"
+#include "xlsx_stream_writer.h"
+
+using namespace v8;
+
+namespace node_libxl {
+
+
+// XLSX limits, XFD1048576
+static const double MAX_ROW = 1048575;
+static const double MAX_COL = 16383;
+
+
+// Reads a whole file into memory
+static bool ReadFile(const std::string& path, std::string& data) {
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file) return false;
+
+    data.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+
+    return !file.bad();
+}
+
+
+// Implementation
+
+
+NAN_METHOD(Functions::SplitBook) {
+    class Worker : public NanAsyncWorker {
+        public:
+            Worker(NanCallback* callback, Handle<Value> source,
+                    Handle<Value> outDir, int targetType, int concurrency) :
+                NanAsyncWorker(callback),
+                outDir(*String::Utf8Value(outDir)),
+                targetType(targetType),
+                concurrency(concurrency)
+            {
+                if (node::Buffer::HasInstance(source)) {
+                    data.assign(node::Buffer::Data(source),
+                        node::Buffer::Length(source));
+                } else {
+                    path = *String::Utf8Value(source);
+                }
+            }
+
+            virtual void Execute() {
+                if (!path.empty() && !ReadFile(path, data)) {
+                    SetErrorMessage(("unable to read " + path).c_str());
+                    return;
+                }
+
+                BookSplit split(data.data(), data.size(), outDir,
+                    targetType, concurrency);
+
+                if (!split.Run()) {
+                    SetErrorMessage(split.ErrorMessage().c_str());
+                    return;
+                }
+
+                files = split.GetFiles();
+            }
+
+            virtual void HandleOKCallback() {
+                NanScope();
+
+                Local<Array> result = NanNew<Array>();
+                uint32_t length = 0;
+
+                for (size_t i = 0; i < files.size(); i++) {
+                    if (files[i].empty()) continue;
+                    result->Set(length++, NanNew<String>(files[i].c_str()));
+                }
+
+                Handle<Value> argv[] = {NanUndefined(), result};
+                callback->Call(2, argv);
+            }
+
+        private:
+            std::string path, data, outDir;
+            int targetType, concurrency;
+            std::vector<std::string> files;
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Value> source = node::Buffer::HasInstance(args[0]) ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    Handle<Value> outDir = arguments.GetString(1, "outDir", NULL);
+    Handle<Value> format = arguments.GetString(1, "format", NULL);
+    int concurrency = arguments.GetInt(1, "concurrency", 0);
+    Handle<Function> callback = arguments.GetFunction(2);
+    ASSERT_ARGUMENTS(arguments);
+
+    if (!outDir->IsString()) {
+        return NanThrowTypeError("string required for property outDir of argument 1");
+    }
+
+    int targetType = -1;
+    if (format->IsString()) {
+        String::Utf8Value formatName(format);
+
+        if (strcmp(*formatName, "xls") == 0) {
+            targetType = BOOK_TYPE_XLS;
+        } else if (strcmp(*formatName, "xlsx") == 0) {
+            targetType = BOOK_TYPE_XLSX;
+        } else {
+            return NanThrowTypeError("format must be either 'xls' or 'xlsx'");
+        }
+    }
+
+    // Default to one worker per CPU
+    if (concurrency <= 0) {
+        uv_cpu_info_t* cpuInfo;
+        int cpuCount = 0;
+
+        if (uv_cpu_info(&cpuInfo, &cpuCount) == 0) {
+            uv_free_cpu_info(cpuInfo, cpuCount);
+        }
+
+        concurrency = cpuCount > 0 ? cpuCount : 1;
+    }
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback), source, outDir,
+        targetType, concurrency));
+
+    NanReturnUndefined();
+}
+
+
+// Addresses that cannot be parsed or lie beyond the sheet limits yield -1
+// for row and column
+NAN_METHOD(Functions::AddrToRowColMany) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Array> addresses = arguments.GetArray(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    uint32_t length = addresses->Length();
+    int32_t *rows, *cols;
+    uint8_t *rowRelative, *colRelative;
+
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("row"), util::NewTypedArray(
+        "Int32Array", length, reinterpret_cast<void**>(&rows)));
+    result->Set(NanNew<String>("col"), util::NewTypedArray(
+        "Int32Array", length, reinterpret_cast<void**>(&cols)));
+    result->Set(NanNew<String>("rowRelative"), util::NewTypedArray(
+        "Uint8Array", length, reinterpret_cast<void**>(&rowRelative)));
+    result->Set(NanNew<String>("colRelative"), util::NewTypedArray(
+        "Uint8Array", length, reinterpret_cast<void**>(&colRelative)));
+
+    for (uint32_t i = 0; i < length; i++) {
+        Handle<Value> address = addresses->Get(i);
+
+        if (!address->IsString()) {
+            std::ostringstream error;
+            error << "string required at index " << i;
+
+            return NanThrowTypeError(error.str().c_str());
+        }
+
+        String::Utf8Value text(address);
+        CellReference reference(-1, -1);
+        size_t textLength = text.length();
+
+        if (reference.Parse(*text, textLength) != textLength ||
+            reference.row > MAX_ROW || reference.col > MAX_COL)
+        {
+            reference = CellReference(-1, -1);
+        }
+
+        rows[i] = reference.row;
+        cols[i] = reference.col;
+        rowRelative[i] = reference.rowRelative;
+        colRelative[i] = reference.colRelative;
+    }
+
+    NanReturnValue(result);
+}
+
+
+NAN_METHOD(Functions::RowColToAddrMany) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    std::vector<double> rows, cols;
+    arguments.GetNumberArray(0, rows);
+    arguments.GetNumberArray(1, cols);
+    bool rowRelative = arguments.GetBoolean(2, "rowRelative", true),
+         colRelative = arguments.GetBoolean(2, "colRelative", true);
+    ASSERT_ARGUMENTS(arguments);
+
+    if (rows.size() != cols.size()) {
+        return NanThrowTypeError("rows and cols must have the same length");
+    }
+
+    Local<Array> result = NanNew<Array>(static_cast<int>(rows.size()));
+    std::string address;
+
+    for (uint32_t i = 0; i < rows.size(); i++) {
+        if (rows[i] < 0 || rows[i] > MAX_ROW || cols[i] < 0 ||
+            cols[i] > MAX_COL)
+        {
+            std::ostringstream error;
+            error << "invalid row or column at index " << i;
+
+            return NanThrowTypeError(error.str().c_str());
+        }
+
+        address.clear();
+        CellReference(static_cast<int>(rows[i]), static_cast<int>(cols[i]),
+            rowRelative, colRelative).AppendTo(address);
+
+        result->Set(i, NanNew<String>(address.c_str(),
+            static_cast<int>(address.size())));
+    }
+
+    NanReturnValue(result);
+}
+
+
+NAN_METHOD(Functions::Probe) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    bool isBuffer = node::Buffer::HasInstance(args[0]);
+    Handle<Value> source = isBuffer ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    std::string path = isBuffer ? "" : *String::Utf8Value(source);
+    BufferSource buffer(isBuffer ? node::Buffer::Data(source) : NULL,
+        isBuffer ? node::Buffer::Length(source) : 0);
+    FileSource file(path);
+
+    if (!isBuffer && !file.IsOpen()) {
+        return NanThrowError(("unable to read " + path).c_str());
+    }
+
+    BookProbe probe(isBuffer ? static_cast<ByteSource&>(buffer) : file);
+
+    if (!probe.Run()) {
+        return NanThrowError(probe.ErrorMessage().c_str());
+    }
+
+    const std::vector<BookProbe::SheetInfo>& sheetInfos = probe.Sheets();
+    Local<Array> sheets = NanNew<Array>(static_cast<int>(sheetInfos.size()));
+
+    for (size_t i = 0; i < sheetInfos.size(); i++) {
+        const BookProbe::SheetInfo& info = sheetInfos[i];
+        Local<Object> sheet = NanNew<Object>();
+
+        sheet->Set(NanNew<String>("name"), NanNew<String>(info.name.c_str()));
+        sheet->Set(NanNew<String>("state"),
+            NanNew<String>(info.state.c_str()));
+        sheet->Set(NanNew<String>("type"), NanNew<String>(info.type.c_str()));
+
+        if (info.hasDimension) {
+            sheet->Set(NanNew<String>("rowFirst"),
+                NanNew<Integer>(info.dimension.rowFirst));
+            sheet->Set(NanNew<String>("rowLast"),
+                NanNew<Integer>(info.dimension.rowLast));
+            sheet->Set(NanNew<String>("colFirst"),
+                NanNew<Integer>(info.dimension.colFirst));
+            sheet->Set(NanNew<String>("colLast"),
+                NanNew<Integer>(info.dimension.colLast));
+        }
+
+        sheets->Set(i, sheet);
+    }
+
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("format"), NanNew<String>(
+        probe.Type() == BOOK_TYPE_XLS ? "xls" : "xlsx"));
+    result->Set(NanNew<String>("sheets"), sheets);
+
+    NanReturnValue(result);
+}
+
+
+// The stream is opened synchronously, which only reads the zip directory and
+// the workbook part
+NAN_METHOD(Functions::StreamXlsx) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    String::Utf8Value path(arguments.GetString(0));
+    String::Utf8Value sheet(arguments.GetString(1, "sheet", ""));
+    int batchSize = arguments.GetInt(1, "batchSize", 1000);
+    ASSERT_ARGUMENTS(arguments);
+
+    if (batchSize <= 0) {
+        return NanThrowTypeError("batchSize must be positive");
+    }
+
+    XlsxStream* stream = new XlsxStream(*path, batchSize);
+
+    if (!stream->Open(*sheet)) {
+        std::string message = stream->ErrorMessage();
+
+        delete stream;
+        return NanThrowError(message.c_str());
+    }
+
+    NanReturnValue(XlsxStream::NewInstance(stream));
+}
+
+
+// Column formats are Format objects of any book (or null for unformatted
+// columns); the properties the writer supports are copied right away
+NAN_METHOD(Functions::CreateXlsxStreamWriter) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    String::Utf8Value path(arguments.GetString(0));
+    std::vector<std::string> sheets;
+    arguments.GetStringArray(1, "sheets", sheets);
+
+    Handle<Value> columnFormats = args[1]->IsObject() ?
+        args[1].As<Object>()->Get(NanNew<String>("columnFormats")) :
+        NanUndefined().As<Value>();
+    uint32_t columnCount = columnFormats->IsArray() ?
+        columnFormats.As<Array>()->Length() : 0;
+    std::vector<Format*> formats;
+
+    if (!columnFormats->IsUndefined()) {
+        arguments.GetWrappedArray(1, "columnFormats", columnCount, formats);
+    }
+
+    ASSERT_ARGUMENTS(arguments);
+
+    if (sheets.empty()) sheets.push_back("Sheet1");
+
+    std::vector<XlsxWriter::CellStyle> styles;
+    std::vector<int> columnStyles(formats.size(), -1);
+    std::map<Format*, int> styleIndex;
+
+    for (size_t i = 0; i < formats.size(); i++) {
+        if (!formats[i]) continue;
+
+        std::map<Format*, int>::iterator index = styleIndex.find(formats[i]);
+
+        if (index == styleIndex.end()) {
+            index = styleIndex.insert(
+                std::make_pair(formats[i], styles.size())).first;
+            styles.push_back(XlsxStreamWriter::StyleFromFormat(formats[i]));
+        }
+
+        columnStyles[i] = index->second;
+    }
+
+    XlsxWriter* writer = new XlsxWriter(*path, sheets, styles, columnStyles);
+
+    if (!writer->Open()) {
+        std::string message = writer->ErrorMessage();
+
+        delete writer;
+        return NanThrowError(message.c_str());
+    }
+
+    NanReturnValue(XlsxStreamWriter::NewInstance(writer));
+}
+
+
+// Values are returned as columns. String and error cells refer to the
+// strings array through their entry in number.
+NAN_METHOD(Functions::ScanXls) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    bool isBuffer = node::Buffer::HasInstance(args[0]);
+    Handle<Value> source = isBuffer ?
+        arguments.GetBuffer(0) : arguments.GetString(0);
+    String::Utf8Value sheet(arguments.GetString(1, "sheet", ""));
+    ASSERT_ARGUMENTS(arguments);
+
+    std::string path = isBuffer ? "" : *String::Utf8Value(source);
+    BufferSource buffer(isBuffer ? node::Buffer::Data(source) : NULL,
+        isBuffer ? node::Buffer::Length(source) : 0);
+    FileSource file(path);
+
+    if (!isBuffer && !file.IsOpen()) {
+        return NanThrowError(("unable to read " + path).c_str());
+    }
+
+    XlsScanner scanner(isBuffer ? static_cast<ByteSource&>(buffer) : file);
+    XlsScanner::Result cells;
+
+    if (!scanner.Run(*sheet, cells)) {
+        return NanThrowError(scanner.ErrorMessage().c_str());
+    }
+
+    uint32_t length = static_cast<uint32_t>(cells.rows.size());
+    int32_t *rows, *cols;
+    uint8_t* types;
+    double* numbers;
+
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("row"), util::NewTypedArray(
+        "Int32Array", length, reinterpret_cast<void**>(&rows)));
+    result->Set(NanNew<String>("col"), util::NewTypedArray(
+        "Int32Array", length, reinterpret_cast<void**>(&cols)));
+    result->Set(NanNew<String>("type"), util::NewTypedArray(
+        "Uint8Array", length, reinterpret_cast<void**>(&types)));
+    result->Set(NanNew<String>("number"), util::NewTypedArray(
+        "Float64Array", length, reinterpret_cast<void**>(&numbers)));
+
+    if (length > 0) {
+        std::memcpy(rows, &cells.rows[0], length * sizeof(int32_t));
+        std::memcpy(cols, &cells.cols[0], length * sizeof(int32_t));
+        std::memcpy(types, &cells.types[0], length * sizeof(uint8_t));
+        std::memcpy(numbers, &cells.numbers[0], length * sizeof(double));
+    }
+
+    Local<Array> strings = NanNew<Array>(
+        static_cast<int>(cells.strings.size()));
+
+    for (size_t i = 0; i < cells.strings.size(); i++) {
+        strings->Set(i, NanNew<String>(cells.strings[i].c_str(),
+            static_cast<int>(cells.strings[i].size())));
+    }
+
+    result->Set(NanNew<String>("strings"), strings);
+
+    NanReturnValue(result);
+}
+
+
+// Init
+
+
+void Functions::Initialize(Handle<Object> exports) {
+    NanScope();
+
+    NODE_SET_METHOD(exports, "splitBook", SplitBook);
+    NODE_SET_METHOD(exports, "addrToRowColMany", AddrToRowColMany);
+    NODE_SET_METHOD(exports, "rowColToAddrMany", RowColToAddrMany);
+    NODE_SET_METHOD(exports, "probe", Probe);
+    NODE_SET_METHOD(exports, "streamXlsx", StreamXlsx);
+    NODE_SET_METHOD(exports, "createXlsxStreamWriter",
+        CreateXlsxStreamWriter);
+    NODE_SET_METHOD(exports, "scanXls", ScanXls);
+}
+
+
+}
@@ -0,0 +1,217 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "picture_extract.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace node_libxl {
+
+
+#ifdef _WIN32
+    static const char PATH_SEPARATOR = '\\';
+#else
+    static const char PATH_SEPARATOR = '/';
+#endif
+
+
+PictureExtract::PictureExtract(libxl::Book* book, const std::string& outDir) :
+    book(book),
+    outDir(outDir),
+    toMemory(false)
+{}
+
+
+PictureExtract::PictureExtract(libxl::Book* book) :
+    book(book),
+    toMemory(true)
+{}
+
+
+PictureExtract::~PictureExtract() {
+    for (size_t i = 0; i < pictures.size(); i++) {
+        delete[] pictures[i].data;
+    }
+}
+
+
+bool PictureExtract::Run(const std::vector<int>& indices) {
+    int pictureCount = book->pictureSize();
+
+    // Maps book picture indices to their entry in the result
+    std::vector<int> slots(pictureCount > 0 ? pictureCount : 0, -1);
+
+    pictures.resize(indices.size());
+
+    for (size_t i = 0; i < indices.size(); i++) {
+        Picture& picture = pictures[i];
+
+        picture.index = indices[i];
+        picture.type = libxl::PICTURETYPE_ERROR;
+        picture.data = NULL;
+        picture.size = 0;
+
+        if (picture.index < 0 || picture.index >= pictureCount) {
+            std::ostringstream ss;
+            ss << "invalid picture index " << picture.index;
+            return Fail(ss.str());
+        }
+
+        // Placements are assigned to a single entry per picture
+        if (slots[picture.index] >= 0) {
+            std::ostringstream ss;
+            ss << "duplicate picture index " << picture.index;
+            return Fail(ss.str());
+        }
+
+        slots[picture.index] = static_cast<int>(i);
+    }
+
+    // Nothing is written before all indices are known to be valid
+    for (size_t i = 0; i < pictures.size(); i++) {
+        if (!ExtractPicture(pictures[i])) return false;
+    }
+
+    CollectPlacements(slots);
+
+    return true;
+}
+
+
+std::vector<PictureExtract::Picture>& PictureExtract::GetPictures() {
+    return pictures;
+}
+
+
+char* PictureExtract::ReleaseData(size_t picture) {
+    char* data = pictures[picture].data;
+    pictures[picture].data = NULL;
+
+    return data;
+}
+
+
+const std::string& PictureExtract::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+const char* PictureExtract::Extension(int type) {
+    switch (type) {
+        case libxl::PICTURETYPE_PNG:    return "png";
+        case libxl::PICTURETYPE_JPEG:   return "jpg";
+        case libxl::PICTURETYPE_WMF:    return "wmf";
+        case libxl::PICTURETYPE_DIB:    return "dib";
+        case libxl::PICTURETYPE_EMF:    return "emf";
+        case libxl::PICTURETYPE_PICT:   return "pict";
+        case libxl::PICTURETYPE_TIFF:   return "tiff";
+        default:                        return "bin";
+    }
+}
+
+
+bool PictureExtract::ExtractPicture(Picture& picture) {
+    const char* data;
+    unsigned size;
+
+    picture.type = book->getPicture(picture.index, &data, &size);
+    if (picture.type == libxl::PICTURETYPE_ERROR) {
+        return Fail(book->errorMessage());
+    }
+
+    picture.size = size;
+
+    if (toMemory) {
+        picture.data = new char[size];
+        memcpy(picture.data, data, size);
+
+        return true;
+    }
+
+    picture.path = FilePath(picture.index, picture.type);
+
+    std::ofstream file(picture.path.c_str(),
+        std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(data, size);
+    file.close();
+
+    if (!file) return Fail("unable to write " + picture.path);
+
+    return true;
+}
+
+
+void PictureExtract::CollectPlacements(const std::vector<int>& slots) {
+    int sheetCount = book->sheetCount();
+
+    for (int i = 0; i < sheetCount; i++) {
+        libxl::Sheet* sheet = book->getSheet(i);
+        if (!sheet) continue;
+
+        int placementCount = sheet->pictureSize();
+
+        for (int j = 0; j < placementCount; j++) {
+            Placement placement;
+            placement.sheet = i;
+
+            int index = sheet->getPicture(j,
+                &placement.rowTop, &placement.colLeft,
+                &placement.rowBottom, &placement.colRight,
+                &placement.width, &placement.height,
+                &placement.offsetX, &placement.offsetY);
+
+            if (index < 0 || index >= static_cast<int>(slots.size()) ||
+                slots[index] < 0)
+            {
+                continue;
+            }
+
+            pictures[slots[index]].placements.push_back(placement);
+        }
+    }
+}
+
+
+std::string PictureExtract::FilePath(int index, int type) const {
+    std::ostringstream ss;
+
+    ss << outDir;
+    if (!outDir.empty() && outDir[outDir.size() - 1] != PATH_SEPARATOR) {
+        ss << PATH_SEPARATOR;
+    }
+    ss << "picture" << index << "." << Extension(type);
+
+    return ss.str();
+}
+
+
+bool PictureExtract::Fail(const std::string& message) {
+    errorMessage = message;
+    return false;
+}
+
+
+}
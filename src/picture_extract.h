@@ -0,0 +1,94 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_PICTURE_EXTRACT_H
+#define BINDINGS_PICTURE_EXTRACT_H
+
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+namespace node_libxl {
+
+
+// Copies a set of book pictures either to files or to memory in one pass,
+// together with the places where the sheets of the book show them.
+class PictureExtract {
+    public:
+
+        struct Placement {
+            int sheet;
+            int rowTop, colLeft, rowBottom, colRight;
+            int width, height, offsetX, offsetY;
+        };
+
+        // Data is only set when extracting to memory and belongs to the
+        // extractor until it is released
+        struct Picture {
+            int index, type;
+            std::string path;
+            char* data;
+            unsigned size;
+            std::vector<Placement> placements;
+        };
+
+        // Extracts to files in a directory or to memory
+        PictureExtract(libxl::Book* book, const std::string& outDir);
+        explicit PictureExtract(libxl::Book* book);
+        ~PictureExtract();
+
+        // Fails on indices that are out of range or repeated
+        bool Run(const std::vector<int>& indices);
+
+        std::vector<Picture>& GetPictures();
+        char* ReleaseData(size_t picture);
+
+        const std::string& ErrorMessage() const;
+
+        static const char* Extension(int type);
+
+    private:
+
+        bool ExtractPicture(Picture& picture);
+        void CollectPlacements(const std::vector<int>& slots);
+        std::string FilePath(int index, int type) const;
+
+        bool Fail(const std::string& message);
+
+        libxl::Book* book;
+        std::string outDir;
+        bool toMemory;
+
+        std::vector<Picture> pictures;
+        std::string errorMessage;
+
+        PictureExtract(const PictureExtract&);
+        const PictureExtract& operator=(const PictureExtract&);
+};
+
+
+}
+
+#endif // BINDINGS_PICTURE_EXTRACT_H
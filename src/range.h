@@ -0,0 +1,76 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_RANGE_H
+#define BINDINGS_RANGE_H
+
+namespace node_libxl {
+
+
+class Range {
+    public:
+
+        Range() : rowFirst(0), rowLast(-1), colFirst(0), colLast(-1) {}
+
+        Range(int rowFirst, int rowLast, int colFirst, int colLast) :
+            rowFirst(rowFirst),
+            rowLast(rowLast),
+            colFirst(colFirst),
+            colLast(colLast)
+        {}
+
+        int Rows() const {
+            return rowLast - rowFirst + 1;
+        }
+
+        int Cols() const {
+            return colLast - colFirst + 1;
+        }
+
+        bool IsValid() const {
+            return rowFirst >= 0 && colFirst >= 0 &&
+                rowFirst <= rowLast && colFirst <= colLast;
+        }
+
+        bool Contains(int row, int col) const {
+            return row >= rowFirst && row <= rowLast &&
+                col >= colFirst && col <= colLast;
+        }
+
+        // The result is invalid if the ranges do not overlap
+        Range Intersect(const Range& other) const {
+            return Range(
+                rowFirst > other.rowFirst ? rowFirst : other.rowFirst,
+                rowLast < other.rowLast ? rowLast : other.rowLast,
+                colFirst > other.colFirst ? colFirst : other.colFirst,
+                colLast < other.colLast ? colLast : other.colLast);
+        }
+
+        int rowFirst, rowLast, colFirst, colLast;
+};
+
+
+}
+
+#endif // BINDINGS_RANGE_H
@@ -0,0 +1,203 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "range_copy.h"
+
+#include <string>
+
+namespace node_libxl {
+
+
+RangeCopy::RangeCopy(libxl::Sheet* sourceSheet, libxl::Book* sourceBook,
+        libxl::Sheet* targetSheet, libxl::Book* targetBook, int flags) :
+    sourceSheet(sourceSheet),
+    targetSheet(targetSheet),
+    sourceBook(sourceBook),
+    targetBook(targetBook),
+    flags(flags),
+    ownTranslator(sourceBook, targetBook),
+    translator(ownTranslator),
+    errorMessage("")
+{}
+
+
+RangeCopy::RangeCopy(libxl::Sheet* sourceSheet, libxl::Sheet* targetSheet,
+        FormatTranslator& translator, int flags) :
+    sourceSheet(sourceSheet),
+    targetSheet(targetSheet),
+    sourceBook(translator.GetSourceBook()),
+    targetBook(translator.GetTargetBook()),
+    flags(flags),
+    ownTranslator(sourceBook, targetBook),
+    translator(translator),
+    errorMessage("")
+{}
+
+
+bool RangeCopy::Copy(const Range& range, int rowDst, int colDst) {
+    // Walk backwards along an axis if source and destination overlap in
+    // a way that would otherwise overwrite cells before they are read
+    bool sameSheet = sourceSheet == targetSheet;
+    bool rowsBackward = sameSheet && rowDst > range.rowFirst;
+    bool colsBackward = sameSheet && colDst > range.colFirst;
+
+    int rows = range.Rows(), cols = range.Cols();
+
+    for (int i = 0; i < rows; i++) {
+        int rowOffset = rowsBackward ? rows - 1 - i : i;
+
+        for (int j = 0; j < cols; j++) {
+            int colOffset = colsBackward ? cols - 1 - j : j;
+
+            if (!CopyCell(range.rowFirst + rowOffset, range.colFirst + colOffset,
+                    rowDst + rowOffset, colDst + colOffset))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool RangeCopy::CopyCell(int rowSrc, int colSrc, int rowDst, int colDst) {
+    libxl::CellType cellType = sourceSheet->cellType(rowSrc, colSrc);
+
+    if (cellType == libxl::CELLTYPE_EMPTY) return true;
+
+    libxl::Format* format = NULL;
+
+    // Without COPY_FORMULAS, formula cells are copied as their cached values
+    if ((flags & COPY_FORMULAS) && sourceSheet->isFormula(rowSrc, colSrc)) {
+        const char* value = sourceSheet->readFormula(rowSrc, colSrc, &format);
+        if (!value) return Fail(sourceBook);
+
+        std::string formula(value);
+        libxl::Format* translated = NULL;
+
+        if ((flags & COPY_FORMATS) && format) {
+            translated = translator.Translate(format);
+            if (!translated) return Fail(targetBook);
+        }
+
+        if (!targetSheet->writeFormula(rowDst, colDst, formula.c_str(), translated)) {
+            return Fail(targetBook);
+        }
+
+        return true;
+    }
+
+    if (flags & COPY_VALUES) {
+        std::string str;
+        double num = 0;
+        bool boolean = false;
+
+        switch (cellType) {
+            case libxl::CELLTYPE_NUMBER:
+                num = sourceSheet->readNum(rowSrc, colSrc, &format);
+                break;
+
+            case libxl::CELLTYPE_STRING: {
+                const char* value = sourceSheet->readStr(rowSrc, colSrc, &format);
+                if (!value) return Fail(sourceBook);
+                str = value;
+                break;
+            }
+
+            case libxl::CELLTYPE_BOOLEAN:
+                boolean = sourceSheet->readBool(rowSrc, colSrc, &format);
+                break;
+
+            case libxl::CELLTYPE_BLANK:
+                sourceSheet->readBlank(rowSrc, colSrc, &format);
+                break;
+
+            default:
+                // Error cells cannot be written through the libxl API
+                format = sourceSheet->cellFormat(rowSrc, colSrc);
+                break;
+        }
+
+        libxl::Format* translated = NULL;
+
+        if ((flags & COPY_FORMATS) && format) {
+            translated = translator.Translate(format);
+            if (!translated) return Fail(targetBook);
+        }
+
+        bool success = true;
+
+        switch (cellType) {
+            case libxl::CELLTYPE_NUMBER:
+                success = targetSheet->writeNum(rowDst, colDst, num, translated);
+                break;
+
+            case libxl::CELLTYPE_STRING:
+                success = targetSheet->writeStr(rowDst, colDst, str.c_str(),
+                    translated);
+                break;
+
+            case libxl::CELLTYPE_BOOLEAN:
+                success = targetSheet->writeBool(rowDst, colDst, boolean,
+                    translated);
+                break;
+
+            default:
+                if (translated) {
+                    success = targetSheet->writeBlank(rowDst, colDst, translated);
+                }
+                break;
+        }
+
+        return success ? true : Fail(targetBook);
+    }
+
+    if (flags & COPY_FORMATS) {
+        format = sourceSheet->cellFormat(rowSrc, colSrc);
+
+        if (format) {
+            libxl::Format* translated = translator.Translate(format);
+            if (!translated) return Fail(targetBook);
+
+            targetSheet->setCellFormat(rowDst, colDst, translated);
+        }
+    }
+
+    return true;
+}
+
+
+const char* RangeCopy::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool RangeCopy::Fail(libxl::Book* book) {
+    errorMessage = book->errorMessage();
+    return false;
+}
+
+
+}
@@ -0,0 +1,81 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_RANGE_COPY_H
+#define BINDINGS_RANGE_COPY_H
+
+#include <libxl.h>
+
+#include "range.h"
+#include "format_translator.h"
+
+namespace node_libxl {
+
+
+// Copies a rectangular block of cells between two sheets, which may belong to
+// different books. Formats are translated into the target book on the fly,
+// either through a private translator or through one that is shared between
+// several copies.
+class RangeCopy {
+    public:
+
+        enum {
+            COPY_VALUES     = 0x01,
+            COPY_FORMATS    = 0x02,
+            COPY_FORMULAS   = 0x04,
+            COPY_ALL        = 0x07
+        };
+
+        RangeCopy(libxl::Sheet* sourceSheet, libxl::Book* sourceBook,
+            libxl::Sheet* targetSheet, libxl::Book* targetBook,
+            int flags = COPY_ALL);
+
+        RangeCopy(libxl::Sheet* sourceSheet, libxl::Sheet* targetSheet,
+            FormatTranslator& translator, int flags = COPY_ALL);
+
+        bool Copy(const Range& range, int rowDst, int colDst);
+
+        const char* ErrorMessage() const;
+
+    private:
+
+        bool CopyCell(int rowSrc, int colSrc, int rowDst, int colDst);
+        bool Fail(libxl::Book* book);
+
+        libxl::Sheet *sourceSheet, *targetSheet;
+        libxl::Book *sourceBook, *targetBook;
+        int flags;
+
+        FormatTranslator ownTranslator;
+        FormatTranslator& translator;
+        const char* errorMessage;
+
+        RangeCopy(const RangeCopy&);
+        const RangeCopy& operator=(const RangeCopy&);
+};
+
+
+}
+
+#endif // BINDINGS_RANGE_COPY_H
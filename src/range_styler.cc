@@ -0,0 +1,219 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "range_styler.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+template<typename T> bool Compare(RangeStyler::Rule::Op op, const T& a,
+    const T& b)
+{
+    switch (op) {
+        case RangeStyler::Rule::OP_LT: return a < b;
+        case RangeStyler::Rule::OP_LE: return a < b || a == b;
+        case RangeStyler::Rule::OP_GT: return b < a;
+        case RangeStyler::Rule::OP_GE: return b < a || a == b;
+        case RangeStyler::Rule::OP_EQ: return a == b;
+        case RangeStyler::Rule::OP_NE: return !(a == b);
+        default: return true;
+    }
+}
+
+
+}
+
+
+RangeStyler::Rule::Rule() :
+    op(OP_NONE),
+    numeric(false),
+    number(0),
+    isDate(-1),
+    format(NULL)
+{}
+
+
+// Values are only compared to cells of the same type
+bool RangeStyler::Rule::Matches(libxl::Sheet* sheet, int row, int col) const {
+    libxl::CellType type = sheet->cellType(row, col);
+
+    if (type == libxl::CELLTYPE_EMPTY || type == libxl::CELLTYPE_BLANK) {
+        return false;
+    }
+
+    if (isDate >= 0 && (type != libxl::CELLTYPE_NUMBER ||
+        sheet->isDate(row, col) != (isDate == 1)))
+    {
+        return false;
+    }
+
+    if (op == OP_NONE) return true;
+
+    if (numeric) {
+        return type == libxl::CELLTYPE_NUMBER &&
+            Compare(op, sheet->readNum(row, col), number);
+    }
+
+    if (type != libxl::CELLTYPE_STRING) return false;
+
+    const char* value = sheet->readStr(row, col);
+    return value && Compare(op, std::string(value), str);
+}
+
+
+RangeStyler::VariantKey::VariantKey(libxl::Format* format, int sides,
+        int style, int color) :
+    format(format),
+    sides(sides),
+    style(style),
+    color(color)
+{}
+
+
+bool RangeStyler::VariantKey::operator<(const VariantKey& other) const {
+    if (format != other.format) return format < other.format;
+    if (sides != other.sides) return sides < other.sides;
+    if (style != other.style) return style < other.style;
+
+    return color < other.color;
+}
+
+
+RangeStyler::RangeStyler(libxl::Book* book, libxl::Sheet* sheet) :
+    book(book),
+    sheet(sheet)
+{}
+
+
+void RangeStyler::SetFormat(const Range& range, libxl::Format* format) {
+    for (int row = range.rowFirst; row <= range.rowLast; row++) {
+        for (int col = range.colFirst; col <= range.colLast; col++) {
+            sheet->setCellFormat(row, col, format);
+        }
+    }
+}
+
+
+void RangeStyler::Band(const Range& range,
+    const std::vector<libxl::Format*>& formats, int bandBy)
+{
+    if (formats.empty()) return;
+
+    for (int row = range.rowFirst; row <= range.rowLast; row++) {
+        for (int col = range.colFirst; col <= range.colLast; col++) {
+            int band = bandBy == BAND_ROWS ?
+                row - range.rowFirst : col - range.colFirst;
+
+            sheet->setCellFormat(row, col, formats[band % formats.size()]);
+        }
+    }
+}
+
+
+void RangeStyler::ApplyRules(const Range& range,
+    const std::vector<Rule>& rules)
+{
+    for (int row = range.rowFirst; row <= range.rowLast; row++) {
+        for (int col = range.colFirst; col <= range.colLast; col++) {
+            for (size_t i = 0; i < rules.size(); i++) {
+                if (rules[i].Matches(sheet, row, col)) {
+                    sheet->setCellFormat(row, col, rules[i].format);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+bool RangeStyler::BorderBox(const Range& range, libxl::BorderStyle style,
+    libxl::Color color)
+{
+    for (int row = range.rowFirst; row <= range.rowLast; row++) {
+        for (int col = range.colFirst; col <= range.colLast; col++) {
+            int sides =
+                (col == range.colFirst ? SIDE_LEFT : 0) |
+                (col == range.colLast ? SIDE_RIGHT : 0) |
+                (row == range.rowFirst ? SIDE_TOP : 0) |
+                (row == range.rowLast ? SIDE_BOTTOM : 0);
+
+            // Only the edges are touched
+            if (!sides) {
+                col = range.colLast - 1;
+                continue;
+            }
+
+            libxl::Format* variant = BorderVariant(sheet->cellFormat(row, col),
+                sides, style, color);
+            if (!variant) return false;
+
+            sheet->setCellFormat(row, col, variant);
+        }
+    }
+
+    return true;
+}
+
+
+libxl::Format* RangeStyler::BorderVariant(libxl::Format* format, int sides,
+    libxl::BorderStyle style, libxl::Color color)
+{
+    VariantKey key(format, sides, style, color);
+
+    std::map<VariantKey, libxl::Format*>::iterator cached = variants.find(key);
+    if (cached != variants.end()) return cached->second;
+
+    libxl::Format* variant = book->addFormat(format);
+    if (!variant) return NULL;
+
+    if (sides & SIDE_LEFT) {
+        variant->setBorderLeft(style);
+        variant->setBorderLeftColor(color);
+    }
+
+    if (sides & SIDE_RIGHT) {
+        variant->setBorderRight(style);
+        variant->setBorderRightColor(color);
+    }
+
+    if (sides & SIDE_TOP) {
+        variant->setBorderTop(style);
+        variant->setBorderTopColor(color);
+    }
+
+    if (sides & SIDE_BOTTOM) {
+        variant->setBorderBottom(style);
+        variant->setBorderBottomColor(color);
+    }
+
+    variants[key] = variant;
+
+    return variant;
+}
+
+
+}
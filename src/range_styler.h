@@ -0,0 +1,127 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_RANGE_STYLER_H
+#define BINDINGS_RANGE_STYLER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+#include "range.h"
+
+namespace node_libxl {
+
+
+// Applies formats to rectangular ranges. Derived formats (currently formats
+// with additional borders) are created once per base format and kept in a
+// variant table for the lifetime of the styler.
+class RangeStyler {
+    public:
+
+        enum {
+            BAND_ROWS,
+            BAND_COLS
+        };
+
+        // A condition on the value of a cell and the format to apply if
+        // it holds. All conditions that are set must be met.
+        struct Rule {
+            enum Op {
+                OP_NONE,
+                OP_LT,
+                OP_LE,
+                OP_GT,
+                OP_GE,
+                OP_EQ,
+                OP_NE
+            };
+
+            Rule();
+
+            bool Matches(libxl::Sheet* sheet, int row, int col) const;
+
+            Op op;
+            bool numeric;
+            double number;
+            std::string str;
+
+            // -1: don't care
+            int isDate;
+
+            libxl::Format* format;
+        };
+
+        RangeStyler(libxl::Book* book, libxl::Sheet* sheet);
+
+        void SetFormat(const Range& range, libxl::Format* format);
+
+        // Cycles through the formats row by row (or column by column)
+        void Band(const Range& range,
+            const std::vector<libxl::Format*>& formats, int bandBy);
+
+        // Applies the format of the first matching rule to each non-empty
+        // cell; cells without a match are left alone
+        void ApplyRules(const Range& range, const std::vector<Rule>& rules);
+
+        // Draws a border around the range, preserving the formats of the
+        // edge cells
+        bool BorderBox(const Range& range, libxl::BorderStyle style,
+            libxl::Color color);
+
+    private:
+
+        enum {
+            SIDE_LEFT   = 0x01,
+            SIDE_RIGHT  = 0x02,
+            SIDE_TOP    = 0x04,
+            SIDE_BOTTOM = 0x08
+        };
+
+        struct VariantKey {
+            VariantKey(libxl::Format* format, int sides, int style, int color);
+            bool operator<(const VariantKey& other) const;
+
+            libxl::Format* format;
+            int sides, style, color;
+        };
+
+        libxl::Format* BorderVariant(libxl::Format* format, int sides,
+            libxl::BorderStyle style, libxl::Color color);
+
+        libxl::Book* book;
+        libxl::Sheet* sheet;
+
+        std::map<VariantKey, libxl::Format*> variants;
+
+        RangeStyler(const RangeStyler&);
+        const RangeStyler& operator=(const RangeStyler&);
+};
+
+
+}
+
+#endif // BINDINGS_RANGE_STYLER_H
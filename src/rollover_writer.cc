@@ -0,0 +1,217 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "rollover_writer.h"
+
+#include "argument_helper.h"
+#include "assert.h"
+#include "sheet.h"
+#include "util.h"
+
+using namespace v8;
+
+namespace node_libxl {
+
+
+namespace {
+
+
+// Days between 1899-12-30 (day 0 of the 1900 date system) and 1970-01-01,
+// and the offset of the 1904 date system
+const double UNIX_EPOCH_SERIAL = 25569;
+const double DATE_1904_OFFSET = 1462;
+const double MS_PER_DAY = 86400000;
+
+
+}
+
+
+// Lifecycle
+
+
+RolloverWriter::RolloverWriter(SheetRollover* rollover, Handle<Value> book) :
+    Wrapper<SheetRollover>(rollover),
+    BookWrapper(book)
+{}
+
+
+RolloverWriter::~RolloverWriter() {
+    delete wrapped;
+}
+
+
+Handle<Object> RolloverWriter::NewInstance(SheetRollover* rollover,
+    Handle<Value> book)
+{
+    NanEscapableScope();
+
+    RolloverWriter* writer = new RolloverWriter(rollover, book);
+
+    Local<Object> that = NanNew(util::CallStubConstructor(
+        NanNew(constructor)).As<Object>());
+
+    writer->Wrap(that);
+
+    return NanEscapeScope(that);
+}
+
+
+// Implementation
+
+
+// Rows are arrays of numbers, strings, booleans and dates; null and
+// undefined leave cells empty. Each row is validated before it is written.
+NAN_METHOD(RolloverWriter::WriteRows) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Array> rows = arguments.GetArray(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    RolloverWriter* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    SheetRollover* rollover = that->wrapped;
+    libxl::Book* libxlBook = util::UnwrapBook(that);
+    double dateOffset = UNIX_EPOCH_SERIAL -
+        (libxlBook->isDate1904() ? DATE_1904_OFFSET : 0);
+
+    for (uint32_t i = 0; i < rows->Length(); i++) {
+        Handle<Value> row = rows->Get(i);
+
+        if (!row->IsArray()) {
+            return NanThrowTypeError("rows must be arrays");
+        }
+
+        Handle<Array> values = row.As<Array>();
+        uint32_t length = values->Length();
+
+        for (uint32_t j = 0; j < length; j++) {
+            Handle<Value> value = values->Get(j);
+
+            if (!value->IsNumber() && !value->IsString() &&
+                !value->IsBoolean() && !value->IsDate() &&
+                !value->IsNull() && !value->IsUndefined())
+            {
+                return NanThrowTypeError("invalid cell value");
+            }
+        }
+
+        libxl::Sheet* sheet;
+        int rowIndex, sheetCount = rollover->SheetCount();
+        bool reserved = rollover->NextRow(sheet, rowIndex);
+
+        // Adding a sheet changes the book even if the row stays empty, and
+        // a failed attempt may have added and removed one
+        if (!reserved || rollover->SheetCount() != sheetCount) {
+            that->GetBook()->Modified();
+        }
+
+        if (!reserved) return NanThrowError(rollover->ErrorMessage());
+
+        for (uint32_t j = 0; j < length; j++) {
+            Handle<Value> value = values->Get(j);
+            libxl::Format* format = rollover->ColumnFormat(j);
+            bool success = true;
+
+            if (value->IsNumber()) {
+                success = sheet->writeNum(rowIndex, j, value->NumberValue(),
+                    format);
+            } else if (value->IsString()) {
+                success = sheet->writeStr(rowIndex, j,
+                    *String::Utf8Value(value), format);
+            } else if (value->IsBoolean()) {
+                success = sheet->writeBool(rowIndex, j, value->BooleanValue(),
+                    format);
+            } else if (value->IsDate()) {
+                success = sheet->writeNum(rowIndex, j,
+                    value->NumberValue() / MS_PER_DAY + dateOffset, format);
+            }
+
+            if (!success) return util::ThrowLibxlError(that);
+
+            that->GetBook()->CellChanged(sheet, rowIndex, j);
+        }
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(RolloverWriter::CurrentSheet) {
+    NanScope();
+
+    RolloverWriter* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    NanReturnValue(Sheet::NewInstance(that->wrapped->CurrentSheet(),
+        that->GetBookHandle()));
+}
+
+
+NAN_METHOD(RolloverWriter::SheetCount) {
+    NanScope();
+
+    RolloverWriter* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    NanReturnValue(NanNew<Integer>(that->wrapped->SheetCount()));
+}
+
+
+NAN_METHOD(RolloverWriter::RowCount) {
+    NanScope();
+
+    RolloverWriter* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    NanReturnValue(NanNew<Integer>(that->wrapped->RowCount()));
+}
+
+
+// Init
+
+
+void RolloverWriter::Initialize(Handle<Object> exports) {
+    NanScope();
+
+    Local<FunctionTemplate> t = NanNew<FunctionTemplate>(util::StubConstructor);
+    t->SetClassName(NanNew<String>("RolloverWriter"));
+    t->InstanceTemplate()->SetInternalFieldCount(1);
+
+    BookWrapper::Initialize<RolloverWriter>(t);
+
+    NODE_SET_PROTOTYPE_METHOD(t, "writeRows", WriteRows);
+    NODE_SET_PROTOTYPE_METHOD(t, "sheet", CurrentSheet);
+    NODE_SET_PROTOTYPE_METHOD(t, "sheetCount", SheetCount);
+    NODE_SET_PROTOTYPE_METHOD(t, "rowCount", RowCount);
+
+    t->ReadOnlyPrototype();
+    NanAssignPersistent(constructor, t->GetFunction());
+}
+
+
+}
@@ -0,0 +1,69 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_ROLLOVER_WRITER_H
+#define BINDINGS_ROLLOVER_WRITER_H
+
+#include "common.h"
+#include "wrapper.h"
+#include "book_wrapper.h"
+#include "sheet_rollover.h"
+
+namespace node_libxl {
+
+
+// JS handle for appending rows to a series of sheets, as returned by
+// sheet.createRolloverWriter
+class RolloverWriter : public Wrapper<SheetRollover>, public BookWrapper {
+    public:
+
+        RolloverWriter(SheetRollover* rollover, v8::Handle<v8::Value> book);
+        ~RolloverWriter();
+
+        static void Initialize(v8::Handle<v8::Object> exports);
+
+        static RolloverWriter* Unwrap(v8::Handle<v8::Value> object) {
+            return Wrapper<SheetRollover>::Unwrap<RolloverWriter>(object);
+        }
+
+        static v8::Handle<v8::Object> NewInstance(SheetRollover* rollover,
+            v8::Handle<v8::Value> book);
+
+    protected:
+
+        static NAN_METHOD(WriteRows);
+        static NAN_METHOD(CurrentSheet);
+        static NAN_METHOD(SheetCount);
+        static NAN_METHOD(RowCount);
+
+    private:
+
+        RolloverWriter(const RolloverWriter&);
+        const RolloverWriter& operator=(const RolloverWriter&);
+};
+
+
+}
+
+#endif // BINDINGS_ROLLOVER_WRITER_H
@@ -24,11 +24,26 @@
 
 #include "sheet.h"
 
+#include <cstring>
+#include <sstream>
+#include <vector>
+
 #include "assert.h"
 #include "util.h"
 #include "argument_helper.h"
 #include "format.h"
 #include "async_worker.h"
+#include "range_copy.h"
+#include "typed_array.h"
+#include "column_auto_fit.h"
+#include "range_styler.h"
+#include "formula_template.h"
+#include "rollover_writer.h"
+#include "sheet_cache.h"
+#include "sheet_journal.h"
+#include "csv_export.h"
+#include "sheet_patch.h"
+#include "formula_evaluator.h"
 
 using namespace v8;
 
@@ -60,6 +75,46 @@ Handle<Object> Sheet::NewInstance(
 }
 
 
+void Sheet::CellChanged(int row, int col) {
+    GetBook()->CellChanged(GetWrapped(), row, col);
+}
+
+
+void Sheet::SheetChanged() {
+    GetBook()->SheetChanged(GetWrapped());
+}
+
+
+void Sheet::RowsChanged(int first, int last) {
+    GetBook()->RowsChanged(GetWrapped(), first, last);
+}
+
+
+void Sheet::RowsInserted(int first, int last) {
+    GetBook()->RowsInserted(GetWrapped(), first, last);
+}
+
+
+void Sheet::RowsRemoved(int first, int last) {
+    GetBook()->RowsRemoved(GetWrapped(), first, last);
+}
+
+
+void Sheet::FormatsChanged() {
+    GetBook()->FormatsChanged(GetWrapped());
+}
+
+
+void Sheet::Modified() {
+    GetBook()->Modified();
+}
+
+
+SheetCache* Sheet::Cache() {
+    return GetBook()->GetSheetCache(GetWrapped());
+}
+
+
 // Wrappers
 
 
@@ -75,7 +130,13 @@ NAN_METHOD(Sheet::CellType) {
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
 
-    libxl::CellType cellType = that->GetWrapped()->cellType(row, col);
+    SheetCache* cache = that->Cache();
+    libxl::CellType cellType;
+
+    if (!cache || !cache->CellType(row, col, cellType)) {
+        cellType = that->GetWrapped()->cellType(row, col);
+    }
+
     if (cellType == libxl::CELLTYPE_ERROR) {
         return util::ThrowLibxlError(that);
     }
@@ -134,14 +195,300 @@ NAN_METHOD(Sheet::SetCellFormat) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     ASSERT_SAME_BOOK(that, format);
 
+    that->CellChanged(row, col);
+
     that->GetWrapped()->setCellFormat(row, col, format->GetWrapped());
 
     NanReturnValue(args.This());
 }
 
 
+NAN_METHOD(Sheet::SetRangeFormat) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Range range = arguments.GetRange(0);
+    Format* format = arguments.GetWrapped<Format>(1);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+    ASSERT_SAME_BOOK(that, format);
+
+    that->FormatsChanged();
+
+    RangeStyler styler(util::UnwrapBook(that), that->GetWrapped());
+    styler.SetFormat(range, format->GetWrapped());
+
+    NanReturnValue(args.This());
+}
+
+
+namespace {
+
+
+// A single entry of the array passed to sheet.applyStyles
+struct Style {
+    Range range;
+    libxl::Format* format;
+    std::vector<libxl::Format*> formats;
+    int bandBy, border, borderColor;
+};
+
+
+}
+
+
+NAN_METHOD(Sheet::ApplyStyles) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Array> styleArray = arguments.GetArray(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    // All styles are validated before the sheet is touched
+    std::vector<Style> styles(styleArray->Length());
+
+    for (uint32_t i = 0; i < styles.size(); i++) {
+        Style& style = styles[i];
+        Handle<Value> styleHandle = styleArray->Get(i);
+
+        std::ostringstream error;
+        error << "style " << i << ": ";
+
+        if (!styleHandle->IsObject()) {
+            error << "object required";
+            return NanThrowTypeError(error.str().c_str());
+        }
+
+        Handle<Object> object = styleHandle.As<Object>();
+
+        if (!ArgumentHelper::ToRange(object->Get(NanNew<String>("range")),
+            style.range))
+        {
+            error << "valid range required";
+            return NanThrowTypeError(error.str().c_str());
+        }
+
+        Handle<Value> formatHandle = object->Get(NanNew<String>("format")),
+            formatsHandle = object->Get(NanNew<String>("formats")),
+            bandByHandle = object->Get(NanNew<String>("bandBy")),
+            borderHandle = object->Get(NanNew<String>("border")),
+            borderColorHandle = object->Get(NanNew<String>("borderColor"));
+
+        style.format = NULL;
+        if (!formatHandle->IsUndefined()) {
+            Format* format = Format::Unwrap(formatHandle);
+
+            if (!format) {
+                error << "invalid format";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            ASSERT_SAME_BOOK(that, format);
+            style.format = format->GetWrapped();
+        }
+
+        if (!formatsHandle->IsUndefined()) {
+            if (!formatsHandle->IsArray() ||
+                formatsHandle.As<Array>()->Length() == 0)
+            {
+                error << "non-empty array of formats required";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            Handle<Array> formats = formatsHandle.As<Array>();
+
+            for (uint32_t j = 0; j < formats->Length(); j++) {
+                Format* format = Format::Unwrap(formats->Get(j));
+
+                if (!format) {
+                    error << "invalid format in formats";
+                    return NanThrowTypeError(error.str().c_str());
+                }
+
+                ASSERT_SAME_BOOK(that, format);
+                style.formats.push_back(format->GetWrapped());
+            }
+        }
+
+        style.bandBy = RangeStyler::BAND_ROWS;
+        if (!bandByHandle->IsUndefined()) {
+            String::Utf8Value bandBy(bandByHandle);
+
+            if (!bandByHandle->IsString() ||
+                (strcmp(*bandBy, "rows") != 0 && strcmp(*bandBy, "columns") != 0))
+            {
+                error << "bandBy must be either 'rows' or 'columns'";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            if (strcmp(*bandBy, "columns") == 0) {
+                style.bandBy = RangeStyler::BAND_COLS;
+            }
+        }
+
+        style.border = -1;
+        style.borderColor = libxl::COLOR_BLACK;
+
+        if (!borderHandle->IsUndefined()) {
+            if (!borderHandle->IsInt32()) {
+                error << "integer required for border";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            style.border = borderHandle->Int32Value();
+        }
+
+        if (!borderColorHandle->IsUndefined()) {
+            if (!borderColorHandle->IsInt32()) {
+                error << "integer required for borderColor";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            style.borderColor = borderColorHandle->Int32Value();
+        }
+
+        if (!style.format && style.formats.empty() && style.border < 0) {
+            error << "format, formats or border required";
+            return NanThrowTypeError(error.str().c_str());
+        }
+    }
+
+    that->FormatsChanged();
+
+    // Styles are applied in order, so later styles override earlier ones
+    RangeStyler styler(util::UnwrapBook(that), that->GetWrapped());
+
+    for (size_t i = 0; i < styles.size(); i++) {
+        const Style& style = styles[i];
+
+        if (style.format) {
+            styler.SetFormat(style.range, style.format);
+        }
+
+        if (!style.formats.empty()) {
+            styler.Band(style.range, style.formats, style.bandBy);
+        }
+
+        if (style.border >= 0 && !styler.BorderBox(style.range,
+            static_cast<libxl::BorderStyle>(style.border),
+            static_cast<libxl::Color>(style.borderColor)))
+        {
+            return util::ThrowLibxlError(that);
+        }
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Sheet::StyleByRules) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Range range = arguments.GetRange(0);
+    Handle<Array> ruleArray = arguments.GetArray(1);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    const char* operators[] = {"<", "<=", ">", ">=", "==", "!="};
+    const RangeStyler::Rule::Op ops[] = {
+        RangeStyler::Rule::OP_LT, RangeStyler::Rule::OP_LE,
+        RangeStyler::Rule::OP_GT, RangeStyler::Rule::OP_GE,
+        RangeStyler::Rule::OP_EQ, RangeStyler::Rule::OP_NE
+    };
+
+    std::vector<RangeStyler::Rule> rules(ruleArray->Length());
+
+    for (uint32_t i = 0; i < rules.size(); i++) {
+        RangeStyler::Rule& rule = rules[i];
+        Handle<Value> ruleHandle = ruleArray->Get(i);
+
+        std::ostringstream error;
+        error << "rule " << i << ": ";
+
+        Handle<Value> whenHandle = ruleHandle->IsObject() ?
+            ruleHandle.As<Object>()->Get(NanNew<String>("when")) :
+            NanUndefined().As<Value>();
+
+        if (!whenHandle->IsObject()) {
+            error << "object with a when condition required";
+            return NanThrowTypeError(error.str().c_str());
+        }
+
+        Format* format = Format::Unwrap(
+            ruleHandle.As<Object>()->Get(NanNew<String>("format")));
+
+        if (!format) {
+            error << "format required";
+            return NanThrowTypeError(error.str().c_str());
+        }
+
+        ASSERT_SAME_BOOK(that, format);
+        rule.format = format->GetWrapped();
+
+        Handle<Object> when = whenHandle.As<Object>();
+        Handle<Value> opHandle = when->Get(NanNew<String>("op")),
+            valueHandle = when->Get(NanNew<String>("value")),
+            isDateHandle = when->Get(NanNew<String>("isDate"));
+
+        if (!opHandle->IsUndefined()) {
+            String::Utf8Value op(opHandle);
+
+            for (int j = 0; j < 6 && opHandle->IsString(); j++) {
+                if (strcmp(*op, operators[j]) == 0) rule.op = ops[j];
+            }
+
+            if (rule.op == RangeStyler::Rule::OP_NONE) {
+                error << "op must be one of <, <=, >, >=, ==, !=";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            if (valueHandle->IsNumber()) {
+                rule.numeric = true;
+                rule.number = valueHandle->NumberValue();
+            } else if (valueHandle->IsString()) {
+                rule.str = *String::Utf8Value(valueHandle);
+            } else {
+                error << "number or string value required";
+                return NanThrowTypeError(error.str().c_str());
+            }
+        }
+
+        if (!isDateHandle->IsUndefined()) {
+            if (!isDateHandle->IsBoolean()) {
+                error << "bool required for isDate";
+                return NanThrowTypeError(error.str().c_str());
+            }
+
+            rule.isDate = isDateHandle->BooleanValue() ? 1 : 0;
+        }
+    }
+
+    that->FormatsChanged();
+
+    RangeStyler styler(util::UnwrapBook(that), that->GetWrapped());
+    styler.ApplyRules(range, rules);
+
+    NanReturnValue(args.This());
+}
+
+
 NAN_METHOD(Sheet::ReadStr) {
     NanScope();
 
@@ -154,8 +501,14 @@ NAN_METHOD(Sheet::ReadStr) {
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
 
+    SheetCache* cache = that->Cache();
     libxl::Format* libxlFormat = NULL;
-    const char* value = that->GetWrapped()->readStr(row, col, &libxlFormat);
+    const char* value;
+
+    if (!cache || !cache->ReadStr(row, col, value, libxlFormat)) {
+        value = that->GetWrapped()->readStr(row, col, &libxlFormat);
+    }
+
     if (!value) {
         return util::ThrowLibxlError(that);
     }
@@ -182,10 +535,13 @@ NAN_METHOD(Sheet::WriteStr) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (format) {
         ASSERT_SAME_BOOK(that, format);
     }
 
+    that->CellChanged(row, col);
+
     if (!that->GetWrapped()->
             writeStr(row, col, *value, format ? format->GetWrapped() : NULL))
     {
@@ -208,9 +564,14 @@ NAN_METHOD(Sheet::ReadNum) {
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
 
+    SheetCache* cache = that->Cache();
     libxl::Format* libxlFormat = NULL;
-    double value = that->GetWrapped()->readNum(row, col, &libxlFormat);
-    
+    double value;
+
+    if (!cache || !cache->ReadNum(row, col, value, libxlFormat)) {
+        value = that->GetWrapped()->readNum(row, col, &libxlFormat);
+    }
+
     if (formatRef->IsObject() && libxlFormat) {
         formatRef.As<Object>()->Set(NanNew<String>("format"),
             Format::NewInstance(libxlFormat, that->GetBookHandle()));
@@ -233,10 +594,13 @@ NAN_METHOD(Sheet::WriteNum) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (format) {
         ASSERT_SAME_BOOK(that, format);
     }
 
+    that->CellChanged(row, col);
+
     if (!that->GetWrapped()->
             writeNum(row, col, value, format ? format->GetWrapped() : NULL))
     {
@@ -259,9 +623,14 @@ NAN_METHOD(Sheet::ReadBool) {
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
 
+    SheetCache* cache = that->Cache();
     libxl::Format* libxlFormat = NULL;
-    bool value = that->GetWrapped()->readBool(row, col, &libxlFormat);
-    
+    bool value;
+
+    if (!cache || !cache->ReadBool(row, col, value, libxlFormat)) {
+        value = that->GetWrapped()->readBool(row, col, &libxlFormat);
+    }
+
     if (formatRef->IsObject() && libxlFormat) {
         formatRef.As<Object>()->Set(NanNew<String>("format"),
             Format::NewInstance(libxlFormat, that->GetBookHandle()));
@@ -284,10 +653,13 @@ NAN_METHOD(Sheet::WriteBool) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (format) {
         ASSERT_SAME_BOOK(that, format);
     }
 
+    that->CellChanged(row, col);
+
     if (!that->GetWrapped()->
             writeBool(row, col, value, format ? format->GetWrapped() : NULL))
     {
@@ -338,8 +710,11 @@ NAN_METHOD(Sheet::WriteBlank) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     ASSERT_SAME_BOOK(that, format);
 
+    that->CellChanged(row, col);
+
     if (!that->GetWrapped()->
             writeBlank(row, col, format ? format->GetWrapped() : NULL))
     {
@@ -390,10 +765,13 @@ NAN_METHOD(Sheet::WriteFormula) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (format) {
         ASSERT_SAME_BOOK(that, format);
     }
 
+    that->CellChanged(row, col);
+
     if (!that->GetWrapped()->
             writeFormula(row, col, *value, format? format->GetWrapped() : NULL))
     {
@@ -404,6 +782,140 @@ NAN_METHOD(Sheet::WriteFormula) {
 }
 
 
+namespace {
+
+
+// Sheet dimensions of the file formats
+const int XLS_MAX_ROWS = 65536;
+const int XLS_MAX_COLS = 256;
+const int XLSX_MAX_ROWS = 1048576;
+const int XLSX_MAX_COLS = 16384;
+
+
+}
+
+
+NAN_METHOD(Sheet::FillFormula) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    String::Utf8Value formula(arguments.GetString(0));
+    int rowFirst = arguments.GetInt(1),
+        rowLast = arguments.GetInt(2),
+        col = arguments.GetInt(3);
+    Format* format = arguments.GetWrapped<Format>(4, "format", NULL);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+    if (format) {
+        ASSERT_SAME_BOOK(that, format);
+    }
+
+    if (rowFirst < 0 || rowLast < rowFirst) {
+        return NanThrowTypeError("invalid row range");
+    }
+
+    that->RowsChanged(rowFirst, rowLast);
+
+    // The template is the formula of the first row
+    bool xls = util::UnwrapBook(that)->biffVersion() != 0;
+    FormulaTemplate formulaTemplate(*formula,
+        xls ? XLS_MAX_ROWS : XLSX_MAX_ROWS, xls ? XLS_MAX_COLS : XLSX_MAX_COLS);
+    libxl::Sheet* libxlSheet = that->GetWrapped();
+    libxl::Format* libxlFormat = format ? format->GetWrapped() : NULL;
+
+    for (int row = rowFirst; row <= rowLast; row++) {
+        if (!libxlSheet->writeFormula(row, col,
+            formulaTemplate.Shift(row - rowFirst, 0).c_str(), libxlFormat))
+        {
+            return util::ThrowLibxlError(that);
+        }
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Sheet::EvaluateFormulas) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Range range = arguments.GetRange(0);
+    bool write = arguments.GetBoolean(1, "write", false);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    libxl::Sheet* libxlSheet = that->GetWrapped();
+    FormulaEvaluator evaluator(util::UnwrapBook(that), libxlSheet);
+
+    if (!evaluator.Evaluate(range)) {
+        return util::ThrowLibxlError(that);
+    }
+
+    Local<Array> result = NanNew<Array>(range.Rows());
+
+    for (int row = range.rowFirst; row <= range.rowLast; row++) {
+        Local<Array> rowValues = NanNew<Array>(range.Cols());
+
+        for (int col = range.colFirst; col <= range.colLast; col++) {
+            const FormulaEvaluator::Value* value = evaluator.Result(row, col);
+            Handle<Value> cellValue = NanNull();
+            bool success = true;
+
+            // Error results are not written as libxl cannot write errors
+            if (value) {
+                libxl::Format* format = libxlSheet->cellFormat(row, col);
+
+                switch (value->type) {
+                    case FormulaEvaluator::Value::NUMBER:
+                        cellValue = NanNew<Number>(value->number);
+                        success = !write || libxlSheet->writeNum(row, col,
+                            value->number, format);
+                        break;
+
+                    case FormulaEvaluator::Value::STRING:
+                        cellValue = NanNew<String>(value->text.c_str());
+                        success = !write || libxlSheet->writeStr(row, col,
+                            value->text.c_str(), format);
+                        break;
+
+                    case FormulaEvaluator::Value::BOOLEAN:
+                        cellValue = NanNew<Boolean>(value->number != 0);
+                        success = !write || libxlSheet->writeBool(row, col,
+                            value->number != 0, format);
+                        break;
+
+                    default:
+                        cellValue = NanNew<String>(value->text.c_str());
+                        break;
+                }
+            }
+
+            if (!success) {
+                that->RowsChanged(range.rowFirst, row);
+                return util::ThrowLibxlError(that);
+            }
+
+            rowValues->Set(col - range.colFirst, cellValue);
+        }
+
+        result->Set(row - range.rowFirst, rowValues);
+    }
+
+    // Read-only evaluation leaves the book clean
+    if (write) that->RowsChanged(range.rowFirst, range.rowLast);
+
+    NanReturnValue(result);
+}
+
+
 NAN_METHOD(Sheet::ReadComment) {
     NanScope();
 
@@ -439,6 +951,9 @@ NAN_METHOD(Sheet::WriteComment) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (args[3]->IsString()) {
         that->GetWrapped()->writeComment(row, col, *value, *author,
@@ -528,10 +1043,13 @@ NAN_METHOD(Sheet::SetCol) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (format) {
         ASSERT_SAME_BOOK(that, format);
     }
 
+    that->FormatsChanged();
+
     if (!that->GetWrapped()->setCol(first, last, width,
             format ? format->GetWrapped() : NULL, hidden))
     {
@@ -555,10 +1073,13 @@ NAN_METHOD(Sheet::SetRow) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
     if (format) {
         ASSERT_SAME_BOOK(that, format);
     }
 
+    that->FormatsChanged();
+
     if (!that->GetWrapped()->setRow(row, height,
         format ? format->GetWrapped() : NULL, hidden))
     {
@@ -595,43 +1116,203 @@ NAN_METHOD(Sheet::SetRowHidden) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
+
+    if (!that->GetWrapped()->setRowHidden(row, hidden)) {
+        return util::ThrowLibxlError(that);
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Sheet::ColHidden) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    int col = arguments.GetInt(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    NanReturnValue(NanNew<Boolean>(that->GetWrapped()->colHidden(col)));
+}
+
+
+NAN_METHOD(Sheet::SetColHidden) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    int col = arguments.GetInt(0);
+    bool hidden = arguments.GetBoolean(1);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
+
+    if (!that->GetWrapped()->setColHidden(col, hidden)) {
+        return util::ThrowLibxlError(that);
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Sheet::GetLayout) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Range range = arguments.GetRange(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    libxl::Sheet* libxlSheet = that->GetWrapped();
+    double *rowHeight, *colWidth;
+    uint8_t *rowHidden, *colHidden;
+
+    Local<Object> result = NanNew<Object>();
+    result->Set(NanNew<String>("rowHeight"), util::NewTypedArray(
+        "Float64Array", range.Rows(), reinterpret_cast<void**>(&rowHeight)));
+    result->Set(NanNew<String>("rowHidden"), util::NewTypedArray(
+        "Uint8Array", range.Rows(), reinterpret_cast<void**>(&rowHidden)));
+    result->Set(NanNew<String>("colWidth"), util::NewTypedArray(
+        "Float64Array", range.Cols(), reinterpret_cast<void**>(&colWidth)));
+    result->Set(NanNew<String>("colHidden"), util::NewTypedArray(
+        "Uint8Array", range.Cols(), reinterpret_cast<void**>(&colHidden)));
+
+    for (int i = 0; i < range.Rows(); i++) {
+        rowHeight[i] = libxlSheet->rowHeight(range.rowFirst + i);
+        rowHidden[i] = libxlSheet->rowHidden(range.rowFirst + i);
+    }
+
+    for (int i = 0; i < range.Cols(); i++) {
+        colWidth[i] = libxlSheet->colWidth(range.colFirst + i);
+        colHidden[i] = libxlSheet->colHidden(range.colFirst + i);
+    }
+
+    NanReturnValue(result);
+}
+
+
+NAN_METHOD(Sheet::SetLayout) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Range range = arguments.GetRange(0);
+    std::vector<double> rowHeight, rowHidden, colWidth, colHidden;
+    std::vector<Format*> rowFormat, colFormat;
+
+    bool hasRowHeight = arguments.GetNumberArray(1, "rowHeight", range.Rows(), rowHeight),
+         hasRowHidden = arguments.GetNumberArray(1, "rowHidden", range.Rows(), rowHidden),
+         hasRowFormat = arguments.GetWrappedArray(1, "rowFormat", range.Rows(), rowFormat),
+         hasColWidth  = arguments.GetNumberArray(1, "colWidth", range.Cols(), colWidth),
+         hasColHidden = arguments.GetNumberArray(1, "colHidden", range.Cols(), colHidden),
+         hasColFormat = arguments.GetWrappedArray(1, "colFormat", range.Cols(), colFormat);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
-    if (!that->GetWrapped()->setRowHidden(row, hidden)) {
-        return util::ThrowLibxlError(that);
+    for (size_t i = 0; i < rowFormat.size(); i++) {
+        if (rowFormat[i]) {
+            ASSERT_SAME_BOOK(that, rowFormat[i]);
+        }
     }
 
-    NanReturnValue(args.This());
-}
+    for (size_t i = 0; i < colFormat.size(); i++) {
+        if (colFormat[i]) {
+            ASSERT_SAME_BOOK(that, colFormat[i]);
+        }
+    }
 
+    that->FormatsChanged();
 
-NAN_METHOD(Sheet::ColHidden) {
-    NanScope();
+    libxl::Sheet* libxlSheet = that->GetWrapped();
 
-    ArgumentHelper arguments(args);
+    // Properties that are not passed keep their current values. setRow
+    // always fixes the row height, so rows that are only hidden or shown
+    // keep their automatic height.
+    if (hasRowHeight || hasRowFormat) {
+        for (int i = 0; i < range.Rows(); i++) {
+            int row = range.rowFirst + i;
 
-    int col = arguments.GetInt(0);
-    ASSERT_ARGUMENTS(arguments);
+            if (!libxlSheet->setRow(row,
+                hasRowHeight ? rowHeight[i] : libxlSheet->rowHeight(row),
+                hasRowFormat && rowFormat[i] ? rowFormat[i]->GetWrapped() : NULL,
+                hasRowHidden ? rowHidden[i] != 0 : libxlSheet->rowHidden(row)))
+            {
+                return util::ThrowLibxlError(that);
+            }
+        }
+    } else if (hasRowHidden) {
+        for (int i = 0; i < range.Rows(); i++) {
+            if (!libxlSheet->setRowHidden(range.rowFirst + i,
+                rowHidden[i] != 0))
+            {
+                return util::ThrowLibxlError(that);
+            }
+        }
+    }
 
-    Sheet* that = Unwrap(args.This());
-    ASSERT_THIS(that);
+    if (hasColWidth || hasColFormat) {
+        for (int i = 0; i < range.Cols(); i++) {
+            int col = range.colFirst + i;
 
-    NanReturnValue(NanNew<Boolean>(that->GetWrapped()->colHidden(col)));
+            if (!libxlSheet->setCol(col, col,
+                hasColWidth ? colWidth[i] : libxlSheet->colWidth(col),
+                hasColFormat && colFormat[i] ? colFormat[i]->GetWrapped() : NULL,
+                hasColHidden ? colHidden[i] != 0 : libxlSheet->colHidden(col)))
+            {
+                return util::ThrowLibxlError(that);
+            }
+        }
+    } else if (hasColHidden) {
+        for (int i = 0; i < range.Cols(); i++) {
+            if (!libxlSheet->setColHidden(range.colFirst + i,
+                colHidden[i] != 0))
+            {
+                return util::ThrowLibxlError(that);
+            }
+        }
+    }
+
+    NanReturnValue(args.This());
 }
 
 
-NAN_METHOD(Sheet::SetColHidden) {
+NAN_METHOD(Sheet::AutoFitColumns) {
     NanScope();
 
     ArgumentHelper arguments(args);
 
-    int col = arguments.GetInt(0);
-    bool hidden = arguments.GetBoolean(1);
+    Range range = arguments.GetRange(0);
+    double minWidth = arguments.GetDouble(1, "min", 0),
+           maxWidth = arguments.GetDouble(1, "max", 255),
+           padding  = arguments.GetDouble(1, "padding", 1);
     ASSERT_ARGUMENTS(arguments);
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
-    if (!that->GetWrapped()->setColHidden(col, hidden)) {
+    that->Modified();
+
+    ColumnAutoFit autoFit(util::UnwrapBook(that), that->GetWrapped());
+
+    if (!autoFit.Apply(range, minWidth, maxWidth, padding)) {
         return util::ThrowLibxlError(that);
     }
 
@@ -682,6 +1363,9 @@ NAN_METHOD(Sheet::SetMerge) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setMerge(rowFirst, rowLast, colFirst, colLast)) {
         return util::ThrowLibxlError(that);
@@ -702,6 +1386,9 @@ NAN_METHOD(Sheet::DelMerge) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->delMerge(row, col)) {
         return util::ThrowLibxlError(that);
@@ -772,6 +1459,9 @@ NAN_METHOD(Sheet::SetPicture) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPicture(row, col, id, scale, offset_x, offset_y);
 
@@ -795,6 +1485,9 @@ NAN_METHOD(Sheet::SetPicture2) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPicture2(row, col, id, width, height, offset_x,
         offset_y);
@@ -864,6 +1557,9 @@ NAN_METHOD(Sheet::SetHorPageBreak) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setHorPageBreak(row, pagebreak)) {
         return util::ThrowLibxlError(that);
@@ -884,6 +1580,9 @@ NAN_METHOD(Sheet::SetVerPageBreak) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setVerPageBreak(col, pagebreak)) {
         return util::ThrowLibxlError(that);
@@ -904,6 +1603,9 @@ NAN_METHOD(Sheet::Split) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->split(row, col);
 
@@ -923,6 +1625,9 @@ NAN_METHOD(Sheet::GroupRows) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->groupRows(rowFirst, rowLast, collapsed)) {
         return util::ThrowLibxlError(that);
@@ -944,6 +1649,9 @@ NAN_METHOD(Sheet::GroupCols) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->groupCols(colFirst, colLast, collapsed)) {
         return util::ThrowLibxlError(that);
@@ -973,6 +1681,9 @@ NAN_METHOD(Sheet::SetGroupSummaryBelow) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setGroupSummaryBelow(summaryBelow);
 
@@ -1000,6 +1711,9 @@ NAN_METHOD(Sheet::SetGroupSummaryRight) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setGroupSummaryRight(summaryRight);
 
@@ -1020,6 +1734,9 @@ NAN_METHOD(Sheet::Clear) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->RowsChanged(rowFirst, rowLast);
 
     that->GetWrapped()->clear(rowFirst, rowLast, colFirst, colLast);
 
@@ -1038,11 +1755,15 @@ NAN_METHOD(Sheet::InsertRow) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
     if (!that->GetWrapped()->insertRow(rowFirst, rowLast)) {
+        that->SheetChanged();
         return util::ThrowLibxlError(that);
     }
 
+    that->RowsInserted(rowFirst, rowLast);
+
     NanReturnValue(args.This());
 }
 
@@ -1063,6 +1784,18 @@ NAN_METHOD(Sheet::InsertRowAsync) {
                 }
             }
 
+            virtual void HandleOKCallback() {
+                that->RowsInserted(rowFirst, rowLast);
+
+                AsyncWorker<Sheet>::HandleOKCallback();
+            }
+
+            virtual void HandleErrorCallback() {
+                that->SheetChanged();
+
+                AsyncWorker<Sheet>::HandleErrorCallback();
+            }
+
         private:
             int rowFirst, rowLast;
     };
@@ -1078,6 +1811,7 @@ NAN_METHOD(Sheet::InsertRowAsync) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
     NanAsyncQueueWorker(new Worker(new NanCallback(callback),
         args.This(), rowFirst, rowLast));
@@ -1097,6 +1831,9 @@ NAN_METHOD(Sheet::InsertCol) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetChanged();
 
     if (!that->GetWrapped()->insertCol(colFirst, colLast)) {
         return util::ThrowLibxlError(that);
@@ -1137,6 +1874,9 @@ NAN_METHOD(Sheet::InsertColAsync) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetChanged();
 
     NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(),
         colFirst, colLast));
@@ -1156,11 +1896,15 @@ NAN_METHOD(Sheet::RemoveRow) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
     if (!that->GetWrapped()->removeRow(rowFirst, rowLast)) {
+        that->SheetChanged();
         return util::ThrowLibxlError(that);
     }
 
+    that->RowsRemoved(rowFirst, rowLast);
+
     NanReturnValue(args.This());
 }
 
@@ -1181,6 +1925,18 @@ NAN_METHOD(Sheet::RemoveRowAsync) {
                 }
             }
 
+            virtual void HandleOKCallback() {
+                that->RowsRemoved(rowFirst, rowLast);
+
+                AsyncWorker<Sheet>::HandleOKCallback();
+            }
+
+            virtual void HandleErrorCallback() {
+                that->SheetChanged();
+
+                AsyncWorker<Sheet>::HandleErrorCallback();
+            }
+
         private:
             int rowFirst, rowLast;
     };
@@ -1196,6 +1952,7 @@ NAN_METHOD(Sheet::RemoveRowAsync) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
 
     NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(),
         rowFirst, rowLast));
@@ -1235,6 +1992,9 @@ NAN_METHOD(Sheet::RemoveColAsync) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetChanged();
 
     NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This(),
         colFirst, colLast));
@@ -1254,6 +2014,9 @@ NAN_METHOD(Sheet::RemoveCol) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->SheetChanged();
 
     if (!that->GetWrapped()->removeCol(colFirst, colLast)) {
         return util::ThrowLibxlError(that);
@@ -1276,6 +2039,9 @@ NAN_METHOD(Sheet::CopyCell) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->CellChanged(rowDst, colDst);
 
     if (!that->GetWrapped()->copyCell(rowSrc, colSrc, rowDst, colDst)) {
         return util::ThrowLibxlError(that);
@@ -1285,6 +2051,325 @@ NAN_METHOD(Sheet::CopyCell) {
 }
 
 
+NAN_METHOD(Sheet::CopyRange) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Range range = arguments.GetRange(0);
+    int rowDst = arguments.GetInt(1),
+        colDst = arguments.GetInt(2);
+    Sheet* targetSheet = arguments.GetWrapped<Sheet>(3, "targetSheet", NULL);
+    bool values     = arguments.GetBoolean(3, "values", true),
+         formats    = arguments.GetBoolean(3, "formats", true),
+         formulas   = arguments.GetBoolean(3, "formulas", true);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    if (targetSheet) {
+        ASSERT_THIS(targetSheet);
+    } else {
+        targetSheet = that;
+    }
+
+    ASSERT_WRITABLE(targetSheet);
+
+    targetSheet->RowsChanged(rowDst, rowDst + range.Rows() - 1);
+
+    int flags = (values ? RangeCopy::COPY_VALUES : 0) |
+        (formats ? RangeCopy::COPY_FORMATS : 0) |
+        (formulas ? RangeCopy::COPY_FORMULAS : 0);
+
+    RangeCopy rangeCopy(that->GetWrapped(), util::UnwrapBook(that),
+        targetSheet->GetWrapped(), util::UnwrapBook(targetSheet), flags);
+
+    if (!rangeCopy.Copy(range, rowDst, colDst)) {
+        return NanThrowError(rangeCopy.ErrorMessage());
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+// Rows are appended after the header rows or the last used row; the writer
+// continues on a new sheet once maxRows rows are used
+NAN_METHOD(Sheet::CreateRolloverWriter) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    int headerRows = arguments.GetInt(0, "headerRows", 0);
+    int maxRows = arguments.GetInt(0, "maxRows", 0);
+
+    Handle<Value> columnFormats = args[0]->IsObject() ?
+        args[0].As<Object>()->Get(NanNew<String>("columnFormats")) :
+        NanUndefined().As<Value>();
+    uint32_t columnCount = columnFormats->IsArray() ?
+        columnFormats.As<Array>()->Length() : 0;
+    std::vector<Format*> formats;
+
+    if (!columnFormats->IsUndefined()) {
+        arguments.GetWrappedArray(0, "columnFormats", columnCount, formats);
+    }
+
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    libxl::Book* libxlBook = util::UnwrapBook(that);
+    int rowLimit = SheetRollover::FormatRowLimit(libxlBook);
+
+    if (maxRows == 0) maxRows = rowLimit;
+
+    if (headerRows < 0 || maxRows < 0 || maxRows > rowLimit ||
+        headerRows >= maxRows)
+    {
+        return NanThrowTypeError("invalid headerRows or maxRows");
+    }
+
+    std::vector<libxl::Format*> libxlFormats(formats.size(), NULL);
+
+    for (size_t i = 0; i < formats.size(); i++) {
+        if (!formats[i]) continue;
+
+        ASSERT_SAME_BOOK(that, formats[i]);
+        libxlFormats[i] = formats[i]->GetWrapped();
+    }
+
+    NanReturnValue(RolloverWriter::NewInstance(new SheetRollover(libxlBook,
+        that->GetWrapped(), headerRows, maxRows, libxlFormats),
+        that->GetBookHandle()));
+}
+
+
+// The snapshot is taken lazily on the first read and again after changes
+// to whole ranges; single written cells are read from libxl from then on
+NAN_METHOD(Sheet::EnableCache) {
+    NanScope();
+
+    Handle<Value> rangeValue = args[0]->IsObject() ?
+        args[0].As<Object>()->Get(NanNew<String>("range")) :
+        NanUndefined().As<Value>();
+
+    // Without a range, the used range of the sheet is cached
+    Range range;
+    if (!rangeValue->IsUndefined() &&
+        !ArgumentHelper::ToRange(rangeValue, range))
+    {
+        return NanThrowTypeError("invalid range");
+    }
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    that->GetBook()->SetSheetCache(that->GetWrapped(),
+        new SheetCache(that->GetWrapped(), range));
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(Sheet::DisableCache) {
+    NanScope();
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    that->GetBook()->SetSheetCache(that->GetWrapped(), NULL);
+
+    NanReturnValue(args.This());
+}
+
+
+// The first call starts a change journal for the sheet. Later calls reuse
+// the lines of unchanged rows from previousExport if it is the result of
+// the last call.
+NAN_METHOD(Sheet::ExportCsvIncremental) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    bool hasPrevious = !args[0]->IsUndefined() && !args[0]->IsNull();
+    Handle<Value> previousHandle = hasPrevious ?
+        arguments.GetString(0) : Handle<Value>();
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+
+    SheetJournal* journal = that->GetBook()->GetSheetJournal(
+        that->GetWrapped());
+
+    if (!journal) {
+        journal = new SheetJournal();
+        that->GetBook()->SetSheetJournal(that->GetWrapped(), journal);
+    }
+
+    std::string previous, csv;
+    if (hasPrevious) previous = *String::Utf8Value(previousHandle);
+
+    CsvExport(that->GetWrapped(), *journal).Run(
+        hasPrevious ? &previous : NULL, csv);
+
+    NanReturnValue(NanNew<String>(csv.data(), static_cast<int>(csv.size())));
+}
+
+
+namespace {
+
+
+// Copies a typed array property of the patch, optional arrays may be absent
+template<typename T> bool GetPatchArray(Handle<Object> patch, const char* key,
+    const char* type, bool optional, std::vector<T>& values)
+{
+    Handle<Value> value = patch->Get(NanNew<String>(key));
+    if (optional && value->IsUndefined()) return true;
+
+    uint32_t length;
+    T* data = static_cast<T*>(util::GetTypedArrayData(value, type, length));
+    if (!data) return false;
+
+    values.assign(data, data + length);
+
+    return true;
+}
+
+
+std::string ReadPatch(Handle<Value> value, SheetPatch::Cells& cells) {
+    if (!value->IsObject()) return "patch object required as argument 0";
+
+    Handle<Object> patch = value.As<Object>();
+
+    if (!GetPatchArray(patch, "row", "Int32Array", false, cells.rows) ||
+        !GetPatchArray(patch, "col", "Int32Array", false, cells.cols) ||
+        !GetPatchArray(patch, "type", "Uint8Array", false, cells.types) ||
+        !GetPatchArray(patch, "number", "Float64Array", false,
+            cells.numbers) ||
+        !GetPatchArray(patch, "format", "Int32Array", true, cells.formats))
+    {
+        return "patch requires the typed arrays row, col, type and number";
+    }
+
+    Handle<Value> strings = patch->Get(NanNew<String>("strings"));
+    if (strings->IsUndefined()) return "";
+    if (!strings->IsArray()) return "strings of the patch must be an array";
+
+    uint32_t length = strings.As<Array>()->Length();
+    cells.strings.resize(length);
+
+    for (uint32_t i = 0; i < length; i++) {
+        Handle<Value> string = strings.As<Array>()->Get(i);
+        if (!string->IsString()) return "strings of the patch must be strings";
+
+        cells.strings[i] = *String::Utf8Value(string);
+    }
+
+    return "";
+}
+
+
+}
+
+
+// The patch is validated completely before the first cell is written, so
+// invalid patches leave the sheet untouched
+NAN_METHOD(Sheet::ApplyPatch) {
+    class Worker : public AsyncWorker<Sheet> {
+        public:
+            Worker(NanCallback* callback, Local<Object> that,
+                    SheetPatch* patch) :
+                AsyncWorker<Sheet>(callback, that),
+                patch(patch)
+            {}
+
+            ~Worker() {
+                delete patch;
+            }
+
+            virtual void Execute() {
+                if (!patch->Apply()) SetErrorMessage(
+                    patch->ErrorMessage().c_str());
+            }
+
+            virtual void HandleOKCallback() {
+                const SheetPatch::Cells& cells = patch->GetCells();
+
+                for (size_t i = 0; i < cells.rows.size(); i++) {
+                    that->CellChanged(cells.rows[i], cells.cols[i]);
+                }
+
+                AsyncWorker<Sheet>::HandleOKCallback();
+            }
+
+            virtual void HandleErrorCallback() {
+                that->SheetChanged();
+
+                AsyncWorker<Sheet>::HandleErrorCallback();
+            }
+
+        private:
+            SheetPatch* patch;
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    bool async = !args[1]->IsUndefined();
+    Handle<Function> callback;
+    if (async) callback = arguments.GetFunction(1);
+    ASSERT_ARGUMENTS(arguments);
+
+    Sheet* that = Unwrap(args.This());
+    ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    SheetPatch* patch = new SheetPatch(util::UnwrapBook(that),
+        that->GetWrapped());
+    std::string error = ReadPatch(args[0], patch->GetCells());
+
+    if (!error.empty()) {
+        delete patch;
+        return NanThrowTypeError(error.c_str());
+    }
+
+    if (!patch->Validate()) {
+        error = patch->ErrorMessage();
+        delete patch;
+
+        return NanThrowError(error.c_str());
+    }
+
+    if (async) {
+        NanAsyncQueueWorker(new Worker(new NanCallback(callback),
+            args.This(), patch));
+
+        NanReturnValue(args.This());
+    }
+
+    bool ok = patch->Apply();
+    const SheetPatch::Cells& cells = patch->GetCells();
+
+    if (ok) {
+        for (size_t i = 0; i < cells.rows.size(); i++) {
+            that->CellChanged(cells.rows[i], cells.cols[i]);
+        }
+    } else {
+        error = patch->ErrorMessage();
+        that->SheetChanged();
+    }
+
+    delete patch;
+
+    if (!ok) return NanThrowError(error.c_str());
+
+    NanReturnValue(args.This());
+}
+
+
 NAN_METHOD(Sheet::FirstRow) {
     NanScope();
 
@@ -1345,6 +2430,9 @@ NAN_METHOD(Sheet::SetDisplayGridlines) {
     
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setDisplayGridlines(displayGridlines);
 
@@ -1372,6 +2460,9 @@ NAN_METHOD(Sheet::SetPrintGridlines) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintGridlines(printGridlines);
 
@@ -1399,6 +2490,9 @@ NAN_METHOD(Sheet::SetZoom) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setZoom(zoom);
 
@@ -1426,6 +2520,9 @@ NAN_METHOD(Sheet::SetPrintZoom) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintZoom(zoom);
 
@@ -1465,6 +2562,9 @@ NAN_METHOD(Sheet::SetPrintFit) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintFit(wPages, hPages);
 
@@ -1492,6 +2592,9 @@ NAN_METHOD(Sheet::SetLandscape) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setLandscape(landscape);
 
@@ -1519,6 +2622,9 @@ NAN_METHOD(Sheet::SetPaper) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPaper(static_cast<libxl::Paper>(paper));
 
@@ -1547,6 +2653,9 @@ NAN_METHOD(Sheet::SetHeader) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setHeader(*header, margin)) {
         return util::ThrowLibxlError(that);
@@ -1588,6 +2697,9 @@ NAN_METHOD(Sheet::SetFooter) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setFooter(*footer, margin)) {
         return util::ThrowLibxlError(that);
@@ -1627,6 +2739,9 @@ NAN_METHOD(Sheet::SetHCenter) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setHCenter(center);
 
@@ -1654,6 +2769,9 @@ NAN_METHOD(Sheet::SetVCenter) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setVCenter(center);
 
@@ -1681,6 +2799,9 @@ NAN_METHOD(Sheet::SetMarginLeft) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setMarginLeft(margin);
 
@@ -1708,6 +2829,9 @@ NAN_METHOD(Sheet::SetMarginRight) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setMarginRight(margin);
 
@@ -1735,6 +2859,9 @@ NAN_METHOD(Sheet::SetMarginTop) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setMarginTop(margin);
 
@@ -1762,6 +2889,9 @@ NAN_METHOD(Sheet::SetMarginBottom) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setMarginBottom(margin);
 
@@ -1788,6 +2918,9 @@ NAN_METHOD(Sheet::SetPrintRowCol) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintRowCol(printRowCol);
 
@@ -1806,6 +2939,9 @@ NAN_METHOD(Sheet::SetPrintRepeatRows) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintRepeatRows(rowFirst, rowLast);
 
@@ -1824,6 +2960,9 @@ NAN_METHOD(Sheet::SetPrintRepeatCols) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintRepeatCols(colFirst, colLast);
 
@@ -1844,6 +2983,9 @@ NAN_METHOD(Sheet::SetPrintArea) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setPrintArea(rowFirst, rowLast, colFirst, colLast);
 
@@ -1856,6 +2998,9 @@ NAN_METHOD(Sheet::ClearPrintRepeats) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->clearPrintRepeats();
 
@@ -1868,6 +3013,9 @@ NAN_METHOD(Sheet::ClearPrintArea) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->clearPrintArea();
 
@@ -1922,6 +3070,9 @@ NAN_METHOD(Sheet::SetNamedRange) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setNamedRange(*name,
         rowFirst, rowLast, colFirst, colLast, static_cast<libxl::Scope>(scopeId)))
@@ -1944,6 +3095,9 @@ NAN_METHOD(Sheet::DelNamedRange) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->delNamedRange(*name,
         static_cast<libxl::Scope>(scopeId)))
@@ -2019,6 +3173,9 @@ NAN_METHOD(Sheet::SetName) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setName(*name);
 
@@ -2046,6 +3203,9 @@ NAN_METHOD(Sheet::SetProtect) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setProtect(protect);
 
@@ -2073,6 +3233,9 @@ NAN_METHOD(Sheet::SetRightToLeft) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setRightToLeft(rightToLeft);
 
@@ -2100,6 +3263,9 @@ NAN_METHOD(Sheet::SetHidden) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     if (!that->GetWrapped()->setHidden(static_cast<libxl::SheetState>(state))) {
         return util::ThrowLibxlError(that);
@@ -2137,6 +3303,9 @@ NAN_METHOD(Sheet::SetTopLeftView) {
 
     Sheet* that = Unwrap(args.This());
     ASSERT_THIS(that);
+    ASSERT_WRITABLE(that);
+
+    that->Modified();
 
     that->GetWrapped()->setTopLeftView(row, col);
 
@@ -2213,6 +3382,9 @@ void Sheet::Initialize(Handle<Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(t, "isFormula", IsFormula);
     NODE_SET_PROTOTYPE_METHOD(t, "cellFormat", CellFormat);
     NODE_SET_PROTOTYPE_METHOD(t, "setCellFormat", SetCellFormat);
+    NODE_SET_PROTOTYPE_METHOD(t, "setRangeFormat", SetRangeFormat);
+    NODE_SET_PROTOTYPE_METHOD(t, "applyStyles", ApplyStyles);
+    NODE_SET_PROTOTYPE_METHOD(t, "styleByRules", StyleByRules);
     NODE_SET_PROTOTYPE_METHOD(t, "readStr", ReadStr);
     NODE_SET_PROTOTYPE_METHOD(t, "readString", ReadStr);
     NODE_SET_PROTOTYPE_METHOD(t, "writeString", WriteStr);
@@ -2225,6 +3397,8 @@ void Sheet::Initialize(Handle<Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(t, "writeBlank", WriteBlank);
     NODE_SET_PROTOTYPE_METHOD(t, "readFormula", ReadFormula);
     NODE_SET_PROTOTYPE_METHOD(t, "writeFormula", WriteFormula);
+    NODE_SET_PROTOTYPE_METHOD(t, "fillFormula", FillFormula);
+    NODE_SET_PROTOTYPE_METHOD(t, "evaluateFormulas", EvaluateFormulas);
     NODE_SET_PROTOTYPE_METHOD(t, "readComment", ReadComment);
     NODE_SET_PROTOTYPE_METHOD(t, "writeComment", WriteComment);
     NODE_SET_PROTOTYPE_METHOD(t, "isDate", IsDate);
@@ -2237,6 +3411,9 @@ void Sheet::Initialize(Handle<Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(t, "setRowHidden", SetRowHidden);
     NODE_SET_PROTOTYPE_METHOD(t, "colHidden", ColHidden);
     NODE_SET_PROTOTYPE_METHOD(t, "setColHidden", SetColHidden);
+    NODE_SET_PROTOTYPE_METHOD(t, "getLayout", GetLayout);
+    NODE_SET_PROTOTYPE_METHOD(t, "setLayout", SetLayout);
+    NODE_SET_PROTOTYPE_METHOD(t, "autoFitColumns", AutoFitColumns);
     NODE_SET_PROTOTYPE_METHOD(t, "getMerge", GetMerge);
     NODE_SET_PROTOTYPE_METHOD(t, "setMerge", SetMerge);
     NODE_SET_PROTOTYPE_METHOD(t, "delMerge", DelMerge);
@@ -2267,6 +3444,13 @@ void Sheet::Initialize(Handle<Object> exports) {
     NODE_SET_PROTOTYPE_METHOD(t, "removeCol", RemoveCol);
     NODE_SET_PROTOTYPE_METHOD(t, "removeColAsync", RemoveColAsync);
     NODE_SET_PROTOTYPE_METHOD(t, "copyCell", CopyCell);
+    NODE_SET_PROTOTYPE_METHOD(t, "copyRange", CopyRange);
+    NODE_SET_PROTOTYPE_METHOD(t, "createRolloverWriter",
+        CreateRolloverWriter);
+    NODE_SET_PROTOTYPE_METHOD(t, "enableCache", EnableCache);
+    NODE_SET_PROTOTYPE_METHOD(t, "disableCache", DisableCache);
+    NODE_SET_PROTOTYPE_METHOD(t, "exportCsvIncremental", ExportCsvIncremental);
+    NODE_SET_PROTOTYPE_METHOD(t, "applyPatch", ApplyPatch);
     NODE_SET_PROTOTYPE_METHOD(t, "firstRow", FirstRow);
     NODE_SET_PROTOTYPE_METHOD(t, "lastRow", LastRow);
     NODE_SET_PROTOTYPE_METHOD(t, "firstCol", FirstCol);
@@ -32,6 +32,9 @@
 namespace node_libxl {
 
 
+class SheetCache;
+
+
 class Sheet : public Wrapper<libxl::Sheet> , public BookWrapper
 
 {
@@ -56,6 +59,9 @@ class Sheet : public Wrapper<libxl::Sheet> , public BookWrapper
         static NAN_METHOD(IsFormula);
         static NAN_METHOD(CellFormat);
         static NAN_METHOD(SetCellFormat);
+        static NAN_METHOD(SetRangeFormat);
+        static NAN_METHOD(ApplyStyles);
+        static NAN_METHOD(StyleByRules);
         static NAN_METHOD(ReadStr);
         static NAN_METHOD(WriteStr);
         static NAN_METHOD(ReadNum);
@@ -66,6 +72,8 @@ class Sheet : public Wrapper<libxl::Sheet> , public BookWrapper
         static NAN_METHOD(WriteBlank);
         static NAN_METHOD(ReadFormula);
         static NAN_METHOD(WriteFormula);
+        static NAN_METHOD(FillFormula);
+        static NAN_METHOD(EvaluateFormulas);
         static NAN_METHOD(ReadComment);
         static NAN_METHOD(WriteComment);
         static NAN_METHOD(IsDate);
@@ -78,6 +86,9 @@ class Sheet : public Wrapper<libxl::Sheet> , public BookWrapper
         static NAN_METHOD(SetRowHidden);
         static NAN_METHOD(ColHidden);
         static NAN_METHOD(SetColHidden);
+        static NAN_METHOD(GetLayout);
+        static NAN_METHOD(SetLayout);
+        static NAN_METHOD(AutoFitColumns);
         static NAN_METHOD(GetMerge);
         static NAN_METHOD(SetMerge);
         static NAN_METHOD(DelMerge);
@@ -108,6 +119,12 @@ class Sheet : public Wrapper<libxl::Sheet> , public BookWrapper
         static NAN_METHOD(RemoveCol);
         static NAN_METHOD(RemoveColAsync);
         static NAN_METHOD(CopyCell);
+        static NAN_METHOD(CopyRange);
+        static NAN_METHOD(CreateRolloverWriter);
+        static NAN_METHOD(EnableCache);
+        static NAN_METHOD(DisableCache);
+        static NAN_METHOD(ExportCsvIncremental);
+        static NAN_METHOD(ApplyPatch);
         static NAN_METHOD(FirstRow);
         static NAN_METHOD(LastRow);
         static NAN_METHOD(FirstCol);
@@ -171,6 +188,17 @@ class Sheet : public Wrapper<libxl::Sheet> , public BookWrapper
 
     private:
 
+        // Forward changes to the book, which maintains the read cache and
+        // the dirty state
+        void CellChanged(int row, int col);
+        void RowsChanged(int first, int last);
+        void RowsInserted(int first, int last);
+        void RowsRemoved(int first, int last);
+        void FormatsChanged();
+        void SheetChanged();
+        void Modified();
+        SheetCache* Cache();
+
         Sheet(const Sheet&);
         const Sheet& operator=(const Sheet&);
 };
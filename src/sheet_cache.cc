@@ -0,0 +1,188 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sheet_cache.h"
+
+namespace node_libxl {
+
+
+SheetCache::SheetCache(libxl::Sheet* sheet, const Range& range) :
+    sheet(sheet),
+    range(range),
+    usedRange(!range.IsValid()),
+    stale(true)
+{}
+
+
+bool SheetCache::CellType(int row, int col, libxl::CellType& type) {
+    size_t index;
+    if (!Lookup(row, col, index)) return false;
+
+    type = static_cast<libxl::CellType>(types[index]);
+
+    return true;
+}
+
+
+bool SheetCache::ReadNum(int row, int col, double& value,
+    libxl::Format*& format)
+{
+    size_t index;
+
+    if (!Lookup(row, col, index) || types[index] != libxl::CELLTYPE_NUMBER) {
+        return false;
+    }
+
+    value = numbers[index];
+    format = formats[index];
+
+    return true;
+}
+
+
+bool SheetCache::ReadStr(int row, int col, const char*& value,
+    libxl::Format*& format)
+{
+    size_t index;
+
+    if (!Lookup(row, col, index) || types[index] != libxl::CELLTYPE_STRING) {
+        return false;
+    }
+
+    value = strings.c_str() + stringOffsets[index];
+    format = formats[index];
+
+    return true;
+}
+
+
+bool SheetCache::ReadBool(int row, int col, bool& value,
+    libxl::Format*& format)
+{
+    size_t index;
+
+    if (!Lookup(row, col, index) || types[index] != libxl::CELLTYPE_BOOLEAN) {
+        return false;
+    }
+
+    value = numbers[index] != 0;
+    format = formats[index];
+
+    return true;
+}
+
+
+void SheetCache::InvalidateCell(int row, int col) {
+    if (stale || !range.Contains(row, col)) return;
+
+    types[static_cast<size_t>(row - range.rowFirst) * range.Cols() +
+        (col - range.colFirst)] = UNCACHED;
+}
+
+
+void SheetCache::Invalidate() {
+    stale = true;
+}
+
+
+size_t SheetCache::Size() const {
+    return types.size() * (sizeof(uint8_t) + sizeof(double) +
+        sizeof(uint32_t) + sizeof(libxl::Format*)) + strings.size();
+}
+
+
+bool SheetCache::Lookup(int row, int col, size_t& index) {
+    if (stale) Load();
+    if (!range.Contains(row, col)) return false;
+
+    index = static_cast<size_t>(row - range.rowFirst) * range.Cols() +
+        (col - range.colFirst);
+
+    return types[index] != UNCACHED;
+}
+
+
+// Cells that libxl cannot read, like error cells, are left to libxl
+void SheetCache::Load() {
+    if (usedRange) {
+        range = Range(sheet->firstRow(), sheet->lastRow() - 1,
+            sheet->firstCol(), sheet->lastCol() - 1);
+    }
+
+    size_t size = range.IsValid() ?
+        static_cast<size_t>(range.Rows()) * range.Cols() : 0;
+
+    types.assign(size, UNCACHED);
+    numbers.assign(size, 0);
+    stringOffsets.assign(size, 0);
+    formats.assign(size, NULL);
+    strings.clear();
+
+    size_t index = 0;
+
+    for (int row = range.rowFirst; row <= range.rowLast; row++) {
+        for (int col = range.colFirst; col <= range.colLast; col++, index++) {
+            libxl::CellType type = sheet->cellType(row, col);
+            libxl::Format* format = NULL;
+
+            switch (type) {
+                case libxl::CELLTYPE_NUMBER:
+                    numbers[index] = sheet->readNum(row, col, &format);
+                    break;
+
+                case libxl::CELLTYPE_STRING: {
+                    const char* value = sheet->readStr(row, col, &format);
+                    if (!value) continue;
+
+                    stringOffsets[index] = strings.size();
+                    strings.append(value);
+                    strings += '\0';
+                    break;
+                }
+
+                case libxl::CELLTYPE_BOOLEAN:
+                    numbers[index] = sheet->readBool(row, col, &format);
+                    break;
+
+                case libxl::CELLTYPE_BLANK:
+                    sheet->readBlank(row, col, &format);
+                    break;
+
+                case libxl::CELLTYPE_EMPTY:
+                    break;
+
+                default:
+                    continue;
+            }
+
+            types[index] = type;
+            formats[index] = format;
+        }
+    }
+
+    stale = false;
+}
+
+
+}
@@ -0,0 +1,89 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_SHEET_CACHE_H
+#define BINDINGS_SHEET_CACHE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+#include "range.h"
+
+namespace node_libxl {
+
+
+// Snapshot of the values and formats of a block of cells, stored in flat
+// arrays with one entry per cell. Single cells are dropped from the snapshot
+// when they are written; changes to whole ranges mark the snapshot stale,
+// which makes the next lookup take a new one.
+class SheetCache {
+    public:
+
+        // An invalid range selects the used range of the sheet, which is
+        // determined again with every snapshot
+        SheetCache(libxl::Sheet* sheet, const Range& range);
+
+        // Lookups fail for cells outside of the range, for dropped cells and
+        // for cells of a different type, which are left to libxl
+        bool CellType(int row, int col, libxl::CellType& type);
+        bool ReadNum(int row, int col, double& value, libxl::Format*& format);
+        bool ReadStr(int row, int col, const char*& value,
+            libxl::Format*& format);
+        bool ReadBool(int row, int col, bool& value, libxl::Format*& format);
+
+        void InvalidateCell(int row, int col);
+        void Invalidate();
+
+        // Approximate memory used by the snapshot
+        size_t Size() const;
+
+    private:
+
+        enum {UNCACHED = 0xFF};
+
+        bool Lookup(int row, int col, size_t& index);
+        void Load();
+
+        libxl::Sheet* sheet;
+        Range range;
+        bool usedRange, stale;
+
+        std::vector<uint8_t> types;
+        std::vector<double> numbers;
+        std::vector<uint32_t> stringOffsets;
+        std::vector<libxl::Format*> formats;
+        std::string strings;
+
+        SheetCache(const SheetCache&);
+        const SheetCache& operator=(const SheetCache&);
+};
+
+
+}
+
+#endif // BINDINGS_SHEET_CACHE_H
@@ -0,0 +1,196 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sheet_import.h"
+
+namespace node_libxl {
+
+
+SheetImport::SheetImport(libxl::Book* sourceBook, libxl::Book* targetBook,
+        int flags) :
+    sourceBook(sourceBook),
+    targetBook(targetBook),
+    flags(flags),
+    translator(sourceBook, targetBook),
+    errorMessage("")
+{}
+
+
+libxl::Sheet* SheetImport::Import(libxl::Sheet* sourceSheet, const char* name) {
+    libxl::Sheet* targetSheet = targetBook->addSheet(name);
+
+    if (!targetSheet) {
+        Fail(targetBook);
+        return NULL;
+    }
+
+    if (!ImportInto(sourceSheet, targetSheet)) {
+        // Don't leave a partial copy behind; addSheet appends
+        targetBook->delSheet(targetBook->sheetCount() - 1);
+        return NULL;
+    }
+
+    return targetSheet;
+}
+
+
+bool SheetImport::ImportInto(libxl::Sheet* sourceSheet,
+    libxl::Sheet* targetSheet)
+{
+    Range used(sourceSheet->firstRow(), sourceSheet->lastRow() - 1,
+        sourceSheet->firstCol(), sourceSheet->lastCol() - 1);
+
+    if (used.IsValid()) {
+        RangeCopy rangeCopy(sourceSheet, targetSheet, translator,
+            RangeCopy::COPY_VALUES | RangeCopy::COPY_FORMULAS |
+            ((flags & IMPORT_FORMATS) ? RangeCopy::COPY_FORMATS : 0));
+
+        if (!rangeCopy.Copy(used, used.rowFirst, used.colFirst)) {
+            return Fail(rangeCopy.ErrorMessage());
+        }
+
+        if (!ImportLayout(sourceSheet, targetSheet)) return false;
+    }
+
+    if ((flags & IMPORT_MERGES) && !ImportMerges(sourceSheet, targetSheet)) {
+        return false;
+    }
+
+    if ((flags & IMPORT_PICTURES) && !ImportPictures(sourceSheet, targetSheet)) {
+        return false;
+    }
+
+    return true;
+}
+
+
+bool SheetImport::ImportLayout(libxl::Sheet* sourceSheet,
+    libxl::Sheet* targetSheet)
+{
+    int colLast = sourceSheet->lastCol(), rowLast = sourceSheet->lastRow();
+
+    for (int col = sourceSheet->firstCol(); col < colLast; col++) {
+        if (!targetSheet->setCol(col, col, sourceSheet->colWidth(col), NULL,
+                sourceSheet->colHidden(col)))
+        {
+            return Fail(targetBook);
+        }
+    }
+
+    for (int row = sourceSheet->firstRow(); row < rowLast; row++) {
+        if (!targetSheet->setRow(row, sourceSheet->rowHeight(row), NULL,
+                sourceSheet->rowHidden(row)))
+        {
+            return Fail(targetBook);
+        }
+    }
+
+    return true;
+}
+
+
+bool SheetImport::ImportMerges(libxl::Sheet* sourceSheet,
+    libxl::Sheet* targetSheet)
+{
+    int mergeSize = sourceSheet->mergeSize();
+
+    for (int i = 0; i < mergeSize; i++) {
+        int rowFirst, rowLast, colFirst, colLast;
+
+        if (!sourceSheet->merge(i, &rowFirst, &rowLast, &colFirst, &colLast)) {
+            return Fail(sourceBook);
+        }
+
+        if (!targetSheet->setMerge(rowFirst, rowLast, colFirst, colLast)) {
+            return Fail(targetBook);
+        }
+    }
+
+    return true;
+}
+
+
+bool SheetImport::ImportPictures(libxl::Sheet* sourceSheet,
+    libxl::Sheet* targetSheet)
+{
+    int pictureSize = sourceSheet->pictureSize();
+
+    for (int i = 0; i < pictureSize; i++) {
+        int rowTop, colLeft, rowBottom, colRight, width, height,
+            offset_x, offset_y;
+
+        int sourceIndex = sourceSheet->getPicture(i, &rowTop, &colLeft,
+            &rowBottom, &colRight, &width, &height, &offset_x, &offset_y);
+        if (sourceIndex == -1) return Fail(sourceBook);
+
+        // Pictures shared between placements are only added once, and
+        // copies within a book share the pictures of the source
+        int targetIndex;
+        std::map<int, int>::iterator cached = pictureCache.find(sourceIndex);
+
+        if (sourceBook == targetBook) {
+            targetIndex = sourceIndex;
+        } else if (cached != pictureCache.end()) {
+            targetIndex = cached->second;
+        } else {
+            const char* data;
+            unsigned size;
+
+            if (sourceBook->getPicture(sourceIndex, &data, &size) ==
+                    libxl::PICTURETYPE_ERROR)
+            {
+                return Fail(sourceBook);
+            }
+
+            targetIndex = targetBook->addPicture2(data, size);
+            if (targetIndex == -1) return Fail(targetBook);
+
+            pictureCache[sourceIndex] = targetIndex;
+        }
+
+        targetSheet->setPicture2(rowTop, colLeft, targetIndex, width, height,
+            offset_x, offset_y);
+    }
+
+    return true;
+}
+
+
+const char* SheetImport::ErrorMessage() const {
+    return errorMessage.c_str();
+}
+
+
+bool SheetImport::Fail(libxl::Book* book) {
+    return Fail(book->errorMessage());
+}
+
+
+bool SheetImport::Fail(const char* message) {
+    errorMessage = message;
+    return false;
+}
+
+
+}
@@ -0,0 +1,82 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_SHEET_IMPORT_H
+#define BINDINGS_SHEET_IMPORT_H
+
+#include <map>
+#include <string>
+
+#include <libxl.h>
+
+#include "range_copy.h"
+
+namespace node_libxl {
+
+
+// Recreates a sheet from the same or another book: cells, formulas, column
+// widths, row heights and optionally formats, merges and pictures. A sheet
+// that cannot be imported completely is removed again.
+class SheetImport {
+    public:
+
+        enum {
+            IMPORT_FORMATS  = 0x01,
+            IMPORT_MERGES   = 0x02,
+            IMPORT_PICTURES = 0x04,
+            IMPORT_ALL      = 0x07
+        };
+
+        SheetImport(libxl::Book* sourceBook, libxl::Book* targetBook,
+            int flags = IMPORT_ALL);
+
+        libxl::Sheet* Import(libxl::Sheet* sourceSheet, const char* name);
+        bool ImportInto(libxl::Sheet* sourceSheet, libxl::Sheet* targetSheet);
+
+        const char* ErrorMessage() const;
+
+    private:
+
+        bool ImportLayout(libxl::Sheet* sourceSheet, libxl::Sheet* targetSheet);
+        bool ImportMerges(libxl::Sheet* sourceSheet, libxl::Sheet* targetSheet);
+        bool ImportPictures(libxl::Sheet* sourceSheet, libxl::Sheet* targetSheet);
+
+        bool Fail(libxl::Book* book);
+        bool Fail(const char* message);
+
+        libxl::Book *sourceBook, *targetBook;
+        int flags;
+
+        FormatTranslator translator;
+        std::map<int, int> pictureCache;
+        std::string errorMessage;
+
+        SheetImport(const SheetImport&);
+        const SheetImport& operator=(const SheetImport&);
+};
+
+
+}
+
+#endif // BINDINGS_SHEET_IMPORT_H
@@ -0,0 +1,99 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sheet_journal.h"
+
+namespace node_libxl {
+
+
+SheetJournal::SheetJournal() :
+    valid(false)
+{}
+
+
+void SheetJournal::RowsChanged(int first, int last) {
+    int size = static_cast<int>(sourceRows.size());
+
+    if (first < 0) first = 0;
+    if (last >= size) last = size - 1;
+
+    for (int row = first; row <= last; row++) {
+        sourceRows[row] = -1;
+    }
+}
+
+
+// Rows past the end of the snapshot count as changed anyway
+void SheetJournal::RowsInserted(int first, int last) {
+    if (first < 0 || last < first) return Invalidate();
+    if (first >= static_cast<int>(sourceRows.size())) return;
+
+    sourceRows.insert(sourceRows.begin() + first, last - first + 1, -1);
+}
+
+
+void SheetJournal::RowsRemoved(int first, int last) {
+    int size = static_cast<int>(sourceRows.size());
+
+    if (first < 0 || last < first) return Invalidate();
+    if (first >= size) return;
+    if (last >= size) last = size - 1;
+
+    sourceRows.erase(sourceRows.begin() + first,
+        sourceRows.begin() + last + 1);
+}
+
+
+void SheetJournal::Invalidate() {
+    valid = false;
+    sourceRows.clear();
+}
+
+
+void SheetJournal::Reset(int rows) {
+    sourceRows.resize(rows);
+
+    for (int row = 0; row < rows; row++) {
+        sourceRows[row] = row;
+    }
+
+    valid = true;
+}
+
+
+int SheetJournal::SourceRow(int row) const {
+    if (!valid || row < 0 || row >= static_cast<int>(sourceRows.size())) {
+        return -1;
+    }
+
+    return sourceRows[row];
+}
+
+
+SheetJournal::Snapshot& SheetJournal::GetSnapshot() {
+    return snapshot;
+}
+
+
+}
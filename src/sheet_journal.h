@@ -0,0 +1,81 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_SHEET_JOURNAL_H
+#define BINDINGS_SHEET_JOURNAL_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#include <vector>
+
+namespace node_libxl {
+
+
+// Records which rows of a sheet changed since a snapshot (the last export)
+// was taken. Inserted and removed rows are followed, so unchanged rows can
+// still be located in the snapshot after they moved.
+class SheetJournal {
+    public:
+
+        // Layout of the output the journal is relative to
+        struct Snapshot {
+            Snapshot() : checksum(0), cols(0) {}
+
+            // Start of each row in the output, plus its total length
+            std::vector<size_t> offsets;
+            uint64_t checksum;
+            int cols;
+        };
+
+        SheetJournal();
+
+        void RowsChanged(int first, int last);
+        void RowsInserted(int first, int last);
+        void RowsRemoved(int first, int last);
+        void Invalidate();
+
+        // Starts over with an unchanged snapshot of the given number of rows
+        void Reset(int rows);
+
+        // The snapshot row a row corresponds to, or -1 if it changed
+        int SourceRow(int row) const;
+
+        Snapshot& GetSnapshot();
+
+    private:
+
+        std::vector<int> sourceRows;
+        bool valid;
+
+        Snapshot snapshot;
+
+        SheetJournal(const SheetJournal&);
+        const SheetJournal& operator=(const SheetJournal&);
+};
+
+
+}
+
+#endif // BINDINGS_SHEET_JOURNAL_H
@@ -0,0 +1,233 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <sstream>
+
+#include "sheet_patch.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const int XLS_MAX_ROWS = 65536;
+const int XLS_MAX_COLS = 256;
+const int XLSX_MAX_ROWS = 1048576;
+const int XLSX_MAX_COLS = 16384;
+
+
+}
+
+
+SheetPatch::SheetPatch(libxl::Book* book, libxl::Sheet* sheet) :
+    book(book),
+    sheet(sheet)
+{}
+
+
+SheetPatch::Cells& SheetPatch::GetCells() {
+    return cells;
+}
+
+
+bool SheetPatch::Validate() {
+    size_t count = cells.rows.size();
+
+    if (cells.cols.size() != count || cells.types.size() != count ||
+        cells.numbers.size() != count ||
+        (!cells.formats.empty() && cells.formats.size() != count))
+    {
+        errorMessage = "patch arrays differ in length";
+        return false;
+    }
+
+    bool xls = book->biffVersion() != 0;
+    int maxRows = xls ? XLS_MAX_ROWS : XLSX_MAX_ROWS,
+        maxCols = xls ? XLS_MAX_COLS : XLSX_MAX_COLS,
+        formatCount = book->formatSize();
+
+    for (size_t i = 0; i < count; i++) {
+        if (cells.rows[i] < 0 || cells.rows[i] >= maxRows ||
+            cells.cols[i] < 0 || cells.cols[i] >= maxCols)
+        {
+            return Fail(i, "cell out of range");
+        }
+
+        double number = cells.numbers[i];
+
+        switch (cells.types[i]) {
+            case CELL_BLANK:
+            case CELL_NUMBER:
+            case CELL_BOOLEAN:
+                break;
+
+            case CELL_STRING:
+            case CELL_FORMULA:
+                if (!(number >= 0 && number < cells.strings.size()) ||
+                    number != static_cast<size_t>(number))
+                {
+                    return Fail(i, "invalid string index");
+                }
+                break;
+
+            default:
+                return Fail(i, "invalid cell type");
+        }
+
+        if (!cells.formats.empty() &&
+            (cells.formats[i] < -1 || cells.formats[i] >= formatCount))
+        {
+            return Fail(i, "invalid format index");
+        }
+    }
+
+    return true;
+}
+
+
+bool SheetPatch::Apply() {
+    size_t count = cells.rows.size();
+    std::vector<Backup> backups(count);
+
+    for (size_t i = 0; i < count; i++) {
+        TakeBackup(cells.rows[i], cells.cols[i], backups[i]);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (Write(i)) continue;
+
+        errorMessage = book->errorMessage();
+
+        // In reverse, so cells patched twice end up in their original state
+        for (size_t j = i + 1; j > 0; j--) {
+            Restore(cells.rows[j - 1], cells.cols[j - 1], backups[j - 1]);
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+
+const std::string& SheetPatch::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool SheetPatch::Write(size_t index) {
+    int row = cells.rows[index], col = cells.cols[index];
+    int formatIndex = cells.formats.empty() ? -1 : cells.formats[index];
+    double number = cells.numbers[index];
+
+    libxl::Format* format = formatIndex >= 0 ?
+        book->format(formatIndex) : sheet->cellFormat(row, col);
+
+    switch (cells.types[index]) {
+        case CELL_BLANK:
+            return sheet->writeBlank(row, col, format);
+
+        case CELL_NUMBER:
+            return sheet->writeNum(row, col, number, format);
+
+        case CELL_STRING:
+            return sheet->writeStr(row, col,
+                cells.strings[static_cast<size_t>(number)].c_str(), format);
+
+        case CELL_BOOLEAN:
+            return sheet->writeBool(row, col, number != 0, format);
+
+        case CELL_FORMULA:
+            return sheet->writeFormula(row, col,
+                cells.strings[static_cast<size_t>(number)].c_str(), format);
+    }
+
+    return false;
+}
+
+
+void SheetPatch::TakeBackup(int row, int col, Backup& backup) {
+    backup.type = sheet->cellType(row, col);
+    backup.isFormula = sheet->isFormula(row, col);
+    backup.number = 0;
+    backup.format = sheet->cellFormat(row, col);
+
+    const char* text = NULL;
+
+    if (backup.isFormula) {
+        text = sheet->readFormula(row, col);
+    } else if (backup.type == libxl::CELLTYPE_STRING) {
+        text = sheet->readStr(row, col);
+    } else if (backup.type == libxl::CELLTYPE_NUMBER) {
+        backup.number = sheet->readNum(row, col);
+    } else if (backup.type == libxl::CELLTYPE_BOOLEAN) {
+        backup.number = sheet->readBool(row, col);
+    }
+
+    if (text) backup.text = text;
+}
+
+
+// Error values cannot be written through libxl and come back as blanks
+void SheetPatch::Restore(int row, int col, const Backup& backup) {
+    if (backup.isFormula) {
+        sheet->writeFormula(row, col, backup.text.c_str(), backup.format);
+        return;
+    }
+
+    switch (backup.type) {
+        case libxl::CELLTYPE_EMPTY:
+            sheet->clear(row, row, col, col);
+            break;
+
+        case libxl::CELLTYPE_NUMBER:
+            sheet->writeNum(row, col, backup.number, backup.format);
+            break;
+
+        case libxl::CELLTYPE_STRING:
+            sheet->writeStr(row, col, backup.text.c_str(), backup.format);
+            break;
+
+        case libxl::CELLTYPE_BOOLEAN:
+            sheet->writeBool(row, col, backup.number != 0, backup.format);
+            break;
+
+        default:
+            sheet->writeBlank(row, col, backup.format);
+            break;
+    }
+}
+
+
+bool SheetPatch::Fail(size_t index, const std::string& message) {
+    std::ostringstream ss;
+    ss << message << " at patch entry " << index;
+    errorMessage = ss.str();
+
+    return false;
+}
+
+
+}
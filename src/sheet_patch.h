@@ -0,0 +1,98 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_SHEET_PATCH_H
+#define BINDINGS_SHEET_PATCH_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+namespace node_libxl {
+
+
+// A batch of cell writes that is validated as a whole before the first cell
+// is touched. If libxl fails on a cell anyway, the cells written up to that
+// point are restored from a snapshot taken before.
+class SheetPatch {
+    public:
+
+        enum CellType {
+            CELL_BLANK = 0,
+            CELL_NUMBER = 1,
+            CELL_STRING = 2,
+            CELL_BOOLEAN = 3,
+            CELL_FORMULA = 5
+        };
+
+        // Strings and formulas refer to strings through their entry in
+        // numbers. A format index of -1 keeps the format of the cell.
+        struct Cells {
+            std::vector<int32_t> rows, cols, formats;
+            std::vector<uint8_t> types;
+            std::vector<double> numbers;
+            std::vector<std::string> strings;
+        };
+
+        SheetPatch(libxl::Book* book, libxl::Sheet* sheet);
+
+        // The cells are filled in by the caller before validation
+        Cells& GetCells();
+
+        bool Validate();
+        bool Apply();
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        struct Backup {
+            libxl::CellType type;
+            bool isFormula;
+            double number;
+            std::string text;
+            libxl::Format* format;
+        };
+
+        libxl::Book* book;
+        libxl::Sheet* sheet;
+        Cells cells;
+        std::string errorMessage;
+
+        bool Write(size_t index);
+        void TakeBackup(int row, int col, Backup& backup);
+        void Restore(int row, int col, const Backup& backup);
+        bool Fail(size_t index, const std::string& message);
+
+        SheetPatch(const SheetPatch&);
+        const SheetPatch& operator=(const SheetPatch&);
+};
+
+
+}
+
+#endif // BINDINGS_SHEET_PATCH_H
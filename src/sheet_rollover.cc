@@ -0,0 +1,237 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "sheet_rollover.h"
+
+#include <sstream>
+
+#include "range.h"
+#include "range_copy.h"
+#include "sheet_name.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const int XLS_MAX_ROWS = 65536;
+const int XLSX_MAX_ROWS = 1048576;
+
+const size_t MAX_SHEET_NAME_LENGTH = 31;
+
+
+// Truncates UTF-8 text to a number of characters
+std::string Truncate(const std::string& text, size_t length) {
+    size_t characters = 0;
+
+    for (size_t i = 0; i < text.size(); i++) {
+        bool start = (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80;
+
+        if (start && characters++ == length) return text.substr(0, i);
+    }
+
+    return text;
+}
+
+
+}
+
+
+SheetRollover::SheetRollover(libxl::Book* book, libxl::Sheet* sheet,
+        int headerRows, int maxRows,
+        const std::vector<libxl::Format*>& columnFormats) :
+    book(book),
+    firstSheet(sheet),
+    currentSheet(sheet),
+    headerRows(headerRows),
+    maxRows(maxRows > 0 ? maxRows : FormatRowLimit(book)),
+    columnFormats(columnFormats),
+    sheetCount(1),
+    nameNumber(1),
+    nextRow(sheet->lastRow() > headerRows ? sheet->lastRow() : headerRows),
+    errorMessage("")
+{}
+
+
+bool SheetRollover::NextRow(libxl::Sheet*& sheet, int& row) {
+    if (nextRow >= maxRows && !AddSheet()) return false;
+
+    sheet = currentSheet;
+    row = nextRow++;
+
+    return true;
+}
+
+
+libxl::Format* SheetRollover::ColumnFormat(int col) const {
+    return col < static_cast<int>(columnFormats.size()) ?
+        columnFormats[col] : NULL;
+}
+
+
+libxl::Sheet* SheetRollover::CurrentSheet() const {
+    return currentSheet;
+}
+
+
+int SheetRollover::SheetCount() const {
+    return sheetCount;
+}
+
+
+int SheetRollover::RowCount() const {
+    return nextRow;
+}
+
+
+const char* SheetRollover::ErrorMessage() const {
+    return errorMessage.c_str();
+}
+
+
+// XLSX books report a BIFF version of 0
+int SheetRollover::FormatRowLimit(libxl::Book* book) {
+    return book->biffVersion() ? XLS_MAX_ROWS : XLSX_MAX_ROWS;
+}
+
+
+bool SheetRollover::AddSheet() {
+    std::string name;
+
+    do {
+        name = SheetName(++nameNumber);
+    } while (HasSheet(name));
+
+    int index = SheetIndex(currentSheet);
+    libxl::Sheet* sheet = index < 0 ? book->addSheet(name.c_str()) :
+        book->insertSheet(index + 1, name.c_str());
+
+    if (!sheet) {
+        nameNumber--;
+        return Fail();
+    }
+
+    // A sheet without the header would be picked up again by the next
+    // attempt, so it is removed and its name is reused
+    if (!CopyLayout(sheet)) {
+        book->delSheet(index < 0 ? book->sheetCount() - 1 : index + 1);
+        nameNumber--;
+
+        return false;
+    }
+
+    currentSheet = sheet;
+    sheetCount++;
+    nextRow = headerRows;
+
+    return true;
+}
+
+
+bool SheetRollover::CopyLayout(libxl::Sheet* sheet) {
+    int colFirst = firstSheet->firstCol(), colLast = firstSheet->lastCol(),
+        rowFirst = firstSheet->firstRow();
+
+    // Empty rows above the header are not copied
+    if (rowFirst < headerRows && colLast > colFirst) {
+        RangeCopy copy(firstSheet, book, sheet, book);
+
+        if (!copy.Copy(Range(rowFirst, headerRows - 1, colFirst, colLast - 1),
+                rowFirst, colFirst))
+        {
+            errorMessage = copy.ErrorMessage();
+            return false;
+        }
+    }
+
+    // Only header rows with a custom height or visibility are touched
+    for (int row = 0; row < headerRows; row++) {
+        double height = firstSheet->rowHeight(row);
+        bool hidden = firstSheet->rowHidden(row);
+
+        if ((height != sheet->rowHeight(row) ||
+                hidden != sheet->rowHidden(row)) &&
+            !sheet->setRow(row, height, NULL, hidden))
+        {
+            return Fail();
+        }
+    }
+
+    int cols = static_cast<int>(columnFormats.size());
+    if (colLast > cols) cols = colLast;
+
+    for (int col = 0; col < cols; col++) {
+        if (!sheet->setCol(col, col, firstSheet->colWidth(col),
+                ColumnFormat(col), firstSheet->colHidden(col)))
+        {
+            return Fail();
+        }
+    }
+
+    return true;
+}
+
+
+// The name of the first sheet is shortened if the suffix would exceed the
+// length limit for sheet names
+std::string SheetRollover::SheetName(int number) const {
+    std::ostringstream suffix;
+    suffix << " (" << number << ")";
+
+    return Truncate(firstSheet->name() ? firstSheet->name() : "",
+        MAX_SHEET_NAME_LENGTH - suffix.str().size()) + suffix.str();
+}
+
+
+// Sheet names are compared case-insensitively like libxl does
+bool SheetRollover::HasSheet(const std::string& name) const {
+    for (int i = 0; i < book->sheetCount(); i++) {
+        const char* sheetName = book->getSheet(i)->name();
+
+        if (sheetName && SheetNamesEqual(name, sheetName)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+int SheetRollover::SheetIndex(libxl::Sheet* sheet) const {
+    for (int i = 0; i < book->sheetCount(); i++) {
+        if (book->getSheet(i) == sheet) return i;
+    }
+
+    return -1;
+}
+
+
+bool SheetRollover::Fail() {
+    errorMessage = book->errorMessage();
+    return false;
+}
+
+
+}
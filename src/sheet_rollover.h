@@ -0,0 +1,85 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_SHEET_ROLLOVER_H
+#define BINDINGS_SHEET_ROLLOVER_H
+
+#include <string>
+#include <vector>
+
+#include <libxl.h>
+
+namespace node_libxl {
+
+
+// Hands out consecutive rows of a sheet and continues on a new sheet when
+// the current one is full. Follow-up sheets are named like "Data (2)" and
+// placed after their predecessor; they receive a copy of the header rows,
+// the column widths and the column formats of the first sheet.
+class SheetRollover {
+    public:
+
+        // A maxRows of 0 selects the row limit of the file format. Column
+        // formats may be NULL for unformatted columns.
+        SheetRollover(libxl::Book* book, libxl::Sheet* sheet, int headerRows,
+            int maxRows, const std::vector<libxl::Format*>& columnFormats);
+
+        // Reserves the next row, adding a sheet if necessary
+        bool NextRow(libxl::Sheet*& sheet, int& row);
+
+        libxl::Format* ColumnFormat(int col) const;
+
+        libxl::Sheet* CurrentSheet() const;
+        int SheetCount() const;
+        int RowCount() const;
+
+        const char* ErrorMessage() const;
+
+        static int FormatRowLimit(libxl::Book* book);
+
+    private:
+
+        bool AddSheet();
+        bool CopyLayout(libxl::Sheet* sheet);
+        std::string SheetName(int number) const;
+        bool HasSheet(const std::string& name) const;
+        int SheetIndex(libxl::Sheet* sheet) const;
+        bool Fail();
+
+        libxl::Book* book;
+        libxl::Sheet *firstSheet, *currentSheet;
+        int headerRows, maxRows;
+        std::vector<libxl::Format*> columnFormats;
+
+        int sheetCount, nameNumber, nextRow;
+        std::string errorMessage;
+
+        SheetRollover(const SheetRollover&);
+        const SheetRollover& operator=(const SheetRollover&);
+};
+
+
+}
+
+#endif // BINDINGS_SHEET_ROLLOVER_H
@@ -0,0 +1,71 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "typed_array.h"
+
+using namespace v8;
+
+namespace node_libxl {
+namespace util {
+
+
+Local<Object> NewTypedArray(const char* type, uint32_t length, void** data) {
+    NanEscapableScope();
+
+    Local<Function> constructor = NanGetCurrentContext()->Global()
+        ->Get(NanNew<String>(type)).As<Function>();
+
+    Handle<Value> argv[] = {NanNew<Number>(static_cast<double>(length))};
+    Local<Object> array = constructor->NewInstance(1, argv);
+
+    *data = array->GetIndexedPropertiesExternalArrayData();
+
+    return NanEscapeScope(array);
+}
+
+
+void* GetTypedArrayData(Handle<Value> value, const char* type,
+    uint32_t& length)
+{
+    NanScope();
+
+    if (!value->IsObject()) return NULL;
+
+    Local<Object> array = value.As<Object>();
+    Local<Value> constructor = NanGetCurrentContext()->Global()
+        ->Get(NanNew<String>(type));
+
+    if (!constructor->IsFunction() || !array->GetPrototype()->StrictEquals(
+        constructor.As<Function>()->Get(NanNew<String>("prototype"))))
+    {
+        return NULL;
+    }
+
+    length = array->GetIndexedPropertiesExternalArrayDataLength();
+    return array->GetIndexedPropertiesExternalArrayData();
+}
+
+
+}
+}
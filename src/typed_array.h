@@ -0,0 +1,50 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_TYPED_ARRAY_H
+#define BINDINGS_TYPED_ARRAY_H
+
+#include "common.h"
+
+namespace node_libxl {
+namespace util {
+
+
+// Creates a typed array of the given type ("Float64Array", "Uint8Array",
+// ...) through its global constructor and stores a pointer to the backing
+// store in data, so the array can be filled without a V8 call per element.
+v8::Local<v8::Object> NewTypedArray(const char* type, uint32_t length,
+    void** data);
+
+
+// Returns the backing store of value and its number of elements if value is
+// a typed array of the given type, NULL otherwise.
+void* GetTypedArrayData(v8::Handle<v8::Value> value, const char* type,
+    uint32_t& length);
+
+
+}
+}
+
+#endif // BINDINGS_TYPED_ARRAY_H
@@ -0,0 +1,545 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xls_scanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "compound_file.h"
+#include "sheet_name.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const uint16_t BIFF8_VERSION = 0x0600;
+const uint8_t SHEET_TYPE_WORKSHEET = 0x00;
+
+// Cells hold the row, column and format index ahead of their value
+const size_t CELL_HEADER_SIZE = 6;
+
+
+// Reads a record that is continued over CONTINUE records. Characters that
+// cross a record boundary are preceded by a new option byte.
+class ContinuedRecord {
+    public:
+
+        explicit ContinuedRecord(const std::vector<std::string>& segments) :
+            segments(segments),
+            segment(0),
+            position(0)
+        {}
+
+        bool Read(char* out, size_t length) {
+            while (length > 0) {
+                if (!Available()) return false;
+
+                const std::string& data = segments[segment];
+                size_t count = data.size() - position;
+                if (count > length) count = length;
+
+                if (out) {
+                    std::memcpy(out, data.data() + position, count);
+                    out += count;
+                }
+
+                position += count;
+                length -= count;
+            }
+
+            return true;
+        }
+
+        bool Skip(size_t length) {
+            return Read(NULL, length);
+        }
+
+        bool ReadCharacters(size_t count, bool wide, std::string& out) {
+            while (count > 0) {
+                if (position == segments[segment].size()) {
+                    if (++segment == segments.size()) return false;
+
+                    const std::string& data = segments[segment];
+                    if (data.empty()) return false;
+
+                    wide = data[0] & 0x01;
+                    position = 1;
+                }
+
+                const std::string& data = segments[segment];
+                size_t available = (data.size() - position) / (wide ? 2 : 1),
+                    length = count < available ? count : available;
+
+                if (length == 0) return false;
+
+                out += BiffReader::DecodeCharacters(data.data() + position,
+                    length, wide);
+                position += length * (wide ? 2 : 1);
+                count -= length;
+            }
+
+            return true;
+        }
+
+    private:
+
+        // Moves to the next segment if the current one is exhausted
+        bool Available() {
+            while (position == segments[segment].size()) {
+                if (segment + 1 == segments.size()) return false;
+
+                segment++;
+                position = 0;
+            }
+
+            return true;
+        }
+
+        const std::vector<std::string>& segments;
+        size_t segment, position;
+};
+
+
+// RK values are either 30 bit integers or doubles with a truncated
+// mantissa, optionally multiplied by 100
+double DecodeRk(uint32_t rk) {
+    double value;
+
+    if (rk & 0x02) {
+        value = static_cast<int32_t>(rk) >> 2;
+    } else {
+        uint64_t bits = static_cast<uint64_t>(rk & 0xFFFFFFFC) << 32;
+        std::memcpy(&value, &bits, sizeof(value));
+    }
+
+    return (rk & 0x01) ? value / 100 : value;
+}
+
+
+double DecodeDouble(const char* data) {
+    uint64_t bits = ByteSource::Uint64(data);
+    double value;
+
+    std::memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+
+const char* ErrorText(uint8_t code) {
+    switch (code) {
+        case 0x00:  return "#NULL!";
+        case 0x07:  return "#DIV/0!";
+        case 0x0F:  return "#VALUE!";
+        case 0x17:  return "#REF!";
+        case 0x1D:  return "#NAME?";
+        case 0x24:  return "#NUM!";
+        case 0x2A:  return "#N/A";
+        default:    return "#N/A";
+    }
+}
+
+
+}
+
+
+XlsScanner::XlsScanner(ByteSource& source) :
+    source(source),
+    sharedStringCount(0)
+{}
+
+
+bool XlsScanner::Run(const std::string& sheet, Result& result) {
+    CompoundFile file(source);
+    CompoundFile::Stream stream;
+
+    if (!file.Open()) return Fail(file.ErrorMessage());
+
+    if (!file.OpenStream("Workbook", stream)) {
+        return Fail(file.OpenStream("Book", stream) ?
+            "only BIFF8 workbooks are supported" : "missing workbook stream");
+    }
+
+    BiffReader reader(stream);
+    uint32_t offset;
+
+    if (!ReadGlobals(reader, sheet, offset, result)) return false;
+
+    reader.Seek(offset);
+
+    return ReadCells(reader, result);
+}
+
+
+const std::string& XlsScanner::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+// Reads the shared strings and locates the sheet in the workbook globals
+bool XlsScanner::ReadGlobals(BiffReader& reader, const std::string& sheet,
+    uint32_t& offset, Result& result)
+{
+    if (!reader.Next() || reader.Id() != BiffReader::RECORD_BOF ||
+        reader.Data().size() < 2 ||
+        ByteSource::Uint16(reader.Data().data()) != BIFF8_VERSION)
+    {
+        return Fail("only BIFF8 workbooks are supported");
+    }
+
+    bool found = false;
+
+    while (reader.Next() && reader.Id() != BiffReader::RECORD_EOF) {
+        const std::string& data = reader.Data();
+
+        switch (reader.Id()) {
+            case BiffReader::RECORD_FILEPASS:
+                return Fail("encrypted workbooks are not supported");
+
+            case BiffReader::RECORD_SST:
+                if (!ReadSharedStrings(reader, result)) return false;
+                break;
+
+            case BiffReader::RECORD_BOUNDSHEET: {
+                if (found || data.size() < 8 ||
+                    data[5] != SHEET_TYPE_WORKSHEET)
+                {
+                    break;
+                }
+
+                size_t count = static_cast<unsigned char>(data[6]);
+                bool wide = data[7] & 0x01;
+
+                if (data.size() < 8 + count * (wide ? 2 : 1)) {
+                    return Fail("corrupt BOUNDSHEET record");
+                }
+
+                std::string name = BiffReader::DecodeCharacters(
+                    data.data() + 8, count, wide);
+
+                if (sheet.empty() || SheetNamesEqual(name, sheet)) {
+                    offset = ByteSource::Uint32(data.data());
+                    found = true;
+                }
+
+                break;
+            }
+        }
+    }
+
+    if (!found) {
+        return Fail(sheet.empty() ? "no worksheet found" :
+            "unknown sheet " + sheet);
+    }
+
+    return true;
+}
+
+
+bool XlsScanner::ReadSharedStrings(BiffReader& reader, Result& result) {
+    std::vector<std::string> segments;
+    segments.push_back(reader.Data());
+    size_t size = reader.Data().size();
+    bool more;
+
+    while ((more = reader.Next()) &&
+        reader.Id() == BiffReader::RECORD_CONTINUE)
+    {
+        segments.push_back(reader.Data());
+        size += reader.Data().size();
+    }
+
+    // The globals end with an EOF record, so a string table that isn't
+    // followed by another record is truncated. Seeking back would read the
+    // table again.
+    if (!more) return Fail("corrupt SST record");
+
+    // The record that ended the string table is read again by the caller
+    reader.Seek(reader.Offset());
+
+    ContinuedRecord record(segments);
+    char header[8];
+
+    if (!record.Read(header, sizeof(header))) {
+        return Fail("corrupt SST record");
+    }
+
+    // The count is untrusted; every string takes at least 3 bytes
+    uint32_t count = ByteSource::Uint32(header + 4);
+    result.strings.reserve(std::min<size_t>(count, (size - 8) / 3));
+
+    for (uint32_t i = 0; i < count; i++) {
+        char stringHeader[3], extra[4];
+
+        if (!record.Read(stringHeader, sizeof(stringHeader))) {
+            return Fail("corrupt SST record");
+        }
+
+        size_t length = ByteSource::Uint16(stringHeader);
+        uint8_t flags = static_cast<uint8_t>(stringHeader[2]);
+        size_t runs = 0, extension = 0;
+
+        if (flags & 0x08) {
+            if (!record.Read(extra, 2)) return Fail("corrupt SST record");
+            runs = ByteSource::Uint16(extra);
+        }
+
+        if (flags & 0x04) {
+            if (!record.Read(extra, 4)) return Fail("corrupt SST record");
+            extension = ByteSource::Uint32(extra);
+        }
+
+        result.strings.push_back(std::string());
+
+        if (!record.ReadCharacters(length, flags & 0x01,
+                result.strings.back()) ||
+            !record.Skip(runs * 4 + extension))
+        {
+            return Fail("corrupt SST record");
+        }
+    }
+
+    sharedStringCount = result.strings.size();
+
+    return true;
+}
+
+
+// Embedded charts are nested substreams with their own BOF and EOF records
+bool XlsScanner::ReadCells(BiffReader& reader, Result& result) {
+    int depth = 0;
+    bool pendingString = false;
+    uint16_t pendingRow = 0, pendingCol = 0;
+
+    while (reader.Next()) {
+        const std::string& data = reader.Data();
+        const char* bytes = data.data();
+        size_t size = data.size();
+
+        uint16_t id = reader.Id();
+
+        if (id == BiffReader::RECORD_BOF) {
+            depth++;
+            continue;
+        }
+
+        if (id == BiffReader::RECORD_EOF) {
+            if (--depth <= 0) return true;
+            continue;
+        }
+
+        if (depth != 1) continue;
+
+        if (pendingString && id == BiffReader::RECORD_STRING) {
+            pendingString = false;
+
+            if (size < 3) return Fail("corrupt STRING record");
+
+            size_t length = ByteSource::Uint16(bytes);
+            bool wide = bytes[2] & 0x01;
+            size_t available = (size - 3) / (wide ? 2 : 1);
+
+            AddString(result, pendingRow, pendingCol,
+                BiffReader::DecodeCharacters(bytes + 3,
+                    length < available ? length : available, wide));
+            continue;
+        }
+
+        pendingString = false;
+
+        if (size < CELL_HEADER_SIZE) continue;
+
+        uint16_t row = ByteSource::Uint16(bytes),
+            col = ByteSource::Uint16(bytes + 2);
+
+        switch (id) {
+            case BiffReader::RECORD_NUMBER:
+                if (size < CELL_HEADER_SIZE + 8) {
+                    return Fail("corrupt NUMBER record");
+                }
+
+                AddCell(result, row, col, CELL_NUMBER,
+                    DecodeDouble(bytes + CELL_HEADER_SIZE));
+                break;
+
+            case BiffReader::RECORD_RK:
+                if (size < CELL_HEADER_SIZE + 4) {
+                    return Fail("corrupt RK record");
+                }
+
+                AddCell(result, row, col, CELL_NUMBER,
+                    DecodeRk(ByteSource::Uint32(bytes + CELL_HEADER_SIZE)));
+                break;
+
+            // Format index and value pairs for consecutive columns,
+            // followed by the last column
+            case BiffReader::RECORD_MULRK: {
+                size_t count = (size - 6) / 6;
+
+                for (size_t i = 0; i < count; i++) {
+                    AddCell(result, row, static_cast<uint16_t>(col + i),
+                        CELL_NUMBER,
+                        DecodeRk(ByteSource::Uint32(bytes + 6 + i * 6)));
+                }
+
+                break;
+            }
+
+            case BiffReader::RECORD_LABELSST: {
+                if (size < CELL_HEADER_SIZE + 4) {
+                    return Fail("corrupt LABELSST record");
+                }
+
+                uint32_t index = ByteSource::Uint32(bytes + CELL_HEADER_SIZE);
+
+                if (index >= sharedStringCount) {
+                    return Fail("corrupt LABELSST record");
+                }
+
+                AddCell(result, row, col, CELL_STRING, index);
+                break;
+            }
+
+            case BiffReader::RECORD_LABEL: {
+                if (size < CELL_HEADER_SIZE + 3) {
+                    return Fail("corrupt LABEL record");
+                }
+
+                size_t length = ByteSource::Uint16(bytes + CELL_HEADER_SIZE);
+                bool wide = bytes[CELL_HEADER_SIZE + 2] & 0x01;
+
+                if (size < CELL_HEADER_SIZE + 3 + length * (wide ? 2 : 1)) {
+                    return Fail("corrupt LABEL record");
+                }
+
+                AddString(result, row, col, BiffReader::DecodeCharacters(
+                    bytes + CELL_HEADER_SIZE + 3, length, wide));
+                break;
+            }
+
+            case BiffReader::RECORD_BOOLERR:
+                if (size < CELL_HEADER_SIZE + 2) {
+                    return Fail("corrupt BOOLERR record");
+                }
+
+                if (bytes[CELL_HEADER_SIZE + 1]) {
+                    AddError(result, row, col, bytes[CELL_HEADER_SIZE]);
+                } else {
+                    AddCell(result, row, col, CELL_BOOLEAN,
+                        bytes[CELL_HEADER_SIZE] ? 1 : 0);
+                }
+
+                break;
+
+            // Cached results are numbers unless the top two bytes are
+            // 0xFFFF, in which case the first byte holds the result type.
+            // String results follow in a STRING record.
+            case BiffReader::RECORD_FORMULA: {
+                if (size < CELL_HEADER_SIZE + 8) {
+                    return Fail("corrupt FORMULA record");
+                }
+
+                const char* value = bytes + CELL_HEADER_SIZE;
+
+                if (ByteSource::Uint16(value + 6) != 0xFFFF) {
+                    AddCell(result, row, col, CELL_NUMBER,
+                        DecodeDouble(value));
+                    break;
+                }
+
+                switch (value[0]) {
+                    case 0x00:
+                        pendingString = true;
+                        pendingRow = row;
+                        pendingCol = col;
+                        break;
+
+                    case 0x01:
+                        AddCell(result, row, col, CELL_BOOLEAN,
+                            value[2] ? 1 : 0);
+                        break;
+
+                    case 0x02:
+                        AddError(result, row, col, value[2]);
+                        break;
+
+                    case 0x03:
+                        AddString(result, row, col, "");
+                        break;
+                }
+
+                break;
+            }
+        }
+    }
+
+    return Fail("unexpected end of sheet stream");
+}
+
+
+void XlsScanner::AddCell(Result& result, uint16_t row, uint16_t col,
+    CellType type, double number)
+{
+    result.rows.push_back(row);
+    result.cols.push_back(col);
+    result.types.push_back(type);
+    result.numbers.push_back(number);
+}
+
+
+void XlsScanner::AddString(Result& result, uint16_t row, uint16_t col,
+    const std::string& text)
+{
+    AddCell(result, row, col, CELL_STRING, result.strings.size());
+    result.strings.push_back(text);
+}
+
+
+// Error texts are added to the strings once per error code
+void XlsScanner::AddError(Result& result, uint16_t row, uint16_t col,
+    uint8_t code)
+{
+    std::map<uint8_t, size_t>::iterator it = errorStrings.find(code);
+
+    if (it == errorStrings.end()) {
+        it = errorStrings.insert(std::make_pair(code,
+            result.strings.size())).first;
+        result.strings.push_back(ErrorText(code));
+    }
+
+    AddCell(result, row, col, CELL_ERROR, it->second);
+}
+
+
+bool XlsScanner::Fail(const std::string& message) {
+    errorMessage = message;
+    return false;
+}
+
+
+}
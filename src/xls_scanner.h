@@ -0,0 +1,94 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XLS_SCANNER_H
+#define BINDINGS_XLS_SCANNER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "biff_reader.h"
+#include "byte_source.h"
+
+namespace node_libxl {
+
+
+// Extracts the cell values of a BIFF8 worksheet by walking its records
+// directly. Formats, formulas and everything else are skipped; formula cells
+// yield their cached results.
+class XlsScanner {
+    public:
+
+        // Matches the cell types of XlsxRowReader
+        enum CellType {CELL_NUMBER = 1, CELL_STRING, CELL_BOOLEAN, CELL_ERROR};
+
+        // Cells in record order. For strings and errors, numbers holds the
+        // index into strings.
+        struct Result {
+            std::vector<int32_t> rows, cols;
+            std::vector<uint8_t> types;
+            std::vector<double> numbers;
+            std::vector<std::string> strings;
+        };
+
+        explicit XlsScanner(ByteSource& source);
+
+        // Scans a worksheet selected by its name (case-insensitively), or
+        // the first worksheet if the name is empty
+        bool Run(const std::string& sheet, Result& result);
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        bool ReadGlobals(BiffReader& reader, const std::string& sheet,
+            uint32_t& offset, Result& result);
+        bool ReadSharedStrings(BiffReader& reader, Result& result);
+        bool ReadCells(BiffReader& reader, Result& result);
+
+        void AddCell(Result& result, uint16_t row, uint16_t col,
+            CellType type, double number);
+        void AddString(Result& result, uint16_t row, uint16_t col,
+            const std::string& text);
+        void AddError(Result& result, uint16_t row, uint16_t col,
+            uint8_t code);
+
+        bool Fail(const std::string& message);
+
+        ByteSource& source;
+        size_t sharedStringCount;
+        std::map<uint8_t, size_t> errorStrings;
+        std::string errorMessage;
+
+        XlsScanner(const XlsScanner&);
+        const XlsScanner& operator=(const XlsScanner&);
+};
+
+
+}
+
+#endif // BINDINGS_XLS_SCANNER_H
@@ -0,0 +1,221 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xlsx_package.h"
+
+#include "xml_tag.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+std::string DirectoryOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+
+std::string SheetType(const std::string& relationshipType) {
+    if (relationshipType == "chartsheet" ||
+        relationshipType == "dialogsheet")
+    {
+        return relationshipType;
+    }
+
+    if (relationshipType == "xlMacrosheet" ||
+        relationshipType == "xlIntlMacrosheet")
+    {
+        return "macrosheet";
+    }
+
+    return "worksheet";
+}
+
+
+}
+
+
+XlsxPackage::XlsxPackage(ByteSource& source) :
+    zip(source),
+    workbookPath("xl/workbook.xml")
+{}
+
+
+bool XlsxPackage::Open() {
+    if (!zip.Open()) return Fail(zip.ErrorMessage());
+
+    // The package relationships point to the workbook part
+    RelationshipMap relationships;
+
+    if (ReadRelationships("", relationships)) {
+        for (RelationshipMap::iterator i = relationships.begin();
+            i != relationships.end(); ++i)
+        {
+            if (i->second.type == "officeDocument") {
+                workbookPath = i->second.target;
+            }
+        }
+    }
+
+    const ZipReader::Entry* entry = zip.Find(workbookPath);
+    std::string workbook;
+
+    if (!entry) return Fail("missing workbook part");
+    if (!zip.Extract(*entry, workbook)) return Fail(zip.ErrorMessage());
+
+    ReadRelationships(workbookPath, workbookRelationships);
+
+    XmlTag tag;
+    size_t pos = 0;
+
+    while (tag.Find(workbook, pos, "sheet")) {
+        Sheet sheet;
+        sheet.name = tag.Attribute("name");
+        sheet.state = tag.Attribute("state", "visible");
+        sheet.type = "worksheet";
+
+        RelationshipMap::iterator relationship =
+            workbookRelationships.find(tag.Attribute("id"));
+
+        if (relationship != workbookRelationships.end()) {
+            sheet.type = SheetType(relationship->second.type);
+
+            if (zip.Find(relationship->second.target)) {
+                sheet.path = relationship->second.target;
+            }
+        }
+
+        sheets.push_back(sheet);
+    }
+
+    return true;
+}
+
+
+ZipReader& XlsxPackage::Zip() {
+    return zip;
+}
+
+
+const std::string& XlsxPackage::WorkbookPath() const {
+    return workbookPath;
+}
+
+
+const std::vector<XlsxPackage::Sheet>& XlsxPackage::Sheets() const {
+    return sheets;
+}
+
+
+std::string XlsxPackage::RelatedPart(const std::string& type) const {
+    for (RelationshipMap::const_iterator i = workbookRelationships.begin();
+        i != workbookRelationships.end(); ++i)
+    {
+        if (i->second.type == type) return i->second.target;
+    }
+
+    return "";
+}
+
+
+const std::string& XlsxPackage::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+std::string XlsxPackage::ResolvePath(const std::string& sourcePart,
+    const std::string& target)
+{
+    std::string path = !target.empty() && target[0] == '/' ?
+        target.substr(1) : DirectoryOf(sourcePart) + target;
+    std::vector<std::string> segments;
+
+    for (size_t pos = 0; pos <= path.size();) {
+        size_t slash = path.find('/', pos);
+        if (slash == std::string::npos) slash = path.size();
+
+        std::string segment = path.substr(pos, slash - pos);
+
+        if (segment == "..") {
+            if (!segments.empty()) segments.pop_back();
+        } else if (!segment.empty() && segment != ".") {
+            segments.push_back(segment);
+        }
+
+        pos = slash + 1;
+    }
+
+    std::string resolved;
+
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (i > 0) resolved += '/';
+        resolved += segments[i];
+    }
+
+    return resolved;
+}
+
+
+// Relationship types are reduced to their last path segment, like
+// "worksheet" or "sharedStrings"
+bool XlsxPackage::ReadRelationships(const std::string& part,
+    RelationshipMap& relationships)
+{
+    std::string directory = DirectoryOf(part),
+        path = directory + "_rels/" + part.substr(directory.size()) + ".rels";
+    const ZipReader::Entry* entry = zip.Find(path);
+    std::string xml;
+
+    if (!entry || !zip.Extract(*entry, xml)) return false;
+
+    XmlTag tag;
+    size_t pos = 0;
+
+    while (tag.Find(xml, pos, "Relationship")) {
+        Relationship relationship;
+        std::string type = tag.Attribute("Type");
+
+        relationship.type = type.substr(type.rfind('/') + 1);
+        relationship.target = tag.Attribute("TargetMode") == "External" ?
+            tag.Attribute("Target") :
+            ResolvePath(part, tag.Attribute("Target"));
+
+        relationships[tag.Attribute("Id")] = relationship;
+    }
+
+    return true;
+}
+
+
+bool XlsxPackage::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return false;
+}
+
+
+}
@@ -0,0 +1,103 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XLSX_PACKAGE_H
+#define BINDINGS_XLSX_PACKAGE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "byte_source.h"
+#include "zip_reader.h"
+
+namespace node_libxl {
+
+
+// Locates the parts of an XLSX package: the workbook part, the sheets it
+// lists and the parts related to the workbook (shared strings, styles).
+class XlsxPackage {
+    public:
+
+        struct Sheet {
+            std::string name;
+
+            // "visible", "hidden" or "veryHidden"
+            std::string state;
+
+            // "worksheet", "chartsheet", "dialogsheet" or "macrosheet"
+            std::string type;
+
+            // Path of the sheet part in the zip archive; empty if missing
+            std::string path;
+        };
+
+        explicit XlsxPackage(ByteSource& source);
+
+        // Reads the zip directory, the workbook part and the relationships
+        bool Open();
+
+        ZipReader& Zip();
+
+        const std::string& WorkbookPath() const;
+        const std::vector<Sheet>& Sheets() const;
+
+        // Path of the first part related to the workbook by a relationship
+        // of the given type (like "sharedStrings"); empty if there is none
+        std::string RelatedPart(const std::string& type) const;
+
+        const std::string& ErrorMessage() const;
+
+        // Resolves a relationship target against the directory of its
+        // source part
+        static std::string ResolvePath(const std::string& sourcePart,
+            const std::string& target);
+
+    private:
+
+        struct Relationship {
+            std::string target, type;
+        };
+
+        typedef std::map<std::string, Relationship> RelationshipMap;
+
+        bool ReadRelationships(const std::string& part,
+            RelationshipMap& relationships);
+
+        bool Fail(const std::string& message);
+
+        ZipReader zip;
+        std::string workbookPath;
+        std::vector<Sheet> sheets;
+        RelationshipMap workbookRelationships;
+        std::string errorMessage;
+
+        XlsxPackage(const XlsxPackage&);
+        const XlsxPackage& operator=(const XlsxPackage&);
+};
+
+
+}
+
+#endif // BINDINGS_XLSX_PACKAGE_H
@@ -0,0 +1,398 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xlsx_row_reader.h"
+
+#include <cstdlib>
+#include <utility>
+
+#include "cell_reference.h"
+#include "sheet_name.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const int MAX_COL = 16383;
+
+
+// Decodes characters escaped like _x0001_, which is how XLSX represents
+// characters that XML cannot
+std::string DecodeEscapes(const std::string& text) {
+    if (text.find("_x") == std::string::npos) return text;
+
+    std::string out;
+
+    for (size_t pos = 0; pos < text.size();) {
+        if (text.compare(pos, 2, "_x") == 0 && pos + 7 <= text.size() &&
+            text[pos + 6] == '_')
+        {
+            std::string digits = text.substr(pos + 2, 4);
+            char* end;
+            unsigned long code = strtoul(digits.c_str(), &end, 16);
+
+            if (*end == '\0' && code < 0x80) {
+                out += static_cast<char>(code);
+                pos += 7;
+                continue;
+            }
+        }
+
+        out += text[pos++];
+    }
+
+    return out;
+}
+
+
+// Concatenates the <t> elements of a string item (the content of <si> or
+// <is>), skipping phonetic runs
+std::string TextContent(const std::string& xml) {
+    std::vector<std::pair<size_t, size_t> > phonetic;
+    std::string text;
+    XmlTag tag;
+    size_t pos = 0;
+
+    while (tag.Find(xml, pos, "rPh")) {
+        size_t close = tag.selfClosing ? tag.end :
+            xml.find("</" + tag.name + ">", tag.end);
+        if (close == std::string::npos) close = xml.size();
+
+        phonetic.push_back(std::make_pair(tag.begin, close));
+        pos = close;
+    }
+
+    pos = 0;
+
+    while (tag.Find(xml, pos, "t")) {
+        if (tag.selfClosing) continue;
+
+        size_t close = xml.find('<', tag.end);
+        if (close == std::string::npos) close = xml.size();
+
+        bool skip = false;
+
+        for (size_t i = 0; i < phonetic.size() && !skip; i++) {
+            skip = tag.begin >= phonetic[i].first &&
+                tag.begin < phonetic[i].second;
+        }
+
+        if (!skip) text += XmlTag::Decode(xml.substr(tag.end, close - tag.end));
+
+        pos = close;
+    }
+
+    return DecodeEscapes(text);
+}
+
+
+}
+
+
+// Inflates a part chunk by chunk and cuts complete elements out of it.
+// Only the current chunk and the element being read are kept in memory.
+class XlsxRowReader::ElementReader {
+    public:
+
+        ElementReader(ZipReader& zip, const ZipReader::Entry& entry) :
+            zip(zip),
+            reader(zip, entry),
+            pos(0),
+            truncated(false)
+        {}
+
+        // Finds the next element with the given local name and returns its
+        // start tag and content (empty for self-closing elements)
+        bool Next(const char* localName, XmlTag& tag, std::string& content) {
+            while (true) {
+                size_t start = pos;
+                size_t keep;
+
+                if (tag.Find(buffer, start, localName)) {
+                    if (tag.selfClosing) {
+                        content.clear();
+                        pos = start;
+                        return true;
+                    }
+
+                    size_t close = buffer.find("</" + tag.name + ">", start);
+
+                    if (close != std::string::npos) {
+                        content.assign(buffer, start, close - start);
+                        pos = close + tag.name.size() + 3;
+                        return true;
+                    }
+
+                    keep = tag.begin;
+                } else {
+                    // Scan a tag cut off by the end of the chunk again
+                    size_t last = buffer.rfind('<');
+                    keep = last != std::string::npos && last >= pos ?
+                        last : buffer.size();
+                }
+
+                if (!reader.Next(chunk)) {
+                    truncated = keep < buffer.size() &&
+                        tag.Find(buffer, keep, localName);
+                    return false;
+                }
+
+                buffer.erase(0, keep);
+                buffer += chunk;
+                pos = 0;
+            }
+        }
+
+        bool Failed() const {
+            return reader.Failed() || truncated;
+        }
+
+        std::string ErrorMessage() const {
+            return reader.Failed() ? zip.ErrorMessage() : "truncated part";
+        }
+
+    private:
+
+        ZipReader& zip;
+        ZipReader::EntryReader reader;
+        std::string buffer, chunk;
+        size_t pos;
+        bool truncated;
+
+        ElementReader(const ElementReader&);
+        const ElementReader& operator=(const ElementReader&);
+};
+
+
+XlsxRowReader::Cell::Cell() :
+    type(EMPTY),
+    number(0)
+{}
+
+
+XlsxRowReader::XlsxRowReader(ByteSource& source) :
+    package(source),
+    entry(NULL),
+    sheetReader(NULL),
+    sharedStringsLoaded(false),
+    failed(false),
+    nextRow(0)
+{}
+
+
+XlsxRowReader::~XlsxRowReader() {
+    delete sheetReader;
+}
+
+
+bool XlsxRowReader::Open(const std::string& sheet) {
+    if (!package.Open()) return Fail(package.ErrorMessage());
+
+    const std::vector<XlsxPackage::Sheet>& sheets = package.Sheets();
+
+    for (size_t i = 0; i < sheets.size() && !entry; i++) {
+        bool matches = sheet.empty() ? sheets[i].type == "worksheet" :
+            SheetNamesEqual(sheets[i].name, sheet);
+
+        if (!matches) continue;
+
+        if (sheets[i].type != "worksheet" || sheets[i].path.empty()) {
+            return Fail("not a worksheet: " + sheets[i].name);
+        }
+
+        entry = package.Zip().Find(sheets[i].path);
+    }
+
+    if (!entry) {
+        return Fail(sheet.empty() ? "no worksheet found" :
+            "unknown sheet " + sheet);
+    }
+
+    sheetReader = new ElementReader(package.Zip(), *entry);
+
+    return true;
+}
+
+
+bool XlsxRowReader::Next(Row& row) {
+    if (failed || !sheetReader) return false;
+    if (!sharedStringsLoaded && !LoadSharedStrings()) return false;
+
+    if (!sheetReader->Next("row", tag, content)) {
+        if (sheetReader->Failed()) Fail(sheetReader->ErrorMessage());
+        return false;
+    }
+
+    // Row numbers are one based and may be omitted
+    std::string index = tag.Attribute("r");
+    row.index = index.empty() ? nextRow : atoi(index.c_str()) - 1;
+    nextRow = row.index + 1;
+
+    return ParseRow(content, row);
+}
+
+
+bool XlsxRowReader::Failed() const {
+    return failed;
+}
+
+
+const std::string& XlsxRowReader::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool XlsxRowReader::LoadSharedStrings() {
+    sharedStringsLoaded = true;
+
+    std::string path = package.RelatedPart("sharedStrings");
+    const ZipReader::Entry* stringsEntry = package.Zip().Find(path);
+
+    if (!stringsEntry) return true;
+
+    ElementReader reader(package.Zip(), *stringsEntry);
+    XmlTag item;
+    std::string text;
+
+    while (reader.Next("si", item, text)) {
+        sharedStrings.push_back(TextContent(text));
+    }
+
+    if (reader.Failed()) return Fail(reader.ErrorMessage());
+
+    return true;
+}
+
+
+bool XlsxRowReader::ParseRow(const std::string& xml, Row& row) {
+    XmlTag cellTag;
+    size_t pos = 0;
+    int col = -1;
+
+    row.cells.clear();
+
+    while (cellTag.Find(xml, pos, "c")) {
+        std::string ref = cellTag.Attribute("r");
+        CellReference reference;
+
+        // Cells without a reference follow their predecessor
+        col = reference.Parse(ref.c_str(), ref.size()) > 0 ?
+            reference.col : col + 1;
+
+        if (col < 0 || col > MAX_COL) return Fail("invalid cell reference");
+
+        if (cellTag.selfClosing) continue;
+
+        size_t close = xml.find("</" + cellTag.name + ">", pos);
+        if (close == std::string::npos) return Fail("invalid cell");
+
+        Cell cell;
+
+        if (!ParseCell(xml.substr(pos, close - pos),
+            cellTag.Attribute("t", "n"), cell))
+        {
+            return false;
+        }
+
+        pos = close;
+
+        if (cell.type == Cell::EMPTY) continue;
+
+        if (row.cells.size() <= static_cast<size_t>(col)) {
+            row.cells.resize(col + 1);
+        }
+
+        row.cells[col] = cell;
+    }
+
+    return true;
+}
+
+
+bool XlsxRowReader::ParseCell(const std::string& xml, const std::string& type,
+    Cell& cell)
+{
+    if (type == "inlineStr") {
+        XmlTag item;
+        size_t pos = 0;
+
+        if (item.Find(xml, pos, "is") && !item.selfClosing) {
+            cell.type = Cell::STRING;
+            cell.text = TextContent(xml.substr(pos));
+        }
+
+        return true;
+    }
+
+    XmlTag value;
+    size_t pos = 0;
+
+    if (!value.Find(xml, pos, "v") || value.selfClosing) return true;
+
+    std::string text = XmlTag::Decode(
+        xml.substr(pos, xml.find('<', pos) - pos));
+
+    if (type == "s") {
+        char* end;
+        unsigned long index = strtoul(text.c_str(), &end, 10);
+
+        if (text.empty() || *end != '\0' || index >= sharedStrings.size()) {
+            return Fail("invalid shared string index " + text);
+        }
+
+        cell.type = Cell::STRING;
+        cell.text = sharedStrings[index];
+    } else if (type == "b") {
+        cell.type = Cell::BOOLEAN;
+        cell.number = text == "1" || text == "true";
+    } else if (type == "e") {
+        cell.type = Cell::ERROR;
+        cell.text = text;
+    } else if (type == "str" || type == "d") {
+        cell.type = Cell::STRING;
+        cell.text = text;
+    } else if (!text.empty()) {
+        char* end;
+
+        cell.type = Cell::NUMBER;
+        cell.number = strtod(text.c_str(), &end);
+
+        if (*end != '\0') return Fail("invalid number " + text);
+    }
+
+    return true;
+}
+
+
+bool XlsxRowReader::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    failed = true;
+    return false;
+}
+
+
+}
@@ -0,0 +1,109 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XLSX_ROW_READER_H
+#define BINDINGS_XLSX_ROW_READER_H
+
+#include <string>
+#include <vector>
+
+#include "byte_source.h"
+#include "xlsx_package.h"
+#include "xml_tag.h"
+#include "zip_reader.h"
+
+namespace node_libxl {
+
+
+// Reads the cell values of a worksheet row by row, inflating the sheet part
+// incrementally. Only the shared strings table is kept in memory; styles,
+// formulas and everything else in the package are ignored.
+class XlsxRowReader {
+    public:
+
+        struct Cell {
+            enum Type {EMPTY, NUMBER, STRING, BOOLEAN, ERROR};
+
+            Cell();
+
+            Type type;
+            double number;
+
+            // Strings, and error codes like "#N/A"
+            std::string text;
+        };
+
+        struct Row {
+            int index;
+
+            // Indexed by column, padded with empty cells
+            std::vector<Cell> cells;
+        };
+
+        explicit XlsxRowReader(ByteSource& source);
+        ~XlsxRowReader();
+
+        // Locates a worksheet by its name (case-insensitively); the first
+        // worksheet is read if the name is empty
+        bool Open(const std::string& sheet);
+
+        // Returns false at the end of the sheet or on errors. The shared
+        // strings are loaded on the first call.
+        bool Next(Row& row);
+
+        bool Failed() const;
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        // Streams the elements of a part; defined in the implementation
+        class ElementReader;
+
+        bool LoadSharedStrings();
+
+        bool ParseRow(const std::string& xml, Row& row);
+        bool ParseCell(const std::string& xml, const std::string& type,
+            Cell& cell);
+
+        bool Fail(const std::string& message);
+
+        XlsxPackage package;
+        const ZipReader::Entry* entry;
+        ElementReader* sheetReader;
+        std::vector<std::string> sharedStrings;
+        bool sharedStringsLoaded, failed;
+        int nextRow;
+
+        XmlTag tag;
+        std::string content;
+        std::string errorMessage;
+
+        XlsxRowReader(const XlsxRowReader&);
+        const XlsxRowReader& operator=(const XlsxRowReader&);
+};
+
+
+}
+
+#endif // BINDINGS_XLSX_ROW_READER_H
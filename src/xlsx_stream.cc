@@ -0,0 +1,257 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xlsx_stream.h"
+
+#include "argument_helper.h"
+#include "assert.h"
+#include "util.h"
+
+using namespace v8;
+
+namespace node_libxl {
+
+
+// Lifecycle
+
+
+XlsxStream::XlsxStream(const std::string& path, int batchSize) :
+    path(path),
+    file(new FileSource(path)),
+    batchSize(batchSize),
+    pending(false)
+{
+    wrapped = new XlsxRowReader(*file);
+}
+
+
+XlsxStream::~XlsxStream() {
+    Release();
+}
+
+
+Handle<Object> XlsxStream::NewInstance(XlsxStream* stream) {
+    NanEscapableScope();
+
+    Local<Object> that = NanNew(util::CallStubConstructor(
+        NanNew(constructor)).As<Object>());
+
+    stream->Wrap(that);
+
+    return NanEscapeScope(that);
+}
+
+
+bool XlsxStream::Open(const std::string& sheet) {
+    return file->IsOpen() && wrapped->Open(sheet);
+}
+
+
+std::string XlsxStream::ErrorMessage() const {
+    return file && !file->IsOpen() ?
+        "unable to read " + path : wrapped->ErrorMessage();
+}
+
+
+bool XlsxStream::ReadBatch(Batch& batch) {
+    batch.clear();
+    batch.reserve(batchSize);
+
+    XlsxRowReader::Row row;
+
+    while (static_cast<int>(batch.size()) < batchSize &&
+        wrapped->Next(row))
+    {
+        batch.push_back(row);
+    }
+
+    return !wrapped->Failed();
+}
+
+
+void XlsxStream::Release() {
+    delete wrapped;
+    delete file;
+
+    wrapped = NULL;
+    file = NULL;
+}
+
+
+// Rows are converted into objects with the row index and an array of
+// values; empty cells are null and errors are passed as their codes
+Handle<Value> XlsxStream::BatchToJs(const Batch& batch) {
+    NanEscapableScope();
+
+    if (batch.empty()) return NanEscapeScope(NanNull());
+
+    Local<Array> rows = NanNew<Array>(static_cast<int>(batch.size()));
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        const std::vector<XlsxRowReader::Cell>& cells = batch[i].cells;
+        Local<Array> values = NanNew<Array>(static_cast<int>(cells.size()));
+
+        for (size_t j = 0; j < cells.size(); j++) {
+            Handle<Value> value;
+
+            switch (cells[j].type) {
+                case XlsxRowReader::Cell::NUMBER:
+                    value = NanNew<Number>(cells[j].number);
+                    break;
+                case XlsxRowReader::Cell::BOOLEAN:
+                    value = NanNew<Boolean>(cells[j].number != 0);
+                    break;
+                case XlsxRowReader::Cell::STRING:
+                case XlsxRowReader::Cell::ERROR:
+                    value = NanNew<String>(cells[j].text.c_str());
+                    break;
+                default:
+                    value = NanNull();
+            }
+
+            values->Set(j, value);
+        }
+
+        Local<Object> row = NanNew<Object>();
+        row->Set(NanNew<String>("row"), NanNew<Integer>(batch[i].index));
+        row->Set(NanNew<String>("values"), values);
+
+        rows->Set(i, row);
+    }
+
+    return NanEscapeScope(rows);
+}
+
+
+// Implementation
+
+
+NAN_METHOD(XlsxStream::NextSync) {
+    NanScope();
+
+    XlsxStream* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+    if (!that->wrapped) return NanThrowError("stream closed");
+
+    Batch batch;
+
+    if (!that->ReadBatch(batch)) {
+        return NanThrowError(that->wrapped->ErrorMessage().c_str());
+    }
+
+    NanReturnValue(BatchToJs(batch));
+}
+
+
+NAN_METHOD(XlsxStream::Next) {
+    class Worker : public NanAsyncWorker {
+        public:
+            Worker(NanCallback* callback, Local<Object> stream) :
+                NanAsyncWorker(callback),
+                that(XlsxStream::Unwrap(stream))
+            {
+                that->pending = true;
+                SaveToPersistent("that", stream);
+            }
+
+            virtual void Execute() {
+                if (!that->ReadBatch(batch)) {
+                    SetErrorMessage(that->wrapped->ErrorMessage().c_str());
+                }
+            }
+
+            virtual void WorkComplete() {
+                that->pending = false;
+
+                NanAsyncWorker::WorkComplete();
+            }
+
+            virtual void HandleOKCallback() {
+                NanScope();
+
+                Handle<Value> argv[] = {NanUndefined(), BatchToJs(batch)};
+                callback->Call(2, argv);
+            }
+
+        private:
+            XlsxStream* that;
+            Batch batch;
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Function> callback = arguments.GetFunction(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    XlsxStream* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+    if (!that->wrapped) return NanThrowError("stream closed");
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This()));
+
+    NanReturnValue(args.This());
+}
+
+
+// Closes the file; pending reads have to complete first
+NAN_METHOD(XlsxStream::Close) {
+    NanScope();
+
+    XlsxStream* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+
+    that->Release();
+
+    NanReturnValue(args.This());
+}
+
+
+// Init
+
+
+void XlsxStream::Initialize(Handle<Object> exports) {
+    NanScope();
+
+    Local<FunctionTemplate> t = NanNew<FunctionTemplate>(util::StubConstructor);
+    t->SetClassName(NanNew<String>("XlsxStream"));
+    t->InstanceTemplate()->SetInternalFieldCount(1);
+
+    NODE_SET_PROTOTYPE_METHOD(t, "nextSync", NextSync);
+    NODE_SET_PROTOTYPE_METHOD(t, "next", Next);
+    NODE_SET_PROTOTYPE_METHOD(t, "close", Close);
+
+    t->ReadOnlyPrototype();
+    NanAssignPersistent(constructor, t->GetFunction());
+}
+
+
+}
@@ -0,0 +1,87 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XLSX_STREAM_H
+#define BINDINGS_XLSX_STREAM_H
+
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "wrapper.h"
+#include "byte_source.h"
+#include "xlsx_row_reader.h"
+
+namespace node_libxl {
+
+
+// JS handle for reading the values of an XLSX worksheet in batches of rows,
+// as returned by xl.streamXlsx
+class XlsxStream : public Wrapper<XlsxRowReader> {
+    public:
+
+        XlsxStream(const std::string& path, int batchSize);
+        ~XlsxStream();
+
+        static void Initialize(v8::Handle<v8::Object> exports);
+
+        static XlsxStream* Unwrap(v8::Handle<v8::Value> object) {
+            return Wrapper<XlsxRowReader>::Unwrap<XlsxStream>(object);
+        }
+
+        static v8::Handle<v8::Object> NewInstance(XlsxStream* stream);
+
+        // Opens the file and locates the sheet
+        bool Open(const std::string& sheet);
+        std::string ErrorMessage() const;
+
+    protected:
+
+        static NAN_METHOD(NextSync);
+        static NAN_METHOD(Next);
+        static NAN_METHOD(Close);
+
+    private:
+
+        typedef std::vector<XlsxRowReader::Row> Batch;
+
+        // Returns false on errors; an empty batch marks the end
+        bool ReadBatch(Batch& batch);
+        void Release();
+
+        static v8::Handle<v8::Value> BatchToJs(const Batch& batch);
+
+        std::string path;
+        FileSource* file;
+        int batchSize;
+        bool pending;
+
+        XlsxStream(const XlsxStream&);
+        const XlsxStream& operator=(const XlsxStream&);
+};
+
+
+}
+
+#endif // BINDINGS_XLSX_STREAM_H
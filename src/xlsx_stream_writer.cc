@@ -0,0 +1,293 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xlsx_stream_writer.h"
+
+#include "argument_helper.h"
+#include "assert.h"
+#include "format.h"
+#include "util.h"
+
+using namespace v8;
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const int MAX_COL = 16383;
+
+// Days between 1899-12-30 (day 0 of the 1900 date system) and 1970-01-01
+const double UNIX_EPOCH_SERIAL = 25569;
+const double MS_PER_DAY = 86400000;
+
+
+}
+
+
+// Lifecycle
+
+
+XlsxStreamWriter::XlsxStreamWriter(XlsxWriter* writer) :
+    Wrapper<XlsxWriter>(writer),
+    pending(false)
+{}
+
+
+XlsxStreamWriter::~XlsxStreamWriter() {
+    delete wrapped;
+}
+
+
+Handle<Object> XlsxStreamWriter::NewInstance(XlsxWriter* writer) {
+    NanEscapableScope();
+
+    XlsxStreamWriter* streamWriter = new XlsxStreamWriter(writer);
+
+    Local<Object> that = NanNew(util::CallStubConstructor(
+        NanNew(constructor)).As<Object>());
+
+    streamWriter->Wrap(that);
+
+    return NanEscapeScope(that);
+}
+
+
+XlsxWriter::CellStyle XlsxStreamWriter::StyleFromFormat(Format* format) {
+    libxl::Format* libxlFormat = format->GetWrapped();
+    libxl::Book* libxlBook = util::UnwrapBook(format);
+    XlsxWriter::CellStyle style;
+
+    style.numFormatId = libxlFormat->numFormat();
+
+    if (style.numFormatId >= 164) {
+        const char* code = libxlBook->customNumFormat(style.numFormatId);
+
+        if (code) {
+            style.numFormatCode = code;
+        } else {
+            style.numFormatId = 0;
+        }
+    }
+
+    libxl::Font* font = libxlFormat->font();
+
+    if (font) {
+        style.fontName = font->name() ? font->name() : "";
+        style.fontSize = font->size();
+        style.fontColor = font->color();
+        style.underline = font->underline();
+        style.bold = font->bold();
+        style.italic = font->italic();
+    }
+
+    style.alignH = libxlFormat->alignH();
+    style.alignV = libxlFormat->alignV();
+    style.wrap = libxlFormat->wrap();
+
+    // Patterns are approximated by a solid fill in the foreground color
+    if (libxlFormat->fillPattern() != libxl::FILLPATTERN_NONE) {
+        style.fillColor = libxlFormat->patternForegroundColor();
+    }
+
+    return style;
+}
+
+
+// Implementation
+
+
+// Rows are arrays of numbers, strings, booleans and dates; null and
+// undefined leave cells empty. Each row is validated before it is written.
+NAN_METHOD(XlsxStreamWriter::WriteRows) {
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Array> rows = arguments.GetArray(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    XlsxStreamWriter* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+    if (that->wrapped->IsClosed()) return NanThrowError("writer closed");
+
+    XlsxWriter* writer = that->wrapped;
+
+    for (uint32_t i = 0; i < rows->Length(); i++) {
+        Handle<Value> row = rows->Get(i);
+
+        if (!row->IsArray()) {
+            return NanThrowTypeError("rows must be arrays");
+        }
+
+        Handle<Array> values = row.As<Array>();
+        uint32_t length = values->Length();
+
+        if (length > MAX_COL + 1) return NanThrowTypeError("too many columns");
+
+        for (uint32_t j = 0; j < length; j++) {
+            Handle<Value> value = values->Get(j);
+
+            if (!value->IsNumber() && !value->IsString() &&
+                !value->IsBoolean() && !value->IsDate() &&
+                !value->IsNull() && !value->IsUndefined())
+            {
+                return NanThrowTypeError("invalid cell value");
+            }
+        }
+
+        if (!writer->BeginRow()) {
+            return NanThrowError(writer->ErrorMessage().c_str());
+        }
+
+        for (uint32_t j = 0; j < length; j++) {
+            Handle<Value> value = values->Get(j);
+
+            if (value->IsNumber()) {
+                writer->AddNumber(j, value->NumberValue());
+            } else if (value->IsString()) {
+                writer->AddString(j, *String::Utf8Value(value));
+            } else if (value->IsBoolean()) {
+                writer->AddBoolean(j, value->BooleanValue());
+            } else if (value->IsDate()) {
+                writer->AddNumber(j, value->NumberValue() / MS_PER_DAY +
+                    UNIX_EPOCH_SERIAL);
+            }
+        }
+
+        if (!writer->EndRow()) {
+            return NanThrowError(writer->ErrorMessage().c_str());
+        }
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(XlsxStreamWriter::NextSheet) {
+    NanScope();
+
+    XlsxStreamWriter* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+    if (that->wrapped->IsClosed()) return NanThrowError("writer closed");
+
+    if (!that->wrapped->NextSheet()) {
+        return NanThrowError(that->wrapped->ErrorMessage().c_str());
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+NAN_METHOD(XlsxStreamWriter::CloseSync) {
+    NanScope();
+
+    XlsxStreamWriter* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+    if (that->wrapped->IsClosed()) return NanThrowError("writer closed");
+
+    if (!that->wrapped->Close()) {
+        return NanThrowError(that->wrapped->ErrorMessage().c_str());
+    }
+
+    NanReturnValue(args.This());
+}
+
+
+// Copying the shared strings and waiting for the compression to finish
+// happens on a worker thread
+NAN_METHOD(XlsxStreamWriter::Close) {
+    class Worker : public NanAsyncWorker {
+        public:
+            Worker(NanCallback* callback, Local<Object> writer) :
+                NanAsyncWorker(callback),
+                that(XlsxStreamWriter::Unwrap(writer))
+            {
+                that->pending = true;
+                SaveToPersistent("that", writer);
+            }
+
+            virtual void Execute() {
+                if (!that->wrapped->Close()) {
+                    SetErrorMessage(that->wrapped->ErrorMessage().c_str());
+                }
+            }
+
+            virtual void WorkComplete() {
+                that->pending = false;
+
+                NanAsyncWorker::WorkComplete();
+            }
+
+        private:
+            XlsxStreamWriter* that;
+    };
+
+    NanScope();
+
+    ArgumentHelper arguments(args);
+
+    Handle<Function> callback = arguments.GetFunction(0);
+    ASSERT_ARGUMENTS(arguments);
+
+    XlsxStreamWriter* that = Unwrap(args.This());
+
+    if (!that) return NanThrowTypeError("invalid scope");
+    if (that->pending) return NanThrowError("async operation pending");
+    if (that->wrapped->IsClosed()) return NanThrowError("writer closed");
+
+    NanAsyncQueueWorker(new Worker(new NanCallback(callback), args.This()));
+
+    NanReturnValue(args.This());
+}
+
+
+// Init
+
+
+void XlsxStreamWriter::Initialize(Handle<Object> exports) {
+    NanScope();
+
+    Local<FunctionTemplate> t = NanNew<FunctionTemplate>(util::StubConstructor);
+    t->SetClassName(NanNew<String>("XlsxStreamWriter"));
+    t->InstanceTemplate()->SetInternalFieldCount(1);
+
+    NODE_SET_PROTOTYPE_METHOD(t, "writeRows", WriteRows);
+    NODE_SET_PROTOTYPE_METHOD(t, "nextSheet", NextSheet);
+    NODE_SET_PROTOTYPE_METHOD(t, "closeSync", CloseSync);
+    NODE_SET_PROTOTYPE_METHOD(t, "close", Close);
+
+    t->ReadOnlyPrototype();
+    NanAssignPersistent(constructor, t->GetFunction());
+}
+
+
+}
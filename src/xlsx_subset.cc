@@ -0,0 +1,206 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xlsx_subset.h"
+
+#include "sheet_name.h"
+#include "xml_tag.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const char* WORKSHEET_STUB =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<worksheet xmlns="
+    "\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+    "<sheetData/></worksheet>";
+
+
+std::string RelationshipsPath(const std::string& part) {
+    size_t slash = part.rfind('/');
+    size_t nameStart = slash == std::string::npos ? 0 : slash + 1;
+
+    return part.substr(0, nameStart) + "_rels/" + part.substr(nameStart) +
+        ".rels";
+}
+
+
+}
+
+
+XlsxSubset::XlsxSubset(ByteSource& source) :
+    source(source),
+    package(source),
+    rowLimit(-1)
+{}
+
+
+void XlsxSubset::SelectSheets(const std::vector<std::string>& names) {
+    selectedSheets = names;
+}
+
+
+void XlsxSubset::LimitRows(int rows) {
+    rowLimit = rows;
+}
+
+
+bool XlsxSubset::Run(std::string& out) {
+    out.clear();
+
+    if (!package.Open()) return Fail(package.ErrorMessage());
+
+    const std::vector<XlsxPackage::Sheet>& sheets = package.Sheets();
+    std::set<std::string> stubbed, truncated, dropped;
+
+    for (size_t i = 0; i < selectedSheets.size(); i++) {
+        size_t j = 0;
+
+        while (j < sheets.size() &&
+            !SheetNamesEqual(sheets[j].name, selectedSheets[i]))
+        {
+            j++;
+        }
+
+        if (j == sheets.size()) {
+            return Fail("unknown sheet " + selectedSheets[i]);
+        }
+    }
+
+    for (size_t i = 0; i < sheets.size(); i++) {
+        if (sheets[i].type != "worksheet" || sheets[i].path.empty()) continue;
+
+        bool selected = selectedSheets.empty();
+
+        for (size_t j = 0; j < selectedSheets.size() && !selected; j++) {
+            selected = SheetNamesEqual(sheets[i].name, selectedSheets[j]);
+        }
+
+        if (selected) {
+            if (rowLimit >= 0) truncated.insert(sheets[i].path);
+        } else {
+            // The relationships of a stub point to nothing it uses, and
+            // parts like comments would otherwise still be loaded
+            stubbed.insert(sheets[i].path);
+            dropped.insert(RelationshipsPath(sheets[i].path));
+        }
+    }
+
+    ZipReader& zip = package.Zip();
+    const std::vector<ZipReader::Entry>& entries = zip.Entries();
+    ZipWriter writer(out);
+    std::string raw;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const ZipReader::Entry& entry = entries[i];
+
+        if (dropped.count(entry.name)) continue;
+
+        if (stubbed.count(entry.name)) {
+            if (!writer.Add(entry.name, WORKSHEET_STUB)) {
+                return Fail(writer.ErrorMessage());
+            }
+        } else if (truncated.count(entry.name)) {
+            if (!Truncate(entry, writer)) return false;
+        } else {
+            if (!zip.ReadRaw(entry, raw)) return Fail(zip.ErrorMessage());
+            if (!writer.AddRaw(entry, raw)) return Fail(writer.ErrorMessage());
+        }
+    }
+
+    if (!writer.Finish()) return Fail(writer.ErrorMessage());
+
+    return true;
+}
+
+
+const std::string& XlsxSubset::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+// Inflates a worksheet only up to the start tag of the first row behind the
+// limit, and closes the cell data there. Elements following the cell data
+// (merged cells, hyperlinks, drawings...) are dropped along with the rows.
+bool XlsxSubset::Truncate(const ZipReader::Entry& entry, ZipWriter& writer) {
+    ZipReader& zip = package.Zip();
+    ZipReader::EntryReader reader(zip, entry);
+    std::string xml, chunk;
+    XmlTag tag;
+    size_t pos = 0;
+    int rows = 0;
+
+    while (reader.Next(chunk)) {
+        xml += chunk;
+
+        size_t scanned = pos;
+
+        while (tag.Find(xml, pos, "row")) {
+            scanned = pos;
+
+            if (rows++ < rowLimit) continue;
+
+            // Reuse the namespace prefix of the row element
+            std::string prefix = tag.name.substr(0, tag.name.size() - 3);
+
+            xml.resize(tag.begin);
+            xml += "</" + prefix + "sheetData></" + prefix + "worksheet>";
+
+            if (!writer.Add(entry.name, xml)) {
+                return Fail(writer.ErrorMessage());
+            }
+
+            return true;
+        }
+
+        // A tag cut off by the end of the chunk is scanned again with the
+        // next one
+        size_t lastTag = xml.rfind('<');
+        pos = lastTag != std::string::npos && lastTag > scanned ?
+            lastTag : scanned;
+    }
+
+    if (reader.Failed()) return Fail(zip.ErrorMessage());
+
+    // The sheet has no more rows than the limit and is copied as is
+    std::string raw;
+
+    if (!zip.ReadRaw(entry, raw)) return Fail(zip.ErrorMessage());
+    if (!writer.AddRaw(entry, raw)) return Fail(writer.ErrorMessage());
+
+    return true;
+}
+
+
+bool XlsxSubset::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return false;
+}
+
+
+}
@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XLSX_SUBSET_H
+#define BINDINGS_XLSX_SUBSET_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "byte_source.h"
+#include "xlsx_package.h"
+#include "zip_writer.h"
+
+namespace node_libxl {
+
+
+// Repackages an XLSX file so that libxl only has to parse part of it.
+// Worksheets that were not selected are replaced by empty stubs (they keep
+// their names and positions in the book), and the cell data of selected
+// worksheets can be cut off after a number of rows.
+class XlsxSubset {
+    public:
+
+        explicit XlsxSubset(ByteSource& source);
+
+        // Sheet names are matched case-insensitively; all sheets are kept
+        // if none are selected
+        void SelectSheets(const std::vector<std::string>& names);
+
+        // A negative limit keeps all rows
+        void LimitRows(int rows);
+
+        bool Run(std::string& out);
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        bool Truncate(const ZipReader::Entry& entry, ZipWriter& writer);
+
+        bool Fail(const std::string& message);
+
+        ByteSource& source;
+        XlsxPackage package;
+        std::vector<std::string> selectedSheets;
+        int rowLimit;
+        std::string errorMessage;
+
+        XlsxSubset(const XlsxSubset&);
+        const XlsxSubset& operator=(const XlsxSubset&);
+};
+
+
+}
+
+#endif // BINDINGS_XLSX_SUBSET_H
@@ -0,0 +1,831 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xlsx_writer.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <libxl.h>
+
+#include "cell_reference.h"
+#include "sheet_name.h"
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const size_t CHUNK_SIZE = 256 * 1024;
+const size_t MAX_PENDING_JOBS = 8;
+
+const int MAX_ROWS = 1048576;
+const int MAX_COL = 16383;
+
+// Bounds the memory used for reusing shared strings
+const size_t MAX_CACHED_STRINGS = 65536;
+const size_t MAX_CACHED_STRING_LENGTH = 64;
+
+const int FIRST_CUSTOM_NUM_FORMAT = 164;
+
+const char* MAIN_NAMESPACE =
+    "http://schemas.openxmlformats.org/spreadsheetml/2006/main";
+const char* RELATIONSHIPS_NAMESPACE =
+    "http://schemas.openxmlformats.org/officeDocument/2006/relationships";
+const char* PACKAGE_RELATIONSHIPS_NAMESPACE =
+    "http://schemas.openxmlformats.org/package/2006/relationships";
+const char* XML_DECLARATION =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+
+
+// Escapes text for element content and attribute values. Control
+// characters, which XML cannot represent, are encoded like _x0001_.
+void AppendEscaped(std::string& out, const std::string& text) {
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+
+        switch (c) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default:
+                if (c < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "_x%04X_", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+}
+
+
+std::string Escape(const std::string& text) {
+    std::string out;
+    AppendEscaped(out, text);
+
+    return out;
+}
+
+
+void AppendInt(std::string& out, int value) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%d", value);
+    out += buffer;
+}
+
+
+// Uses the shortest representation that reads back to the same value
+void AppendNumber(std::string& out, double value) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.15g", value);
+
+    if (strtod(buffer, NULL) != value) {
+        snprintf(buffer, sizeof(buffer), "%.17g", value);
+    }
+
+    out += buffer;
+}
+
+
+std::string SheetPart(int index) {
+    std::string part = "xl/worksheets/sheet";
+    AppendInt(part, index + 1);
+
+    return part + ".xml";
+}
+
+
+const char* HorizontalAlignment(int alignH) {
+    static const char* names[] = {
+        "general", "left", "center", "right", "fill", "justify",
+        "centerContinuous", "distributed"
+    };
+
+    return alignH > 0 && alignH < 8 ? names[alignH] : NULL;
+}
+
+
+// Bottom is the default
+const char* VerticalAlignment(int alignV) {
+    static const char* names[] = {
+        "top", "center", "bottom", "justify", "distributed"
+    };
+
+    return alignV >= 0 && alignV < 5 && alignV != 2 ? names[alignV] : NULL;
+}
+
+
+const char* UnderlineStyle(int underline) {
+    switch (underline) {
+        case libxl::UNDERLINE_SINGLE: return "single";
+        case libxl::UNDERLINE_DOUBLE: return "double";
+        case libxl::UNDERLINE_SINGLEACC: return "singleAccounting";
+        case libxl::UNDERLINE_DOUBLEACC: return "doubleAccounting";
+        default: return NULL;
+    }
+}
+
+
+// The libxl color constants are indices into the legacy palette, which
+// XLSX supports as indexed colors
+bool IsIndexedColor(int color) {
+    return color >= 0 && color < libxl::COLOR_DEFAULT_FOREGROUND;
+}
+
+
+}
+
+
+XlsxWriter::CellStyle::CellStyle() :
+    numFormatId(0),
+    fontSize(0),
+    fontColor(libxl::COLOR_AUTO),
+    underline(libxl::UNDERLINE_NONE),
+    bold(false),
+    italic(false),
+    alignH(libxl::ALIGNH_GENERAL),
+    alignV(libxl::ALIGNV_BOTTOM),
+    wrap(false),
+    fillColor(-1)
+{}
+
+
+XlsxWriter::XlsxWriter(const std::string& path,
+        const std::vector<std::string>& sheets,
+        const std::vector<CellStyle>& styles,
+        const std::vector<int>& columnStyles) :
+    path(path),
+    stringsPath(path + ".strings.tmp"),
+    sheets(sheets),
+    styles(styles),
+    columnStyles(columnStyles),
+    sheetIndex(0),
+    rowCount(0),
+    opened(false),
+    closed(false),
+    failed(false),
+    stringCount(0),
+    uniqueStringCount(0),
+    threadFailed(false),
+    zip(output)
+{
+    uv_mutex_init(&mutex);
+    uv_cond_init(&jobAdded);
+    uv_cond_init(&jobTaken);
+}
+
+
+XlsxWriter::~XlsxWriter() {
+    // An unfinished file is useless and removed
+    if (opened && !closed) {
+        std::string none;
+        Push(Job::FINISH, none);
+        uv_thread_join(&thread);
+
+        strings.close();
+        remove(stringsPath.c_str());
+        remove(path.c_str());
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++) delete jobs[i];
+
+    uv_cond_destroy(&jobTaken);
+    uv_cond_destroy(&jobAdded);
+    uv_mutex_destroy(&mutex);
+}
+
+
+bool XlsxWriter::Open() {
+    if (sheets.empty()) return Fail("at least one sheet is required");
+
+    for (size_t i = 0; i < sheets.size(); i++) {
+        if (sheets[i].empty() || sheets[i].size() > 31 ||
+            sheets[i].find_first_of("[]:*?/\\") != std::string::npos)
+        {
+            return Fail("invalid sheet name " + sheets[i]);
+        }
+
+        for (size_t j = 0; j < i; j++) {
+            if (SheetNamesEqual(sheets[i], sheets[j])) {
+                return Fail("duplicate sheet name " + sheets[i]);
+            }
+        }
+    }
+
+    file.open(path.c_str(), std::ios::out | std::ios::binary |
+        std::ios::trunc);
+    strings.open(stringsPath.c_str(), std::ios::out | std::ios::binary |
+        std::ios::trunc);
+
+    if (!file || !strings) {
+        file.close();
+        strings.close();
+        remove(stringsPath.c_str());
+
+        return Fail("unable to write " + path);
+    }
+
+    uv_thread_create(&thread, ThreadMain, this);
+    opened = true;
+
+    return BeginPart(SheetPart(0));
+}
+
+
+bool XlsxWriter::BeginRow() {
+    if (failed || closed) return false;
+    if (rowCount >= MAX_ROWS) return Fail("too many rows");
+
+    chunk += "<row r=\"";
+    AppendInt(chunk, rowCount + 1);
+    chunk += "\">";
+
+    return true;
+}
+
+
+void XlsxWriter::AddNumber(int col, double value) {
+    // Infinity and NaN cannot be stored
+    if (value - value != 0) return;
+
+    BeginCell(col, NULL);
+    chunk += "<v>";
+    AppendNumber(chunk, value);
+    chunk += "</v></c>";
+}
+
+
+void XlsxWriter::AddString(int col, const std::string& value) {
+    std::map<std::string, int>::iterator cached = stringIndex.find(value);
+    int index;
+
+    if (cached != stringIndex.end()) {
+        index = cached->second;
+    } else {
+        index = uniqueStringCount++;
+
+        std::string item = "<si><t xml:space=\"preserve\">";
+        AppendEscaped(item, value);
+        item += "</t></si>";
+        strings.write(item.data(), item.size());
+
+        if (stringIndex.size() < MAX_CACHED_STRINGS &&
+            value.size() <= MAX_CACHED_STRING_LENGTH)
+        {
+            stringIndex[value] = index;
+        }
+    }
+
+    stringCount++;
+
+    BeginCell(col, "s");
+    chunk += "<v>";
+    AppendInt(chunk, index);
+    chunk += "</v></c>";
+}
+
+
+void XlsxWriter::AddBoolean(int col, bool value) {
+    BeginCell(col, "b");
+    chunk += value ? "<v>1</v></c>" : "<v>0</v></c>";
+}
+
+
+bool XlsxWriter::EndRow() {
+    chunk += "</row>";
+    rowCount++;
+
+    if (!strings) return Fail("unable to write " + stringsPath);
+
+    return chunk.size() < CHUNK_SIZE || Flush();
+}
+
+
+bool XlsxWriter::NextSheet() {
+    if (failed || closed) return false;
+
+    if (sheetIndex + 1 >= static_cast<int>(sheets.size())) {
+        return Fail("no more sheets");
+    }
+
+    if (!FinishSheet()) return false;
+
+    sheetIndex++;
+    rowCount = 0;
+
+    return BeginPart(SheetPart(sheetIndex));
+}
+
+
+bool XlsxWriter::Close() {
+    if (closed) return !failed;
+    if (!opened) return Fail("not open");
+
+    bool success = FinishSheet();
+
+    // Sheets that were never started are written empty
+    while (success && sheetIndex + 1 < static_cast<int>(sheets.size())) {
+        sheetIndex++;
+        success = BeginPart(SheetPart(sheetIndex)) && FinishSheet();
+    }
+
+    strings.close();
+
+    if (success) {
+        success = BeginPart("xl/sharedStrings.xml");
+
+        chunk += "<sst xmlns=\"";
+        chunk += MAIN_NAMESPACE;
+        chunk += "\" count=\"";
+        AppendInt(chunk, stringCount);
+        chunk += "\" uniqueCount=\"";
+        AppendInt(chunk, uniqueStringCount);
+        chunk += "\">";
+
+        std::ifstream spool(stringsPath.c_str(), std::ios::in |
+            std::ios::binary);
+        std::vector<char> buffer(CHUNK_SIZE);
+
+        while (success && spool) {
+            spool.read(&buffer[0], buffer.size());
+            chunk.append(&buffer[0], spool.gcount());
+            success = Flush();
+        }
+
+        if (success && spool.bad()) {
+            success = Fail("unable to read " + stringsPath);
+        }
+
+        chunk += "</sst>";
+        success = success && EndPart();
+    }
+
+    remove(stringsPath.c_str());
+
+    if (success) {
+        std::string workbook = XML_DECLARATION,
+            relationships = XML_DECLARATION,
+            contentTypes = XML_DECLARATION;
+
+        workbook += "<workbook xmlns=\"";
+        workbook += MAIN_NAMESPACE;
+        workbook += "\" xmlns:r=\"";
+        workbook += RELATIONSHIPS_NAMESPACE;
+        workbook += "\"><sheets>";
+
+        relationships += "<Relationships xmlns=\"";
+        relationships += PACKAGE_RELATIONSHIPS_NAMESPACE;
+        relationships += "\">";
+
+        contentTypes +=
+            "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/"
+            "content-types\"><Default Extension=\"rels\" ContentType=\""
+            "application/vnd.openxmlformats-package.relationships+xml\"/>"
+            "<Default Extension=\"xml\" ContentType=\"application/xml\"/>"
+            "<Override PartName=\"/xl/workbook.xml\" ContentType=\""
+            "application/vnd.openxmlformats-officedocument.spreadsheetml."
+            "sheet.main+xml\"/><Override PartName=\"/xl/styles.xml\" "
+            "ContentType=\"application/vnd.openxmlformats-officedocument."
+            "spreadsheetml.styles+xml\"/><Override PartName=\""
+            "/xl/sharedStrings.xml\" ContentType=\"application/"
+            "vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings"
+            "+xml\"/>";
+
+        for (size_t i = 0; i < sheets.size(); i++) {
+            std::string id = "rId";
+            AppendInt(id, i + 1);
+
+            workbook += "<sheet name=\"" + Escape(sheets[i]) +
+                "\" sheetId=\"";
+            AppendInt(workbook, i + 1);
+            workbook += "\" r:id=\"" + id + "\"/>";
+
+            relationships += "<Relationship Id=\"" + id + "\" Type=\"";
+            relationships += RELATIONSHIPS_NAMESPACE;
+            relationships += "/worksheet\" Target=\"worksheets/sheet";
+            AppendInt(relationships, i + 1);
+            relationships += ".xml\"/>";
+
+            contentTypes += "<Override PartName=\"/" + SheetPart(i) +
+                "\" ContentType=\"application/vnd.openxmlformats-"
+                "officedocument.spreadsheetml.worksheet+xml\"/>";
+        }
+
+        workbook += "</sheets></workbook>";
+
+        relationships += "<Relationship Id=\"rIdStyles\" Type=\"";
+        relationships += RELATIONSHIPS_NAMESPACE;
+        relationships += "/styles\" Target=\"styles.xml\"/>"
+            "<Relationship Id=\"rIdStrings\" Type=\"";
+        relationships += RELATIONSHIPS_NAMESPACE;
+        relationships += "/sharedStrings\" Target=\"sharedStrings.xml\"/>"
+            "</Relationships>";
+
+        contentTypes += "</Types>";
+
+        std::string packageRelationships = XML_DECLARATION;
+        packageRelationships += "<Relationships xmlns=\"";
+        packageRelationships += PACKAGE_RELATIONSHIPS_NAMESPACE;
+        packageRelationships += "\"><Relationship Id=\"rId1\" Type=\"";
+        packageRelationships += RELATIONSHIPS_NAMESPACE;
+        packageRelationships += "/officeDocument\" "
+            "Target=\"xl/workbook.xml\"/></Relationships>";
+
+        success = AddPart("xl/styles.xml", StyleSheet()) &&
+            AddPart("xl/workbook.xml", workbook) &&
+            AddPart("xl/_rels/workbook.xml.rels", relationships) &&
+            AddPart("[Content_Types].xml", contentTypes) &&
+            AddPart("_rels/.rels", packageRelationships);
+    }
+
+    std::string none;
+    Push(Job::FINISH, none);
+    uv_thread_join(&thread);
+
+    closed = true;
+
+    uv_mutex_lock(&mutex);
+    failed = failed || threadFailed;
+    uv_mutex_unlock(&mutex);
+
+    if (failed) remove(path.c_str());
+
+    return !failed;
+}
+
+
+bool XlsxWriter::IsClosed() const {
+    return closed;
+}
+
+
+int XlsxWriter::SheetIndex() const {
+    return sheetIndex;
+}
+
+
+int XlsxWriter::RowCount() const {
+    return rowCount;
+}
+
+
+std::string XlsxWriter::ErrorMessage() {
+    uv_mutex_lock(&mutex);
+    std::string message = errorMessage;
+    uv_mutex_unlock(&mutex);
+
+    return message;
+}
+
+
+void XlsxWriter::ThreadMain(void* writer) {
+    static_cast<XlsxWriter*>(writer)->Work();
+}
+
+
+// Runs on the background thread, which owns the zip writer and the file.
+// After a failure the remaining jobs are discarded.
+void XlsxWriter::Work() {
+    bool finished = false;
+
+    while (!finished) {
+        uv_mutex_lock(&mutex);
+
+        while (jobs.empty()) uv_cond_wait(&jobAdded, &mutex);
+
+        Job* job = jobs.front();
+        jobs.pop_front();
+        bool skip = threadFailed;
+
+        uv_cond_signal(&jobTaken);
+        uv_mutex_unlock(&mutex);
+
+        std::string message;
+        finished = job->type == Job::FINISH;
+
+        if (!skip) {
+            bool success = true;
+
+            switch (job->type) {
+                case Job::BEGIN_ENTRY:
+                    success = zip.BeginEntry(job->data);
+                    break;
+                case Job::WRITE:
+                    success = zip.WriteEntry(job->data.data(),
+                        job->data.size());
+                    break;
+                case Job::END_ENTRY:
+                    success = zip.EndEntry();
+                    break;
+                case Job::FINISH:
+                    success = zip.Finish();
+                    break;
+            }
+
+            file.write(output.data(), output.size());
+            output.clear();
+
+            if (finished) file.close();
+
+            if (!success) {
+                message = zip.ErrorMessage();
+            } else if (file.fail()) {
+                message = "unable to write " + path;
+            }
+        }
+
+        delete job;
+
+        if (!message.empty()) {
+            uv_mutex_lock(&mutex);
+
+            threadFailed = true;
+            if (errorMessage.empty()) errorMessage = message;
+
+            uv_cond_broadcast(&jobTaken);
+            uv_mutex_unlock(&mutex);
+        }
+    }
+
+    if (file.is_open()) file.close();
+}
+
+
+void XlsxWriter::BeginCell(int col, const char* type) {
+    chunk += "<c r=\"";
+    CellReference::AppendColumn(chunk, col);
+    AppendInt(chunk, rowCount + 1);
+    chunk += '"';
+
+    if (col < static_cast<int>(columnStyles.size()) &&
+        columnStyles[col] >= 0)
+    {
+        chunk += " s=\"";
+        AppendInt(chunk, columnStyles[col] + 1);
+        chunk += '"';
+    }
+
+    if (type) {
+        chunk += " t=\"";
+        chunk += type;
+        chunk += '"';
+    }
+
+    chunk += '>';
+}
+
+
+// Every style gets its own font and fill; format 0 is the default
+std::string XlsxWriter::StyleSheet() const {
+    std::map<std::string, int> numFormatIds;
+    std::string numFormats, fonts, fills, formats;
+    int fillCount = 2;
+
+    for (size_t i = 0; i < styles.size(); i++) {
+        const CellStyle& style = styles[i];
+        int numFormatId = style.numFormatId;
+
+        if (numFormatId >= FIRST_CUSTOM_NUM_FORMAT) {
+            std::map<std::string, int>::iterator id =
+                numFormatIds.find(style.numFormatCode);
+
+            if (id != numFormatIds.end()) {
+                numFormatId = id->second;
+            } else {
+                numFormatId = FIRST_CUSTOM_NUM_FORMAT + numFormatIds.size();
+                numFormatIds[style.numFormatCode] = numFormatId;
+
+                numFormats += "<numFmt numFmtId=\"";
+                AppendInt(numFormats, numFormatId);
+                numFormats += "\" formatCode=\"" +
+                    Escape(style.numFormatCode) + "\"/>";
+            }
+        }
+
+        fonts += "<font>";
+        if (style.bold) fonts += "<b/>";
+        if (style.italic) fonts += "<i/>";
+
+        if (UnderlineStyle(style.underline)) {
+            fonts += "<u val=\"";
+            fonts += UnderlineStyle(style.underline);
+            fonts += "\"/>";
+        }
+
+        fonts += "<sz val=\"";
+        AppendInt(fonts, style.fontSize > 0 ? style.fontSize : 11);
+        fonts += "\"/>";
+
+        if (IsIndexedColor(style.fontColor)) {
+            fonts += "<color indexed=\"";
+            AppendInt(fonts, style.fontColor);
+            fonts += "\"/>";
+        }
+
+        fonts += "<name val=\"" + Escape(style.fontName.empty() ?
+            "Calibri" : style.fontName) + "\"/></font>";
+
+        int fillId = 0;
+
+        if (IsIndexedColor(style.fillColor)) {
+            fillId = fillCount++;
+
+            fills += "<fill><patternFill patternType=\"solid\">"
+                "<fgColor indexed=\"";
+            AppendInt(fills, style.fillColor);
+            fills += "\"/><bgColor indexed=\"64\"/></patternFill></fill>";
+        }
+
+        const char* horizontal = HorizontalAlignment(style.alignH);
+        const char* vertical = VerticalAlignment(style.alignV);
+        bool aligned = horizontal || vertical || style.wrap;
+
+        formats += "<xf numFmtId=\"";
+        AppendInt(formats, numFormatId);
+        formats += "\" fontId=\"";
+        AppendInt(formats, i + 1);
+        formats += "\" fillId=\"";
+        AppendInt(formats, fillId);
+        formats += "\" borderId=\"0\" xfId=\"0\" applyNumberFormat=\"1\" "
+            "applyFont=\"1\"";
+
+        if (fillId > 0) formats += " applyFill=\"1\"";
+
+        if (aligned) {
+            formats += " applyAlignment=\"1\"><alignment";
+
+            if (horizontal) {
+                formats += " horizontal=\"";
+                formats += horizontal;
+                formats += '"';
+            }
+
+            if (vertical) {
+                formats += " vertical=\"";
+                formats += vertical;
+                formats += '"';
+            }
+
+            if (style.wrap) formats += " wrapText=\"1\"";
+
+            formats += "/></xf>";
+        } else {
+            formats += "/>";
+        }
+    }
+
+    std::string xml = XML_DECLARATION;
+    xml += "<styleSheet xmlns=\"";
+    xml += MAIN_NAMESPACE;
+    xml += "\">";
+
+    if (!numFormatIds.empty()) {
+        xml += "<numFmts count=\"";
+        AppendInt(xml, numFormatIds.size());
+        xml += "\">" + numFormats + "</numFmts>";
+    }
+
+    xml += "<fonts count=\"";
+    AppendInt(xml, styles.size() + 1);
+    xml += "\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font>" +
+        fonts + "</fonts><fills count=\"";
+    AppendInt(xml, fillCount);
+    xml += "\"><fill><patternFill patternType=\"none\"/></fill>"
+        "<fill><patternFill patternType=\"gray125\"/></fill>" + fills +
+        "</fills><borders count=\"1\"><border><left/><right/><top/>"
+        "<bottom/><diagonal/></border></borders><cellStyleXfs count=\"1\">"
+        "<xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/>"
+        "</cellStyleXfs><cellXfs count=\"";
+    AppendInt(xml, styles.size() + 1);
+    xml += "\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" "
+        "xfId=\"0\"/>" + formats + "</cellXfs><cellStyles count=\"1\">"
+        "<cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/>"
+        "</cellStyles></styleSheet>";
+
+    return xml;
+}
+
+
+bool XlsxWriter::BeginPart(const std::string& name) {
+    std::string data = name;
+
+    if (!Push(Job::BEGIN_ENTRY, data)) return false;
+
+    chunk = XML_DECLARATION;
+
+    if (name.compare(0, 14, "xl/worksheets/") == 0) {
+        chunk += "<worksheet xmlns=\"";
+        chunk += MAIN_NAMESPACE;
+        chunk += "\" xmlns:r=\"";
+        chunk += RELATIONSHIPS_NAMESPACE;
+        chunk += "\"><sheetData>";
+    }
+
+    return true;
+}
+
+
+bool XlsxWriter::EndPart() {
+    std::string none;
+
+    return Flush() && Push(Job::END_ENTRY, none);
+}
+
+
+bool XlsxWriter::AddPart(const std::string& name, const std::string& content)
+{
+    std::string data = name;
+
+    if (!Push(Job::BEGIN_ENTRY, data)) return false;
+
+    chunk = content;
+
+    return EndPart();
+}
+
+
+bool XlsxWriter::Flush() {
+    if (chunk.empty()) return !failed;
+
+    return Push(Job::WRITE, chunk);
+}
+
+
+// Hands data over to the background thread (data is swapped out). Waits
+// while too many jobs are pending.
+bool XlsxWriter::Push(Job::Type type, std::string& data) {
+    if (failed && type != Job::FINISH) return false;
+
+    Job* job = new Job();
+    job->type = type;
+    job->data.swap(data);
+
+    uv_mutex_lock(&mutex);
+
+    while (type != Job::FINISH && !threadFailed &&
+        jobs.size() >= MAX_PENDING_JOBS)
+    {
+        uv_cond_wait(&jobTaken, &mutex);
+    }
+
+    bool accepted = type == Job::FINISH || !threadFailed;
+
+    if (accepted) {
+        jobs.push_back(job);
+        uv_cond_signal(&jobAdded);
+    }
+
+    uv_mutex_unlock(&mutex);
+
+    if (!accepted) {
+        delete job;
+        failed = true;
+    }
+
+    return accepted;
+}
+
+
+bool XlsxWriter::FinishSheet() {
+    chunk += "</sheetData></worksheet>";
+
+    return EndPart();
+}
+
+
+bool XlsxWriter::Fail(const std::string& message) {
+    uv_mutex_lock(&mutex);
+    if (errorMessage.empty()) errorMessage = message;
+    uv_mutex_unlock(&mutex);
+
+    failed = true;
+    return false;
+}
+
+
+}
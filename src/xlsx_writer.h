@@ -0,0 +1,157 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XLSX_WRITER_H
+#define BINDINGS_XLSX_WRITER_H
+
+#include <deque>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <uv.h>
+
+#include "zip_writer.h"
+
+namespace node_libxl {
+
+
+// Writes an XLSX file row by row without holding the book in memory. Sheet
+// XML is generated into chunks that a background thread deflates and writes
+// to disk; the number of chunks in flight is bounded, so the producer waits
+// if compression falls behind. Shared strings are spooled to a temporary
+// file next to the target and copied into the package on Close.
+class XlsxWriter {
+    public:
+
+        // The subset of format properties that can be applied to columns.
+        // Colors and enums use the values of libxl.
+        struct CellStyle {
+            CellStyle();
+
+            // Number formats with ids from 164 on are custom formats
+            int numFormatId;
+            std::string numFormatCode;
+
+            std::string fontName;
+            int fontSize, fontColor, underline;
+            bool bold, italic;
+
+            int alignH, alignV;
+            bool wrap;
+
+            // -1 if the cell is not filled
+            int fillColor;
+        };
+
+        // Column styles are indices into styles, -1 for unstyled columns
+        XlsxWriter(const std::string& path,
+            const std::vector<std::string>& sheets,
+            const std::vector<CellStyle>& styles,
+            const std::vector<int>& columnStyles);
+        ~XlsxWriter();
+
+        // Creates the files, starts the background thread and the first
+        // sheet
+        bool Open();
+
+        // Cells have to be added in ascending column order
+        bool BeginRow();
+        void AddNumber(int col, double value);
+        void AddString(int col, const std::string& value);
+        void AddBoolean(int col, bool value);
+        bool EndRow();
+
+        // Finishes the current sheet and starts the next one
+        bool NextSheet();
+
+        // Writes the remaining parts and waits for the background thread
+        bool Close();
+
+        bool IsClosed() const;
+
+        // Number of the current sheet and rows written to it
+        int SheetIndex() const;
+        int RowCount() const;
+
+        std::string ErrorMessage();
+
+    private:
+
+        struct Job {
+            enum Type {BEGIN_ENTRY, WRITE, END_ENTRY, FINISH};
+
+            Type type;
+            std::string data;
+        };
+
+        static void ThreadMain(void* writer);
+        void Work();
+
+        void BeginCell(int col, const char* type);
+        std::string StyleSheet() const;
+
+        bool BeginPart(const std::string& name);
+        bool EndPart();
+        bool AddPart(const std::string& name, const std::string& content);
+        bool Flush();
+        bool Push(Job::Type type, std::string& data);
+
+        bool FinishSheet();
+        bool Fail(const std::string& message);
+
+        std::string path, stringsPath;
+        std::vector<std::string> sheets;
+        std::vector<CellStyle> styles;
+        std::vector<int> columnStyles;
+
+        std::string chunk;
+        int sheetIndex, rowCount;
+        bool opened, closed, failed;
+
+        std::ofstream strings;
+        std::map<std::string, int> stringIndex;
+        int stringCount, uniqueStringCount;
+
+        // Shared with the background thread
+        uv_thread_t thread;
+        uv_mutex_t mutex;
+        uv_cond_t jobAdded, jobTaken;
+        std::deque<Job*> jobs;
+        bool threadFailed;
+        std::string errorMessage;
+
+        std::ofstream file;
+        std::string output;
+        ZipWriter zip;
+
+        XlsxWriter(const XlsxWriter&);
+        const XlsxWriter& operator=(const XlsxWriter&);
+};
+
+
+}
+
+#endif // BINDINGS_XLSX_WRITER_H
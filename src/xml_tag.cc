@@ -0,0 +1,222 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "xml_tag.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+bool IsNameEnd(char c) {
+    return isspace(static_cast<unsigned char>(c)) || c == '/' || c == '>' ||
+        c == '=';
+}
+
+
+std::string LocalName(const std::string& name) {
+    size_t colon = name.rfind(':');
+
+    return colon == std::string::npos ? name : name.substr(colon + 1);
+}
+
+
+void AppendUtf8(std::string& out, unsigned long code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+
+}
+
+
+XmlTag::XmlTag() :
+    begin(0),
+    end(0),
+    selfClosing(false)
+{}
+
+
+bool XmlTag::Find(const std::string& xml, size_t& pos, const char* localName)
+{
+    while ((pos = xml.find('<', pos)) != std::string::npos) {
+        size_t start = pos++;
+
+        if (pos >= xml.size()) return false;
+
+        // Skip end tags, comments, CDATA and processing instructions
+        if (xml.compare(start, 4, "<!--") == 0) {
+            pos = xml.find("-->", pos);
+            if (pos == std::string::npos) return false;
+            continue;
+        }
+
+        if (xml.compare(start, 9, "<![CDATA[") == 0) {
+            pos = xml.find("]]>", pos);
+            if (pos == std::string::npos) return false;
+            continue;
+        }
+
+        if (xml[pos] == '/' || xml[pos] == '?' || xml[pos] == '!') continue;
+
+        size_t nameEnd = pos;
+        while (nameEnd < xml.size() && !IsNameEnd(xml[nameEnd])) nameEnd++;
+
+        std::string qualifiedName = xml.substr(pos, nameEnd - pos);
+        if (LocalName(qualifiedName) != localName) continue;
+
+        name = qualifiedName;
+        attributes.clear();
+        selfClosing = false;
+        begin = start;
+        pos = nameEnd;
+
+        while (pos < xml.size()) {
+            char c = xml[pos];
+
+            if (c == '>') {
+                end = ++pos;
+                return true;
+            }
+
+            if (c == '/' || isspace(static_cast<unsigned char>(c))) {
+                selfClosing = c == '/';
+                pos++;
+                continue;
+            }
+
+            size_t attributeEnd = pos;
+            while (attributeEnd < xml.size() && !IsNameEnd(xml[attributeEnd]))
+            {
+                attributeEnd++;
+            }
+
+            std::string name = LocalName(xml.substr(pos, attributeEnd - pos));
+            pos = xml.find_first_of("\"'", attributeEnd);
+            if (pos == std::string::npos) return false;
+
+            size_t valueEnd = xml.find(xml[pos], pos + 1);
+            if (valueEnd == std::string::npos) return false;
+
+            attributes[name] = xml.substr(pos + 1, valueEnd - pos - 1);
+            pos = valueEnd + 1;
+            selfClosing = false;
+        }
+
+        return false;
+    }
+
+    return false;
+}
+
+
+bool XmlTag::HasAttribute(const char* localName) const {
+    return attributes.find(localName) != attributes.end();
+}
+
+
+std::string XmlTag::Attribute(const char* localName, const std::string& def)
+    const
+{
+    std::map<std::string, std::string>::const_iterator i =
+        attributes.find(localName);
+
+    return i == attributes.end() ? def : Decode(i->second);
+}
+
+
+std::string XmlTag::Decode(const std::string& text) {
+    if (text.find('&') == std::string::npos) return text;
+
+    static const char* entities[][2] = {
+        {"&amp;", "&"}, {"&lt;", "<"}, {"&gt;", ">"}, {"&quot;", "\""},
+        {"&apos;", "'"}
+    };
+
+    std::string out;
+
+    for (size_t pos = 0; pos < text.size();) {
+        if (text[pos] != '&') {
+            out += text[pos++];
+            continue;
+        }
+
+        bool decoded = false;
+
+        for (size_t i = 0; i < 5 && !decoded; i++) {
+            size_t length = strlen(entities[i][0]);
+
+            if (text.compare(pos, length, entities[i][0]) == 0) {
+                out += entities[i][1];
+                pos += length;
+                decoded = true;
+            }
+        }
+
+        size_t semicolon = text.find(';', pos);
+
+        if (!decoded && text.compare(pos, 2, "&#") == 0 &&
+            semicolon != std::string::npos)
+        {
+            bool hex = pos + 2 < text.size() &&
+                (text[pos + 2] == 'x' || text[pos + 2] == 'X');
+            std::string digits = text.substr(pos + (hex ? 3 : 2),
+                semicolon - pos - (hex ? 3 : 2));
+            char* digitsEnd;
+            unsigned long code = strtoul(digits.c_str(), &digitsEnd,
+                hex ? 16 : 10);
+
+            if (!digits.empty() && *digitsEnd == '\0' && code <= 0x10FFFF) {
+                AppendUtf8(out, code);
+                pos = semicolon + 1;
+                decoded = true;
+            }
+        }
+
+        if (!decoded) out += text[pos++];
+    }
+
+    return out;
+}
+
+
+}
@@ -0,0 +1,68 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_XML_TAG_H
+#define BINDINGS_XML_TAG_H
+
+#include <map>
+#include <string>
+
+namespace node_libxl {
+
+
+// A start tag located by scanning XML text. This is sufficient for the
+// well known parts of XLSX packages and avoids a full XML parser.
+class XmlTag {
+    public:
+
+        XmlTag();
+
+        // Finds the next start tag with the given local name (namespace
+        // prefixes are ignored) at or after pos and moves pos behind it
+        bool Find(const std::string& xml, size_t& pos, const char* localName);
+
+        // Looks up an attribute by its local name; entities are decoded
+        bool HasAttribute(const char* localName) const;
+        std::string Attribute(const char* localName,
+            const std::string& def = "") const;
+
+        // Qualified name as written, for locating the matching end tag
+        std::string name;
+
+        // Offsets of the opening '<' and behind the closing '>'
+        size_t begin, end;
+
+        bool selfClosing;
+
+        static std::string Decode(const std::string& text);
+
+    private:
+
+        std::map<std::string, std::string> attributes;
+};
+
+
+}
+
+#endif // BINDINGS_XML_TAG_H
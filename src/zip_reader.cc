@@ -0,0 +1,372 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "zip_reader.h"
+
+#include <cstring>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const uint32_t END_SIGNATURE = 0x06054b50;
+const uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+const uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+
+const size_t END_SIZE = 22;
+const size_t MAX_COMMENT_SIZE = 0xFFFF;
+const size_t LOCAL_HEADER_SIZE = 30;
+const size_t CENTRAL_HEADER_SIZE = 46;
+
+const int METHOD_STORED = 0;
+const int METHOD_DEFLATED = 8;
+
+const size_t CHUNK_SIZE = 64 * 1024;
+
+
+}
+
+
+ZipReader::EntryReader::EntryReader(ZipReader& zip, const Entry& entry) :
+    zip(zip),
+    entry(entry),
+    streamInitialized(false),
+    finished(false),
+    failed(false),
+    offset(0),
+    remaining(entry.compressedSize)
+{
+    memset(&stream, 0, sizeof(stream));
+
+    if (!zip.DataOffset(entry, offset)) {
+        failed = true;
+        return;
+    }
+
+    if (entry.method == METHOD_DEFLATED) {
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            Fail("unable to initialize zlib");
+            return;
+        }
+
+        streamInitialized = true;
+    } else if (entry.method != METHOD_STORED) {
+        Fail("unsupported compression method for " + entry.name);
+    }
+}
+
+
+ZipReader::EntryReader::~EntryReader() {
+    if (streamInitialized) inflateEnd(&stream);
+}
+
+
+bool ZipReader::EntryReader::Next(std::string& chunk) {
+    chunk.clear();
+    if (failed || finished) return false;
+
+    if (entry.method == METHOD_STORED) {
+        size_t length = remaining < CHUNK_SIZE ? remaining : CHUNK_SIZE;
+
+        if (length == 0) {
+            finished = true;
+            return false;
+        }
+
+        if (!zip.source.Read(offset, length, chunk) || chunk.size() != length) {
+            return Fail("truncated entry " + entry.name);
+        }
+
+        offset += length;
+        remaining -= length;
+
+        return true;
+    }
+
+    chunk.resize(CHUNK_SIZE);
+    stream.next_out = reinterpret_cast<Bytef*>(&chunk[0]);
+    stream.avail_out = CHUNK_SIZE;
+
+    while (stream.avail_out > 0) {
+        if (stream.avail_in == 0 && remaining > 0) {
+            size_t length = remaining < CHUNK_SIZE ? remaining : CHUNK_SIZE;
+
+            if (!zip.source.Read(offset, length, input) ||
+                input.size() != length)
+            {
+                return Fail("truncated entry " + entry.name);
+            }
+
+            offset += length;
+            remaining -= length;
+
+            stream.next_in = reinterpret_cast<Bytef*>(&input[0]);
+            stream.avail_in = length;
+        }
+
+        int status = inflate(&stream, Z_NO_FLUSH);
+
+        if (status == Z_STREAM_END) {
+            finished = true;
+            break;
+        }
+
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            return Fail("corrupt entry " + entry.name);
+        }
+
+        if (stream.avail_in == 0 && remaining == 0 && status == Z_BUF_ERROR) {
+            return Fail("truncated entry " + entry.name);
+        }
+    }
+
+    chunk.resize(CHUNK_SIZE - stream.avail_out);
+
+    return !chunk.empty() || !finished;
+}
+
+
+bool ZipReader::EntryReader::Failed() const {
+    return failed;
+}
+
+
+bool ZipReader::EntryReader::Fail(const std::string& message) {
+    if (!failed) zip.Fail(message);
+
+    failed = true;
+    return false;
+}
+
+
+ZipReader::ZipReader(ByteSource& source) :
+    source(source)
+{}
+
+
+bool ZipReader::Open() {
+    uint64_t size = source.Size();
+    if (size < END_SIZE) return Fail("not a zip file");
+
+    // The end of central directory record is followed by a comment of up
+    // to 64k
+    uint64_t tailOffset = size > END_SIZE + MAX_COMMENT_SIZE ?
+        size - END_SIZE - MAX_COMMENT_SIZE : 0;
+    std::string tail;
+
+    if (!source.Read(tailOffset, size - tailOffset, tail)) {
+        return Fail("unable to read zip directory");
+    }
+
+    size_t endPos = std::string::npos;
+
+    for (size_t i = tail.size() - END_SIZE + 1; i-- > 0;) {
+        if (ByteSource::Uint32(tail.data() + i) == END_SIGNATURE) {
+            endPos = i;
+            break;
+        }
+    }
+
+    if (endPos == std::string::npos) return Fail("not a zip file");
+
+    const char* end = tail.data() + endPos;
+    uint64_t entryCount = ByteSource::Uint16(end + 10),
+        directorySize = ByteSource::Uint32(end + 12),
+        directoryOffset = ByteSource::Uint32(end + 16);
+
+    if (directoryOffset == 0xFFFFFFFF || entryCount == 0xFFFF) {
+        std::string locator, end64;
+
+        if (endPos < 20 ||
+            ByteSource::Uint32(tail.data() + endPos - 20) !=
+                ZIP64_LOCATOR_SIGNATURE ||
+            !source.Read(ByteSource::Uint64(tail.data() + endPos - 12), 56,
+                end64) ||
+            end64.size() < 56 ||
+            ByteSource::Uint32(end64.data()) != ZIP64_END_SIGNATURE)
+        {
+            return Fail("invalid zip64 directory");
+        }
+
+        entryCount = ByteSource::Uint64(end64.data() + 32);
+        directorySize = ByteSource::Uint64(end64.data() + 40);
+        directoryOffset = ByteSource::Uint64(end64.data() + 48);
+    }
+
+    std::string directory;
+
+    if (directoryOffset + directorySize > size ||
+        !source.Read(directoryOffset, directorySize, directory) ||
+        directory.size() != directorySize)
+    {
+        return Fail("unable to read zip directory");
+    }
+
+    entries.clear();
+    index.clear();
+
+    size_t pos = 0;
+
+    for (uint64_t i = 0; i < entryCount; i++) {
+        const char* header = directory.data() + pos;
+
+        if (pos + CENTRAL_HEADER_SIZE > directory.size() ||
+            ByteSource::Uint32(header) != CENTRAL_HEADER_SIGNATURE)
+        {
+            return Fail("corrupt zip directory");
+        }
+
+        size_t nameLength = ByteSource::Uint16(header + 28),
+            extraLength = ByteSource::Uint16(header + 30),
+            commentLength = ByteSource::Uint16(header + 32);
+
+        if (pos + CENTRAL_HEADER_SIZE + nameLength + extraLength >
+            directory.size())
+        {
+            return Fail("corrupt zip directory");
+        }
+
+        Entry entry;
+        entry.flags = ByteSource::Uint16(header + 8);
+        entry.method = ByteSource::Uint16(header + 10);
+        entry.modifiedTime = ByteSource::Uint16(header + 12);
+        entry.modifiedDate = ByteSource::Uint16(header + 14);
+        entry.checksum = ByteSource::Uint32(header + 16);
+        entry.compressedSize = ByteSource::Uint32(header + 20);
+        entry.size = ByteSource::Uint32(header + 24);
+        entry.localHeaderOffset = ByteSource::Uint32(header + 42);
+        entry.name.assign(header + CENTRAL_HEADER_SIZE, nameLength);
+
+        // Sizes and offset that do not fit into 32 bits are stored in the
+        // zip64 extra field, in this order
+        const char* extra = header + CENTRAL_HEADER_SIZE + nameLength;
+
+        for (size_t j = 0; j + 4 <= extraLength;) {
+            size_t fieldSize = ByteSource::Uint16(extra + j + 2);
+
+            if (ByteSource::Uint16(extra + j) == 1) {
+                const char* field = extra + j + 4;
+                const char* fieldEnd = field + fieldSize;
+                uint64_t* values[] = {
+                    &entry.size, &entry.compressedSize, &entry.localHeaderOffset
+                };
+
+                for (int k = 0; k < 3; k++) {
+                    if (*values[k] == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                        *values[k] = ByteSource::Uint64(field);
+                        field += 8;
+                    }
+                }
+            }
+
+            j += 4 + fieldSize;
+        }
+
+        index[entry.name] = entries.size();
+        entries.push_back(entry);
+
+        pos += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+    }
+
+    return true;
+}
+
+
+const std::vector<ZipReader::Entry>& ZipReader::Entries() const {
+    return entries;
+}
+
+
+const ZipReader::Entry* ZipReader::Find(const std::string& name) const {
+    std::map<std::string, size_t>::const_iterator i = index.find(name);
+
+    return i == index.end() ? NULL : &entries[i->second];
+}
+
+
+bool ZipReader::Extract(const Entry& entry, std::string& out, size_t limit) {
+    EntryReader reader(*this, entry);
+    std::string chunk;
+
+    out.clear();
+
+    while (out.size() < limit && reader.Next(chunk)) {
+        out.append(chunk, 0, limit - out.size());
+    }
+
+    return !reader.Failed();
+}
+
+
+bool ZipReader::ReadRaw(const Entry& entry, std::string& out) {
+    uint64_t offset;
+    out.clear();
+
+    if (!DataOffset(entry, offset)) return false;
+
+    if (!source.Read(offset, entry.compressedSize, out) ||
+        out.size() != entry.compressedSize)
+    {
+        return Fail("truncated entry " + entry.name);
+    }
+
+    return true;
+}
+
+
+const std::string& ZipReader::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool ZipReader::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return false;
+}
+
+
+bool ZipReader::DataOffset(const Entry& entry, uint64_t& offset) {
+    std::string header;
+
+    if (!source.Read(entry.localHeaderOffset, LOCAL_HEADER_SIZE, header) ||
+        header.size() < LOCAL_HEADER_SIZE ||
+        ByteSource::Uint32(header.data()) != LOCAL_HEADER_SIGNATURE)
+    {
+        return Fail("invalid local header for " + entry.name);
+    }
+
+    offset = entry.localHeaderOffset + LOCAL_HEADER_SIZE +
+        ByteSource::Uint16(header.data() + 26) +
+        ByteSource::Uint16(header.data() + 28);
+
+    return true;
+}
+
+
+}
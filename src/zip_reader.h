@@ -0,0 +1,123 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_ZIP_READER_H
+#define BINDINGS_ZIP_READER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "byte_source.h"
+
+namespace node_libxl {
+
+
+// Reads the entries of a zip archive (like an XLSX package) through its
+// central directory. Only the parts of the archive that are actually
+// extracted are read from the source.
+class ZipReader {
+    public:
+
+        struct Entry {
+            std::string name;
+            int method;
+            uint16_t flags, modifiedTime, modifiedDate;
+            uint32_t checksum;
+            uint64_t compressedSize, size, localHeaderOffset;
+        };
+
+        // Decompresses an entry chunk by chunk
+        class EntryReader {
+            public:
+
+                EntryReader(ZipReader& zip, const Entry& entry);
+                ~EntryReader();
+
+                // Returns false at the end of the entry or on errors
+                bool Next(std::string& chunk);
+
+                bool Failed() const;
+
+            private:
+
+                bool Fail(const std::string& message);
+
+                ZipReader& zip;
+                const Entry& entry;
+                z_stream stream;
+                bool streamInitialized, finished, failed;
+                uint64_t offset, remaining;
+                std::string input;
+
+                EntryReader(const EntryReader&);
+                const EntryReader& operator=(const EntryReader&);
+        };
+
+        explicit ZipReader(ByteSource& source);
+
+        // Reads the central directory
+        bool Open();
+
+        const std::vector<Entry>& Entries() const;
+
+        // Returns NULL for missing entries
+        const Entry* Find(const std::string& name) const;
+
+        // Decompresses an entry, stopping once limit bytes are extracted
+        bool Extract(const Entry& entry, std::string& out,
+            size_t limit = std::string::npos);
+
+        // Reads the data of an entry as stored in the archive, without
+        // decompressing it
+        bool ReadRaw(const Entry& entry, std::string& out);
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        friend class EntryReader;
+
+        bool Fail(const std::string& message);
+
+        // Locates the data behind the local header of an entry
+        bool DataOffset(const Entry& entry, uint64_t& offset);
+
+        ByteSource& source;
+        std::vector<Entry> entries;
+        std::map<std::string, size_t> index;
+        std::string errorMessage;
+
+        ZipReader(const ZipReader&);
+        const ZipReader& operator=(const ZipReader&);
+};
+
+
+}
+
+#endif // BINDINGS_ZIP_READER_H
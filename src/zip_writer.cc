@@ -0,0 +1,366 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "zip_writer.h"
+
+#include <cstring>
+
+#include <zlib.h>
+
+namespace node_libxl {
+
+
+namespace {
+
+
+const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const uint32_t END_SIGNATURE = 0x06054b50;
+const uint32_t DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+
+const uint16_t VERSION = 20;
+const uint16_t METHOD_DEFLATED = 8;
+
+// Copied entries are written with their sizes in the local header, so the
+// data descriptor flag is only set for streamed entries
+const uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
+
+const size_t CHUNK_SIZE = 16 * 1024;
+
+// 1980-01-01 00:00 in DOS format
+const uint16_t DEFAULT_TIME = 0;
+const uint16_t DEFAULT_DATE = 0x0021;
+
+const uint64_t MAX_SIZE = 0xFFFFFFFF;
+
+
+void AppendUint16(std::string& out, uint16_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>(value >> 8);
+}
+
+
+void AppendUint32(std::string& out, uint32_t value) {
+    AppendUint16(out, value & 0xFFFF);
+    AppendUint16(out, value >> 16);
+}
+
+
+}
+
+
+ZipWriter::ZipWriter(std::string& out) :
+    out(out),
+    offset(0),
+    streaming(false),
+    compressedSize(0),
+    size(0)
+{
+    memset(&stream, 0, sizeof(stream));
+}
+
+
+ZipWriter::~ZipWriter() {
+    if (streaming) deflateEnd(&stream);
+}
+
+
+bool ZipWriter::Add(const std::string& name, const std::string& data) {
+    if (data.size() > MAX_SIZE) return Fail("entry too large: " + name);
+
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+        8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return Fail("unable to initialize zlib");
+    }
+
+    std::string compressed(deflateBound(&stream, data.size()), '\0');
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    stream.avail_out = compressed.size();
+
+    int status = deflate(&stream, Z_FINISH);
+    compressed.resize(compressed.size() - stream.avail_out);
+    deflateEnd(&stream);
+
+    if (status != Z_STREAM_END) return Fail("unable to compress " + name);
+
+    Entry entry;
+    entry.name = name;
+    entry.flags = 0;
+    entry.method = METHOD_DEFLATED;
+    entry.modifiedTime = DEFAULT_TIME;
+    entry.modifiedDate = DEFAULT_DATE;
+    entry.checksum = crc32(crc32(0, Z_NULL, 0),
+        reinterpret_cast<const Bytef*>(data.data()), data.size());
+    entry.size = data.size();
+
+    return Append(entry, compressed);
+}
+
+
+bool ZipWriter::AddRaw(const ZipReader::Entry& source, const std::string& raw)
+{
+    if (source.size > MAX_SIZE || raw.size() > MAX_SIZE) {
+        return Fail("entry too large: " + source.name);
+    }
+
+    Entry entry;
+    entry.name = source.name;
+    entry.flags = source.flags & ~FLAG_DATA_DESCRIPTOR;
+    entry.method = source.method;
+    entry.modifiedTime = source.modifiedTime;
+    entry.modifiedDate = source.modifiedDate;
+    entry.checksum = source.checksum;
+    entry.size = source.size;
+
+    return Append(entry, raw);
+}
+
+
+bool ZipWriter::Finish() {
+    if (!errorMessage.empty()) return false;
+    if (streaming) return Fail("unfinished entry " + current.name);
+
+    uint64_t directoryOffset = offset;
+    size_t directoryStart = out.size();
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+
+        AppendUint32(out, CENTRAL_HEADER_SIGNATURE);
+        AppendUint16(out, VERSION);
+        AppendUint16(out, VERSION);
+        AppendUint16(out, entry.flags);
+        AppendUint16(out, entry.method);
+        AppendUint16(out, entry.modifiedTime);
+        AppendUint16(out, entry.modifiedDate);
+        AppendUint32(out, entry.checksum);
+        AppendUint32(out, entry.compressedSize);
+        AppendUint32(out, entry.size);
+        AppendUint16(out, entry.name.size());
+        AppendUint16(out, 0);
+        AppendUint16(out, 0);
+        AppendUint16(out, 0);
+        AppendUint16(out, 0);
+        AppendUint32(out, 0);
+        AppendUint32(out, entry.localHeaderOffset);
+        out += entry.name;
+    }
+
+    uint64_t directorySize = out.size() - directoryStart;
+
+    if (entries.size() > 0xFFFF || directoryOffset > MAX_SIZE ||
+        directorySize > MAX_SIZE)
+    {
+        return Fail("archive too large");
+    }
+
+    AppendUint32(out, END_SIGNATURE);
+    AppendUint16(out, 0);
+    AppendUint16(out, 0);
+    AppendUint16(out, entries.size());
+    AppendUint16(out, entries.size());
+    AppendUint32(out, directorySize);
+    AppendUint32(out, directoryOffset);
+    AppendUint16(out, 0);
+
+    offset += out.size() - directoryStart;
+
+    return true;
+}
+
+
+const std::string& ZipWriter::ErrorMessage() const {
+    return errorMessage;
+}
+
+
+bool ZipWriter::BeginEntry(const std::string& name) {
+    if (!errorMessage.empty()) return false;
+    if (streaming) return Fail("unfinished entry " + current.name);
+
+    if (offset > MAX_SIZE || name.size() > 0xFFFF) {
+        return Fail("archive too large");
+    }
+
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+        8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return Fail("unable to initialize zlib");
+    }
+
+    streaming = true;
+    compressedSize = 0;
+    size = 0;
+
+    current.name = name;
+    current.flags = FLAG_DATA_DESCRIPTOR;
+    current.method = METHOD_DEFLATED;
+    current.modifiedTime = DEFAULT_TIME;
+    current.modifiedDate = DEFAULT_DATE;
+    current.checksum = crc32(0, Z_NULL, 0);
+    current.compressedSize = 0;
+    current.size = 0;
+    current.localHeaderOffset = offset;
+
+    AppendLocalHeader(current);
+
+    return true;
+}
+
+
+bool ZipWriter::WriteEntry(const char* data, size_t length) {
+    if (!errorMessage.empty()) return false;
+    if (!streaming) return Fail("no entry started");
+
+    current.checksum = crc32(current.checksum,
+        reinterpret_cast<const Bytef*>(data), length);
+    size += length;
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = length;
+
+    return Deflate(Z_NO_FLUSH);
+}
+
+
+bool ZipWriter::EndEntry() {
+    if (!errorMessage.empty()) return false;
+    if (!streaming) return Fail("no entry started");
+
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+
+    bool finished = Deflate(Z_FINISH);
+
+    deflateEnd(&stream);
+    streaming = false;
+
+    if (!finished) return false;
+
+    if (size > MAX_SIZE || compressedSize > MAX_SIZE) {
+        return Fail("entry too large: " + current.name);
+    }
+
+    current.size = size;
+    current.compressedSize = compressedSize;
+
+    size_t start = out.size();
+
+    AppendUint32(out, DATA_DESCRIPTOR_SIGNATURE);
+    AppendUint32(out, current.checksum);
+    AppendUint32(out, current.compressedSize);
+    AppendUint32(out, current.size);
+
+    offset += out.size() - start;
+    entries.push_back(current);
+
+    return true;
+}
+
+
+bool ZipWriter::Append(const Entry& source, const std::string& raw) {
+    if (!errorMessage.empty()) return false;
+    if (streaming) return Fail("unfinished entry " + current.name);
+
+    if (offset > MAX_SIZE || raw.size() > MAX_SIZE ||
+        source.name.size() > 0xFFFF)
+    {
+        return Fail("archive too large");
+    }
+
+    Entry entry = source;
+    entry.compressedSize = raw.size();
+    entry.localHeaderOffset = offset;
+
+    AppendLocalHeader(entry);
+    out += raw;
+    offset += raw.size();
+
+    entries.push_back(entry);
+
+    return true;
+}
+
+
+void ZipWriter::AppendLocalHeader(const Entry& entry) {
+    size_t start = out.size();
+
+    AppendUint32(out, LOCAL_HEADER_SIGNATURE);
+    AppendUint16(out, VERSION);
+    AppendUint16(out, entry.flags);
+    AppendUint16(out, entry.method);
+    AppendUint16(out, entry.modifiedTime);
+    AppendUint16(out, entry.modifiedDate);
+    AppendUint32(out, entry.checksum);
+    AppendUint32(out, entry.compressedSize);
+    AppendUint32(out, entry.size);
+    AppendUint16(out, entry.name.size());
+    AppendUint16(out, 0);
+    out += entry.name;
+
+    offset += out.size() - start;
+}
+
+
+bool ZipWriter::Deflate(int flush) {
+    char buffer[CHUNK_SIZE];
+
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = CHUNK_SIZE;
+
+        int status = deflate(&stream, flush);
+
+        if (status == Z_STREAM_ERROR) {
+            return Fail("unable to compress " + current.name);
+        }
+
+        size_t length = CHUNK_SIZE - stream.avail_out;
+
+        out.append(buffer, length);
+        offset += length;
+        compressedSize += length;
+    } while (stream.avail_out == 0);
+
+    return true;
+}
+
+
+bool ZipWriter::Fail(const std::string& message) {
+    if (errorMessage.empty()) errorMessage = message;
+
+    return false;
+}
+
+
+}
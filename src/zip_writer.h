@@ -0,0 +1,106 @@
+/**
+ * The MIT License (MIT)
+ * 
+ * Copyright (c) 2013 Christian Speckner <cnspeckn@googlemail.com>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef BINDINGS_ZIP_WRITER_H
+#define BINDINGS_ZIP_WRITER_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+#include "zip_reader.h"
+
+namespace node_libxl {
+
+
+// Writes a zip archive into memory. Entries can be copied from another
+// archive without recompressing them, or be deflated piece by piece. The
+// output may be drained from out between calls in order to write large
+// archives to disk. Archives that need zip64 extensions are not supported.
+class ZipWriter {
+    public:
+
+        explicit ZipWriter(std::string& out);
+        ~ZipWriter();
+
+        // Deflates data into a new entry
+        bool Add(const std::string& name, const std::string& data);
+
+        // Adds an entry from the raw (still compressed) data of an entry
+        // read by ZipReader
+        bool AddRaw(const ZipReader::Entry& entry, const std::string& raw);
+
+        // Streams an entry of unknown size; its sizes and checksum follow
+        // the data in a data descriptor
+        bool BeginEntry(const std::string& name);
+        bool WriteEntry(const char* data, size_t size);
+        bool EndEntry();
+
+        // Writes the central directory
+        bool Finish();
+
+        const std::string& ErrorMessage() const;
+
+    private:
+
+        struct Entry {
+            std::string name;
+            uint16_t flags, method, modifiedTime, modifiedDate;
+            uint32_t checksum, compressedSize, size, localHeaderOffset;
+        };
+
+        bool Append(const Entry& entry, const std::string& raw);
+        void AppendLocalHeader(const Entry& entry);
+
+        // Deflates the pending input of the entry stream into out
+        bool Deflate(int flush);
+
+        bool Fail(const std::string& message);
+
+        std::string& out;
+
+        // Number of bytes written, including those drained from out
+        uint64_t offset;
+
+        std::vector<Entry> entries;
+
+        // The streamed entry
+        Entry current;
+        z_stream stream;
+        bool streaming;
+        uint64_t compressedSize, size;
+
+        std::string errorMessage;
+
+        ZipWriter(const ZipWriter&);
+        const ZipWriter& operator=(const ZipWriter&);
+};
+
+
+}
+
+#endif // BINDINGS_ZIP_WRITER_H